@@ -43,12 +43,18 @@ class ExecutionModel:
                  slippage_factor: float = 0.0001,
                  market_impact_factor: float = 0.1,
                  fill_probability: float = 1.0,
-                 latency_ms: int = 0):
+                 latency_ms: int = 0,
+                 trigger_book=None):
         self.slippage_model = slippage_model
         self.slippage_factor = slippage_factor
         self.market_impact_factor = market_impact_factor
         self.fill_probability = fill_probability
         self.latency_ms = latency_ms
+        # Optional NativeTriggerBook; STOP orders then rest in it and fire in
+        # stop-price order instead of being rechecked one by one
+        self.trigger_book = trigger_book
+        self.stop_orders: Dict[str, Order] = {}
+        self._next_stop_id = 0
         
     def calculate_slippage(self, order: Order, market_price: float) -> float:
         direction_multiplier = 1.0 if order.direction == "BUY" else -1.0
@@ -150,6 +156,9 @@ class ExecutionModel:
             return self.execute_market_order(order, market_data, timestamp)
         elif order.order_type == "LIMIT":
             return self.execute_limit_order(order, market_data, timestamp)
+        elif order.order_type == "STOP" and self.trigger_book is not None:
+            self.add_stop_order(order)
+            return order in self.process_stop_orders(market_data, timestamp)
         elif order.order_type == "STOP":
             market_price = market_data.get("mid_price", market_data.get("close", 0.0))
             if ((order.direction == "BUY" and market_price >= order.stop_price) or
@@ -157,4 +166,38 @@ class ExecutionModel:
                 order.order_type = "MARKET"
                 return self.execute_market_order(order, market_data, timestamp)
                 
-        return False 
\ No newline at end of file
+        return False 
+        
+    def add_stop_order(self, order: Order) -> None:
+        """Register a STOP order with the trigger book; repeated calls are no-ops"""
+        if order.order_id is None:
+            order.order_id = f"stop-{self._next_stop_id}"
+            self._next_stop_id += 1
+        if order.order_id in self.stop_orders:
+            return
+        self.stop_orders[order.order_id] = order
+        self.trigger_book.add(order.order_id, order.stop_price, order.quantity, order.direction == "BUY")
+        
+    def cancel_stop_order(self, order: Order) -> bool:
+        if self.stop_orders.pop(order.order_id, None) is None:
+            return False
+        order.update_status("CANCELLED")
+        return self.trigger_book.cancel(order.order_id)
+        
+    def process_stop_orders(self, market_data: Dict, timestamp: int) -> List[Order]:
+        """Fire every registered stop crossed by the market price and execute
+        it as a market order, buys from the lowest stop and sells from the
+        highest. Returns the orders that filled."""
+        market_price = market_data.get("mid_price", market_data.get("close", 0.0))
+        if market_price <= 0:
+            return []
+            
+        filled = []
+        for stop in self.trigger_book.fire(market_price, market_price):
+            order = self.stop_orders.pop(stop["order_id"], None)
+            if order is None:
+                continue
+            order.order_type = "MARKET"
+            if self.execute_market_order(order, market_data, timestamp):
+                filled.append(order)
+        return filled
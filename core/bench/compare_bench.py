@@ -0,0 +1,38 @@
+"""Compare two benchmark JSON files written with --json.
+
+    python core/bench/compare_bench.py before.json after.json
+
+Prints each benchmark's mean, p50, p99 and allocations per op side by
+side with the relative change; a negative change is an improvement.
+"""
+import json
+import sys
+
+METRICS = ("mean_ns", "p50_ns", "p99_ns", "allocations_per_op")
+
+def load_results(path):
+    with open(path) as f:
+        return {result["name"]: result for result in json.load(f)["results"]}
+
+def format_change(before, after):
+    if before == 0:
+        return "    n/a" if after else "     0%"
+    return f"{(after - before) / before * 100:+6.1f}%"
+
+def main(argv):
+    if len(argv) != 3:
+        print(__doc__.strip())
+        return 2
+        
+    before, after = load_results(argv[1]), load_results(argv[2])
+    print(f"{'benchmark':<16}" + "".join(f"{metric:>30}" for metric in METRICS))
+    for name, old in before.items():
+        new = after.get(name)
+        if new is None:
+            continue
+        cells = [f"{old[m]:>10.1f} {new[m]:>10.1f} {format_change(old[m], new[m])}" for m in METRICS]
+        print(f"{name:<16}" + "".join(f"{cell:>30}" for cell in cells))
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,117 @@
+// Binary feed decoder microbenchmark: ns/message for parsing alone and for
+// parsing straight into books.
+//
+//   cd core/bench
+//   g++ -std=c++17 -O2 -I../src/orderbook -I../src/market_data decoder_bench.cpp
+//       ../src/orderbook/limit_order_book.cpp ../src/orderbook/trigger_book.cpp -o decoder_bench
+//   ./decoder_bench [messages] [books]
+
+#include "binary_protocol.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace microstructure;
+
+namespace {
+
+constexpr size_t kMinLive = 64;
+constexpr size_t kMaxLive = 4096;
+
+// Adds near a fixed mid, with modifies, executes and deletes against live
+// orders, roughly the mix of an equities order feed. Live orders per book
+// stay between kMinLive and kMaxLive so the books reach a steady state.
+std::vector<uint8_t> GenerateFeed(size_t message_count, uint16_t book_count) {
+    std::vector<uint8_t> buffer;
+    buffer.reserve(message_count * wire::kAddSize);
+    BinaryEncoder encoder(buffer);
+    
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> action(0, 99);
+    std::uniform_int_distribution<int> offset(1, 20);
+    std::uniform_int_distribution<uint32_t> shares(1, 10);
+    std::vector<std::vector<uint64_t>> live(book_count);
+    uint64_t next_id = 1;
+    int64_t ts = 0;
+    
+    for (size_t i = 0; i < message_count; ++i) {
+        uint16_t locate = static_cast<uint16_t>(rng() % book_count);
+        auto& orders = live[locate];
+        ts += 100;
+        int roll = action(rng);
+        if (orders.size() < kMinLive || (roll < 50 && orders.size() < kMaxLive)) {
+            bool is_buy = rng() & 1;
+            double price = 100.0 + (is_buy ? -0.01 : 0.01) * offset(rng);
+            encoder.Add(locate, ts, next_id, is_buy, shares(rng) * 100, price);
+            orders.push_back(next_id++);
+            continue;
+        }
+        size_t pick = rng() % orders.size();
+        uint64_t id = orders[pick];
+        if (roll < 70) {
+            encoder.Modify(locate, ts, id, shares(rng) * 100);
+        } else if (roll < 80) {
+            encoder.Execute(locate, ts, id, 100, 100.0);
+        } else {
+            encoder.Delete(locate, ts, id);
+            orders[pick] = orders.back();
+            orders.pop_back();
+        }
+    }
+    return buffer;
+}
+
+template <typename Fn>
+double TimeNs(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t message_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    uint16_t book_count = argc > 2 ? static_cast<uint16_t>(std::atoi(argv[2])) : 8;
+    if (book_count == 0) {
+        book_count = 1;
+    }
+    
+    std::vector<uint8_t> feed = GenerateFeed(message_count, book_count);
+    std::printf("messages: %zu, books: %u, bytes: %zu\n", message_count, book_count, feed.size());
+    
+    // Parse only; the checksum keeps the decoded fields live
+    BinaryDecoder parse_decoder;
+    uint64_t checksum = 0;
+    double parse_ns = TimeNs([&] {
+        parse_decoder.Decode(feed.data(), feed.size(), [&](uint16_t locate, const OrderEvent& event) {
+            checksum += event.order_id + locate + static_cast<uint64_t>(event.quantity);
+        });
+    });
+    
+    // Parse and apply to books
+    std::vector<std::unique_ptr<LimitOrderBook>> books;
+    std::vector<LimitOrderBook*> targets;
+    for (uint16_t i = 0; i < book_count; ++i) {
+        books.push_back(std::make_unique<LimitOrderBook>("SYM" + std::to_string(i)));
+        targets.push_back(books.back().get());
+    }
+    BinaryDecoder apply_decoder;
+    double apply_ns = TimeNs([&] {
+        apply_decoder.Decode(feed.data(), feed.size(), BookDispatcher(targets.data(), targets.size()));
+    });
+    
+    const DecodeStats& stats = apply_decoder.GetStats();
+    std::printf("decoded: %llu, skipped: %llu, checksum: %llu\n",
+                static_cast<unsigned long long>(stats.messages),
+                static_cast<unsigned long long>(stats.skipped),
+                static_cast<unsigned long long>(checksum));
+    std::printf("parse only:    %7.2f ns/message\n", parse_ns / message_count);
+    std::printf("parse + apply: %7.2f ns/message\n", apply_ns / message_count);
+    return 0;
+}
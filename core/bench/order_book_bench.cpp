@@ -0,0 +1,428 @@
+// LimitOrderBook microbenchmark: ns/op percentiles and heap allocations
+// per op for the core book operations on a synthetic book.
+//
+//   cd core/bench
+//   g++ -std=c++17 -O2 -I../src/orderbook -I../src/monitoring order_book_bench.cpp
+//       ../src/orderbook/limit_order_book.cpp ../src/orderbook/trigger_book.cpp -o order_book_bench
+//   ./order_book_bench [--ops N] [--depth LEVELS] [--orders-per-level N] [--touch-decay LEVELS]
+//       [--locality LEVELS] [--cancel-ratio R] [--seed N] [--json FILE]
+//
+// The book starts with depth levels a side, the touch holding the most
+// orders and the count decaying by e every touch-decay levels. New orders
+// land a geometric number of levels from the touch with mean locality.
+// Each benchmark runs twice on identical books: untimed for batch ns/op and
+// allocations/op, then timing every op for the mean and percentiles, which
+// therefore describe the same samples. Compare runs with compare_bench.py.
+
+#include "latency_histogram.h"
+#include "limit_order_book.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace microstructure;
+
+namespace {
+
+// Every heap allocation in the process goes through these; the bench is
+// single threaded so plain counters suffice
+uint64_t g_allocations = 0;
+uint64_t g_allocated_bytes = 0;
+
+} // namespace
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    g_allocated_bytes += size;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Kept out of line so GCC does not pair the inlined free with new
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+constexpr double kMid = 100.0;
+constexpr double kTick = 0.01;
+
+struct Config {
+    size_t ops = 200000;
+    int depth = 50;
+    double orders_per_level = 8.0;
+    double touch_decay = 10.0;
+    double locality = 3.0;
+    double cancel_ratio = 0.9;
+    uint64_t seed = 42;
+    std::string json_path;
+};
+
+struct Result {
+    std::string name;
+    size_t ops;
+    double batch_ns;                // Untimed pass: elapsed / ops with no per-op clock reads
+    double mean_ns;                 // Timed pass, over the same samples as latency
+    double allocations_per_op;
+    double bytes_per_op;
+    LatencyHistogram latency;
+};
+
+double LevelPrice(bool is_buy, int level) {
+    // Rounded to the tick so equal levels always produce equal keys
+    double price = is_buy ? kMid - kTick * (level + 1) : kMid + kTick * (level + 1);
+    return std::round(price / kTick) * kTick;
+}
+
+// Orders and operations for one run, generated up front so that building
+// strings and shared_ptrs stays out of the measured loops
+class Workload {
+public:
+    explicit Workload(const Config& config) : config_(config), rng_(config.seed) {
+        // Orders per level decay from the touch; scale so the mean over
+        // all levels is orders_per_level
+        std::vector<double> weights(config.depth);
+        double total = 0.0;
+        for (int level = 0; level < config.depth; ++level) {
+            weights[level] = std::exp(-level / std::max(config.touch_decay, 1e-9));
+            total += weights[level];
+        }
+        for (int side = 0; side < 2; ++side) {
+            for (int level = 0; level < config.depth; ++level) {
+                double expected = weights[level] / total * config.depth * config.orders_per_level;
+                int count = std::max(1, static_cast<int>(std::lround(expected)));
+                for (int i = 0; i < count; ++i) {
+                    prefill_.push_back(MakeOrder(side == 0, level));
+                }
+            }
+        }
+    }
+    
+    OrderPtr MakeOrder(bool is_buy, int level) {
+        auto order = std::make_shared<Order>();
+        order->order_id = std::to_string(next_id_++);
+        order->price = LevelPrice(is_buy, level);
+        order->quantity = 100.0 * quantity_(rng_);
+        order->is_buy = is_buy;
+        order->timestamp_ns = static_cast<int64_t>(next_id_) * 100;
+        return order;
+    }
+    
+    // A passive order a geometric number of levels from the touch
+    OrderPtr MakeLocalOrder() {
+        std::geometric_distribution<int> distance(1.0 / (1.0 + std::max(config_.locality, 0.0)));
+        int level = std::min(distance(rng_), config_.depth * 2 - 1);
+        return MakeOrder(rng_() & 1, level);
+    }
+    
+    std::unique_ptr<LimitOrderBook> BuildBook() const {
+        auto book = std::make_unique<LimitOrderBook>("BENCH");
+        for (const auto& order : prefill_) {
+            book->AddOrder(std::make_shared<Order>(*order));
+        }
+        return book;
+    }
+    
+    std::vector<OrderPtr> MakeLocalOrders(size_t count) {
+        std::vector<OrderPtr> orders;
+        orders.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            orders.push_back(MakeLocalOrder());
+        }
+        return orders;
+    }
+    
+    std::vector<std::string> GetPrefillIds() const {
+        std::vector<std::string> ids;
+        for (const auto& order : prefill_) {
+            ids.push_back(order->order_id);
+        }
+        return ids;
+    }
+    
+    std::mt19937_64& GetRng() { return rng_; }
+    
+private:
+    Config config_;
+    std::mt19937_64 rng_;
+    std::uniform_int_distribution<int> quantity_{1, 10};
+    std::vector<OrderPtr> prefill_;
+    uint64_t next_id_ = 1;
+};
+
+// One step of the add/cancel mix; cancels name an order added earlier
+struct MixedOp {
+    OrderPtr add;
+    std::string cancel_id;
+};
+
+// A benchmark prepares a fresh book and returns the op to run count times
+using Prepare = std::function<std::function<void(size_t)>(size_t count)>;
+
+double NowNs() {
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Cost of the two clock reads around a timed op, subtracted from each sample
+double MeasureClockOverhead() {
+    LatencyHistogram overhead;
+    for (int i = 0; i < 100000; ++i) {
+        double begin = NowNs();
+        double end = NowNs();
+        overhead.Record(static_cast<uint64_t>(end - begin));
+    }
+    return static_cast<double>(overhead.GetValueAtPercentile(50.0));
+}
+
+Result Run(const std::string& name, size_t ops, const Prepare& prepare, double clock_overhead_ns) {
+    Result result;
+    result.name = name;
+    result.ops = ops;
+    
+    {
+        auto op = prepare(ops);
+        uint64_t allocations = g_allocations;
+        uint64_t bytes = g_allocated_bytes;
+        double begin = NowNs();
+        for (size_t i = 0; i < ops; ++i) {
+            op(i);
+        }
+        double elapsed = NowNs() - begin;
+        result.batch_ns = elapsed / ops;
+        result.allocations_per_op = static_cast<double>(g_allocations - allocations) / ops;
+        result.bytes_per_op = static_cast<double>(g_allocated_bytes - bytes) / ops;
+    }
+    
+    auto op = prepare(ops);
+    double total = 0.0;
+    for (size_t i = 0; i < ops; ++i) {
+        double begin = NowNs();
+        op(i);
+        double sample = NowNs() - begin - clock_overhead_ns;
+        uint64_t recorded = sample > 0.0 ? static_cast<uint64_t>(sample) : 0;
+        result.latency.Record(recorded);
+        total += static_cast<double>(recorded);
+    }
+    result.mean_ns = total / ops;
+    return result;
+}
+
+void PrintResult(const Result& result) {
+    std::printf("%-16s %10.1f %10.1f %8llu %8llu %8llu %8llu %10llu %9.2f %10.1f\n", result.name.c_str(),
+                result.batch_ns, result.mean_ns,
+                static_cast<unsigned long long>(result.latency.GetValueAtPercentile(50.0)),
+                static_cast<unsigned long long>(result.latency.GetValueAtPercentile(90.0)),
+                static_cast<unsigned long long>(result.latency.GetValueAtPercentile(99.0)),
+                static_cast<unsigned long long>(result.latency.GetValueAtPercentile(99.9)),
+                static_cast<unsigned long long>(result.latency.GetMax()),
+                result.allocations_per_op, result.bytes_per_op);
+}
+
+bool WriteJson(const std::string& path, const Config& config, double clock_overhead_ns,
+               const std::vector<Result>& results) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    std::fprintf(out, "{\n  \"benchmark\": \"order_book\",\n");
+    std::fprintf(out, "  \"config\": {\"ops\": %zu, \"depth\": %d, \"orders_per_level\": %g, \"touch_decay\": %g, "
+                      "\"locality\": %g, \"cancel_ratio\": %g, \"seed\": %llu},\n",
+                 config.ops, config.depth, config.orders_per_level, config.touch_decay, config.locality,
+                 config.cancel_ratio, static_cast<unsigned long long>(config.seed));
+    std::fprintf(out, "  \"clock_overhead_ns\": %.1f,\n  \"results\": [\n", clock_overhead_ns);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"ops\": %zu, \"batch_ns\": %.2f, \"mean_ns\": %.2f, "
+                          "\"p50_ns\": %llu, \"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu, "
+                          "\"allocations_per_op\": %.3f, \"bytes_per_op\": %.1f}%s\n",
+                     result.name.c_str(), result.ops, result.batch_ns, result.mean_ns,
+                     static_cast<unsigned long long>(result.latency.GetValueAtPercentile(50.0)),
+                     static_cast<unsigned long long>(result.latency.GetValueAtPercentile(90.0)),
+                     static_cast<unsigned long long>(result.latency.GetValueAtPercentile(99.0)),
+                     static_cast<unsigned long long>(result.latency.GetValueAtPercentile(99.9)),
+                     static_cast<unsigned long long>(result.latency.GetMax()),
+                     result.allocations_per_op, result.bytes_per_op, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    return std::fclose(out) == 0;
+}
+
+int Usage() {
+    std::fprintf(stderr, "usage: order_book_bench [--ops N] [--depth LEVELS] [--orders-per-level N]"
+                         " [--touch-decay LEVELS] [--locality LEVELS] [--cancel-ratio R] [--seed N]"
+                         " [--json FILE]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--ops") && has_value) {
+            config.ops = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--depth") && has_value) {
+            config.depth = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--orders-per-level") && has_value) {
+            config.orders_per_level = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--touch-decay") && has_value) {
+            config.touch_decay = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--locality") && has_value) {
+            config.locality = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--cancel-ratio") && has_value) {
+            config.cancel_ratio = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--seed") && has_value) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--json") && has_value) {
+            config.json_path = argv[++i];
+        } else {
+            return Usage();
+        }
+    }
+    if (config.ops == 0 || config.depth <= 0) {
+        return Usage();
+    }
+    
+    // Each prepare rebuilds the same book and inputs from the seed, so the
+    // untimed and timed passes see identical work
+    std::unique_ptr<LimitOrderBook> book;
+    std::vector<OrderPtr> orders;
+    std::vector<std::string> ids;
+    std::vector<double> quantities;
+    std::vector<MixedOp> mixed;
+    double prices[10];
+    double volumes[10];
+    double sink = 0.0;
+    
+    std::vector<std::pair<std::string, Prepare>> benchmarks;
+    benchmarks.emplace_back("add", [&](size_t count) {
+        Workload workload(config);
+        book = workload.BuildBook();
+        orders = workload.MakeLocalOrders(count);
+        return [&](size_t i) { book->AddOrder(orders[i]); };
+    });
+    benchmarks.emplace_back("cancel", [&](size_t count) {
+        // Cancel orders spread over the book like the adds that placed them
+        Workload workload(config);
+        book = workload.BuildBook();
+        orders = workload.MakeLocalOrders(count);
+        ids.clear();
+        for (const auto& order : orders) {
+            book->AddOrder(order);
+            ids.push_back(order->order_id);
+        }
+        std::shuffle(ids.begin(), ids.end(), workload.GetRng());
+        return [&](size_t i) { book->CancelOrder(ids[i]); };
+    });
+    benchmarks.emplace_back("modify", [&](size_t count) {
+        // Half shrink in place, half grow and lose queue priority
+        Workload workload(config);
+        book = workload.BuildBook();
+        std::vector<std::string> live = workload.GetPrefillIds();
+        ids.clear();
+        quantities.clear();
+        for (size_t i = 0; i < count; ++i) {
+            ids.push_back(live[workload.GetRng()() % live.size()]);
+            quantities.push_back(100.0 * (1 + workload.GetRng()() % 10));
+        }
+        return [&](size_t i) { book->ModifyOrder(ids[i], quantities[i]); };
+    });
+    benchmarks.emplace_back("add_cancel_mix", [&](size_t count) {
+        // cancel_ratio of steps cancel a random live order, the rest add
+        Workload workload(config);
+        book = workload.BuildBook();
+        std::vector<std::string> live = workload.GetPrefillIds();
+        std::uniform_real_distribution<double> roll(0.0, 1.0);
+        mixed.assign(count, MixedOp{});
+        for (size_t i = 0; i < count; ++i) {
+            if (!live.empty() && roll(workload.GetRng()) < config.cancel_ratio) {
+                size_t pick = workload.GetRng()() % live.size();
+                mixed[i].cancel_id = live[pick];
+                live[pick] = live.back();
+                live.pop_back();
+            } else {
+                mixed[i].add = workload.MakeLocalOrder();
+                live.push_back(mixed[i].add->order_id);
+            }
+        }
+        return [&](size_t i) {
+            if (mixed[i].add) {
+                book->AddOrder(mixed[i].add);
+            } else {
+                book->CancelOrder(mixed[i].cancel_id);
+            }
+        };
+    });
+    benchmarks.emplace_back("imbalance", [&](size_t) {
+        Workload workload(config);
+        book = workload.BuildBook();
+        return [&](size_t i) { sink += book->GetOrderImbalance(1 + static_cast<int>(i % 10)); };
+    });
+    benchmarks.emplace_back("market_impact", [&](size_t count) {
+        // Sizes sweeping from inside the touch to several levels deep
+        Workload workload(config);
+        book = workload.BuildBook();
+        quantities.clear();
+        std::exponential_distribution<double> size(1.0 / (config.orders_per_level * 500.0));
+        for (size_t i = 0; i < count; ++i) {
+            quantities.push_back(100.0 + size(workload.GetRng()));
+        }
+        return [&](size_t i) { sink += book->EstimateMarketImpact(i & 1, quantities[i]); };
+    });
+    benchmarks.emplace_back("snapshot", [&](size_t) {
+        Workload workload(config);
+        book = workload.BuildBook();
+        return [&](size_t) {
+            auto bids = book->GetBidLevels(10);
+            auto asks = book->GetAskLevels(10);
+            sink += bids.front().first + asks.front().first;
+        };
+    });
+    benchmarks.emplace_back("snapshot_into", [&](size_t) {
+        Workload workload(config);
+        book = workload.BuildBook();
+        return [&](size_t) {
+            sink += book->GetBidLevels(prices, volumes, 10);
+            sink += book->GetAskLevels(prices, volumes, 10);
+        };
+    });
+    
+    double clock_overhead_ns = MeasureClockOverhead();
+    std::printf("ops %zu, depth %d, orders/level %g, touch decay %g, locality %g, cancel ratio %g, "
+                "clock overhead %.0f ns\n", config.ops, config.depth, config.orders_per_level,
+                config.touch_decay, config.locality, config.cancel_ratio, clock_overhead_ns);
+    std::printf("%-16s %10s %10s %8s %8s %8s %8s %10s %9s %10s\n", "benchmark", "batch ns", "mean ns", "p50",
+                "p90", "p99", "p99.9", "max", "allocs/op", "bytes/op");
+    
+    std::vector<Result> results;
+    for (const auto& benchmark : benchmarks) {
+        results.push_back(Run(benchmark.first, config.ops, benchmark.second, clock_overhead_ns));
+        PrintResult(results.back());
+    }
+    std::printf("checksum: %.3f\n", sink);
+    
+    if (!config.json_path.empty() && !WriteJson(config.json_path, config, clock_overhead_ns, results)) {
+        std::fprintf(stderr, "cannot write %s\n", config.json_path.c_str());
+        return 1;
+    }
+    return 0;
+}
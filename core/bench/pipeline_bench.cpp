@@ -0,0 +1,421 @@
+// End-to-end feed pipeline benchmark: offers a synthetic multi-symbol L3
+// stream to FeedPipeline (ring -> book thread -> metrics -> publish
+// callback) at increasing rates and reports sustained throughput, latency
+// from the scheduled send time to the callback, and pipeline CPU per
+// message, stopping at the rate the pipeline can no longer sustain.
+//
+//   cd core/bench
+//   g++ -std=c++17 -O2 -I../src/orderbook -I../src/market_data -I../src/monitoring -I../src/analysis
+//       pipeline_bench.cpp ../src/market_data/feed_pipeline.cpp ../src/monitoring/stage_latency.cpp
+//       ../src/analysis/microstructure_analyzer.cpp ../src/orderbook/arrow_export.cpp
+//       ../src/orderbook/limit_order_book.cpp ../src/orderbook/trigger_book.cpp -o pipeline_bench -lpthread
+//   ./pipeline_bench [--symbols N] [--zipf S] [--branching N] [--cancel-ratio R] [--start-rate MSGS]
+//       [--step FACTOR] [--max-rate MSGS] [--seconds S] [--max-events N] [--slo-us US] [--stages]
+//       [--analyzer-window N] [--json FILE]
+//
+// Arrivals follow a Hawkes process (branching 0 is Poisson), so bursts
+// queue up the way live feeds do; symbols are drawn from a Zipf law and
+// most adds are eventually cancelled. Latency is measured from when each
+// message was due rather than when it was sent, so a producer held back by
+// a full ring does not hide the delay.
+
+#include "feed_pipeline.h"
+#include "latency_histogram.h"
+#include "stage_latency.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <time.h>
+
+using namespace microstructure;
+
+namespace {
+
+struct Config {
+    size_t symbols = 100;
+    double zipf = 1.1;
+    double branching = 0.7;         // Mean events triggered by each event
+    double burst_decay = 50.0;      // Excitation decay rate relative to the base arrival rate
+    double cancel_ratio = 0.9;      // Share of adds that are later cancelled
+    double start_rate = 10000.0;
+    double step = 1.5;
+    double max_rate = 20e6;
+    double seconds = 1.0;
+    size_t max_events = 1000000;
+    double slo_us = 1000.0;         // p99 above this counts as saturated
+    bool stages = false;
+    size_t analyzer_window = 0;     // Non-zero runs the microstructure analyzer per book
+    uint64_t seed = 42;
+    std::string json_path;
+};
+
+struct StepResult {
+    double offered_rate;
+    double achieved_rate;
+    uint64_t messages;
+    uint64_t rejected;
+    double cpu_ns_per_message;
+    LatencyHistogram latency;
+    bool sustained;
+};
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t ThreadCpuNs() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+int64_t ProcessCpuNs() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (static_cast<int64_t>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000000 +
+           (static_cast<int64_t>(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000;
+}
+
+// L3 message stream with arrival times in units where the mean rate is one
+// message per unit; Run scales them to the offered rate
+class OrderFlowGenerator {
+public:
+    explicit OrderFlowGenerator(const Config& config) : config_(config), rng_(config.seed) {
+        double total = 0.0;
+        for (size_t rank = 1; rank <= config.symbols; ++rank) {
+            total += 1.0 / std::pow(static_cast<double>(rank), config.zipf);
+            symbol_cdf_.push_back(total);
+        }
+        for (double& p : symbol_cdf_) {
+            p /= total;
+        }
+        books_.resize(config.symbols);
+    }
+    
+    void Generate(size_t count, std::vector<FeedEvent>* events, std::vector<double>* times) {
+        events->resize(count);
+        times->resize(count);
+        
+        // Ogata thinning: the intensity only decays between events, so its
+        // current value bounds it until the next arrival
+        double base = 1.0 - std::min(config_.branching, 0.95);
+        double beta = config_.burst_decay;
+        double alpha = std::min(config_.branching, 0.95) * beta;
+        double excitation = 0.0;
+        double t = 0.0;
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        for (size_t i = 0; i < count; ++i) {
+            while (true) {
+                double bound = base + excitation;
+                double wait = -std::log(1.0 - uniform(rng_)) / bound;
+                t += wait;
+                excitation *= std::exp(-beta * wait);
+                if (uniform(rng_) * bound <= base + excitation) {
+                    break;
+                }
+            }
+            excitation += alpha;
+            (*times)[i] = t;
+            NextEvent(&(*events)[i]);
+        }
+    }
+    
+private:
+    struct LiveOrder {
+        uint64_t id;
+        double price;
+        double quantity;
+        bool is_buy;
+    };
+    
+    struct SymbolBook {
+        std::vector<LiveOrder> live;
+        double mid = 100.0;
+    };
+    
+    void NextEvent(FeedEvent* out) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        size_t symbol = std::lower_bound(symbol_cdf_.begin(), symbol_cdf_.end(), uniform(rng_)) -
+                        symbol_cdf_.begin();
+        symbol = std::min(symbol, books_.size() - 1);
+        SymbolBook& book = books_[symbol];
+        std::memset(out, 0, sizeof(*out));
+        out->book_index = static_cast<uint32_t>(symbol);
+        OrderEvent& event = out->event;
+        
+        // Adds and cancels dominate; executions and resizes are a few percent
+        double add_share = 1.0 / (1.0 + config_.cancel_ratio);
+        double roll = uniform(rng_);
+        if (book.live.size() < 16 || (roll < add_share * 0.9 && book.live.size() < 4096)) {
+            std::geometric_distribution<int> distance(0.3);
+            bool is_buy = rng_() & 1;
+            double offset = 0.01 * (1 + distance(rng_));
+            LiveOrder order{next_id_++, std::round((book.mid + (is_buy ? -offset : offset)) * 100.0) / 100.0,
+                            100.0 * (1 + rng_() % 10), is_buy};
+            book.live.push_back(order);
+            event.type = kEventAdd;
+            event.order_id = order.id;
+            event.price = order.price;
+            event.quantity = order.quantity;
+            event.is_buy = is_buy;
+            book.mid += (uniform(rng_) - 0.5) * 0.002;
+            return;
+        }
+        
+        size_t pick = rng_() % book.live.size();
+        LiveOrder& order = book.live[pick];
+        event.order_id = order.id;
+        event.is_buy = order.is_buy;
+        if (roll < 0.94) {
+            event.type = kEventCancel;
+        } else if (roll < 0.97) {
+            order.quantity = 100.0 * (1 + rng_() % 10);
+            event.type = kEventModify;
+            event.quantity = order.quantity;
+            return;
+        } else {
+            event.type = kEventExecute;
+            event.price = order.price;
+            event.quantity = std::min(order.quantity, 100.0);
+            order.quantity -= event.quantity;
+            if (order.quantity > 0.0) {
+                return;
+            }
+        }
+        order = book.live.back();
+        book.live.pop_back();
+    }
+    
+    Config config_;
+    std::mt19937_64 rng_;
+    std::vector<double> symbol_cdf_;
+    std::vector<SymbolBook> books_;
+    uint64_t next_id_ = 1;
+};
+
+// Offer the first messages of the stream at rate messages per second
+StepResult RunStep(const Config& config, const std::vector<std::string>& symbols,
+                   const std::vector<FeedEvent>& stream, const std::vector<double>& times, double rate) {
+    size_t count = std::min(stream.size(), static_cast<size_t>(rate * config.seconds) + 1);
+    std::vector<FeedEvent> events(stream.begin(), stream.begin() + count);
+    for (size_t i = 0; i < count; ++i) {
+        events[i].event.timestamp_ns = static_cast<int64_t>(times[i] / rate * 1e9);
+    }
+    
+    ResetStageLatency();
+    StepResult result;
+    result.offered_rate = rate;
+    FeedPipeline::Options options;
+    options.analyzer_window = config.analyzer_window;
+    FeedPipeline pipeline(symbols, options);
+    int64_t start_ns = 0;
+    int64_t last_delivery_ns = 0;
+    pipeline.Start([&](const BookUpdate* updates, size_t n) {
+        int64_t now = NowNs();
+        for (size_t i = 0; i < n; ++i) {
+            int64_t latency = now - start_ns - updates[i].timestamp_ns;
+            result.latency.Record(static_cast<uint64_t>(std::max<int64_t>(latency, 0)));
+        }
+        last_delivery_ns = now;
+    });
+    
+    int64_t cpu_begin = ProcessCpuNs();
+    int64_t producer_cpu_begin = ThreadCpuNs();
+    start_ns = NowNs();
+    size_t next = 0;
+    while (next < count) {
+        int64_t due = events[next].event.timestamp_ns;
+        int64_t now = NowNs() - start_ns;
+        if (due > now) {
+            // Sleep through long gaps, spin through short ones
+            if (due - now > 200000) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(due - now - 100000));
+            }
+            continue;
+        }
+        size_t ready = next;
+        while (ready < count && ready - next < 256 && events[ready].event.timestamp_ns <= now) {
+            ++ready;
+        }
+        size_t accepted = pipeline.Submit(events.data() + next, ready - next);
+        next += accepted;
+        if (accepted == 0) {
+            std::this_thread::yield();
+        }
+    }
+    int64_t producer_cpu = ThreadCpuNs() - producer_cpu_begin;
+    pipeline.Stop();
+    int64_t pipeline_cpu = ProcessCpuNs() - cpu_begin - producer_cpu;
+    
+    FeedPipelineStats stats = pipeline.GetStats();
+    // Bursts make the schedule of a short prefix longer or shorter than
+    // count / rate, so keeping up is judged against the schedule itself
+    double scheduled = std::max<int64_t>(events.back().event.timestamp_ns, 1) / 1e9;
+    double elapsed = std::max(std::max<int64_t>(last_delivery_ns - start_ns, 1) / 1e9, scheduled);
+    result.messages = stats.delivered;
+    result.rejected = stats.rejected;
+    result.achieved_rate = stats.delivered / elapsed;
+    result.cpu_ns_per_message = stats.delivered ? static_cast<double>(pipeline_cpu) / stats.delivered : 0.0;
+    result.sustained = result.achieved_rate >= 0.95 * count / scheduled &&
+                       result.latency.GetValueAtPercentile(99.0) <= config.slo_us * 1000.0;
+    return result;
+}
+
+void PrintStep(const StepResult& step) {
+    std::printf("%12.0f %12.0f %10llu %8.0f %8llu %8llu %8llu %10llu %9.0f  %s\n", step.offered_rate,
+                step.achieved_rate, static_cast<unsigned long long>(step.messages),
+                step.latency.GetMean() / 1e3,
+                static_cast<unsigned long long>(step.latency.GetValueAtPercentile(50.0) / 1000),
+                static_cast<unsigned long long>(step.latency.GetValueAtPercentile(99.0) / 1000),
+                static_cast<unsigned long long>(step.latency.GetValueAtPercentile(99.9) / 1000),
+                static_cast<unsigned long long>(step.latency.GetMax() / 1000), step.cpu_ns_per_message,
+                step.sustained ? "ok" : "saturated");
+}
+
+bool WriteJson(const std::string& path, const Config& config, const std::vector<StepResult>& steps,
+               double saturation_rate) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    std::fprintf(out, "{\n  \"benchmark\": \"pipeline\",\n");
+    std::fprintf(out, "  \"config\": {\"symbols\": %zu, \"zipf\": %g, \"branching\": %g, \"cancel_ratio\": %g, "
+                      "\"seconds\": %g, \"slo_us\": %g, \"analyzer_window\": %zu, \"seed\": %llu},\n",
+                 config.symbols, config.zipf, config.branching, config.cancel_ratio, config.seconds,
+                 config.slo_us, config.analyzer_window, static_cast<unsigned long long>(config.seed));
+    std::fprintf(out, "  \"saturation_rate\": %.0f,\n  \"steps\": [\n", saturation_rate);
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const StepResult& step = steps[i];
+        std::fprintf(out, "    {\"offered_rate\": %.0f, \"achieved_rate\": %.0f, \"messages\": %llu, "
+                          "\"rejected\": %llu, \"mean_ns\": %.0f, \"p50_ns\": %llu, \"p99_ns\": %llu, "
+                          "\"p999_ns\": %llu, \"max_ns\": %llu, \"cpu_ns_per_message\": %.1f, "
+                          "\"sustained\": %s}%s\n",
+                     step.offered_rate, step.achieved_rate, static_cast<unsigned long long>(step.messages),
+                     static_cast<unsigned long long>(step.rejected), step.latency.GetMean(),
+                     static_cast<unsigned long long>(step.latency.GetValueAtPercentile(50.0)),
+                     static_cast<unsigned long long>(step.latency.GetValueAtPercentile(99.0)),
+                     static_cast<unsigned long long>(step.latency.GetValueAtPercentile(99.9)),
+                     static_cast<unsigned long long>(step.latency.GetMax()), step.cpu_ns_per_message,
+                     step.sustained ? "true" : "false", i + 1 < steps.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    return std::fclose(out) == 0;
+}
+
+int Usage() {
+    std::fprintf(stderr, "usage: pipeline_bench [--symbols N] [--zipf S] [--branching N] [--cancel-ratio R]"
+                         " [--start-rate MSGS] [--step FACTOR] [--max-rate MSGS] [--seconds S]"
+                         " [--max-events N] [--slo-us US] [--stages] [--analyzer-window N] [--seed N] [--json FILE]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--symbols") && has_value) {
+            config.symbols = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--zipf") && has_value) {
+            config.zipf = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--branching") && has_value) {
+            config.branching = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--cancel-ratio") && has_value) {
+            config.cancel_ratio = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--start-rate") && has_value) {
+            config.start_rate = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--step") && has_value) {
+            config.step = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--max-rate") && has_value) {
+            config.max_rate = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--seconds") && has_value) {
+            config.seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--max-events") && has_value) {
+            config.max_events = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--slo-us") && has_value) {
+            config.slo_us = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--stages")) {
+            config.stages = true;
+        } else if (!std::strcmp(argv[i], "--analyzer-window") && has_value) {
+            config.analyzer_window = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--seed") && has_value) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--json") && has_value) {
+            config.json_path = argv[++i];
+        } else {
+            return Usage();
+        }
+    }
+    if (config.symbols == 0 || config.step <= 1.0 || config.start_rate <= 0.0 || config.max_events == 0) {
+        return Usage();
+    }
+    
+    std::vector<std::string> symbols;
+    for (size_t i = 0; i < config.symbols; ++i) {
+        symbols.push_back("SYM" + std::to_string(i));
+    }
+    std::vector<FeedEvent> stream;
+    std::vector<double> times;
+    OrderFlowGenerator(config).Generate(config.max_events, &stream, &times);
+    // Rescale so the realised mean rate is exactly one message per unit
+    double span = times.back();
+    for (double& t : times) {
+        t *= times.size() / span;
+    }
+    if (config.stages) {
+        SetStageTimingEnabled(true);
+    }
+    
+    std::printf("symbols %zu, zipf %g, branching %g, cancel ratio %g, %g s per step, p99 SLO %g us\n",
+                config.symbols, config.zipf, config.branching, config.cancel_ratio, config.seconds,
+                config.slo_us);
+    std::printf("%12s %12s %10s %8s %8s %8s %8s %10s %9s\n", "offered/s", "achieved/s", "messages", "mean us",
+                "p50 us", "p99 us", "p99.9 us", "max us", "cpu ns/msg");
+    
+    // Ramp geometrically until a step falls behind, then bisect between
+    // the last sustained rate and the first saturated one
+    std::vector<StepResult> steps;
+    double good = 0.0;
+    double bad = 0.0;
+    for (double rate = config.start_rate; rate <= config.max_rate; rate *= config.step) {
+        steps.push_back(RunStep(config, symbols, stream, times, rate));
+        PrintStep(steps.back());
+        if (!steps.back().sustained) {
+            bad = rate;
+            break;
+        }
+        good = rate;
+    }
+    for (int i = 0; i < 3 && good > 0.0 && bad > 0.0; ++i) {
+        double rate = std::sqrt(good * bad);
+        steps.push_back(RunStep(config, symbols, stream, times, rate));
+        PrintStep(steps.back());
+        (steps.back().sustained ? good : bad) = rate;
+    }
+    
+    if (good > 0.0) {
+        std::printf("saturation: %.0f messages/s sustained\n", good);
+    } else {
+        std::printf("saturation: below the start rate of %.0f messages/s\n", config.start_rate);
+    }
+    if (config.stages) {
+        std::printf("stage latency over the last step\n%s", FormatStageLatency().c_str());
+    }
+    if (!config.json_path.empty() && !WriteJson(config.json_path, config, steps, good)) {
+        std::fprintf(stderr, "cannot write %s\n", config.json_path.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "microstructure_analyzer.h"
+
+#include <algorithm>
+
+namespace microstructure {
+
+MicrostructureAnalyzer::MicrostructureAnalyzer(const Options& options)
+    : options_(options),
+      returns_(options.window_size),
+      spreads_(options.window_size),
+      imbalances_(options.window_size) {
+    int levels = std::max(options_.impact_levels, 1);
+    options_.impact_levels = levels;
+    bid_prices_.resize(levels);
+    bid_volumes_.resize(levels);
+    ask_prices_.resize(levels);
+    ask_volumes_.resize(levels);
+}
+
+const MicrostructureMetrics& MicrostructureAnalyzer::Update(const LimitOrderBook& book, int64_t timestamp_ns) {
+    ++updates_;
+    latest_.timestamp_ns = timestamp_ns;
+    latest_.mid_price = book.GetMidPrice();
+    latest_.spread = latest_.mid_price > 0 ? book.GetSpread() : 0.0;
+    latest_.order_imbalance = book.GetOrderImbalance(options_.imbalance_levels);
+    spreads_.Push(latest_.spread);
+    imbalances_.Push(latest_.order_imbalance);
+    
+    // Walk the bounded top of book; a shortfall is priced 5% through the
+    // touch, as in the Python analyzer
+    latest_.price_impact = 0.0;
+    int bids = book.GetBidLevels(bid_prices_.data(), bid_volumes_.data(), options_.impact_levels);
+    int asks = book.GetAskLevels(ask_prices_.data(), ask_volumes_.data(), options_.impact_levels);
+    if (bids > 0 && asks > 0 && options_.impact_size > 0) {
+        double mid = (bid_prices_[0] + ask_prices_[0]) / 2.0;
+        double bid_fill = SideFillPrice(bid_prices_.data(), bid_volumes_.data(), bids, 0.95);
+        double ask_fill = SideFillPrice(ask_prices_.data(), ask_volumes_.data(), asks, 1.05);
+        double impact = ((ask_fill - mid) + (mid - bid_fill)) / 2.0;
+        latest_.price_impact = mid > 0 ? impact / mid : 0.0;
+    }
+    
+    // Updates with a one-sided book contribute no return
+    if (latest_.mid_price > 0 && last_mid_ > 0) {
+        returns_.Push(std::log(latest_.mid_price / last_mid_));
+    }
+    if (latest_.mid_price > 0) {
+        last_mid_ = latest_.mid_price;
+    }
+    latest_.realized_volatility = returns_.GetCount() >= 2 ? returns_.GetStdDev() * options_.annualization : 0.0;
+    return latest_;
+}
+
+double MicrostructureAnalyzer::SideFillPrice(const double* prices, const double* volumes, int count,
+                                             double penalty) const {
+    double remaining = options_.impact_size;
+    double cost = 0.0;
+    for (int i = 0; i < count && remaining > 0; ++i) {
+        double filled = std::min(remaining, volumes[i]);
+        cost += filled * prices[i];
+        remaining -= filled;
+    }
+    if (remaining > 0) {
+        cost += remaining * prices[0] * penalty;
+    }
+    return cost / options_.impact_size;
+}
+
+void MicrostructureAnalyzer::Reset() {
+    latest_ = MicrostructureMetrics{};
+    returns_.Clear();
+    spreads_.Clear();
+    imbalances_.Clear();
+    last_mid_ = 0.0;
+    updates_ = 0;
+}
+
+const std::vector<std::string>& MicrostructureAnalyzer::GetMetricNames() {
+    static const std::vector<std::string> names = {
+        "mid_price", "spread", "order_imbalance", "price_impact", "realized_volatility"};
+    return names;
+}
+
+void MicrostructureAnalyzer::AppendTo(MetricBatchBuilder& batch, uint32_t symbol_id) const {
+    const double values[] = {latest_.mid_price, latest_.spread, latest_.order_imbalance,
+                             latest_.price_impact, latest_.realized_volatility};
+    batch.Append(latest_.timestamp_ns, symbol_id, values);
+}
+
+} // namespace microstructure
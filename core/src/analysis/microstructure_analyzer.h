@@ -0,0 +1,72 @@
+#pragma once
+
+#include "arrow_export.h"
+#include "limit_order_book.h"
+#include "rolling_window.h"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace microstructure {
+
+// Layout matches ob_microstructure_metrics_t in the C ABI
+struct MicrostructureMetrics {
+    int64_t timestamp_ns;
+    double mid_price;               // 0 unless both sides are populated
+    double spread;                  // 0 unless both sides are populated
+    double order_imbalance;         // Over the top imbalance_levels per side
+    double price_impact;            // Relative cost of a round trip of impact_size
+    double realized_volatility;     // Annualised std dev of mid log returns
+};
+
+// Streaming replacement for the Python MicrostructureAnalyzer, fed from
+// one LimitOrderBook after each update. Returns live in a fixed-capacity
+// ring with a rolling Welford variance, so an update costs O(1) in the
+// window size: only the imbalance and impact walks touch the book, and
+// they are bounded by imbalance_levels and impact_levels.
+class MicrostructureAnalyzer {
+public:
+    struct Options {
+        size_t window_size = 100;       // Mid returns in the volatility window
+        int imbalance_levels = 5;
+        int impact_levels = 10;         // Depth walked for price impact, as a 10-level snapshot
+        double impact_size = 100.0;
+        // Per-update returns scaled as in the Python analyzer
+        double annualization = std::sqrt(252.0 * 6.5 * 60.0 * 60.0);
+    };
+    
+    explicit MicrostructureAnalyzer(const Options& options);
+    
+    const MicrostructureMetrics& Update(const LimitOrderBook& book, int64_t timestamp_ns);
+    const MicrostructureMetrics& GetLatest() const { return latest_; }
+    
+    // Rolling statistics over the last window_size updates
+    double GetMeanSpread() const { return spreads_.GetMean(); }
+    double GetMeanImbalance() const { return imbalances_.GetMean(); }
+    double GetImbalanceStdDev() const { return imbalances_.GetStdDev(); }
+    size_t GetUpdateCount() const { return updates_; }
+    
+    void Reset();
+    
+    // Column names of AppendTo rows, for a MetricBatchBuilder
+    static const std::vector<std::string>& GetMetricNames();
+    void AppendTo(MetricBatchBuilder& batch, uint32_t symbol_id) const;
+    
+private:
+    double SideFillPrice(const double* prices, const double* volumes, int count, double penalty) const;
+    
+    Options options_;
+    MicrostructureMetrics latest_{};
+    RollingStats returns_;
+    RollingStats spreads_;
+    RollingStats imbalances_;
+    double last_mid_ = 0.0;
+    size_t updates_ = 0;
+    
+    // Depth scratch for the impact walk
+    std::vector<double> bid_prices_, bid_volumes_, ask_prices_, ask_volumes_;
+};
+
+} // namespace microstructure
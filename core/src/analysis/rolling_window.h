@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace microstructure {
+
+// Fixed-capacity ring of the most recent values. Storage is allocated once
+// in the constructor; Push overwrites the oldest value once full.
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity) : slots_(capacity > 0 ? capacity : 1) {}
+    
+    // Returns true and sets *evicted when the push displaced the oldest value
+    bool Push(const T& value, T* evicted = nullptr) {
+        bool full = size_ == slots_.size();
+        if (full && evicted) {
+            *evicted = slots_[head_];
+        }
+        slots_[head_] = value;
+        head_ = head_ + 1 == slots_.size() ? 0 : head_ + 1;
+        if (!full) {
+            ++size_;
+        }
+        return full;
+    }
+    
+    // index 0 is the oldest value
+    const T& operator[](size_t index) const {
+        size_t start = size_ == slots_.size() ? head_ : 0;
+        size_t slot = start + index;
+        return slots_[slot >= slots_.size() ? slot - slots_.size() : slot];
+    }
+    const T& Back() const { return slots_[head_ == 0 ? slots_.size() - 1 : head_ - 1]; }
+    
+    size_t GetSize() const { return size_; }
+    size_t GetCapacity() const { return slots_.size(); }
+    bool IsFull() const { return size_ == slots_.size(); }
+    bool IsEmpty() const { return size_ == 0; }
+    
+    void Clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+    
+private:
+    std::vector<T> slots_;
+    size_t head_ = 0;           // Next slot to write
+    size_t size_ = 0;
+};
+
+// Mean and variance of the last capacity values, updated in O(1) per push
+// with Welford's method; a full window replaces the evicted value in one
+// step. Rounding drift is removed by recomputing from the ring every
+// kRecomputeInterval evictions, which is O(1) amortised.
+class RollingStats {
+public:
+    explicit RollingStats(size_t capacity) : values_(capacity) {}
+    
+    void Push(double value) {
+        double evicted;
+        if (!values_.Push(value, &evicted)) {
+            double n = static_cast<double>(values_.GetSize());
+            double delta = value - mean_;
+            mean_ += delta / n;
+            m2_ += delta * (value - mean_);
+            return;
+        }
+        
+        if (++evictions_ == kRecomputeInterval) {
+            Recompute();
+            return;
+        }
+        double n = static_cast<double>(values_.GetSize());
+        double old_mean = mean_;
+        mean_ += (value - evicted) / n;
+        m2_ += (value - evicted) * (value - mean_ + evicted - old_mean);
+        if (m2_ < 0.0) {
+            m2_ = 0.0;
+        }
+    }
+    
+    size_t GetCount() const { return values_.GetSize(); }
+    double GetMean() const { return mean_; }
+    double GetSum() const { return mean_ * static_cast<double>(values_.GetSize()); }
+    
+    // Population variance, as numpy.var
+    double GetVariance() const {
+        return values_.GetSize() > 0 ? m2_ / static_cast<double>(values_.GetSize()) : 0.0;
+    }
+    double GetSampleVariance() const {
+        return values_.GetSize() > 1 ? m2_ / static_cast<double>(values_.GetSize() - 1) : 0.0;
+    }
+    double GetStdDev() const { return std::sqrt(GetVariance()); }
+    
+    const RingBuffer<double>& GetValues() const { return values_; }
+    
+    void Clear() {
+        values_.Clear();
+        mean_ = 0.0;
+        m2_ = 0.0;
+        evictions_ = 0;
+    }
+    
+private:
+    static constexpr uint32_t kRecomputeInterval = 1 << 16;
+    
+    void Recompute() {
+        evictions_ = 0;
+        size_t n = values_.GetSize();
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += values_[i];
+        }
+        mean_ = sum / static_cast<double>(n);
+        m2_ = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double delta = values_[i] - mean_;
+            m2_ += delta * delta;
+        }
+    }
+    
+    RingBuffer<double> values_;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    uint32_t evictions_ = 0;
+};
+
+} // namespace microstructure
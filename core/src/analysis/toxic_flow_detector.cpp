@@ -0,0 +1,163 @@
+#include "toxic_flow_detector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace microstructure {
+
+namespace {
+
+// Factor weights of the Python detector, in ToxicFlowScore::factors order
+constexpr double kFactorWeights[kToxicFactorCount] = {0.25, 0.20, 0.20, 0.15, 0.20};
+
+} // namespace
+
+ToxicFlowDetector::ToxicFlowDetector(size_t symbol_count, const Options& options)
+    : options_(options) {
+    options_.window_size = std::max<size_t>(options_.window_size, 1);
+    symbols_.reserve(symbol_count);
+    for (size_t i = 0; i < symbol_count; ++i) {
+        symbols_.emplace_back(options_.window_size);
+    }
+}
+
+void ToxicFlowDetector::ProcessOrder(uint32_t symbol_id, int64_t timestamp_ns, double quantity, bool is_buy) {
+    SymbolState& state = symbols_[symbol_id];
+    state.timestamp_ns = timestamp_ns;
+    if (std::isnan(quantity)) {
+        return;     // Would break the sorted window's ordering
+    }
+    
+    // Keep the sorted copy in step with the order window
+    std::vector<double>& sorted = state.sorted_sizes;
+    const RingBuffer<double>& sizes = state.order_sizes.GetValues();
+    if (sizes.IsFull()) {
+        sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), sizes[0]));
+    }
+    state.order_sizes.Push(quantity);
+    state.signed_sizes.Push(is_buy ? quantity : -quantity);
+    sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), quantity), quantity);
+}
+
+void ToxicFlowDetector::ProcessCancel(uint32_t symbol_id, int64_t timestamp_ns) {
+    SymbolState& state = symbols_[symbol_id];
+    state.timestamp_ns = timestamp_ns;
+    ++state.cancels;
+}
+
+void ToxicFlowDetector::ProcessTrade(uint32_t symbol_id, int64_t timestamp_ns, double, bool) {
+    // As in the Python detector only the trade count enters the score
+    SymbolState& state = symbols_[symbol_id];
+    state.timestamp_ns = timestamp_ns;
+    ++state.trades;
+}
+
+void ToxicFlowDetector::ProcessBook(uint32_t symbol_id, int64_t timestamp_ns, double price_impact,
+                                    double volatility) {
+    SymbolState& state = symbols_[symbol_id];
+    state.timestamp_ns = timestamp_ns;
+    state.price_impacts.Push(price_impact);
+    state.volatilities.Push(volatility);
+}
+
+size_t ToxicFlowDetector::Apply(const ToxicFlowEvent* events, size_t count) {
+    size_t applied = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const ToxicFlowEvent& event = events[i];
+        if (event.symbol_id >= symbols_.size()) {
+            continue;
+        }
+        switch (event.type) {
+            case kToxicOrder:
+                ProcessOrder(event.symbol_id, event.timestamp_ns, event.quantity, event.is_buy != 0);
+                break;
+            case kToxicCancel:
+                ProcessCancel(event.symbol_id, event.timestamp_ns);
+                break;
+            case kToxicTrade:
+                ProcessTrade(event.symbol_id, event.timestamp_ns, event.quantity, event.is_buy != 0);
+                break;
+            case kToxicBook:
+                ProcessBook(event.symbol_id, event.timestamp_ns, event.price_impact, event.volatility);
+                break;
+            default:
+                continue;
+        }
+        ++applied;
+    }
+    return applied;
+}
+
+bool ToxicFlowDetector::Score(uint32_t symbol_id, ToxicFlowScore* out) const {
+    if (symbol_id >= symbols_.size()) {
+        return false;
+    }
+    const SymbolState& state = symbols_[symbol_id];
+    ToxicFlowScore& score = *out;
+    score = ToxicFlowScore{};
+    score.timestamp_ns = state.timestamp_ns;
+    
+    // The Python detector keeps the last window_size cancels and trades,
+    // so their counts saturate at the window
+    double window = static_cast<double>(options_.window_size);
+    double cancels = std::min(static_cast<double>(state.cancels), window);
+    double trades = std::min(static_cast<double>(state.trades), window);
+    score.cancel_trade_ratio = trades > 0 ? cancels / trades : (cancels > 0 ? 100.0 : 0.0);
+    
+    double total_size = state.order_sizes.GetSum();
+    score.order_flow_imbalance = total_size > 0 ? state.signed_sizes.GetSum() / total_size : 0.0;
+    score.price_impact = state.price_impacts.GetMean();
+    score.volatility = state.volatilities.GetMean();
+    
+    const std::vector<double>& sorted = state.sorted_sizes;
+    double mean_size = state.order_sizes.GetMean();
+    if (!sorted.empty() && mean_size != 0.0) {
+        score.avg_order_size = mean_size;
+        double base = options_.large_order_quantile > 0 ? GetQuantile(sorted, options_.large_order_quantile)
+                                                        : mean_size;
+        auto large = std::upper_bound(sorted.begin(), sorted.end(), options_.large_order_multiple * base);
+        score.large_order_ratio = static_cast<double>(sorted.end() - large) / static_cast<double>(sorted.size());
+    }
+    
+    score.factors[0] = std::min(1.0, score.cancel_trade_ratio / 10.0);
+    score.factors[1] = std::min(1.0, std::fabs(score.order_flow_imbalance));
+    score.factors[2] = std::min(1.0, score.price_impact / 0.0005);
+    score.factors[3] = std::min(1.0, score.volatility / 0.002);
+    score.factors[4] = std::min(1.0, score.large_order_ratio * 2.0);
+    for (size_t i = 0; i < kToxicFactorCount; ++i) {
+        score.score += score.factors[i] * kFactorWeights[i];
+    }
+    score.is_toxic = score.score > options_.threshold;
+    score.confidence = score.is_toxic ? score.score : 1.0 - score.score;
+    return true;
+}
+
+void ToxicFlowDetector::ScoreAll(ToxicFlowScore* out) const {
+    for (size_t i = 0; i < symbols_.size(); ++i) {
+        Score(static_cast<uint32_t>(i), &out[i]);
+    }
+}
+
+double ToxicFlowDetector::GetOrderSizeQuantile(uint32_t symbol_id, double q) const {
+    if (symbol_id >= symbols_.size()) {
+        return 0.0;
+    }
+    return GetQuantile(symbols_[symbol_id].sorted_sizes, q);
+}
+
+double ToxicFlowDetector::GetQuantile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    double rank = std::ceil(std::fmin(std::fmax(q, 0.0), 1.0) * static_cast<double>(sorted.size()));
+    size_t index = rank > 1.0 ? static_cast<size_t>(rank) - 1 : 0;
+    return sorted[index];
+}
+
+void ToxicFlowDetector::Reset(uint32_t symbol_id) {
+    if (symbol_id < symbols_.size()) {
+        symbols_[symbol_id] = SymbolState(options_.window_size);
+    }
+}
+
+} // namespace microstructure
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "rolling_window.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace microstructure {
+
+enum ToxicFlowEventType : uint8_t {
+    kToxicOrder = 1,        // New order: quantity, is_buy, price
+    kToxicCancel = 2,
+    kToxicTrade = 3,        // quantity, is_buy, price
+    kToxicBook = 4          // Book metrics: price_impact, volatility
+};
+
+// One input for ToxicFlowDetector::Apply, routed by symbol_id. Layout
+// matches ob_toxic_event_t in the C ABI.
+struct ToxicFlowEvent {
+    int64_t timestamp_ns;
+    uint32_t symbol_id;
+    uint8_t type;
+    uint8_t is_buy;
+    uint8_t reserved[2];
+    double quantity;
+    double price;
+    double price_impact;
+    double volatility;
+};
+
+constexpr size_t kToxicFactorCount = 5;
+
+// Score and the factors behind it. Layout matches ob_toxic_score_t.
+struct ToxicFlowScore {
+    int64_t timestamp_ns;               // Last event for the symbol
+    double score;                       // Weighted sum of the factor scores
+    double confidence;
+    double cancel_trade_ratio;
+    double order_flow_imbalance;        // Signed volume over the order window
+    double price_impact;                // Window means of the book metrics
+    double volatility;
+    double avg_order_size;
+    double large_order_ratio;           // Orders above the large-order threshold; see Options
+    double factors[kToxicFactorCount];  // Cancel/trade, imbalance, impact, volatility, large orders
+    uint8_t is_toxic;
+    uint8_t reserved[7];
+};
+
+// Native counterpart of the Python ToxicFlowDetector for many symbols.
+// Every window is a fixed-capacity ring with running sums (RollingStats),
+// and order sizes are also kept sorted, so size quantiles and the
+// large-order share are exact binary searches rather than scans. An order
+// shifts at most window_size sizes, other events cost O(1), and a score
+// O(log window), so a whole universe can be rescored every tick. Scores
+// use the Python factor definitions, weights and 0.6 threshold.
+class ToxicFlowDetector {
+public:
+    struct Options {
+        size_t window_size = 100;
+        
+        // Large orders exceed large_order_multiple x the mean size, as in the
+        // Python detector, or x the order size quantile when
+        // large_order_quantile is in (0, 1], e.g. 0.5 for the median
+        double large_order_multiple = 2.0;
+        double large_order_quantile = 0.0;
+        
+        double threshold = 0.6;             // Toxic above this score; 0 flags any positive score
+    };
+    
+    ToxicFlowDetector(size_t symbol_count, const Options& options);
+    
+    void ProcessOrder(uint32_t symbol_id, int64_t timestamp_ns, double quantity, bool is_buy);
+    void ProcessCancel(uint32_t symbol_id, int64_t timestamp_ns);
+    void ProcessTrade(uint32_t symbol_id, int64_t timestamp_ns, double quantity, bool is_buy);
+    void ProcessBook(uint32_t symbol_id, int64_t timestamp_ns, double price_impact, double volatility);
+    
+    // Apply a batch across symbols in order; events for an unknown symbol
+    // or of an unknown type are skipped. Returns the number applied.
+    size_t Apply(const ToxicFlowEvent* events, size_t count);
+    
+    // False for an unknown symbol. ScoreAll fills out[symbol_id] for every symbol.
+    bool Score(uint32_t symbol_id, ToxicFlowScore* out) const;
+    void ScoreAll(ToxicFlowScore* out) const;
+    
+    // Order size at quantile q in [0, 1] over the order window, the
+    // nearest-rank value; 0 before any order
+    double GetOrderSizeQuantile(uint32_t symbol_id, double q) const;
+    
+    size_t GetSymbolCount() const { return symbols_.size(); }
+    void Reset(uint32_t symbol_id);
+    
+private:
+    struct SymbolState {
+        explicit SymbolState(size_t window)
+            : order_sizes(window), signed_sizes(window), price_impacts(window), volatilities(window) {
+            sorted_sizes.reserve(window);
+        }
+        
+        RollingStats order_sizes;
+        RollingStats signed_sizes;      // +quantity for buys, -quantity for sells
+        RollingStats price_impacts;
+        RollingStats volatilities;
+        std::vector<double> sorted_sizes;   // The order window, ascending
+        uint64_t cancels = 0;
+        uint64_t trades = 0;
+        int64_t timestamp_ns = 0;
+    };
+    
+    static double GetQuantile(const std::vector<double>& sorted, double q);
+    
+    Options options_;
+    std::vector<SymbolState> symbols_;
+};
+
+} // namespace microstructure
@@ -0,0 +1,192 @@
+#include "vpin_calculator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace microstructure {
+
+VpinCalculator::VpinCalculator(size_t symbol_count, const Options& options)
+    : options_(options) {
+    if (!(options_.bucket_volume > 0)) {
+        options_.bucket_volume = Options{}.bucket_volume;
+    }
+    options_.window_buckets = std::max<size_t>(options_.window_buckets, 1);
+    symbols_.reserve(symbol_count);
+    for (size_t i = 0; i < symbol_count; ++i) {
+        symbols_.emplace_back(options_.bucket_volume, options_.window_buckets);
+    }
+}
+
+void VpinCalculator::ProcessTrade(uint32_t symbol_id, int64_t timestamp_ns, double price, double quantity,
+                                  uint8_t side) {
+    if (!(quantity > 0)) {
+        return;
+    }
+    SymbolState& state = symbols_[symbol_id];
+    state.timestamp_ns = timestamp_ns;
+    double share = GetBuyShare(state, price, side);
+    if (state.last_close == 0.0) {
+        state.last_close = price;
+    }
+    
+    // Top up the open bucket; a print may close it and spill over
+    double bucket = state.bucket_volume;
+    double tolerance = bucket * 1e-9;
+    double take = std::min(quantity, bucket - state.filled);
+    state.filled += take;
+    state.buy_volume += take * share;
+    double remaining = quantity - take;
+    if (state.filled >= bucket - tolerance) {
+        // Bulk classification splits a bucket by its price change. One print
+        // is one price change, so every bucket it closes takes the share of
+        // that change and only one return is recorded.
+        if (options_.classification == kVpinBulkVolume) {
+            share = GetBulkShare(state, price);
+            state.buy_volume = share * bucket;
+        }
+        CloseBucket(state, state.buy_volume);
+        
+        // Whole buckets inside one print classify alike, and only the last
+        // window_buckets of them can still be in the window
+        double whole = std::floor((remaining + tolerance) / bucket);
+        double closes = std::min(whole, static_cast<double>(options_.window_buckets));
+        for (double i = 0; i < closes; ++i) {
+            CloseBucket(state, bucket * share);
+        }
+        state.buckets += static_cast<uint64_t>(whole - closes);
+        remaining = std::max(remaining - whole * bucket, 0.0);
+        state.filled = remaining;
+        state.buy_volume = remaining * share;
+    }
+    state.last_price = price;
+}
+
+double VpinCalculator::GetBuyShare(SymbolState& state, double price, uint8_t side) const {
+    if (state.last_price > 0 && price != state.last_price) {
+        state.last_tick = price > state.last_price ? 1 : -1;
+    }
+    if (options_.classification == kVpinAggressor && side != kVpinSideUnknown) {
+        return side == kVpinSideBuy ? 1.0 : 0.0;
+    }
+    // Before the first price change the direction is unknown; split evenly
+    return state.last_tick > 0 ? 1.0 : (state.last_tick < 0 ? 0.0 : 0.5);
+}
+
+double VpinCalculator::GetBulkShare(SymbolState& state, double price) const {
+    // Buy share is Phi(dP / sigma) over the change since the last close,
+    // with sigma from the preceding returns. Without two returns there is
+    // no sigma and the split is even; a flat history leaves the sign.
+    double change = price - state.last_close;
+    double share = 0.5;
+    if (state.bucket_returns.GetCount() >= 2) {
+        double sigma = std::sqrt(state.bucket_returns.GetSampleVariance());
+        if (sigma > 0) {
+            share = 0.5 * std::erfc(-change / (sigma * std::sqrt(2.0)));
+        } else {
+            share = change > 0 ? 1.0 : (change < 0 ? 0.0 : 0.5);
+        }
+    }
+    state.bucket_returns.Push(change);
+    state.last_close = price;
+    return share;
+}
+
+void VpinCalculator::CloseBucket(SymbolState& state, double buy_volume) {
+    double bucket = state.bucket_volume;
+    state.imbalances.Push(std::fabs(2.0 * buy_volume - bucket) / bucket);
+    ++state.buckets;
+}
+
+size_t VpinCalculator::Apply(const VpinTrade* trades, size_t count) {
+    size_t applied = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const VpinTrade& trade = trades[i];
+        if (trade.symbol_id >= symbols_.size() || !(trade.quantity > 0)) {
+            continue;
+        }
+        ProcessTrade(trade.symbol_id, trade.timestamp_ns, trade.price, trade.quantity, trade.side);
+        ++applied;
+    }
+    return applied;
+}
+
+size_t VpinCalculator::UpdateFromBook(uint32_t symbol_id, const LimitOrderBook& book) {
+    if (symbol_id >= symbols_.size()) {
+        return 0;
+    }
+    SymbolState& state = symbols_[symbol_id];
+    const TradeTape& tape = book.GetTradeTape();
+    uint64_t total = tape.GetTotalCount();
+    // A different book restarts the count; so does a new one allocated
+    // where a destroyed book was, once its tape is behind the old one
+    bool same_book = &book == state.tape_book && total >= state.tape_count;
+    uint64_t fresh = same_book ? total - state.tape_count : total;
+    state.tape_book = &book;
+    state.tape_count = total;
+    
+    size_t consumed = 0;
+    tape.ForEachRecent(static_cast<size_t>(fresh), [&](const Trade& trade) {
+        // The tape records the resting side; the aggressor took the other
+        ProcessTrade(symbol_id, trade.timestamp_ns, trade.price, trade.quantity,
+                     trade.is_buy ? kVpinSideSell : kVpinSideBuy);
+        ++consumed;
+    });
+    return consumed;
+}
+
+bool VpinCalculator::GetState(uint32_t symbol_id, VpinState* out) const {
+    if (symbol_id >= symbols_.size()) {
+        return false;
+    }
+    const SymbolState& state = symbols_[symbol_id];
+    out->timestamp_ns = state.timestamp_ns;
+    out->vpin = state.imbalances.GetMean();
+    out->bucket_fill = state.filled / state.bucket_volume;
+    out->last_imbalance = state.imbalances.GetCount() > 0 ? state.imbalances.GetValues().Back() : 0.0;
+    out->buckets = state.buckets;
+    return true;
+}
+
+void VpinCalculator::GetAllStates(VpinState* out) const {
+    for (size_t i = 0; i < symbols_.size(); ++i) {
+        GetState(static_cast<uint32_t>(i), &out[i]);
+    }
+}
+
+bool VpinCalculator::SetBucketVolume(uint32_t symbol_id, double bucket_volume) {
+    if (symbol_id >= symbols_.size() || !(bucket_volume > 0)) {
+        return false;
+    }
+    symbols_[symbol_id].bucket_volume = bucket_volume;
+    Reset(symbol_id);
+    return true;
+}
+
+void VpinCalculator::Reset(uint32_t symbol_id) {
+    if (symbol_id >= symbols_.size()) {
+        return;
+    }
+    // Keep the bucket size and the tape position, so old executions are
+    // not consumed again
+    SymbolState& state = symbols_[symbol_id];
+    SymbolState fresh(state.bucket_volume, options_.window_buckets);
+    fresh.tape_book = state.tape_book;
+    fresh.tape_count = state.tape_count;
+    state = fresh;
+}
+
+uint64_t VpinCalculator::ComputeHistorical(const double* prices, const double* quantities, const uint8_t* sides,
+                                           size_t count, const Options& options, double* vpin_out) {
+    VpinCalculator calculator(1, options);
+    const SymbolState& state = calculator.symbols_[0];
+    size_t window = calculator.options_.window_buckets;
+    for (size_t i = 0; i < count; ++i) {
+        calculator.ProcessTrade(0, 0, prices[i], quantities[i], sides ? sides[i] : static_cast<uint8_t>(kVpinSideUnknown));
+        vpin_out[i] = state.buckets >= window ? state.imbalances.GetMean()
+                                              : std::numeric_limits<double>::quiet_NaN();
+    }
+    return state.buckets;
+}
+
+} // namespace microstructure
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "limit_order_book.h"
+#include "rolling_window.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace microstructure {
+
+enum VpinClassification : uint8_t {
+    kVpinTickRule = 0,          // Up/down tick against the last different price
+    kVpinBulkVolume = 1,        // Bucket volume split by Phi(price change / sigma)
+    kVpinAggressor = 2          // Reported aggressor side, tick rule when unknown
+};
+
+enum VpinSide : uint8_t {
+    kVpinSideUnknown = 0,
+    kVpinSideBuy = 1,
+    kVpinSideSell = 2
+};
+
+// One trade print for VpinCalculator::Apply, routed by symbol_id. side is
+// the aggressor when known. Layout matches ob_vpin_trade_t in the C ABI.
+struct VpinTrade {
+    int64_t timestamp_ns;
+    uint32_t symbol_id;
+    uint8_t side;
+    uint8_t reserved[3];
+    double price;
+    double quantity;
+};
+
+// Layout matches ob_vpin_state_t
+struct VpinState {
+    int64_t timestamp_ns;           // Last trade for the symbol
+    double vpin;                    // Mean bucket imbalance over the window; 0 before any bucket
+    double bucket_fill;             // Share of the open bucket already filled
+    double last_imbalance;          // |buy - sell| / bucket_volume of the last closed bucket
+    uint64_t buckets;               // Buckets closed so far; the window is full at window_buckets
+};
+
+// Volume-synchronised probability of informed trading (Easley, Lopez de
+// Prado and O'Hara) for many symbols. Trades fill fixed-volume buckets,
+// split across bucket boundaries; each closed bucket contributes
+// |buy - sell| / bucket_volume to a rolling window of window_buckets, and
+// VPIN is its mean. A trade costs O(1): it touches the open bucket, and a
+// print spanning many buckets closes at most window_buckets of them, since
+// older ones would leave the window anyway.
+class VpinCalculator {
+public:
+    struct Options {
+        double bucket_volume = 10000.0;     // Default for every symbol; see SetBucketVolume
+        size_t window_buckets = 50;
+        VpinClassification classification = kVpinBulkVolume;
+    };
+    
+    VpinCalculator(size_t symbol_count, const Options& options);
+    
+    void ProcessTrade(uint32_t symbol_id, int64_t timestamp_ns, double price, double quantity,
+                      uint8_t side = kVpinSideUnknown);
+    
+    // Apply a batch across symbols in order; trades for an unknown symbol
+    // or without a positive quantity are skipped. Returns the number applied.
+    size_t Apply(const VpinTrade* trades, size_t count);
+    
+    // Consume the executions recorded on book's trade tape since the last
+    // call for this symbol, with the aggressor opposite the resting order.
+    // Executions that have already left the tape are not seen, and a book
+    // other than the last one is read from its start. Returns the number
+    // consumed.
+    size_t UpdateFromBook(uint32_t symbol_id, const LimitOrderBook& book);
+    
+    // False for an unknown symbol. GetAllStates fills out[symbol_id] for every symbol.
+    bool GetState(uint32_t symbol_id, VpinState* out) const;
+    void GetAllStates(VpinState* out) const;
+    
+    // Per-symbol bucket size, typically a fraction of daily volume. Resets
+    // the symbol, since buckets of different sizes do not mix.
+    bool SetBucketVolume(uint32_t symbol_id, double bucket_volume);
+    
+    size_t GetSymbolCount() const { return symbols_.size(); }
+    void Reset(uint32_t symbol_id);
+    
+    // Whole-day mode: run one symbol's trades through a fresh calculator and
+    // write the VPIN after each trade to vpin_out, NaN until window_buckets
+    // buckets have closed. sides may be null. Returns the buckets closed.
+    static uint64_t ComputeHistorical(const double* prices, const double* quantities, const uint8_t* sides,
+                                      size_t count, const Options& options, double* vpin_out);
+    
+private:
+    struct SymbolState {
+        SymbolState(double bucket, size_t window)
+            : bucket_volume(bucket), imbalances(window), bucket_returns(window) {}
+        
+        double bucket_volume;
+        RollingStats imbalances;        // Closed bucket |buy - sell| / bucket_volume
+        RollingStats bucket_returns;    // Close-to-close price changes, one per closing print (bulk)
+        double filled = 0.0;            // Volume in the open bucket
+        double buy_volume = 0.0;        // Of which classified as buys (tick rule and aggressor)
+        double last_price = 0.0;
+        double last_close = 0.0;        // Price at which the previous bucket closed
+        int8_t last_tick = 0;           // Direction of the last price change
+        uint64_t buckets = 0;
+        const LimitOrderBook* tape_book = nullptr;  // Book whose tape UpdateFromBook last read
+        uint64_t tape_count = 0;        // Position consumed on that tape
+        int64_t timestamp_ns = 0;
+    };
+    
+    // Share of a trade classified as buying, for the per-trade rules
+    double GetBuyShare(SymbolState& state, double price, uint8_t side) const;
+    
+    // Bulk buy share of the buckets closed at price; records the return
+    double GetBulkShare(SymbolState& state, double price) const;
+    void CloseBucket(SymbolState& state, double buy_volume);
+    
+    Options options_;
+    std::vector<SymbolState> symbols_;
+};
+
+} // namespace microstructure
@@ -95,6 +95,22 @@ class MarketDataLoader:
         
         return df
         
+    def replay_order_events(self, order_book_interface, symbols: List[str], date: str,
+                          **options) -> Dict:
+        """Stream the day's binary order events into the interface's books.
+        
+        Unlike the loaders above, the file is never held in memory: native
+        code reads ahead, decompresses and applies in overlapping stages.
+        Message locates index symbols; options go to replay_event_file.
+        """
+        date_obj = pd.to_datetime(date).strftime("%Y%m%d")
+        filename = f"{self.data_dir}/events/events_{date_obj}.bin.gz"
+        
+        if not os.path.exists(filename):
+            raise FileNotFoundError(f"Order event file not found: {filename}")
+            
+        return order_book_interface.replay_event_file(filename, symbols, **options)
+        
     def generate_synthetic_data(self, symbol: str, start_date: str, end_date: str, 
                               timeframe: str = "1min", include_orderbook: bool = False) -> Dict:
         start = pd.to_datetime(start_date)
@@ -1,6 +1,564 @@
 import ctypes
-from typing import List, Dict, Tuple, Optional
+import time
+from typing import List, Dict, Tuple, Optional, Sequence
 
+import numpy as np
+
+from core.src.analysis.microstructure_metrics import MarketMetrics
+
+# Event types accepted by apply_events (mirror order_book_api.h)
+EVENT_ADD = 1
+EVENT_MODIFY = 2
+EVENT_CANCEL = 3
+EVENT_REPLACE = 4
+EVENT_EXECUTE = 5
+
+# Read backends for replay_event_file (mirror order_book_api.h)
+READ_BACKENDS = {"auto": 0, "io_uring": 1, "thread_pool": 2}
+
+# Indexes match OB_STAGE_*
+PIPELINE_STAGES = ("decode", "queue_wait", "apply", "metrics", "publish")
+
+# Metric names of NativeMicrostructureAnalyzer rows, in append order
+ANALYZER_METRICS = ("mid_price", "spread", "order_imbalance", "price_impact", "realized_volatility")
+
+# Event types of NativeToxicFlowDetector.process_events (mirror OB_TOXIC_*)
+TOXIC_ORDER = 1
+TOXIC_CANCEL = 2
+TOXIC_TRADE = 3
+TOXIC_BOOK = 4
+
+# Factor names of the Python ToxicFlowDetector, in ob_toxic_score_t order
+TOXIC_FACTORS = ("Cancel/Trade Ratio", "Order Imbalance", "Price Impact", "Recent Volatility", "Large Orders")
+
+# Volume classification rules of NativeVpinCalculator (mirror OB_VPIN_*)
+VPIN_TICK_RULE = 0
+VPIN_BULK_VOLUME = 1
+VPIN_AGGRESSOR = 2
+
+# Aggressor sides of VPIN_TRADE_DTYPE
+VPIN_SIDE_UNKNOWN = 0
+VPIN_SIDE_BUY = 1
+VPIN_SIDE_SELL = 2
+
+# Mirrors ob_vpin_trade_t
+VPIN_TRADE_DTYPE = np.dtype([
+    ("timestamp_ns", "<i8"),
+    ("symbol_id", "<u4"),
+    ("side", "u1"),
+    ("reserved", "u1", (3,)),
+    ("price", "<f8"),
+    ("quantity", "<f8"),
+])
+
+# Mirrors ob_vpin_state_t
+VPIN_STATE_DTYPE = np.dtype([
+    ("timestamp_ns", "<i8"),
+    ("vpin", "<f8"),
+    ("bucket_fill", "<f8"),
+    ("last_imbalance", "<f8"),
+    ("buckets", "<u8"),
+])
+
+# Mirrors ob_toxic_event_t
+TOXIC_EVENT_DTYPE = np.dtype([
+    ("timestamp_ns", "<i8"),
+    ("symbol_id", "<u4"),
+    ("type", "u1"),
+    ("is_buy", "u1"),
+    ("reserved", "u1", (2,)),
+    ("quantity", "<f8"),
+    ("price", "<f8"),
+    ("price_impact", "<f8"),
+    ("volatility", "<f8"),
+])
+
+# Mirrors ob_toxic_score_t
+TOXIC_SCORE_DTYPE = np.dtype([
+    ("timestamp_ns", "<i8"),
+    ("score", "<f8"),
+    ("confidence", "<f8"),
+    ("cancel_trade_ratio", "<f8"),
+    ("order_flow_imbalance", "<f8"),
+    ("price_impact", "<f8"),
+    ("volatility", "<f8"),
+    ("avg_order_size", "<f8"),
+    ("large_order_ratio", "<f8"),
+    ("factors", "<f8", (5,)),
+    ("is_toxic", "u1"),
+    ("reserved", "u1", (7,)),
+])
+
+class OrderEvent(ctypes.Structure):
+    """Packed order event with a numeric order ID (ob_event_t)"""
+    _fields_ = [
+        ("timestamp_ns", ctypes.c_int64),
+        ("order_id", ctypes.c_uint64),
+        ("price", ctypes.c_double),
+        ("quantity", ctypes.c_double),
+        ("type", ctypes.c_uint8),
+        ("is_buy", ctypes.c_uint8),
+        ("reserved", ctypes.c_uint8 * 6),
+    ]
+
+class BookSnapshot(ctypes.Structure):
+    """Scalar part of a native snapshot (ob_snapshot_t)"""
+    _fields_ = [
+        ("timestamp_ns", ctypes.c_int64),
+        ("best_bid", ctypes.c_double),
+        ("best_ask", ctypes.c_double),
+        ("mid_price", ctypes.c_double),
+        ("spread", ctypes.c_double),
+        ("order_imbalance", ctypes.c_double),
+        ("bid_count", ctypes.c_int32),
+        ("ask_count", ctypes.c_int32),
+    ]
+
+class EventColumns(ctypes.Structure):
+    """Pointers to columnar event arrays (ob_event_columns_t)"""
+    _fields_ = [
+        ("timestamp_ns", ctypes.c_void_p),
+        ("type", ctypes.c_void_p),
+        ("order_id", ctypes.c_void_p),
+        ("price", ctypes.c_void_p),
+        ("quantity", ctypes.c_void_p),
+        ("is_buy", ctypes.c_void_p),
+        ("book_index", ctypes.c_void_p),
+    ]
+
+class DerivedColumns(ctypes.Structure):
+    """Pointers to per-event output arrays (ob_derived_columns_t)"""
+    _fields_ = [
+        ("best_bid", ctypes.c_void_p),
+        ("best_ask", ctypes.c_void_p),
+        ("mid_price", ctypes.c_void_p),
+        ("order_imbalance", ctypes.c_void_p),
+        ("imbalance_levels", ctypes.c_int32),
+    ]
+
+class ReplayOptions(ctypes.Structure):
+    """Capture replay settings (ob_replay_options_t)"""
+    _fields_ = [
+        ("speed", ctypes.c_double),
+        ("udp_port", ctypes.c_uint16),
+        ("sequenced", ctypes.c_bool),
+    ]
+
+class ReplayStats(ctypes.Structure):
+    """Capture replay results (ob_replay_stats_t)"""
+    _fields_ = [
+        ("packets", ctypes.c_uint64),
+        ("messages", ctypes.c_uint64),
+        ("bytes", ctypes.c_uint64),
+        ("gaps", ctypes.c_uint64),
+        ("duplicates", ctypes.c_uint64),
+        ("skipped_records", ctypes.c_uint64),
+        ("elapsed_seconds", ctypes.c_double),
+        ("capture_seconds", ctypes.c_double),
+        ("latency_mean_ns", ctypes.c_double),
+        ("latency_p50_ns", ctypes.c_uint64),
+        ("latency_p99_ns", ctypes.c_uint64),
+        ("latency_p999_ns", ctypes.c_uint64),
+        ("latency_max_ns", ctypes.c_uint64),
+        ("lag_p99_ns", ctypes.c_uint64),
+        ("lag_max_ns", ctypes.c_uint64),
+    ]
+
+class EventFileOptions(ctypes.Structure):
+    """Event file replay settings (ob_event_file_options_t)"""
+    _fields_ = [
+        ("chunk_size", ctypes.c_size_t),
+        ("queue_depth", ctypes.c_size_t),
+        ("threads", ctypes.c_size_t),
+        ("block_size", ctypes.c_size_t),
+        ("backend", ctypes.c_int32),
+    ]
+
+class EventFileStats(ctypes.Structure):
+    """Event file replay results (ob_event_file_stats_t)"""
+    _fields_ = [
+        ("bytes_read", ctypes.c_uint64),
+        ("bytes_decompressed", ctypes.c_uint64),
+        ("messages", ctypes.c_uint64),
+        ("skipped", ctypes.c_uint64),
+        ("malformed", ctypes.c_uint64),
+        ("truncated_bytes", ctypes.c_uint64),
+        ("compressed", ctypes.c_bool),
+        ("backend", ctypes.c_int32),
+        ("elapsed_seconds", ctypes.c_double),
+        ("read_wait_seconds", ctypes.c_double),
+        ("decompress_seconds", ctypes.c_double),
+        ("apply_seconds", ctypes.c_double),
+        ("apply_wait_seconds", ctypes.c_double),
+    ]
+
+class StageLatency(ctypes.Structure):
+    """Latency summary of one pipeline stage in ns (ob_stage_latency_t)"""
+    _fields_ = [
+        ("count", ctypes.c_uint64),
+        ("mean_ns", ctypes.c_double),
+        ("min_ns", ctypes.c_uint64),
+        ("p50_ns", ctypes.c_uint64),
+        ("p90_ns", ctypes.c_uint64),
+        ("p99_ns", ctypes.c_uint64),
+        ("p999_ns", ctypes.c_uint64),
+        ("max_ns", ctypes.c_uint64),
+    ]
+
+class DecodeStats(ctypes.Structure):
+    """Binary feed decode counters (ob_decode_stats_t)"""
+    _fields_ = [
+        ("messages", ctypes.c_uint64),
+        ("skipped", ctypes.c_uint64),
+        ("malformed", ctypes.c_uint64),
+    ]
+
+class ArrowSchema(ctypes.Structure):
+    """Arrow C Data Interface schema, filled by the export functions"""
+    _fields_ = [
+        ("format", ctypes.c_char_p),
+        ("name", ctypes.c_char_p),
+        ("metadata", ctypes.c_char_p),
+        ("flags", ctypes.c_int64),
+        ("n_children", ctypes.c_int64),
+        ("children", ctypes.c_void_p),
+        ("dictionary", ctypes.c_void_p),
+        ("release", ctypes.c_void_p),
+        ("private_data", ctypes.c_void_p),
+    ]
+
+class ArrowArray(ctypes.Structure):
+    """Arrow C Data Interface array, filled by the export functions"""
+    _fields_ = [
+        ("length", ctypes.c_int64),
+        ("null_count", ctypes.c_int64),
+        ("offset", ctypes.c_int64),
+        ("n_buffers", ctypes.c_int64),
+        ("n_children", ctypes.c_int64),
+        ("buffers", ctypes.c_void_p),
+        ("children", ctypes.c_void_p),
+        ("dictionary", ctypes.c_void_p),
+        ("release", ctypes.c_void_p),
+        ("private_data", ctypes.c_void_p),
+    ]
+
+def _import_record_batch(array: ArrowArray, schema: ArrowSchema):
+    """Hand exported structs to pyarrow, which takes ownership of the buffers"""
+    import pyarrow as pa
+    return pa.RecordBatch._import_from_c(ctypes.addressof(array), ctypes.addressof(schema))
+
+class MetricBatch:
+    def __init__(self, lib, metric_names: Sequence[str]):
+        """Native accumulator of metric rows exported as Arrow record batches"""
+        self.lib = lib
+        self.metric_names = list(metric_names)
+        names = (ctypes.c_char_p * len(self.metric_names))(*[n.encode('utf-8') for n in self.metric_names])
+        self._values = (ctypes.c_double * len(self.metric_names))()
+        self._handle = lib.create_metric_batch(names, len(self.metric_names))
+        
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            self.lib.destroy_metric_batch(self._handle)
+            self._handle = None
+            
+    def append(self, timestamp_ns: int, symbol_id: int, values: Sequence[float]) -> None:
+        """Add one row; values follow the order of metric_names"""
+        self._values[:] = values
+        self.lib.append_metric_row(self._handle, timestamp_ns, symbol_id, self._values)
+        
+    def __len__(self) -> int:
+        return self.lib.get_metric_batch_rows(self._handle)
+        
+    def export(self):
+        """Move the accumulated rows into a pyarrow.RecordBatch"""
+        array, schema = ArrowArray(), ArrowSchema()
+        self.lib.export_metric_batch(self._handle, ctypes.byref(array), ctypes.byref(schema))
+        return _import_record_batch(array, schema)
+
+class MicrostructureMetrics(ctypes.Structure):
+    """Latest analyzer output (ob_microstructure_metrics_t)"""
+    _fields_ = [
+        ("timestamp_ns", ctypes.c_int64),
+        ("mid_price", ctypes.c_double),
+        ("spread", ctypes.c_double),
+        ("order_imbalance", ctypes.c_double),
+        ("price_impact", ctypes.c_double),
+        ("realized_volatility", ctypes.c_double),
+    ]
+
+class NativeMicrostructureAnalyzer:
+    def __init__(self, lib, symbol: str, book_handle, window_size: int = 100,
+                 imbalance_levels: int = 5, impact_size: float = 100.0):
+        """Streaming MicrostructureAnalyzer for one native book; each update
+        is O(1) in window_size"""
+        self.lib = lib
+        self.symbol = symbol
+        self._book = book_handle
+        self._metrics = MicrostructureMetrics()
+        self._handle = lib.create_microstructure_analyzer(window_size, imbalance_levels, impact_size)
+        
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            self.lib.destroy_microstructure_analyzer(self._handle)
+            self._handle = None
+            
+    def update(self, timestamp_ns: Optional[int] = None) -> MarketMetrics:
+        """Recompute the metrics from the book's current state"""
+        if timestamp_ns is None:
+            timestamp_ns = time.time_ns()
+        self.lib.update_microstructure_analyzer(self._handle, self._book, timestamp_ns,
+                                                ctypes.byref(self._metrics))
+        m = self._metrics
+        return MarketMetrics(symbol=self.symbol, timestamp=m.timestamp_ns, mid_price=m.mid_price,
+                             spread=m.spread, order_imbalance=m.order_imbalance,
+                             price_impact=m.price_impact, realized_volatility=m.realized_volatility)
+        
+    def append_to(self, batch: MetricBatch, symbol_id: int) -> None:
+        """Add the latest metrics as a row of a batch created with ANALYZER_METRICS"""
+        if not self.lib.append_analyzer_metrics(self._handle, batch._handle, symbol_id):
+            raise ValueError("Metric batch columns must be ANALYZER_METRICS")
+            
+    def reset(self) -> None:
+        """Forget the volatility and rolling windows"""
+        self.lib.reset_microstructure_analyzer(self._handle)
+        
+class NativeToxicFlowDetector:
+    def __init__(self, lib, symbols: Sequence[str], window_size: int = 100,
+                 large_order_multiple: float = 2.0, threshold: float = 0.6,
+                 large_order_quantile: float = 0.0):
+        """Native multi-symbol ToxicFlowDetector. The process_* methods
+        mirror the Python detector; process_events and score_all handle a
+        whole universe per call. Scores reflect the latest events whenever
+        they are read.
+        
+        Large orders exceed large_order_multiple times the mean order size,
+        as in the Python detector, or times the large_order_quantile order
+        size when that is in (0, 1]. threshold 0 flags any positive score;
+        a negative threshold selects the default 0.6."""
+        self.lib = lib
+        self.symbols = list(symbols)
+        self.symbol_index = {symbol: i for i, symbol in enumerate(self.symbols)}
+        self._event = np.zeros(1, dtype=TOXIC_EVENT_DTYPE)
+        self._score = np.zeros(1, dtype=TOXIC_SCORE_DTYPE)
+        self._handle = lib.create_toxic_flow_detector(len(self.symbols), window_size, large_order_multiple,
+                                                      large_order_quantile, threshold)
+        
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            self.lib.destroy_toxic_flow_detector(self._handle)
+            self._handle = None
+            
+    def process_events(self, events: np.ndarray) -> int:
+        """Apply a TOXIC_EVENT_DTYPE array across symbols; returns the number applied"""
+        events = np.ascontiguousarray(events, dtype=TOXIC_EVENT_DTYPE)
+        return self.lib.apply_toxic_flow_events(self._handle, events.ctypes.data, len(events))
+        
+    def _process_one(self, symbol: str, timestamp: int, event_type: int, quantity: float = 0.0,
+                     is_buy: bool = False, price: float = 0.0, price_impact: float = 0.0,
+                     volatility: float = 0.0) -> None:
+        event = self._event[0]
+        event["timestamp_ns"] = timestamp
+        event["symbol_id"] = self.symbol_index[symbol]
+        event["type"] = event_type
+        event["is_buy"] = bool(is_buy)
+        event["quantity"] = quantity
+        event["price"] = price
+        event["price_impact"] = price_impact
+        event["volatility"] = volatility
+        self.process_events(self._event)
+        
+    def process_order(self, symbol: str, timestamp: int, order_id: str, order_type: str,
+                      quantity: float, is_buy: bool, price: float) -> None:
+        self._process_one(symbol, timestamp, TOXIC_ORDER, quantity, is_buy, price)
+        
+    def process_cancel(self, symbol: str, timestamp: int, order_id: str) -> None:
+        self._process_one(symbol, timestamp, TOXIC_CANCEL)
+        
+    def process_trade(self, symbol: str, timestamp: int, trade_id: str, price: float,
+                      quantity: float, is_buy: bool) -> None:
+        self._process_one(symbol, timestamp, TOXIC_TRADE, quantity, is_buy, price)
+        
+    def process_order_book(self, symbol: str, timestamp: int, order_imbalance: float,
+                           mid_price: float, price_impact: float, volatility: float) -> None:
+        self._process_one(symbol, timestamp, TOXIC_BOOK, price_impact=price_impact, volatility=volatility)
+        
+    def score_all(self) -> np.ndarray:
+        """Current scores of every symbol as a TOXIC_SCORE_DTYPE array indexed like self.symbols"""
+        scores = np.zeros(len(self.symbols), dtype=TOXIC_SCORE_DTYPE)
+        self.lib.score_all_toxic_flow(self._handle, scores.ctypes.data)
+        return scores
+        
+    def get_order_size_quantile(self, symbol: str, q: float) -> float:
+        """Order size at quantile q over the symbol's order window"""
+        return self.lib.get_toxic_order_size_quantile(self._handle, self.symbol_index[symbol], q)
+        
+    def get_toxic_flow_status(self, symbol: str) -> Dict:
+        """Same shape as ToxicFlowDetector.get_toxic_flow_status"""
+        self.lib.score_toxic_flow(self._handle, self.symbol_index[symbol], self._score.ctypes.data)
+        score = self._score[0]
+        return {
+            "symbol": symbol,
+            "is_toxic": bool(score["is_toxic"]),
+            "confidence": float(score["confidence"]),
+            "timestamp": int(score["timestamp_ns"]),
+            "factors": [{"name": name, "contribution": float(value)}
+                        for name, value in zip(TOXIC_FACTORS, score["factors"])]
+        }
+        
+class NativeVpinCalculator:
+    def __init__(self, lib, symbols: Sequence[str], bucket_volume: float = 10000.0,
+                 window_buckets: int = 50, classification: int = VPIN_BULK_VOLUME, get_book_handle=None):
+        """VPIN over volume buckets for a fixed universe of symbols. Trades
+        are fed one at a time, as VPIN_TRADE_DTYPE batches or from a book's
+        executions; each costs O(1)."""
+        self.lib = lib
+        self.symbols = list(symbols)
+        self.symbol_index = {symbol: i for i, symbol in enumerate(self.symbols)}
+        self.window_buckets = window_buckets
+        self._get_book_handle = get_book_handle
+        self._trade = np.zeros(1, dtype=VPIN_TRADE_DTYPE)
+        self._state = np.zeros(1, dtype=VPIN_STATE_DTYPE)
+        self._handle = lib.create_vpin_calculator(len(self.symbols), bucket_volume, window_buckets,
+                                                  classification)
+        
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            self.lib.destroy_vpin_calculator(self._handle)
+            self._handle = None
+            
+    def process_trades(self, trades: np.ndarray) -> int:
+        """Apply a VPIN_TRADE_DTYPE array across symbols; returns the number applied"""
+        trades = np.ascontiguousarray(trades, dtype=VPIN_TRADE_DTYPE)
+        return self.lib.apply_vpin_trades(self._handle, trades.ctypes.data, len(trades))
+        
+    def process_trade(self, symbol: str, timestamp: int, price: float, quantity: float,
+                      is_buy: Optional[bool] = None) -> None:
+        """is_buy is the aggressor side when known"""
+        trade = self._trade[0]
+        trade["timestamp_ns"] = timestamp
+        trade["symbol_id"] = self.symbol_index[symbol]
+        trade["side"] = VPIN_SIDE_UNKNOWN if is_buy is None else (VPIN_SIDE_BUY if is_buy else VPIN_SIDE_SELL)
+        trade["price"] = price
+        trade["quantity"] = quantity
+        self.process_trades(self._trade)
+        
+    def update_from_book(self, symbol: str) -> int:
+        """Consume the executions on symbol's book since the last call; returns how many"""
+        return self.lib.update_vpin_from_book(self._handle, self.symbol_index[symbol],
+                                              self._get_book_handle(symbol))
+        
+    def set_bucket_volume(self, symbol: str, bucket_volume: float) -> None:
+        """Per-symbol bucket size; forgets the symbol's buckets"""
+        if not self.lib.set_vpin_bucket_volume(self._handle, self.symbol_index[symbol], bucket_volume):
+            raise ValueError(f"Invalid bucket volume {bucket_volume}")
+            
+    def get_state(self, symbol: str) -> Dict:
+        self.lib.get_vpin_state(self._handle, self.symbol_index[symbol], self._state.ctypes.data)
+        state = self._state[0]
+        return {
+            "symbol": symbol,
+            "vpin": float(state["vpin"]),
+            "buckets": int(state["buckets"]),
+            "is_warm": int(state["buckets"]) >= self.window_buckets,
+            "bucket_fill": float(state["bucket_fill"]),
+            "last_imbalance": float(state["last_imbalance"]),
+            "timestamp": int(state["timestamp_ns"])
+        }
+        
+    def get_all_states(self) -> np.ndarray:
+        """States of every symbol as a VPIN_STATE_DTYPE array indexed like self.symbols"""
+        states = np.zeros(len(self.symbols), dtype=VPIN_STATE_DTYPE)
+        self.lib.get_all_vpin_states(self._handle, states.ctypes.data)
+        return states
+        
+    def reset(self, symbol: str) -> None:
+        self.lib.reset_vpin_symbol(self._handle, self.symbol_index[symbol])
+        
+class OrderInfo(ctypes.Structure):
+    """Resting order details (ob_order_info_t)"""
+    _fields_ = [
+        ("price", ctypes.c_double),
+        ("quantity", ctypes.c_double),
+        ("hidden_quantity", ctypes.c_double),
+        ("timestamp_ns", ctypes.c_int64),
+        ("is_buy", ctypes.c_uint8),
+    ]
+
+class OrderOptions(ctypes.Structure):
+    """Iceberg, hidden, good-till-time and owner order attributes (ob_order_options_t)"""
+    _fields_ = [
+        ("hidden_quantity", ctypes.c_double),
+        ("peak_quantity", ctypes.c_double),
+        ("expire_time_ns", ctypes.c_int64),
+        ("owner_id", ctypes.c_uint32),
+        ("reserved", ctypes.c_uint32),
+    ]
+
+class TradeRecord(ctypes.Structure):
+    """One execution from a book's trade tape (ob_trade_t); is_buy is the resting side"""
+    _fields_ = [
+        ("price", ctypes.c_double),
+        ("quantity", ctypes.c_double),
+        ("timestamp_ns", ctypes.c_int64),
+        ("is_buy", ctypes.c_uint8),
+        ("reserved", ctypes.c_uint8 * 7),
+    ]
+
+class StopOrderFields(ctypes.Structure):
+    """Stop order fields (ob_stop_order_t); limit_price 0 is a stop-market order"""
+    _fields_ = [
+        ("stop_price", ctypes.c_double),
+        ("limit_price", ctypes.c_double),
+        ("quantity", ctypes.c_double),
+        ("timestamp_ns", ctypes.c_int64),
+        ("is_buy", ctypes.c_uint8),
+        ("reserved", ctypes.c_uint8 * 7),
+    ]
+
+class NativeTriggerBook:
+    def __init__(self, lib):
+        """Stop orders indexed by stop price for simulators that do their own
+        matching. fire returns the stops crossed by the reference prices,
+        buys from the lowest stop and sells from the highest, each in
+        O(log n)."""
+        self.lib = lib
+        self._stop = StopOrderFields()
+        self._order_id = ctypes.create_string_buffer(256)
+        self._handle = lib.create_trigger_book()
+        
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            self.lib.destroy_trigger_book(self._handle)
+            self._handle = None
+            
+    def add(self, order_id: str, stop_price: float, quantity: float, is_buy: bool,
+            limit_price: float = 0.0, timestamp_ns: int = 0) -> None:
+        stop = StopOrderFields(stop_price, limit_price, quantity, timestamp_ns, is_buy)
+        self.lib.add_trigger_stop(self._handle, order_id.encode('utf-8'), ctypes.byref(stop))
+        
+    def cancel(self, order_id: str) -> bool:
+        return self.lib.cancel_trigger_stop(self._handle, order_id.encode('utf-8'))
+        
+    def fire(self, buy_reference: float, sell_reference: float) -> List[Dict]:
+        """Remove and return the stops triggered by buy_reference (buy stops at
+        or below it) and sell_reference (sell stops at or above it)"""
+        self.lib.fire_trigger_stops(self._handle, buy_reference, sell_reference)
+        fired = []
+        while self.lib.pop_fired_stop(self._handle, ctypes.byref(self._stop), self._order_id,
+                                      len(self._order_id)):
+            fired.append({
+                "order_id": self._order_id.value.decode('utf-8'),
+                "stop_price": self._stop.stop_price,
+                "limit_price": self._stop.limit_price,
+                "quantity": self._stop.quantity,
+                "is_buy": bool(self._stop.is_buy),
+                "timestamp_ns": self._stop.timestamp_ns
+            })
+        return fired
+        
+    def __len__(self) -> int:
+        return self.lib.get_trigger_stop_count(self._handle)
+        
 class OrderBookInterface:
     def __init__(self, lib_path: str = "liborderbook.so"):
         """Interface to the C++ order book implementation"""
@@ -10,13 +568,37 @@ class OrderBookInterface:
         self.lib.create_order_book.argtypes = [ctypes.c_char_p]
         self.lib.create_order_book.restype = ctypes.c_void_p
         
+        self.lib.destroy_order_book.argtypes = [ctypes.c_void_p]
+        
         self.lib.add_order.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_double, 
                                      ctypes.c_double, ctypes.c_bool, ctypes.c_longlong]
         
+        self.lib.add_order_with_options.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_double,
+                                                    ctypes.c_double, ctypes.c_bool, ctypes.c_longlong,
+                                                    ctypes.POINTER(OrderOptions)]
+        
         self.lib.modify_order.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_double]
         
         self.lib.cancel_order.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
         
+        self.lib.replace_order.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_double, ctypes.c_double]
+        self.lib.replace_order.restype = ctypes.c_bool
+        
+        self.lib.execute_order.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_double, ctypes.c_double]
+        self.lib.execute_order.restype = ctypes.c_double
+        
+        self.lib.advance_time.argtypes = [ctypes.c_void_p, ctypes.c_longlong]
+        self.lib.advance_time.restype = ctypes.c_size_t
+        
+        self.lib.get_pending_expiry_count.argtypes = [ctypes.c_void_p]
+        self.lib.get_pending_expiry_count.restype = ctypes.c_size_t
+        
+        self.lib.clear_order_book.argtypes = [ctypes.c_void_p]
+        
+        self.lib.mass_cancel.argtypes = [ctypes.c_void_p, ctypes.c_bool, ctypes.c_bool,
+                                         ctypes.c_double, ctypes.c_double, ctypes.c_uint32]
+        self.lib.mass_cancel.restype = ctypes.c_size_t
+        
         self.lib.get_best_bid.argtypes = [ctypes.c_void_p]
         self.lib.get_best_bid.restype = ctypes.c_double
         
@@ -32,83 +614,702 @@ class OrderBookInterface:
         self.lib.get_order_imbalance.argtypes = [ctypes.c_void_p, ctypes.c_int]
         self.lib.get_order_imbalance.restype = ctypes.c_double
         
+        self.lib.get_order_count.argtypes = [ctypes.c_void_p]
+        self.lib.get_order_count.restype = ctypes.c_size_t
+        
+        self.lib.get_order_info.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(OrderInfo)]
+        self.lib.get_order_info.restype = ctypes.c_bool
+        
+        self.lib.get_queue_position.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.get_queue_position.restype = ctypes.c_longlong
+        
+        self.lib.get_hidden_volume.argtypes = [ctypes.c_void_p, ctypes.c_bool, ctypes.c_double]
+        self.lib.get_hidden_volume.restype = ctypes.c_double
+        
+        self.lib.get_recent_trades.argtypes = [ctypes.c_void_p, ctypes.POINTER(TradeRecord), ctypes.c_size_t]
+        self.lib.get_recent_trades.restype = ctypes.c_size_t
+        
+        self.lib.add_stop_order.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(StopOrderFields)]
+        self.lib.add_stop_order.restype = ctypes.c_bool
+        
+        self.lib.cancel_stop_order.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.cancel_stop_order.restype = ctypes.c_bool
+        
+        self.lib.get_stop_order_count.argtypes = [ctypes.c_void_p]
+        self.lib.get_stop_order_count.restype = ctypes.c_size_t
+        
+        self.lib.report_trade_price.argtypes = [ctypes.c_void_p, ctypes.c_double]
+        
+        self.lib.create_trigger_book.argtypes = []
+        self.lib.create_trigger_book.restype = ctypes.c_void_p
+        
+        self.lib.destroy_trigger_book.argtypes = [ctypes.c_void_p]
+        
+        self.lib.add_trigger_stop.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(StopOrderFields)]
+        
+        self.lib.cancel_trigger_stop.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.cancel_trigger_stop.restype = ctypes.c_bool
+        
+        self.lib.get_trigger_stop_count.argtypes = [ctypes.c_void_p]
+        self.lib.get_trigger_stop_count.restype = ctypes.c_size_t
+        
+        self.lib.fire_trigger_stops.argtypes = [ctypes.c_void_p, ctypes.c_double, ctypes.c_double]
+        self.lib.fire_trigger_stops.restype = ctypes.c_size_t
+        
+        self.lib.pop_fired_stop.argtypes = [ctypes.c_void_p, ctypes.POINTER(StopOrderFields),
+                                            ctypes.c_char_p, ctypes.c_size_t]
+        self.lib.pop_fired_stop.restype = ctypes.c_bool
+        
+        for name in ("get_bid_level_price", "get_bid_level_volume",
+                     "get_ask_level_price", "get_ask_level_volume"):
+            getattr(self.lib, name).argtypes = [ctypes.c_void_p, ctypes.c_int]
+            getattr(self.lib, name).restype = ctypes.c_double
+        
+        self.lib.apply_order_events.argtypes = [ctypes.c_void_p, ctypes.POINTER(OrderEvent), ctypes.c_size_t]
+        self.lib.apply_order_events.restype = ctypes.c_size_t
+        
+        self.lib.fill_order_book_snapshot.argtypes = [
+            ctypes.c_void_p, ctypes.c_int,
+            ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+            ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+            ctypes.POINTER(BookSnapshot)
+        ]
+        
+        self.lib.apply_order_event_columns.argtypes = [
+            ctypes.POINTER(ctypes.c_void_p), ctypes.c_size_t,
+            ctypes.POINTER(EventColumns), ctypes.c_size_t,
+            ctypes.POINTER(DerivedColumns)
+        ]
+        self.lib.apply_order_event_columns.restype = ctypes.c_size_t
+        
+        self.lib.apply_binary_messages.argtypes = [
+            ctypes.POINTER(ctypes.c_void_p), ctypes.c_size_t,
+            ctypes.c_void_p, ctypes.c_size_t, ctypes.POINTER(DecodeStats)
+        ]
+        self.lib.apply_binary_messages.restype = ctypes.c_size_t
+        self.lib.replay_pcap_file.argtypes = [
+            ctypes.c_char_p, ctypes.POINTER(ctypes.c_void_p), ctypes.c_size_t,
+            ctypes.POINTER(ReplayOptions), ctypes.POINTER(ReplayStats)
+        ]
+        self.lib.replay_pcap_file.restype = ctypes.c_bool
+        self.lib.replay_event_file.argtypes = [
+            ctypes.c_char_p, ctypes.POINTER(ctypes.c_void_p), ctypes.c_size_t,
+            ctypes.POINTER(EventFileOptions), ctypes.POINTER(EventFileStats)
+        ]
+        self.lib.replay_event_file.restype = ctypes.c_bool
+        
+        self.lib.create_snapshot_region.argtypes = [ctypes.c_char_p, ctypes.c_uint32, ctypes.c_uint32]
+        self.lib.create_snapshot_region.restype = ctypes.c_void_p
+        
+        self.lib.destroy_snapshot_region.argtypes = [ctypes.c_void_p, ctypes.c_bool]
+        
+        self.lib.get_snapshot_region_slot.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+        self.lib.get_snapshot_region_slot.restype = ctypes.c_int
+        
+        self.lib.publish_order_book_snapshot.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p]
+        
+        self.lib.create_snapshot_batch.argtypes = [ctypes.c_int]
+        self.lib.create_snapshot_batch.restype = ctypes.c_void_p
+        
+        self.lib.destroy_snapshot_batch.argtypes = [ctypes.c_void_p]
+        
+        self.lib.append_snapshot_row.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p]
+        
+        self.lib.get_snapshot_batch_rows.argtypes = [ctypes.c_void_p]
+        self.lib.get_snapshot_batch_rows.restype = ctypes.c_size_t
+        
+        self.lib.export_snapshot_batch.argtypes = [ctypes.c_void_p, ctypes.POINTER(ArrowArray),
+                                                   ctypes.POINTER(ArrowSchema)]
+        
+        self.lib.create_metric_batch.argtypes = [ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t]
+        self.lib.create_metric_batch.restype = ctypes.c_void_p
+        
+        self.lib.destroy_metric_batch.argtypes = [ctypes.c_void_p]
+        
+        self.lib.append_metric_row.argtypes = [ctypes.c_void_p, ctypes.c_int64, ctypes.c_uint32,
+                                               ctypes.POINTER(ctypes.c_double)]
+        
+        self.lib.get_metric_batch_rows.argtypes = [ctypes.c_void_p]
+        self.lib.get_metric_batch_rows.restype = ctypes.c_size_t
+        
+        self.lib.export_metric_batch.argtypes = [ctypes.c_void_p, ctypes.POINTER(ArrowArray),
+                                                 ctypes.POINTER(ArrowSchema)]
+        
+        self.lib.create_microstructure_analyzer.argtypes = [ctypes.c_size_t, ctypes.c_int, ctypes.c_double]
+        self.lib.create_microstructure_analyzer.restype = ctypes.c_void_p
+        
+        self.lib.destroy_microstructure_analyzer.argtypes = [ctypes.c_void_p]
+        
+        self.lib.update_microstructure_analyzer.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int64,
+                                                            ctypes.POINTER(MicrostructureMetrics)]
+        
+        self.lib.reset_microstructure_analyzer.argtypes = [ctypes.c_void_p]
+        
+        self.lib.append_analyzer_metrics.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint32]
+        self.lib.append_analyzer_metrics.restype = ctypes.c_bool
+        
+        self.lib.create_toxic_flow_detector.argtypes = [ctypes.c_size_t, ctypes.c_size_t, ctypes.c_double,
+                                                        ctypes.c_double, ctypes.c_double]
+        self.lib.create_toxic_flow_detector.restype = ctypes.c_void_p
+        
+        self.lib.destroy_toxic_flow_detector.argtypes = [ctypes.c_void_p]
+        
+        self.lib.apply_toxic_flow_events.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+        self.lib.apply_toxic_flow_events.restype = ctypes.c_size_t
+        
+        self.lib.score_toxic_flow.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p]
+        self.lib.score_toxic_flow.restype = ctypes.c_bool
+        
+        self.lib.score_all_toxic_flow.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+        
+        self.lib.get_toxic_order_size_quantile.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_double]
+        self.lib.get_toxic_order_size_quantile.restype = ctypes.c_double
+        
+        self.lib.reset_toxic_flow_symbol.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+        
+        self.lib.create_vpin_calculator.argtypes = [ctypes.c_size_t, ctypes.c_double, ctypes.c_size_t,
+                                                    ctypes.c_int]
+        self.lib.create_vpin_calculator.restype = ctypes.c_void_p
+        
+        self.lib.destroy_vpin_calculator.argtypes = [ctypes.c_void_p]
+        
+        self.lib.apply_vpin_trades.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+        self.lib.apply_vpin_trades.restype = ctypes.c_size_t
+        
+        self.lib.update_vpin_from_book.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p]
+        self.lib.update_vpin_from_book.restype = ctypes.c_size_t
+        
+        self.lib.get_vpin_state.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_void_p]
+        self.lib.get_vpin_state.restype = ctypes.c_bool
+        
+        self.lib.get_all_vpin_states.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+        
+        self.lib.set_vpin_bucket_volume.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_double]
+        self.lib.set_vpin_bucket_volume.restype = ctypes.c_bool
+        
+        self.lib.reset_vpin_symbol.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+        
+        self.lib.compute_vpin_historical.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p,
+                                                     ctypes.c_size_t, ctypes.c_double, ctypes.c_size_t,
+                                                     ctypes.c_int, ctypes.c_void_p]
+        self.lib.compute_vpin_historical.restype = ctypes.c_uint64
+        
+        self.lib.set_stage_timing_enabled.argtypes = [ctypes.c_bool]
+        
+        self.lib.get_stage_latency.argtypes = [ctypes.c_int32, ctypes.POINTER(StageLatency)]
+        self.lib.get_stage_latency.restype = ctypes.c_bool
+        
+        self.lib.start_stage_latency_dump.argtypes = [ctypes.c_uint32, ctypes.c_char_p]
+        self.lib.start_stage_latency_dump.restype = ctypes.c_bool
+        self.lib.start_metrics_endpoint.argtypes = [ctypes.c_char_p, ctypes.c_uint16]
+        self.lib.start_metrics_endpoint.restype = ctypes.c_bool
+        self.lib.get_metrics_endpoint_port.restype = ctypes.c_uint16
+        self.lib.scrape_metrics.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+        self.lib.scrape_metrics.restype = ctypes.c_size_t
+        
         # Initialize order books for symbols
         self.order_books = {}
         
+        # Stable numeric IDs used in Arrow exports, in creation order
+        self.symbol_ids = {}
+        
+        # Snapshot buffers reused across calls, keyed by depth
+        self._snapshot_buffers = {}
+        
+        # Shared-memory snapshot region, if this process publishes one
+        self._region = None
+        self._region_slots = {}
+        
+        # Native snapshot accumulators for Arrow export, keyed by depth
+        self._snapshot_batches = {}
+        
+        # Books a running native feed thread applies to, symbol -> owner;
+        # see UdpFeed
+        self._leased_books = {}
+        
     def create_book(self, symbol: str) -> None:
         """Create a new order book for a symbol"""
         symbol_bytes = symbol.encode('utf-8')
         handle = self.lib.create_order_book(symbol_bytes)
         self.order_books[symbol] = handle
+        self.symbol_ids.setdefault(symbol, len(self.symbol_ids))
         
-    def add_order(self, symbol: str, order_id: str, price: float, 
-                 quantity: float, is_buy: bool, timestamp_ns: int) -> None:
-        """Add a new order to the book"""
+    def close(self) -> None:
+        """Release all native order books and the snapshot region"""
+        if self._leased_books:
+            raise RuntimeError("Stop the native feeds that own books before closing")
+        for handle in self.order_books.values():
+            self.lib.destroy_order_book(handle)
+        self.order_books.clear()
+        
+        if self._region is not None:
+            self.lib.destroy_snapshot_region(self._region, True)
+            self._region = None
+            self._region_slots.clear()
+            
+        for batch in self._snapshot_batches.values():
+            self.lib.destroy_snapshot_batch(batch)
+        self._snapshot_batches.clear()
+        
+    def attach_snapshot_region(self, name: str, slot_count: int = 64, depth: int = 10) -> None:
+        """Create a shared-memory snapshot region that publish_snapshot writes to.
+        
+        Other processes read it with core.src.integration.shm_snapshot.
+        """
+        region = self.lib.create_snapshot_region(name.encode('utf-8'), slot_count, depth)
+        if not region:
+            raise OSError(f"Could not create snapshot region {name}")
+        if self._region is not None:
+            self.lib.destroy_snapshot_region(self._region, False)
+        self._region = region
+        self._region_slots.clear()
+        
+    def publish_snapshot(self, symbol: str) -> bool:
+        """Copy the symbol's top levels into the attached region"""
+        if self._region is None:
+            return False
+        handle = self._get_handle(symbol)
+        
+        slot = self._region_slots.get(symbol)
+        if slot is None:
+            slot = self.lib.get_snapshot_region_slot(self._region, symbol.encode('utf-8'))
+            if slot < 0:
+                return False
+            self._region_slots[symbol] = slot
+            
+        self.lib.publish_order_book_snapshot(self._region, slot, handle)
+        return True
+        
+    def _get_handle(self, symbol: str):
         handle = self.order_books.get(symbol)
         if handle is None:
             raise ValueError(f"No order book exists for symbol {symbol}")
+        owner = self._leased_books.get(symbol)
+        if owner is not None:
+            raise RuntimeError(f"The {symbol} book is owned by a running {owner}")
+        return handle
+        
+    def _lease_books(self, symbols: Sequence[str], owner: str) -> None:
+        """Hand books to a native thread; _get_handle refuses them until
+        _release_books"""
+        for symbol in symbols:
+            self._get_handle(symbol)
+        for symbol in symbols:
+            self._leased_books[symbol] = owner
+            
+    def _release_books(self, symbols: Sequence[str]) -> None:
+        for symbol in symbols:
+            self._leased_books.pop(symbol, None)
+        
+    def add_order(self, symbol: str, order_id: str, price: float, 
+                 quantity: float, is_buy: bool, timestamp_ns: Optional[int] = None,
+                 hidden_quantity: float = 0.0, peak_quantity: float = 0.0,
+                 expire_time_ns: int = 0, owner_id: int = 0) -> None:
+        """Add a new order to the book. quantity is the displayed size; an
+        iceberg shows peak_quantity at a time out of hidden_quantity in
+        reserve, and a fully hidden order has quantity 0. A non-zero
+        expire_time_ns cancels the order once advance_time reaches it, and
+        owner_id tags it for mass_cancel."""
+        handle = self._get_handle(symbol)
+        if timestamp_ns is None:
+            timestamp_ns = time.time_ns()
             
         order_id_bytes = order_id.encode('utf-8')
+        if hidden_quantity or peak_quantity or expire_time_ns or owner_id:
+            options = OrderOptions(hidden_quantity, peak_quantity, expire_time_ns, owner_id)
+            self.lib.add_order_with_options(handle, order_id_bytes, price, quantity, is_buy, timestamp_ns,
+                                            ctypes.byref(options))
+            return
         self.lib.add_order(handle, order_id_bytes, price, quantity, is_buy, timestamp_ns)
         
     def modify_order(self, symbol: str, order_id: str, new_quantity: float) -> None:
         """Modify an existing order's quantity"""
-        handle = self.order_books.get(symbol)
-        if handle is None:
-            raise ValueError(f"No order book exists for symbol {symbol}")
-            
+        handle = self._get_handle(symbol)
         order_id_bytes = order_id.encode('utf-8')
         self.lib.modify_order(handle, order_id_bytes, new_quantity)
         
     def cancel_order(self, symbol: str, order_id: str) -> None:
         """Cancel an existing order"""
-        handle = self.order_books.get(symbol)
-        if handle is None:
-            raise ValueError(f"No order book exists for symbol {symbol}")
-            
+        handle = self._get_handle(symbol)
         order_id_bytes = order_id.encode('utf-8')
         self.lib.cancel_order(handle, order_id_bytes)
         
+    def replace_order(self, symbol: str, order_id: str, new_price: float, new_quantity: float) -> bool:
+        """Cancel/replace an order in one call; returns False if the order is unknown"""
+        handle = self._get_handle(symbol)
+        return self.lib.replace_order(handle, order_id.encode('utf-8'), new_price, new_quantity)
+        
+    def execute_order(self, symbol: str, order_id: str, exec_qty: float, trade_price: float) -> float:
+        """Apply an execution against a resting order; returns the quantity executed"""
+        handle = self._get_handle(symbol)
+        return self.lib.execute_order(handle, order_id.encode('utf-8'), exec_qty, trade_price)
+        
+    def advance_time(self, symbol: str, now_ns: int) -> int:
+        """Advance event time, expiring good-till-time orders"""
+        handle = self._get_handle(symbol)
+        return self.lib.advance_time(handle, now_ns)
+        
+    def mass_cancel(self, symbol: str, include_bids: bool = True, include_asks: bool = True,
+                    min_price: float = 0.0, max_price: float = float("inf"), owner_id: int = 0) -> int:
+        """Cancel resting orders by side, price band and owner (0 matches every
+        owner), hidden and iceberg reserve included; returns how many"""
+        return self.lib.mass_cancel(self._get_handle(symbol), include_bids, include_asks,
+                                    min_price, max_price, owner_id)
+        
+    def clear_book(self, symbol: str) -> None:
+        """Drop every resting order, expiry timer and stop order of the book"""
+        self.lib.clear_order_book(self._get_handle(symbol))
+        
+    def get_pending_expiry_count(self, symbol: str) -> int:
+        """Expiry timers still armed for live orders"""
+        return self.lib.get_pending_expiry_count(self._get_handle(symbol))
+        
+    def apply_events(self, symbol: str, events) -> int:
+        """Apply a batch of order events in a single native call.
+        
+        events is either a ctypes array of OrderEvent or a sequence of
+        (timestamp_ns, order_id, price, quantity, event_type, is_buy) tuples
+        with numeric order IDs.
+        """
+        handle = self._get_handle(symbol)
+        
+        if not isinstance(events, ctypes.Array):
+            records = (OrderEvent * len(events))()
+            for record, (timestamp_ns, order_id, price, quantity, event_type, is_buy) in zip(records, events):
+                record.timestamp_ns = timestamp_ns
+                record.order_id = order_id
+                record.price = price
+                record.quantity = quantity
+                record.type = event_type
+                record.is_buy = is_buy
+            events = records
+            
+        return self.lib.apply_order_events(handle, events, len(events))
+        
+    def apply_event_columns(self, symbols: Sequence[str], timestamp_ns, event_type, order_id,
+                            price, quantity, is_buy, symbol_index=None,
+                            derived: bool = False, imbalance_levels: int = 5):
+        """Apply a columnar chunk of events across several books in one native call.
+        
+        Each column is array-like with one entry per event; symbol_index
+        selects the book from symbols (all events go to symbols[0] when it
+        is omitted). Returns the number of events applied, or with
+        derived=True a (applied, columns) pair where columns holds per-event
+        best_bid, best_ask, mid_price and order_imbalance arrays.
+        """
+        handles = (ctypes.c_void_p * len(symbols))(*[self._get_handle(s) for s in symbols])
+        
+        arrays = [
+            np.ascontiguousarray(timestamp_ns, dtype=np.int64),
+            np.ascontiguousarray(event_type, dtype=np.uint8),
+            np.ascontiguousarray(order_id, dtype=np.uint64),
+            np.ascontiguousarray(price, dtype=np.float64),
+            np.ascontiguousarray(quantity, dtype=np.float64),
+            np.ascontiguousarray(is_buy, dtype=np.uint8),
+        ]
+        count = len(arrays[0])
+        if symbol_index is not None:
+            arrays.append(np.ascontiguousarray(symbol_index, dtype=np.uint32))
+        if any(len(column) != count for column in arrays):
+            raise ValueError("All event columns must have the same length")
+            
+        columns = EventColumns(*[column.ctypes.data for column in arrays])
+        if symbol_index is None:
+            columns.book_index = None
+            
+        if not derived:
+            return self.lib.apply_order_event_columns(handles, len(symbols), ctypes.byref(columns),
+                                                      count, None)
+            
+        outputs = {name: np.empty(count, dtype=np.float64)
+                   for name in ("best_bid", "best_ask", "mid_price", "order_imbalance")}
+        derived_columns = DerivedColumns(
+            outputs["best_bid"].ctypes.data, outputs["best_ask"].ctypes.data,
+            outputs["mid_price"].ctypes.data, outputs["order_imbalance"].ctypes.data,
+            imbalance_levels
+        )
+        applied = self.lib.apply_order_event_columns(handles, len(symbols), ctypes.byref(columns),
+                                                     count, ctypes.byref(derived_columns))
+        return applied, outputs
+        
+    def apply_binary_messages(self, symbols: Sequence[str], data) -> Tuple[int, Dict[str, int]]:
+        """Decode a buffer of binary wire messages straight into the books.
+        
+        data is any bytes-like object; each message's locate field indexes
+        symbols. Returns (bytes_consumed, counters). A trailing partial
+        message is not consumed and should be prepended to the next buffer.
+        """
+        handles = (ctypes.c_void_p * len(symbols))(*[self._get_handle(s) for s in symbols])
+        buffer = np.frombuffer(data, dtype=np.uint8)
+        stats = DecodeStats()
+        consumed = self.lib.apply_binary_messages(handles, len(symbols), buffer.ctypes.data,
+                                                  len(buffer), ctypes.byref(stats))
+        return consumed, {name: getattr(stats, name) for name, _ in DecodeStats._fields_}
+        
+    def replay_pcap(self, path: str, symbols: Sequence[str], speed: float = 0.0,
+                    udp_port: int = 0, sequenced: bool = True) -> Dict:
+        """Replay the binary market data in a pcap/pcapng capture into the books.
+        
+        Message locates index symbols. speed is a multiple of recorded time
+        (0 replays as fast as possible). Returns throughput counters and
+        per-packet processing latency percentiles in nanoseconds.
+        """
+        handles = (ctypes.c_void_p * len(symbols))(*[self._get_handle(s) for s in symbols])
+        options = ReplayOptions(speed, udp_port, sequenced)
+        stats = ReplayStats()
+        if not self.lib.replay_pcap_file(path.encode('utf-8'), handles, len(symbols),
+                                         ctypes.byref(options), ctypes.byref(stats)):
+            raise OSError(f"Cannot read capture {path}")
+        return {name: getattr(stats, name) for name, _ in ReplayStats._fields_}
+        
+    def replay_event_file(self, path: str, symbols: Sequence[str], backend: str = "auto",
+                          chunk_size: int = 0, queue_depth: int = 0, block_size: int = 0) -> Dict:
+        """Stream a file of binary wire messages, plain or gzip, into the books.
+        
+        Message locates index symbols. Reads stay queue_depth chunks ahead
+        through io_uring or a pread thread pool (backend "auto", "io_uring"
+        or "thread_pool"), a native thread decompresses and the calling
+        thread applies, so the three overlap. Returns byte and message
+        counts and the time each stage spent working and waiting.
+        """
+        if backend not in READ_BACKENDS:
+            raise ValueError(f"Unknown read backend: {backend}")
+        handles = (ctypes.c_void_p * len(symbols))(*[self._get_handle(s) for s in symbols])
+        options = EventFileOptions(chunk_size, queue_depth, 0, block_size, READ_BACKENDS[backend])
+        stats = EventFileStats()
+        if not self.lib.replay_event_file(path.encode('utf-8'), handles, len(symbols),
+                                          ctypes.byref(options), ctypes.byref(stats)):
+            raise OSError(f"Cannot read event file {path}")
+        result = {name: getattr(stats, name) for name, _ in EventFileStats._fields_}
+        result["backend"] = next(name for name, value in READ_BACKENDS.items() if value == stats.backend)
+        return result
+        
+    def set_stage_timing(self, enabled: bool) -> None:
+        """Turn native per-stage latency recording on or off (process-wide)"""
+        self.lib.set_stage_timing_enabled(enabled)
+        
+    def get_stage_latencies(self) -> Dict[str, Dict]:
+        """Latency percentiles in ns for each of PIPELINE_STAGES, merged
+        across native threads since the last reset"""
+        result = {}
+        for index, name in enumerate(PIPELINE_STAGES):
+            stats = StageLatency()
+            self.lib.get_stage_latency(index, ctypes.byref(stats))
+            result[name] = {field: getattr(stats, field) for field, _ in StageLatency._fields_}
+        return result
+        
+    def reset_stage_latencies(self) -> None:
+        """Clear the stage latency histograms"""
+        self.lib.reset_stage_latency()
+        
+    def start_stage_latency_dump(self, interval_ms: int = 10000, path: Optional[str] = None) -> None:
+        """Periodically append a stage latency summary to path (stderr when None)"""
+        if not self.lib.start_stage_latency_dump(interval_ms, path.encode('utf-8') if path else None):
+            raise OSError(f"Cannot start stage latency dump to {path or 'stderr'}")
+            
+    def stop_stage_latency_dump(self) -> None:
+        """Stop the periodic stage latency dump"""
+        self.lib.stop_stage_latency_dump()
+        
+    def start_metrics_endpoint(self, port: int = 9464, address: str = "127.0.0.1") -> int:
+        """Serve native counters for Prometheus at http://address:port/metrics;
+        port 0 picks a free port. Returns the bound port."""
+        if not self.lib.start_metrics_endpoint(address.encode('utf-8'), port):
+            raise OSError(f"Cannot start metrics endpoint on {address}:{port}")
+        return self.lib.get_metrics_endpoint_port()
+        
+    def stop_metrics_endpoint(self) -> None:
+        """Stop serving /metrics"""
+        self.lib.stop_metrics_endpoint()
+        
+    def scrape_metrics(self) -> str:
+        """Native counters in Prometheus text format, as served on /metrics"""
+        size = self.lib.scrape_metrics(None, 0)
+        while True:
+            buffer = ctypes.create_string_buffer(size + 1)
+            needed = self.lib.scrape_metrics(buffer, size + 1)
+            if needed <= size:
+                return buffer.value.decode('utf-8')
+            size = needed
+        
+    def record_snapshots(self, symbols: Optional[Sequence[str]] = None, levels: int = 10) -> int:
+        """Append the current top levels of each symbol (all books by default)
+        to a native batch; returns the number of rows now pending"""
+        batch = self._snapshot_batches.get(levels)
+        if batch is None:
+            batch = self.lib.create_snapshot_batch(levels)
+            self._snapshot_batches[levels] = batch
+            
+        for symbol in (self.order_books if symbols is None else symbols):
+            self.lib.append_snapshot_row(batch, self.symbol_ids[symbol], self._get_handle(symbol))
+        return self.lib.get_snapshot_batch_rows(batch)
+        
+    def export_snapshots(self, levels: int = 10):
+        """Move the recorded snapshots into a pyarrow.RecordBatch without copying.
+        
+        Columns: timestamp_ns, symbol_id (see symbol_ids), mid_price, spread,
+        order_imbalance, bid_count, ask_count and fixed-size lists
+        bid_prices, bid_volumes, ask_prices, ask_volumes (NaN past the count).
+        """
+        batch = self._snapshot_batches.get(levels)
+        if batch is None:
+            batch = self.lib.create_snapshot_batch(levels)
+            self._snapshot_batches[levels] = batch
+            
+        array, schema = ArrowArray(), ArrowSchema()
+        self.lib.export_snapshot_batch(batch, ctypes.byref(array), ctypes.byref(schema))
+        return _import_record_batch(array, schema)
+        
+    def create_metric_batch(self, metric_names: Sequence[str]) -> MetricBatch:
+        """Create a native metric accumulator with Arrow export"""
+        return MetricBatch(self.lib, metric_names)
+        
+    def create_microstructure_analyzer(self, symbol: str, window_size: int = 100,
+                                       imbalance_levels: int = 5,
+                                       impact_size: float = 100.0) -> NativeMicrostructureAnalyzer:
+        """Native streaming analyzer over the book for symbol; call update
+        after applying changes to the book"""
+        return NativeMicrostructureAnalyzer(self.lib, symbol, self._get_handle(symbol), window_size,
+                                            imbalance_levels, impact_size)
+        
+    def create_toxic_flow_detector(self, symbols: Sequence[str], window_size: int = 100,
+                                   large_order_multiple: float = 2.0,
+                                   threshold: float = 0.6,
+                                   large_order_quantile: float = 0.0) -> NativeToxicFlowDetector:
+        """Native toxic flow detector for a fixed universe of symbols; see
+        NativeToxicFlowDetector for the large-order and threshold options"""
+        return NativeToxicFlowDetector(self.lib, symbols, window_size, large_order_multiple, threshold,
+                                       large_order_quantile)
+        
+    def create_vpin_calculator(self, symbols: Sequence[str], bucket_volume: float = 10000.0,
+                               window_buckets: int = 50,
+                               classification: int = VPIN_BULK_VOLUME) -> NativeVpinCalculator:
+        """Streaming VPIN for a fixed universe of symbols"""
+        if bucket_volume <= 0 or window_buckets <= 0:
+            raise ValueError("bucket_volume and window_buckets must be positive")
+        return NativeVpinCalculator(self.lib, symbols, bucket_volume, window_buckets, classification,
+                                    self._get_handle)
+        
+    def compute_vpin(self, prices: np.ndarray, quantities: np.ndarray, bucket_volume: float,
+                     window_buckets: int = 50, classification: int = VPIN_BULK_VOLUME,
+                     sides: Optional[np.ndarray] = None) -> np.ndarray:
+        """VPIN after each trade of one symbol's day, NaN until window_buckets
+        buckets have closed. sides holds VPIN_SIDE_* values for VPIN_AGGRESSOR."""
+        if bucket_volume <= 0 or window_buckets <= 0:
+            raise ValueError("bucket_volume and window_buckets must be positive")
+        prices = np.ascontiguousarray(prices, dtype=np.float64)
+        quantities = np.ascontiguousarray(quantities, dtype=np.float64)
+        if len(prices) != len(quantities) or (sides is not None and len(sides) != len(prices)):
+            raise ValueError("prices, quantities and sides must have the same length")
+        if sides is not None:
+            sides = np.ascontiguousarray(sides, dtype=np.uint8)
+            
+        vpin = np.empty(len(prices), dtype=np.float64)
+        self.lib.compute_vpin_historical(prices.ctypes.data, quantities.ctypes.data,
+                                         sides.ctypes.data if sides is not None else None, len(prices),
+                                         bucket_volume, window_buckets, classification, vpin.ctypes.data)
+        return vpin
+        
+    def get_order_count(self, symbol: str) -> int:
+        """Get the number of resting orders"""
+        return self.lib.get_order_count(self._get_handle(symbol))
+        
+    def get_order_info(self, symbol: str, order_id: str) -> Optional[Dict]:
+        """Get details of a resting order, or None if it is not in the book"""
+        handle = self._get_handle(symbol)
+        info = OrderInfo()
+        if not self.lib.get_order_info(handle, order_id.encode('utf-8'), ctypes.byref(info)):
+            return None
+            
+        return {
+            "price": info.price,
+            "quantity": info.quantity,
+            "hidden_quantity": info.hidden_quantity,
+            "is_buy": bool(info.is_buy),
+            "timestamp_ns": info.timestamp_ns
+        }
+        
+    def get_queue_position(self, symbol: str, order_id: str) -> Optional[int]:
+        """Orders ahead of order_id in its price level, or None if it is not in the book"""
+        position = self.lib.get_queue_position(self._get_handle(symbol), order_id.encode('utf-8'))
+        return position if position >= 0 else None
+        
+    def get_hidden_volume(self, symbol: str, is_buy: bool, price: float) -> float:
+        """Non-displayed volume resting at a price"""
+        return self.lib.get_hidden_volume(self._get_handle(symbol), is_buy, price)
+        
+    def get_recent_trades(self, symbol: str, count: int = 100) -> List[Dict]:
+        """Most recent executions on the book, oldest first; is_buy is the resting side"""
+        trades = (TradeRecord * count)()
+        written = self.lib.get_recent_trades(self._get_handle(symbol), trades, count)
+        return [{
+            "price": trade.price,
+            "quantity": trade.quantity,
+            "timestamp_ns": trade.timestamp_ns,
+            "is_buy": bool(trade.is_buy)
+        } for trade in trades[:written]]
+        
+    def add_stop_order(self, symbol: str, order_id: str, stop_price: float, quantity: float,
+                       is_buy: bool, limit_price: float = 0.0, timestamp_ns: int = 0) -> bool:
+        """Rest a stop order; it matches as a market order (or a limit order at
+        limit_price) once the book trades or quotes through stop_price. Returns
+        False if order_id belongs to a resting order"""
+        stop = StopOrderFields(stop_price, limit_price, quantity, timestamp_ns, is_buy)
+        return self.lib.add_stop_order(self._get_handle(symbol), order_id.encode('utf-8'), ctypes.byref(stop))
+        
+    def cancel_stop_order(self, symbol: str, order_id: str) -> bool:
+        return self.lib.cancel_stop_order(self._get_handle(symbol), order_id.encode('utf-8'))
+        
+    def get_stop_order_count(self, symbol: str) -> int:
+        return self.lib.get_stop_order_count(self._get_handle(symbol))
+        
+    def report_trade_price(self, symbol: str, price: float) -> None:
+        """Fire the stops crossed by a trade printed away from this book"""
+        self.lib.report_trade_price(self._get_handle(symbol), price)
+        
+    def create_trigger_book(self) -> NativeTriggerBook:
+        """Standalone stop order index, e.g. for ExecutionModel"""
+        return NativeTriggerBook(self.lib)
+        
+    def get_best_bid(self, symbol: str) -> float:
+        """Get the best bid price"""
+        return self.lib.get_best_bid(self._get_handle(symbol))
+        
+    def get_best_ask(self, symbol: str) -> float:
+        """Get the best ask price"""
+        return self.lib.get_best_ask(self._get_handle(symbol))
+        
+    def get_order_imbalance(self, symbol: str, levels: int = 5) -> float:
+        """Get the volume imbalance over the top levels"""
+        return self.lib.get_order_imbalance(self._get_handle(symbol), levels)
+        
     def get_best_prices(self, symbol: str) -> Tuple[float, float]:
         """Get best bid and ask prices"""
-        handle = self.order_books.get(symbol)
-        if handle is None:
-            raise ValueError(f"No order book exists for symbol {symbol}")
-            
+        handle = self._get_handle(symbol)
         best_bid = self.lib.get_best_bid(handle)
         best_ask = self.lib.get_best_ask(handle)
         return best_bid, best_ask
         
     def get_order_book_snapshot(self, symbol: str, levels: int = 10) -> Dict:
-        """Get a snapshot of the order book"""
-        handle = self.order_books.get(symbol)
-        if handle is None:
-            raise ValueError(f"No order book exists for symbol {symbol}")
-            
-        # Get bid levels
-        bid_levels = []
-        for i in range(levels):
-            price = self.lib.get_bid_level_price(handle, i)
-            volume = self.lib.get_bid_level_volume(handle, i)
-            if price > 0:
-                bid_levels.append((price, volume))
-                
-        # Get ask levels
-        ask_levels = []
-        for i in range(levels):
-            price = self.lib.get_ask_level_price(handle, i)
-            volume = self.lib.get_ask_level_volume(handle, i)
-            if price < float('inf'):
-                ask_levels.append((price, volume))
-                
-        mid_price = self.lib.get_mid_price(handle)
-        spread = self.lib.get_spread(handle)
-        order_imbalance = self.lib.get_order_imbalance(handle, 5)
+        """Get a snapshot of the order book in a single native call"""
+        handle = self._get_handle(symbol)
+        
+        buffers = self._snapshot_buffers.get(levels)
+        if buffers is None:
+            buffers = tuple((ctypes.c_double * levels)() for _ in range(4)) + (BookSnapshot(),)
+            self._snapshot_buffers[levels] = buffers
+        bid_prices, bid_volumes, ask_prices, ask_volumes, snapshot = buffers
+        
+        self.lib.fill_order_book_snapshot(handle, levels, bid_prices, bid_volumes,
+                                          ask_prices, ask_volumes, ctypes.byref(snapshot))
+        
+        bid_levels = list(zip(bid_prices[:snapshot.bid_count], bid_volumes[:snapshot.bid_count]))
+        ask_levels = list(zip(ask_prices[:snapshot.ask_count], ask_volumes[:snapshot.ask_count]))
         
         return {
             "bid_levels": bid_levels,
             "ask_levels": ask_levels,
-            "mid_price": mid_price,
-            "spread": spread,
-            "order_imbalance": order_imbalance
+            "mid_price": snapshot.mid_price,
+            "spread": snapshot.spread,
+            "order_imbalance": snapshot.order_imbalance
         } 
\ No newline at end of file
@@ -0,0 +1,288 @@
+// Python extension exposing LimitOrderBook without ctypes marshalling.
+//
+// Batch calls take NumPy structured arrays of EVENT_DTYPE and run with the
+// GIL released; snapshots are returned as NumPy views over buffers owned by
+// a native BookSnapshot object, so no per-level Python objects are built.
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event_columns.h"
+#include "limit_order_book.h"
+
+namespace py = pybind11;
+using namespace microstructure;
+
+namespace {
+
+// Level arrays for one snapshot, laid out as a 4 x depth matrix:
+// bid prices, bid volumes, ask prices, ask volumes
+struct BookSnapshot {
+    explicit BookSnapshot(int depth) : depth(depth), levels(4 * static_cast<size_t>(depth), 0.0) {}
+    
+    double* Row(int row) { return levels.data() + static_cast<size_t>(row) * depth; }
+    
+    int depth;
+    std::vector<double> levels;
+    int bid_count = 0;
+    int ask_count = 0;
+    int64_t timestamp_ns = 0;
+    double mid_price = 0.0;
+    double spread = 0.0;
+    double order_imbalance = 0.0;
+};
+
+py::dtype EventDtype() {
+    py::list names, formats, offsets;
+    auto field = [&](const char* name, const char* format, size_t offset) {
+        names.append(name);
+        formats.append(format);
+        offsets.append(offset);
+    };
+    field("timestamp_ns", "<i8", offsetof(OrderEvent, timestamp_ns));
+    field("order_id", "<u8", offsetof(OrderEvent, order_id));
+    field("price", "<f8", offsetof(OrderEvent, price));
+    field("quantity", "<f8", offsetof(OrderEvent, quantity));
+    field("type", "u1", offsetof(OrderEvent, type));
+    field("is_buy", "u1", offsetof(OrderEvent, is_buy));
+    
+    py::dict spec;
+    spec["names"] = names;
+    spec["formats"] = formats;
+    spec["offsets"] = offsets;
+    spec["itemsize"] = sizeof(OrderEvent);
+    return py::dtype::from_args(spec);
+}
+
+const OrderEvent* CheckedEvents(const py::array& events) {
+    if (events.itemsize() != static_cast<py::ssize_t>(sizeof(OrderEvent)) ||
+        events.ndim() != 1 || !(events.flags() & py::array::c_style)) {
+        throw py::value_error("events must be a contiguous 1-D array of EVENT_DTYPE");
+    }
+    return static_cast<const OrderEvent*>(events.data());
+}
+
+// View one row of a snapshot; the snapshot object stays alive as the base
+py::array_t<double> RowView(py::object owner, BookSnapshot& snapshot, int row, int count) {
+    std::vector<py::ssize_t> shape{count};
+    std::vector<py::ssize_t> strides{static_cast<py::ssize_t>(sizeof(double))};
+    return py::array_t<double>(shape, strides, snapshot.Row(row), owner);
+}
+
+template <typename T>
+py::array_t<T, py::array::c_style | py::array::forcecast> Column(const py::handle& values, size_t count,
+                                                                 const char* name) {
+    auto column = py::array_t<T, py::array::c_style | py::array::forcecast>::ensure(values);
+    if (!column || column.ndim() != 1 || static_cast<size_t>(column.shape(0)) != count) {
+        throw py::value_error(std::string(name) + " must be a 1-D array matching timestamp_ns");
+    }
+    return column;
+}
+
+} // namespace
+
+PYBIND11_MODULE(orderbook_native, m) {
+    m.doc() = "Native limit order book with NumPy batch and snapshot APIs";
+    
+    m.attr("EVENT_ADD") = static_cast<int>(kEventAdd);
+    m.attr("EVENT_MODIFY") = static_cast<int>(kEventModify);
+    m.attr("EVENT_CANCEL") = static_cast<int>(kEventCancel);
+    m.attr("EVENT_REPLACE") = static_cast<int>(kEventReplace);
+    m.attr("EVENT_EXECUTE") = static_cast<int>(kEventExecute);
+    m.attr("EVENT_DTYPE") = EventDtype();
+    
+    m.def("apply_event_columns", [](const std::vector<LimitOrderBook*>& books, py::array timestamp_ns,
+                                    py::handle type, py::handle order_id, py::handle price,
+                                    py::handle quantity, py::handle is_buy, py::object book_index,
+                                    bool derived, int imbalance_levels) -> py::object {
+              auto timestamps = py::array_t<int64_t, py::array::c_style | py::array::forcecast>::ensure(timestamp_ns);
+              if (!timestamps || timestamps.ndim() != 1) {
+                  throw py::value_error("timestamp_ns must be a 1-D array");
+              }
+              size_t count = static_cast<size_t>(timestamps.shape(0));
+              auto types = Column<uint8_t>(type, count, "type");
+              auto ids = Column<uint64_t>(order_id, count, "order_id");
+              auto prices = Column<double>(price, count, "price");
+              auto quantities = Column<double>(quantity, count, "quantity");
+              auto sides = Column<uint8_t>(is_buy, count, "is_buy");
+              
+              EventColumns columns;
+              columns.timestamp_ns = timestamps.data();
+              columns.type = types.data();
+              columns.order_id = ids.data();
+              columns.price = prices.data();
+              columns.quantity = quantities.data();
+              columns.is_buy = sides.data();
+              
+              py::array_t<uint32_t, py::array::c_style | py::array::forcecast> indices;
+              if (!book_index.is_none()) {
+                  indices = Column<uint32_t>(book_index, count, "book_index");
+                  columns.book_index = indices.data();
+              }
+              
+              if (!derived) {
+                  size_t applied;
+                  {
+                      py::gil_scoped_release release;
+                      applied = ApplyEventColumns(books.data(), books.size(), columns, count);
+                  }
+                  return py::int_(applied);
+              }
+              
+              py::array_t<double> best_bid(count), best_ask(count), mid_price(count), imbalance(count);
+              DerivedColumns output;
+              output.best_bid = best_bid.mutable_data();
+              output.best_ask = best_ask.mutable_data();
+              output.mid_price = mid_price.mutable_data();
+              output.order_imbalance = imbalance.mutable_data();
+              output.imbalance_levels = imbalance_levels;
+              
+              size_t applied;
+              {
+                  py::gil_scoped_release release;
+                  applied = ApplyEventColumns(books.data(), books.size(), columns, count, &output);
+              }
+              py::dict outputs;
+              outputs["best_bid"] = best_bid;
+              outputs["best_ask"] = best_ask;
+              outputs["mid_price"] = mid_price;
+              outputs["order_imbalance"] = imbalance;
+              return py::make_tuple(applied, outputs);
+          },
+          py::arg("books"), py::arg("timestamp_ns"), py::arg("type"), py::arg("order_id"),
+          py::arg("price"), py::arg("quantity"), py::arg("is_buy"), py::arg("book_index") = py::none(),
+          py::arg("derived") = false, py::arg("imbalance_levels") = 5,
+          "Apply columnar events across books; book_index routes each event to books[i]");
+    
+    py::class_<BookSnapshot>(m, "BookSnapshot", py::buffer_protocol())
+        .def_buffer([](BookSnapshot& snapshot) {
+            py::ssize_t item = static_cast<py::ssize_t>(sizeof(double));
+            py::ssize_t depth = static_cast<py::ssize_t>(snapshot.depth);
+            return py::buffer_info(
+                snapshot.levels.data(), item, py::format_descriptor<double>::format(), 2,
+                {static_cast<py::ssize_t>(4), depth}, {item * depth, item});
+        })
+        .def_property_readonly("bid_prices", [](py::object self) {
+            auto& snapshot = self.cast<BookSnapshot&>();
+            return RowView(self, snapshot, 0, snapshot.bid_count);
+        })
+        .def_property_readonly("bid_volumes", [](py::object self) {
+            auto& snapshot = self.cast<BookSnapshot&>();
+            return RowView(self, snapshot, 1, snapshot.bid_count);
+        })
+        .def_property_readonly("ask_prices", [](py::object self) {
+            auto& snapshot = self.cast<BookSnapshot&>();
+            return RowView(self, snapshot, 2, snapshot.ask_count);
+        })
+        .def_property_readonly("ask_volumes", [](py::object self) {
+            auto& snapshot = self.cast<BookSnapshot&>();
+            return RowView(self, snapshot, 3, snapshot.ask_count);
+        })
+        .def_readonly("bid_count", &BookSnapshot::bid_count)
+        .def_readonly("ask_count", &BookSnapshot::ask_count)
+        .def_readonly("timestamp_ns", &BookSnapshot::timestamp_ns)
+        .def_readonly("mid_price", &BookSnapshot::mid_price)
+        .def_readonly("spread", &BookSnapshot::spread)
+        .def_readonly("order_imbalance", &BookSnapshot::order_imbalance);
+    
+    py::class_<LimitOrderBook>(m, "LimitOrderBook")
+        .def(py::init<const std::string&>(), py::arg("symbol"))
+        .def_property_readonly("symbol", &LimitOrderBook::GetSymbol)
+        .def("add_order", [](LimitOrderBook& book, const std::string& order_id, double price,
+                             double quantity, bool is_buy, int64_t timestamp_ns,
+                             double hidden_quantity, double peak_quantity,
+                             int64_t expire_time_ns, uint32_t owner_id) {
+                 auto order = std::make_shared<Order>(Order{order_id, price, quantity, is_buy, timestamp_ns});
+                 order->hidden_quantity = hidden_quantity;
+                 order->peak_quantity = peak_quantity;
+                 order->expire_time_ns = expire_time_ns;
+                 order->owner_id = owner_id;
+                 book.AddOrder(order);
+             },
+             py::arg("order_id"), py::arg("price"), py::arg("quantity"), py::arg("is_buy"),
+             py::arg("timestamp_ns") = 0, py::arg("hidden_quantity") = 0.0,
+             py::arg("peak_quantity") = 0.0, py::arg("expire_time_ns") = 0,
+             py::arg("owner_id") = 0)
+        .def("modify_order", &LimitOrderBook::ModifyOrder, py::arg("order_id"), py::arg("new_quantity"))
+        .def("cancel_order", &LimitOrderBook::CancelOrder, py::arg("order_id"))
+        .def("replace_order", &LimitOrderBook::ReplaceOrder,
+             py::arg("order_id"), py::arg("new_price"), py::arg("new_quantity"))
+        .def("execute_order", &LimitOrderBook::ExecuteOrder,
+             py::arg("order_id"), py::arg("exec_qty"), py::arg("trade_price"))
+        .def("advance_time", &LimitOrderBook::AdvanceTime, py::arg("now_ns"))
+        .def("clear", &LimitOrderBook::Clear)
+        .def("add_stop_order", [](LimitOrderBook& book, const std::string& order_id, double stop_price,
+                                  double quantity, bool is_buy, double limit_price, int64_t timestamp_ns) {
+                 return book.AddStopOrder(StopOrder{order_id, stop_price, limit_price, quantity, is_buy, timestamp_ns});
+             },
+             py::arg("order_id"), py::arg("stop_price"), py::arg("quantity"), py::arg("is_buy"),
+             py::arg("limit_price") = 0.0, py::arg("timestamp_ns") = 0)
+        .def("cancel_stop_order", &LimitOrderBook::CancelStopOrder, py::arg("order_id"))
+        .def_property_readonly("stop_order_count", &LimitOrderBook::GetStopOrderCount)
+        .def("report_trade_price", &LimitOrderBook::OnTradePrice, py::arg("price"))
+        .def("recent_trades", [](const LimitOrderBook& book, size_t count) {
+                 py::list trades;
+                 book.GetTradeTape().ForEachRecent(count, [&](const Trade& trade) {
+                     trades.append(py::make_tuple(trade.price, trade.quantity, trade.timestamp_ns, trade.is_buy));
+                 });
+                 return trades;
+             },
+             py::arg("count") = 100,
+             "Most recent executions, oldest first, as (price, quantity, timestamp_ns, is_buy)")
+        .def("mass_cancel", [](LimitOrderBook& book, bool include_bids, bool include_asks,
+                               double min_price, double max_price, uint32_t owner_id) {
+                 MassCancelFilter filter;
+                 filter.include_bids = include_bids;
+                 filter.include_asks = include_asks;
+                 filter.min_price = min_price;
+                 filter.max_price = max_price;
+                 filter.owner_id = owner_id;
+                 return book.MassCancel(filter);
+             },
+             py::arg("include_bids") = true, py::arg("include_asks") = true,
+             py::arg("min_price") = 0.0,
+             py::arg("max_price") = std::numeric_limits<double>::max(),
+             py::arg("owner_id") = 0)
+        // The GIL is released while events are applied, so a book must not
+        // be shared between Python threads without external locking
+        .def("apply_events", [](LimitOrderBook& book, const py::array& events) {
+                 const OrderEvent* data = CheckedEvents(events);
+                 size_t count = static_cast<size_t>(events.shape(0));
+                 py::gil_scoped_release release;
+                 return book.ApplyEvents(data, count);
+             },
+             py::arg("events"))
+        .def("snapshot", [](LimitOrderBook& book, int levels) {
+                 if (levels < 0) {
+                     throw py::value_error("levels must be non-negative");
+                 }
+                 auto snapshot = std::make_unique<BookSnapshot>(levels);
+                 {
+                     py::gil_scoped_release release;
+                     snapshot->bid_count = book.GetBidLevels(snapshot->Row(0), snapshot->Row(1), levels);
+                     snapshot->ask_count = book.GetAskLevels(snapshot->Row(2), snapshot->Row(3), levels);
+                     snapshot->timestamp_ns = book.GetCurrentTime();
+                     snapshot->mid_price = book.GetMidPrice();
+                     snapshot->spread = book.GetSpread();
+                     snapshot->order_imbalance = book.GetOrderImbalance();
+                 }
+                 return snapshot;
+             },
+             py::arg("levels") = 10)
+        .def_property_readonly("best_bid", &LimitOrderBook::GetBestBid)
+        .def_property_readonly("best_ask", &LimitOrderBook::GetBestAsk)
+        .def_property_readonly("mid_price", &LimitOrderBook::GetMidPrice)
+        .def_property_readonly("spread", &LimitOrderBook::GetSpread)
+        .def_property_readonly("order_count", &LimitOrderBook::GetOrderCount)
+        .def("order_imbalance", &LimitOrderBook::GetOrderImbalance, py::arg("levels") = 5)
+        .def("hidden_volume", &LimitOrderBook::GetHiddenVolume, py::arg("is_buy"), py::arg("price"))
+        .def("queue_position", &LimitOrderBook::GetQueuePosition, py::arg("order_id"))
+        .def("estimate_market_impact", &LimitOrderBook::EstimateMarketImpact,
+             py::arg("is_buy"), py::arg("quantity"));
+}
@@ -0,0 +1,138 @@
+import mmap
+import os
+import struct
+from typing import Dict, List, Optional
+
+import numpy as np
+
+# Layout of the region written by SnapshotRegion (core/src/orderbook/snapshot_region.h)
+REGION_MAGIC = 0x31304b4f4f42534d
+REGION_VERSION = 1
+HEADER_SIZE = 64
+SLOT_HEADER_SIZE = 80
+SYMBOL_SIZE = 16
+
+_HEADER = struct.Struct("<QIIIII")
+_SLOT_SCALARS = np.dtype([
+    ("sequence", "<u8"),
+    ("symbol", "S16"),
+    ("timestamp_ns", "<i8"),
+    ("best_bid", "<f8"),
+    ("best_ask", "<f8"),
+    ("mid_price", "<f8"),
+    ("spread", "<f8"),
+    ("order_imbalance", "<f8"),
+    ("bid_count", "<i4"),
+    ("ask_count", "<i4"),
+])
+
+class SnapshotRegionReader:
+    def __init__(self, name: str, shm_dir: str = "/dev/shm"):
+        """Read-only view of a shared-memory snapshot region.
+        
+        Reads are lock-free: each slot is copied and accepted only if its
+        sequence number was even and unchanged across the copy.
+        """
+        self.path = os.path.join(shm_dir, name.lstrip("/"))
+        self._open()
+        
+    def _open(self) -> None:
+        with open(self.path, "rb") as f:
+            identity = os.fstat(f.fileno())
+            region = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+            
+        magic, version, slot_count, depth, slot_size, _ = _HEADER.unpack_from(region, 0)
+        if magic != REGION_MAGIC or version != REGION_VERSION:
+            region.close()
+            raise ValueError(f"{self.path} is not a snapshot region")
+            
+        self._mmap = region
+        self._identity = (identity.st_dev, identity.st_ino)
+        self.slot_count = slot_count
+        self.depth = depth
+        self.slot_size = slot_size
+        
+        # Zero-copy views over the mapping: one scalar record and one
+        # 4 x depth level matrix per slot
+        buffer = np.frombuffer(self._mmap, dtype=np.uint8)
+        slots = buffer[HEADER_SIZE:HEADER_SIZE + slot_count * slot_size].reshape(slot_count, slot_size)
+        self._sequences = slots[:, :8].view("<u8")[:, 0]
+        self._scalars = [slots[i, :SLOT_HEADER_SIZE].view(_SLOT_SCALARS)[0] for i in range(slot_count)]
+        self._levels = slots[:, SLOT_HEADER_SIZE:SLOT_HEADER_SIZE + 32 * depth].view("<f8").reshape(slot_count, 4, depth)
+        self._slots_by_symbol = {}
+        
+    def close(self) -> None:
+        """Unmap the region"""
+        self._sequences = self._scalars = self._levels = None
+        self._mmap.close()
+        
+    def refresh(self) -> bool:
+        """Remap the region if its file was replaced, as when a restarted
+        writer recreates it; the old mapping would go on showing the last
+        book the previous writer published. Returns False while no valid
+        region exists under the name, keeping the current mapping."""
+        try:
+            stat = os.stat(self.path)
+        except OSError:
+            return False
+        if (stat.st_dev, stat.st_ino) == self._identity:
+            return True
+            
+        previous = self._mmap
+        try:
+            self._open()
+        except (OSError, ValueError):
+            return False
+        previous.close()
+        return True
+        
+    def slots_used(self) -> int:
+        return struct.unpack_from("<I", self._mmap, 24)[0]
+        
+    def symbols(self) -> List[str]:
+        """Symbols the writer has published so far"""
+        return [self._scalars[i]["symbol"].decode("utf-8") for i in range(self.slots_used())]
+        
+    def _find_slot(self, symbol: str) -> Optional[int]:
+        slot = self._slots_by_symbol.get(symbol)
+        if slot is None:
+            encoded = symbol.encode("utf-8")[:SYMBOL_SIZE - 1]
+            for i in range(self.slots_used()):
+                if self._scalars[i]["symbol"] == encoded:
+                    slot = i
+                    self._slots_by_symbol[symbol] = i
+                    break
+        return slot
+        
+    def read(self, symbol: str, max_retries: int = 1000) -> Optional[Dict]:
+        """Consistent snapshot for a symbol, or None if it is not published
+        or the writer kept the slot busy for max_retries attempts"""
+        slot = self._find_slot(symbol)
+        if slot is None:
+            return None
+            
+        for _ in range(max_retries):
+            before = int(self._sequences[slot])
+            if before & 1:
+                continue
+            scalars = self._scalars[slot].copy()
+            levels = self._levels[slot].copy()
+            if int(self._sequences[slot]) != before:
+                continue
+                
+            bid_count = min(max(int(scalars["bid_count"]), 0), self.depth)
+            ask_count = min(max(int(scalars["ask_count"]), 0), self.depth)
+            return {
+                "symbol": symbol,
+                "timestamp_ns": int(scalars["timestamp_ns"]),
+                "bid_prices": levels[0, :bid_count],
+                "bid_volumes": levels[1, :bid_count],
+                "ask_prices": levels[2, :ask_count],
+                "ask_volumes": levels[3, :ask_count],
+                "best_bid": float(scalars["best_bid"]),
+                "best_ask": float(scalars["best_ask"]),
+                "mid_price": float(scalars["mid_price"]),
+                "spread": float(scalars["spread"]),
+                "order_imbalance": float(scalars["order_imbalance"])
+            }
+        return None
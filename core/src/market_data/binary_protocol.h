@@ -0,0 +1,301 @@
+#pragma once
+
+#include "limit_order_book.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace microstructure {
+
+// Fixed-layout binary order feed, modelled on ITCH/PITCH. A buffer is a
+// run of length-prefixed messages, all little-endian:
+//
+//   uint16 length   whole message, including this field
+//   char   type
+//   uint16 locate   book index assigned by the session
+//   uint64 timestamp_ns
+//   uint64 order_id
+//   ... type-specific tail
+//
+//   'A' add      char side ('B'/'S'), uint32 shares, uint32 price
+//   'M' modify   uint32 shares (new remaining size)
+//   'D' delete   -
+//   'U' replace  uint32 shares, uint32 price
+//   'E' execute  uint32 shares, uint32 price (execution price)
+//
+// Prices carry four implied decimals. Unknown types are skipped by length,
+// so the feed can grow without breaking older decoders.
+//
+// Sequenced channels frame messages into packets (see sequenced_feed.h):
+//
+//   uint16 channel
+//   uint16 message_count
+//   uint64 sequence   of the first message; each message takes one number
+namespace wire {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "wire decoding assumes a little-endian host");
+
+constexpr char kAdd = 'A';
+constexpr char kModify = 'M';
+constexpr char kDelete = 'D';
+constexpr char kReplace = 'U';
+constexpr char kExecute = 'E';
+
+constexpr size_t kCommonSize = 21;      // length, type, locate, timestamp, order ID
+constexpr size_t kAddSize = kCommonSize + 9;
+constexpr size_t kModifySize = kCommonSize + 4;
+constexpr size_t kDeleteSize = kCommonSize;
+constexpr size_t kReplaceSize = kCommonSize + 8;
+constexpr size_t kExecuteSize = kCommonSize + 8;
+
+constexpr size_t kPacketHeaderSize = 12;
+
+constexpr double kPriceScale = 10000.0;
+
+template <typename T>
+inline T Load(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+template <typename T>
+inline void Store(uint8_t* p, T value) {
+    std::memcpy(p, &value, sizeof(T));
+}
+
+// Offset just past the first `count` messages, or size if the buffer ends
+// first. Messages are counted whatever their type.
+inline size_t SkipMessages(const uint8_t* data, size_t size, size_t count) {
+    size_t offset = 0;
+    while (count > 0 && size - offset >= sizeof(uint16_t)) {
+        size_t length = Load<uint16_t>(data + offset);
+        if (length < kCommonSize || length > size - offset) {
+            return size;
+        }
+        offset += length;
+        --count;
+    }
+    return offset;
+}
+
+} // namespace wire
+
+struct DecodeStats {
+    uint64_t messages = 0;      // Decoded into events
+    uint64_t skipped = 0;       // Unknown type, or too short for its type
+    uint64_t malformed = 0;     // Length below the common header; decoding stops
+};
+
+// Decodes messages straight out of a receive buffer into OrderEvents handed
+// to handler(locate, event). Nothing is copied or allocated; the handler is
+// a template parameter so the per-message call inlines.
+class BinaryDecoder {
+public:
+    // Returns the bytes consumed. A trailing partial message is left
+    // unconsumed so the caller can prepend it to the next read.
+    template <typename Handler>
+    size_t Decode(const uint8_t* data, size_t size, Handler&& handler) {
+        size_t offset = 0;
+        OrderEvent event{};
+        while (size - offset >= sizeof(uint16_t)) {
+            const uint8_t* msg = data + offset;
+            size_t length = wire::Load<uint16_t>(msg);
+            if (length < wire::kCommonSize) {
+                ++stats_.malformed;
+                return size;
+            }
+            if (length > size - offset) {
+                break;
+            }
+            offset += length;
+            
+            char type = static_cast<char>(msg[2]);
+            size_t needed = RequiredSize(type);
+            if (needed == 0 || length < needed) {
+                ++stats_.skipped;
+                continue;
+            }
+            
+            uint16_t locate = wire::Load<uint16_t>(msg + 3);
+            event.timestamp_ns = wire::Load<int64_t>(msg + 5);
+            event.order_id = wire::Load<uint64_t>(msg + 13);
+            event.is_buy = 0;
+            event.price = 0.0;
+            event.quantity = 0.0;
+            const uint8_t* tail = msg + wire::kCommonSize;
+            switch (type) {
+                case wire::kAdd:
+                    event.type = kEventAdd;
+                    event.is_buy = tail[0] == 'B';
+                    event.quantity = wire::Load<uint32_t>(tail + 1);
+                    event.price = wire::Load<uint32_t>(tail + 5) / wire::kPriceScale;
+                    break;
+                case wire::kModify:
+                    event.type = kEventModify;
+                    event.quantity = wire::Load<uint32_t>(tail);
+                    break;
+                case wire::kDelete:
+                    event.type = kEventCancel;
+                    break;
+                case wire::kReplace:
+                    event.type = kEventReplace;
+                    event.quantity = wire::Load<uint32_t>(tail);
+                    event.price = wire::Load<uint32_t>(tail + 4) / wire::kPriceScale;
+                    break;
+                case wire::kExecute:
+                    event.type = kEventExecute;
+                    event.quantity = wire::Load<uint32_t>(tail);
+                    event.price = wire::Load<uint32_t>(tail + 4) / wire::kPriceScale;
+                    break;
+            }
+            ++stats_.messages;
+            handler(locate, event);
+        }
+        return offset;
+    }
+    
+    const DecodeStats& GetStats() const { return stats_; }
+    void ResetStats() { stats_ = DecodeStats(); }
+    
+private:
+    static size_t RequiredSize(char type) {
+        switch (type) {
+            case wire::kAdd: return wire::kAddSize;
+            case wire::kModify: return wire::kModifySize;
+            case wire::kDelete: return wire::kDeleteSize;
+            case wire::kReplace: return wire::kReplaceSize;
+            case wire::kExecute: return wire::kExecuteSize;
+            default: return 0;
+        }
+    }
+    
+    DecodeStats stats_;
+};
+
+// Handler applying decoded events to books indexed by locate
+class BookDispatcher {
+public:
+    BookDispatcher(LimitOrderBook* const* books, size_t book_count)
+        : books_(books), book_count_(book_count) {}
+    
+    void operator()(uint16_t locate, const OrderEvent& event) {
+        if (locate < book_count_ && books_[locate]) {
+            books_[locate]->ApplyEvent(event);
+        }
+    }
+    
+private:
+    LimitOrderBook* const* books_;
+    size_t book_count_;
+};
+
+// Appends messages in the wire format, for tests, replay files and
+// loopback publishers. Messages carrying a price return false and append
+// nothing when it does not fit the unsigned fixed-point field, i.e. is
+// negative, NaN or at least 2^32 / kPriceScale.
+class BinaryEncoder {
+public:
+    explicit BinaryEncoder(std::vector<uint8_t>& out) : out_(out) {}
+    
+    bool Add(uint16_t locate, int64_t timestamp_ns, uint64_t order_id, bool is_buy,
+             uint32_t shares, double price) {
+        if (!IsWirePrice(price)) {
+            return false;
+        }
+        uint8_t* tail = Begin(wire::kAdd, wire::kAddSize, locate, timestamp_ns, order_id);
+        tail[0] = is_buy ? 'B' : 'S';
+        wire::Store<uint32_t>(tail + 1, shares);
+        wire::Store<uint32_t>(tail + 5, ToWirePrice(price));
+        return true;
+    }
+    
+    void Modify(uint16_t locate, int64_t timestamp_ns, uint64_t order_id, uint32_t shares) {
+        uint8_t* tail = Begin(wire::kModify, wire::kModifySize, locate, timestamp_ns, order_id);
+        wire::Store<uint32_t>(tail, shares);
+    }
+    
+    void Delete(uint16_t locate, int64_t timestamp_ns, uint64_t order_id) {
+        Begin(wire::kDelete, wire::kDeleteSize, locate, timestamp_ns, order_id);
+    }
+    
+    bool Replace(uint16_t locate, int64_t timestamp_ns, uint64_t order_id, uint32_t shares, double price) {
+        if (!IsWirePrice(price)) {
+            return false;
+        }
+        uint8_t* tail = Begin(wire::kReplace, wire::kReplaceSize, locate, timestamp_ns, order_id);
+        wire::Store<uint32_t>(tail, shares);
+        wire::Store<uint32_t>(tail + 4, ToWirePrice(price));
+        return true;
+    }
+    
+    bool Execute(uint16_t locate, int64_t timestamp_ns, uint64_t order_id, uint32_t shares, double price) {
+        if (!IsWirePrice(price)) {
+            return false;
+        }
+        uint8_t* tail = Begin(wire::kExecute, wire::kExecuteSize, locate, timestamp_ns, order_id);
+        wire::Store<uint32_t>(tail, shares);
+        wire::Store<uint32_t>(tail + 4, ToWirePrice(price));
+        return true;
+    }
+    
+    static bool IsWirePrice(double price) {
+        // Rounded the same way as ToWirePrice; false for NaN
+        return price >= 0.0 && price * wire::kPriceScale + 0.5 < 4294967296.0;
+    }
+    
+private:
+    static uint32_t ToWirePrice(double price) {
+        return static_cast<uint32_t>(price * wire::kPriceScale + 0.5);
+    }
+    
+    uint8_t* Begin(char type, size_t length, uint16_t locate, int64_t timestamp_ns, uint64_t order_id) {
+        size_t offset = out_.size();
+        out_.resize(offset + length);
+        uint8_t* msg = out_.data() + offset;
+        wire::Store<uint16_t>(msg, static_cast<uint16_t>(length));
+        msg[2] = static_cast<uint8_t>(type);
+        wire::Store<uint16_t>(msg + 3, locate);
+        wire::Store<int64_t>(msg + 5, timestamp_ns);
+        wire::Store<uint64_t>(msg + 13, order_id);
+        return msg + wire::kCommonSize;
+    }
+    
+    std::vector<uint8_t>& out_;
+};
+
+// Frames the messages appended between Begin and Finish into one
+// sequenced packet
+class PacketWriter {
+public:
+    explicit PacketWriter(std::vector<uint8_t>& out) : out_(out), encoder_(out) {}
+    
+    void Begin(uint16_t channel, uint64_t sequence) {
+        start_ = out_.size();
+        out_.resize(start_ + wire::kPacketHeaderSize);
+        wire::Store<uint16_t>(out_.data() + start_, channel);
+        wire::Store<uint64_t>(out_.data() + start_ + 4, sequence);
+    }
+    
+    BinaryEncoder& GetEncoder() { return encoder_; }
+    
+    // Writes the message count into the header and returns it
+    uint16_t Finish() {
+        size_t body = start_ + wire::kPacketHeaderSize;
+        uint16_t count = 0;
+        for (size_t offset = body; offset < out_.size(); ++count) {
+            offset += wire::Load<uint16_t>(out_.data() + offset);
+        }
+        wire::Store<uint16_t>(out_.data() + start_ + 2, count);
+        return count;
+    }
+    
+private:
+    std::vector<uint8_t>& out_;
+    BinaryEncoder encoder_;
+    size_t start_ = 0;
+};
+
+} // namespace microstructure
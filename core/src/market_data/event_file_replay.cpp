@@ -0,0 +1,250 @@
+#include "event_file_replay.h"
+#include "spsc_ring.h"
+#include "stage_latency.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <zlib.h>
+
+namespace microstructure {
+
+namespace {
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Fixed pool of blocks passed from the inflate thread to the book stage
+// and back again through two SPSC rings
+struct BlockQueue {
+    BlockQueue(size_t count, size_t size)
+        : block_size(size), storage(count * size), sizes(count), filled(count), empty(count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            empty.TryPush(i);
+        }
+    }
+    
+    uint8_t* GetData(uint32_t block) { return storage.data() + block * block_size; }
+    
+    size_t block_size;
+    std::vector<uint8_t> storage;
+    std::vector<size_t> sizes;
+    SpscRing<uint32_t> filled;
+    SpscRing<uint32_t> empty;
+};
+
+struct InflateResult {
+    bool ok = true;
+    bool compressed = false;
+    uint64_t bytes_out = 0;
+    int64_t busy_ns = 0;
+};
+
+// Producer side: fills blocks from the reader, inflating gzip input
+class BlockProducer {
+public:
+    explicit BlockProducer(BlockQueue& queue) : queue_(queue), backoff_(WaitStrategy::kAdaptive) {}
+    
+    InflateResult Run(ChunkedFileReader& reader) {
+        InflateResult result;
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        bool first = true;
+        bool stream_open = false;
+        bool member_ended = false;
+        FileChunk chunk;
+        
+        while (result.ok && reader.Next(&chunk)) {
+            if (first) {
+                first = false;
+                result.compressed = chunk.size >= 2 && chunk.data[0] == 0x1f && chunk.data[1] == 0x8b;
+                // 15 + 32 accepts gzip and zlib headers
+                if (result.compressed) {
+                    stream_open = inflateInit2(&stream, 15 + 32) == Z_OK;
+                    result.ok = stream_open;
+                }
+            }
+            if (!result.compressed) {
+                Copy(chunk.data, chunk.size, &result);
+                continue;
+            }
+            
+            stream.next_in = const_cast<Bytef*>(chunk.data);
+            stream.avail_in = static_cast<uInt>(chunk.size);
+            while (stream.avail_in > 0) {
+                Reserve();
+                stream.next_out = queue_.GetData(block_) + used_;
+                stream.avail_out = static_cast<uInt>(queue_.block_size - used_);
+                int64_t begin_ns = NowNs();
+                int status = inflate(&stream, Z_NO_FLUSH);
+                result.busy_ns += NowNs() - begin_ns;
+                size_t produced = queue_.block_size - used_ - stream.avail_out;
+                used_ += produced;
+                result.bytes_out += produced;
+                if (produced > 0 || status == Z_OK) {
+                    member_ended = false;
+                }
+                if (status == Z_STREAM_END) {
+                    // Concatenated members (gzip -c a b, bgzip) follow on
+                    member_ended = true;
+                    inflateReset(&stream);
+                } else if (status != Z_OK) {
+                    result.ok = false;
+                    break;
+                }
+                if (used_ == queue_.block_size) {
+                    Publish();
+                }
+            }
+        }
+        Publish();
+        
+        if (stream_open) {
+            // A compressed stream must end on a member boundary
+            result.ok = result.ok && member_ended;
+            inflateEnd(&stream);
+        }
+        result.ok = result.ok && !reader.HasError();
+        return result;
+    }
+    
+private:
+    void Copy(const uint8_t* data, size_t size, InflateResult* result) {
+        int64_t begin_ns = NowNs();
+        while (size > 0) {
+            Reserve();
+            size_t count = std::min(size, queue_.block_size - used_);
+            std::memcpy(queue_.GetData(block_) + used_, data, count);
+            used_ += count;
+            data += count;
+            size -= count;
+            result->bytes_out += count;
+            if (used_ == queue_.block_size) {
+                Publish();
+            }
+        }
+        result->busy_ns += NowNs() - begin_ns;
+    }
+    
+    void Reserve() {
+        if (have_block_) {
+            return;
+        }
+        while (queue_.empty.TryPopBatch(&block_, 1) == 0) {
+            backoff_.Idle();
+        }
+        backoff_.Reset();
+        have_block_ = true;
+        used_ = 0;
+    }
+    
+    void Publish() {
+        if (!have_block_ || used_ == 0) {
+            return;
+        }
+        queue_.sizes[block_] = used_;
+        // The ring holds every block, so this cannot fail
+        queue_.filled.TryPush(block_);
+        have_block_ = false;
+    }
+    
+    BlockQueue& queue_;
+    Backoff backoff_;
+    uint32_t block_ = 0;
+    size_t used_ = 0;
+    bool have_block_ = false;
+};
+
+} // namespace
+
+EventFileReplay::EventFileReplay(LimitOrderBook* const* books, size_t book_count, const EventFileOptions& options)
+    : books_(books, books + book_count), options_(options) {}
+
+bool EventFileReplay::Run(const std::string& path, EventFileStats* stats) {
+    *stats = EventFileStats{};
+    ChunkedFileReader reader;
+    if (!reader.Open(path, options_.reader)) {
+        return false;
+    }
+    stats->backend = reader.GetBackend();
+    decoder_.ResetStats();
+    carry_.clear();
+    
+    BlockQueue queue(std::max<size_t>(options_.block_count, 2), std::max<size_t>(options_.block_size, 64));
+    InflateResult inflated;
+    std::atomic<bool> producer_done{false};
+    int64_t start_ns = NowNs();
+    std::thread producer([&] {
+        BlockProducer blocks(queue);
+        inflated = blocks.Run(reader);
+        producer_done.store(true, std::memory_order_release);
+    });
+    
+    Backoff backoff(WaitStrategy::kAdaptive);
+    int64_t apply_ns = 0;
+    int64_t wait_ns = 0;
+    uint32_t block;
+    while (true) {
+        // Read the flag first so no block published before it is missed
+        bool done = producer_done.load(std::memory_order_acquire);
+        if (queue.filled.TryPopBatch(&block, 1)) {
+            backoff.Reset();
+            int64_t begin_ns = NowNs();
+            ApplyBlock(queue.GetData(block), queue.sizes[block]);
+            apply_ns += NowNs() - begin_ns;
+            queue.empty.TryPush(block);
+            continue;
+        }
+        if (done) {
+            break;
+        }
+        int64_t idle_ns = NowNs();
+        backoff.Idle();
+        wait_ns += NowNs() - idle_ns;
+    }
+    producer.join();
+    
+    const DecodeStats& decoded = decoder_.GetStats();
+    stats->bytes_read = reader.GetBytesRead();
+    stats->bytes_decompressed = inflated.bytes_out;
+    stats->messages = decoded.messages;
+    stats->skipped = decoded.skipped;
+    stats->malformed = decoded.malformed;
+    stats->truncated_bytes = carry_.size();
+    stats->compressed = inflated.compressed;
+    stats->elapsed_seconds = (NowNs() - start_ns) / 1e9;
+    stats->read_wait_seconds = reader.GetWaitSeconds();
+    stats->decompress_seconds = inflated.busy_ns / 1e9;
+    stats->apply_seconds = apply_ns / 1e9;
+    stats->apply_wait_seconds = wait_ns / 1e9;
+    return inflated.ok;
+}
+
+void EventFileReplay::ApplyBlock(const uint8_t* data, size_t size) {
+    BookDispatcher dispatcher(books_.data(), books_.size());
+    size_t offset = 0;
+    
+    // Complete a message split across the previous block boundary
+    while (!carry_.empty() && offset < size) {
+        size_t want = carry_.size() < 2 ? 2 : std::max<size_t>(wire::Load<uint16_t>(carry_.data()), 2);
+        if (carry_.size() < want) {
+            size_t take = std::min(want - carry_.size(), size - offset);
+            carry_.insert(carry_.end(), data + offset, data + offset + take);
+            offset += take;
+        }
+        if (carry_.size() >= 2 && carry_.size() >= wire::Load<uint16_t>(carry_.data())) {
+            DecodeWithStageTiming(decoder_, carry_.data(), carry_.size(), dispatcher);
+            carry_.clear();
+        }
+    }
+    
+    size_t used = DecodeWithStageTiming(decoder_, data + offset, size - offset, dispatcher);
+    carry_.insert(carry_.end(), data + offset + used, data + size);
+}
+
+} // namespace microstructure
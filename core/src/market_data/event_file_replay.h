@@ -0,0 +1,60 @@
+#pragma once
+
+#include "binary_protocol.h"
+#include "file_reader.h"
+#include "limit_order_book.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace microstructure {
+
+struct EventFileOptions {
+    FileReaderOptions reader;
+    size_t block_size = 1 << 20;    // Decompressed bytes handed to the book stage at a time
+    size_t block_count = 8;
+};
+
+struct EventFileStats {
+    uint64_t bytes_read;
+    uint64_t bytes_decompressed;
+    uint64_t messages;
+    uint64_t skipped;
+    uint64_t malformed;
+    uint64_t truncated_bytes;       // Partial message left at the end of the stream
+    bool compressed;
+    ReadBackend backend;
+    double elapsed_seconds;
+    double read_wait_seconds;       // Decompress stage waiting on the disk
+    double decompress_seconds;
+    double apply_seconds;
+    double apply_wait_seconds;      // Book stage waiting on decompression
+};
+
+// Streams a file of binary wire messages, plain or gzip (multi-member
+// files included), into books[locate] as three overlapping stages:
+//
+//   ChunkedFileReader (io_uring or pread pool) -> inflate thread
+//       -> SPSC ring of blocks -> decode and apply on the calling thread
+//
+// Messages split across blocks are carried over, so block and chunk sizes
+// need not line up with message boundaries.
+class EventFileReplay {
+public:
+    EventFileReplay(LimitOrderBook* const* books, size_t book_count, const EventFileOptions& options);
+    
+    // False if the file cannot be opened or read, or the compressed stream
+    // is corrupt or cut short; stats cover what was applied either way
+    bool Run(const std::string& path, EventFileStats* stats);
+    
+private:
+    void ApplyBlock(const uint8_t* data, size_t size);
+    
+    std::vector<LimitOrderBook*> books_;
+    EventFileOptions options_;
+    BinaryDecoder decoder_;
+    std::vector<uint8_t> carry_;
+};
+
+} // namespace microstructure
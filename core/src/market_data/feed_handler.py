@@ -138,6 +138,23 @@ class MarketDataFeedHandler:
                         symbol,
                         order_id
                     )
+                elif event_type == "replace":
+                    self.order_book.replace_order(
+                        symbol,
+                        order_id,
+                        event["price"],
+                        event["quantity"]
+                    )
+                elif event_type == "execute":
+                    self.order_book.execute_order(
+                        symbol,
+                        order_id,
+                        event["quantity"],
+                        event["price"]
+                    )
+                    
+                # Share the updated book with other processes, if a region is attached
+                self.order_book.publish_snapshot(symbol)
                 
                 # Process for analyzer
                 self.analyzer.process_order(
@@ -0,0 +1,231 @@
+#include "feed_pipeline.h"
+
+#include <algorithm>
+
+namespace microstructure {
+
+FeedPipeline::FeedPipeline(const std::vector<std::string>& symbols, const Options& options)
+    : options_(options),
+      input_ring_(options.ring_capacity),
+      update_ring_(options.ring_capacity),
+      stamp_ring_(options.ring_capacity) {
+    options_.batch_size = std::max<size_t>(options_.batch_size, 1);
+    books_.reserve(symbols.size());
+    for (const auto& symbol : symbols) {
+        books_.push_back(std::make_unique<LimitOrderBook>(symbol));
+    }
+    if (options_.analyzer_window > 0) {
+        MicrostructureAnalyzer::Options analyzer_options;
+        analyzer_options.window_size = options_.analyzer_window;
+        analyzer_options.imbalance_levels = options_.imbalance_levels;
+        analyzers_.assign(symbols.size(), MicrostructureAnalyzer(analyzer_options));
+    }
+}
+
+FeedPipeline::~FeedPipeline() {
+    Stop();
+}
+
+bool FeedPipeline::Start(BatchCallback on_updates) {
+    if (running_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    on_updates_ = std::move(on_updates);
+    stopping_.store(false, std::memory_order_relaxed);
+    book_stage_done_.store(false, std::memory_order_relaxed);
+    running_.store(true, std::memory_order_release);
+    
+    book_thread_ = std::thread(&FeedPipeline::RunBookStage, this);
+    analytics_thread_ = std::thread(&FeedPipeline::RunAnalyticsStage, this);
+    return true;
+}
+
+void FeedPipeline::Stop() {
+    if (!running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    stopping_.store(true, std::memory_order_release);
+    book_thread_.join();
+    analytics_thread_.join();
+    running_.store(false, std::memory_order_release);
+}
+
+size_t FeedPipeline::Submit(const FeedEvent* events, size_t count) {
+    size_t accepted = input_ring_.TryPushBatch(events, count);
+    uint64_t begin = submitted_.fetch_add(accepted, std::memory_order_relaxed);
+    if (accepted > 0 && IsStageTimingEnabled()) {
+        // A full stamp ring only costs the queue wait samples of this call
+        stamp_ring_.TryPush(SubmitStamp{begin, begin + accepted, ReadStageClock()});
+    }
+    if (accepted < count) {
+        rejected_.fetch_add(count - accepted, std::memory_order_relaxed);
+    }
+    return accepted;
+}
+
+FeedPipelineStats FeedPipeline::GetStats() const {
+    FeedPipelineStats stats;
+    stats.submitted = submitted_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    stats.applied = applied_.load(std::memory_order_relaxed);
+    stats.delivered = delivered_.load(std::memory_order_relaxed);
+    stats.callback_batches = callback_batches_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+const LimitOrderBook* FeedPipeline::GetBook(size_t index) const {
+    if (index >= books_.size() || running_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return books_[index].get();
+}
+
+void FeedPipeline::RunBookStage() {
+    std::vector<FeedEvent> events(options_.batch_size);
+    std::vector<BookUpdate> updates(options_.batch_size);
+    Backoff backoff(options_.wait_strategy);
+    
+    while (true) {
+        size_t count = input_ring_.TryPopBatch(events.data(), events.size());
+        if (count == 0) {
+            // Only exit once the producer has stopped and the ring is empty
+            if (stopping_.load(std::memory_order_acquire) && input_ring_.GetSize() == 0) {
+                break;
+            }
+            backoff.Idle();
+            continue;
+        }
+        backoff.Reset();
+        BOOK_PROBE1(pipeline_batch, count);
+        
+        bool timed = IsStageTimingEnabled();
+        if (timed) {
+            RecordQueueWait(count, ReadStageClock());
+        }
+        consumed_ += count;
+        
+        size_t produced = 0;
+        uint64_t begin = 0;
+        uint64_t applied_at = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const FeedEvent& input = events[i];
+            if (input.book_index >= books_.size()) {
+                continue;
+            }
+            LimitOrderBook& book = *books_[input.book_index];
+            if (timed) {
+                begin = ReadStageClock();
+            }
+            if (!book.ApplyEvent(input.event)) {
+                continue;
+            }
+            if (timed) {
+                applied_at = ReadStageClock();
+                RecordStageTicks(PipelineStage::kApply, begin, applied_at);
+            }
+            
+            BookUpdate& update = updates[produced++];
+            update.timestamp_ns = input.event.timestamp_ns;
+            update.order_id = input.event.order_id;
+            update.price = input.event.price;
+            update.quantity = input.event.quantity;
+            update.best_bid = book.GetBestBid();
+            update.best_ask = book.GetBestAsk();
+            if (!analyzers_.empty()) {
+                const MicrostructureMetrics& metrics =
+                    analyzers_[input.book_index].Update(book, input.event.timestamp_ns);
+                update.mid_price = metrics.mid_price;
+                update.order_imbalance = metrics.order_imbalance;
+                update.spread = metrics.spread;
+                update.price_impact = metrics.price_impact;
+                update.realized_volatility = metrics.realized_volatility;
+            } else {
+                update.mid_price = book.GetMidPrice();
+                update.order_imbalance = book.GetOrderImbalance(options_.imbalance_levels);
+                update.spread = 0.0;
+                update.price_impact = 0.0;
+                update.realized_volatility = 0.0;
+            }
+            update.book_index = input.book_index;
+            update.type = input.event.type;
+            update.is_buy = input.event.is_buy;
+            if (timed) {
+                RecordStageTicks(PipelineStage::kMetrics, applied_at, ReadStageClock());
+            }
+        }
+        applied_.fetch_add(produced, std::memory_order_relaxed);
+        BOOK_PROBE1(pipeline_batch_done, produced);
+        
+        // Apply backpressure rather than drop when analytics falls behind
+        size_t pushed = 0;
+        Backoff push_backoff(options_.wait_strategy);
+        while (pushed < produced) {
+            size_t n = update_ring_.TryPushBatch(updates.data() + pushed, produced - pushed);
+            pushed += n;
+            if (n == 0) {
+                push_backoff.Idle();
+            }
+        }
+    }
+    book_stage_done_.store(true, std::memory_order_release);
+}
+
+void FeedPipeline::RunAnalyticsStage() {
+    std::vector<BookUpdate> updates(options_.batch_size);
+    Backoff backoff(options_.wait_strategy);
+    
+    while (true) {
+        size_t count = update_ring_.TryPopBatch(updates.data(), updates.size());
+        if (count == 0) {
+            if (book_stage_done_.load(std::memory_order_acquire) && update_ring_.GetSize() == 0) {
+                break;
+            }
+            backoff.Idle();
+            continue;
+        }
+        backoff.Reset();
+        
+        if (on_updates_) {
+            if (IsStageTimingEnabled()) {
+                uint64_t begin = ReadStageClock();
+                on_updates_(updates.data(), count);
+                RecordStageTicks(PipelineStage::kPublish, begin, ReadStageClock());
+            } else {
+                on_updates_(updates.data(), count);
+            }
+        }
+        delivered_.fetch_add(count, std::memory_order_relaxed);
+        callback_batches_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void FeedPipeline::RecordQueueWait(size_t count, uint64_t now) {
+    // Events [consumed_, last) were just popped; match them against the
+    // stamps, skipping stamps for events already consumed untimed
+    uint64_t next = consumed_;
+    uint64_t last = consumed_ + count;
+    while (next < last) {
+        if (!has_stamp_) {
+            if (stamp_ring_.TryPopBatch(&stamp_, 1) == 0) {
+                break;
+            }
+            has_stamp_ = true;
+        }
+        if (stamp_.end <= next) {
+            has_stamp_ = false;
+            continue;
+        }
+        uint64_t from = std::max(next, stamp_.begin);
+        if (from >= last) {
+            break;
+        }
+        uint64_t to = std::min(last, stamp_.end);
+        uint64_t wait_ns = now > stamp_.ticks ? StageTicksToNs(now - stamp_.ticks) : 0;
+        for (uint64_t i = from; i < to; ++i) {
+            RecordStageLatency(PipelineStage::kQueueWait, wait_ns);
+        }
+        next = to;
+    }
+}
+
+} // namespace microstructure
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "limit_order_book.h"
+#include "microstructure_analyzer.h"
+#include "spsc_ring.h"
+#include "stage_latency.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace microstructure {
+
+// Event handed to the pipeline by the producer, routed by book index
+struct FeedEvent {
+    OrderEvent event;
+    uint32_t book_index;
+    uint32_t reserved;
+};
+
+// Book state after one event, produced by the book thread. Layout matches
+// ob_book_update_t in the C ABI.
+struct BookUpdate {
+    int64_t timestamp_ns;
+    uint64_t order_id;
+    double price;
+    double quantity;
+    double best_bid;
+    double best_ask;
+    double mid_price;
+    double order_imbalance;
+    double spread;                  // Analyzer metrics; 0 when the analyzer is off
+    double price_impact;
+    double realized_volatility;
+    uint32_t book_index;
+    uint8_t type;
+    uint8_t is_buy;
+    uint8_t reserved[2];
+};
+
+struct FeedPipelineStats {
+    uint64_t submitted;         // Accepted by Submit
+    uint64_t rejected;          // Refused because the input ring was full; retries count again
+    uint64_t applied;           // Applied to a book
+    uint64_t delivered;         // Handed to the batch callback
+    uint64_t callback_batches;
+};
+
+// Native replacement for the queue.Queue feed handler:
+//
+//   producer -> SPSC ring -> book thread -> SPSC ring -> analytics thread
+//
+// The book thread owns the books and applies events in batches; the
+// analytics thread hands updates to a callback in batches, so a Python
+// subscriber pays one GIL acquisition per batch rather than per event.
+// Rings and event structs are preallocated, and both stages idle with the
+// configured WaitStrategy. Submit may be called from one thread only.
+// While stage timing is enabled the pipeline records queue wait, apply,
+// metrics and publish latencies (stage_latency.h).
+class FeedPipeline {
+public:
+    using BatchCallback = std::function<void(const BookUpdate* updates, size_t count)>;
+    
+    struct Options {
+        size_t ring_capacity = 1 << 16;
+        size_t batch_size = 256;
+        int imbalance_levels = 5;
+        WaitStrategy wait_strategy = WaitStrategy::kAdaptive;
+        
+        // Run a MicrostructureAnalyzer per book on the book thread with
+        // this many returns in its volatility window; 0 disables it
+        size_t analyzer_window = 0;
+    };
+    
+    FeedPipeline(const std::vector<std::string>& symbols, const Options& options);
+    ~FeedPipeline();
+    
+    FeedPipeline(const FeedPipeline&) = delete;
+    FeedPipeline& operator=(const FeedPipeline&) = delete;
+    
+    // Start both stage threads; returns false if already running
+    bool Start(BatchCallback on_updates);
+    
+    // Drain everything submitted so far, then join both threads
+    void Stop();
+    
+    // Non-blocking; returns the number of events accepted
+    size_t Submit(const FeedEvent* events, size_t count);
+    
+    FeedPipelineStats GetStats() const;
+    size_t GetBookCount() const { return books_.size(); }
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    
+    // Books may only be inspected while the pipeline is stopped
+    const LimitOrderBook* GetBook(size_t index) const;
+    
+    // Safe while running, for metrics scrapes
+    const std::string& GetSymbol(size_t index) const { return books_[index]->GetSymbol(); }
+    const BookCounters& GetBookCounters(size_t index) const { return books_[index]->GetCounters(); }
+    size_t GetInputDepth() const { return input_ring_.GetSize(); }
+    size_t GetUpdateDepth() const { return update_ring_.GetSize(); }
+    
+private:
+    // Submit time of events [begin, end) of the submitted sequence
+    struct SubmitStamp {
+        uint64_t begin;
+        uint64_t end;
+        uint64_t ticks;
+    };
+    
+    void RunBookStage();
+    void RunAnalyticsStage();
+    void RecordQueueWait(size_t count, uint64_t now);
+    
+    Options options_;
+    std::vector<std::unique_ptr<LimitOrderBook>> books_;
+    std::vector<MicrostructureAnalyzer> analyzers_;     // Empty when disabled
+    SpscRing<FeedEvent> input_ring_;
+    SpscRing<BookUpdate> update_ring_;
+    SpscRing<SubmitStamp> stamp_ring_;
+    BatchCallback on_updates_;
+    
+    std::thread book_thread_;
+    std::thread analytics_thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> book_stage_done_{false};
+    
+    // Each counter is written by one thread only
+    alignas(kCacheLineSize) std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> rejected_{0};
+    alignas(kCacheLineSize) std::atomic<uint64_t> applied_{0};
+    alignas(kCacheLineSize) std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> callback_batches_{0};
+    
+    // Book thread only
+    uint64_t consumed_ = 0;
+    SubmitStamp stamp_{};
+    bool has_stamp_ = false;
+};
+
+} // namespace microstructure
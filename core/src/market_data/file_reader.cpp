@@ -0,0 +1,419 @@
+#include "file_reader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define MICROSTRUCTURE_HAVE_IO_URING 1
+#endif
+
+namespace microstructure {
+
+namespace {
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Read the whole range, retrying short reads; returns bytes read or -errno
+int64_t ReadFully(int fd, uint8_t* buffer, size_t size, uint64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t result = pread(fd, buffer + done, size - done, static_cast<off_t>(offset + done));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (result == 0) {
+            break;
+        }
+        done += static_cast<size_t>(result);
+    }
+    return static_cast<int64_t>(done);
+}
+
+class ThreadPoolEngine : public ReadEngine {
+public:
+    ThreadPoolEngine(int fd, size_t tags, size_t threads) : fd_(fd), results_(tags), done_(tags, false) {
+        for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+            workers_.emplace_back(&ThreadPoolEngine::Work, this);
+        }
+    }
+    
+    ~ThreadPoolEngine() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_ready_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+    
+    bool Submit(uint32_t tag, uint8_t* buffer, size_t size, uint64_t offset) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_[tag] = false;
+            queue_.push_back(Request{tag, buffer, size, offset});
+        }
+        work_ready_.notify_one();
+        return true;
+    }
+    
+    int64_t Wait(uint32_t tag) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        read_done_.wait(lock, [&] { return done_[tag]; });
+        return results_[tag];
+    }
+    
+private:
+    struct Request {
+        uint32_t tag;
+        uint8_t* buffer;
+        size_t size;
+        uint64_t offset;
+    };
+    
+    void Work() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            work_ready_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            Request request = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            int64_t result = ReadFully(fd_, request.buffer, request.size, request.offset);
+            lock.lock();
+            results_[request.tag] = result;
+            done_[request.tag] = true;
+            read_done_.notify_all();
+        }
+    }
+    
+    int fd_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable read_done_;
+    std::deque<Request> queue_;
+    std::vector<int64_t> results_;
+    std::vector<bool> done_;
+    std::vector<std::thread> workers_;
+    bool stopping_ = false;
+};
+
+#ifdef MICROSTRUCTURE_HAVE_IO_URING
+
+// io_uring through the raw syscalls, so liburing is not needed. Reads use
+// IORING_OP_READV, available since the first io_uring kernels.
+class IoUringEngine : public ReadEngine {
+public:
+    ~IoUringEngine() override {
+        // Reads still in flight write into the caller's buffers
+        Flush();
+        while (in_flight_ > 0 && Reap()) {
+        }
+        if (sq_ring_ && sq_ring_ != MAP_FAILED) {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (cq_ring_ && cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sqes_ && sqes_ != MAP_FAILED) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (ring_fd_ >= 0) {
+            ::close(ring_fd_);
+        }
+    }
+    
+    // Returns false if the kernel refuses io_uring, e.g. under a seccomp
+    // profile or with kernel.io_uring_disabled set
+    bool Init(int fd, size_t tags) {
+        fd_ = fd;
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(tags), &params));
+        if (ring_fd_ < 0) {
+            return false;
+        }
+        
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        cq_ring_ = single_mmap ? sq_ring_
+                               : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                      ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            return false;
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     ring_fd_, IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED) {
+            return false;
+        }
+        
+        uint8_t* sq = static_cast<uint8_t*>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        uint8_t* cq = static_cast<uint8_t*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        
+        iovecs_.resize(tags);
+        requests_.resize(tags);
+        results_.resize(tags);
+        done_.assign(tags, false);
+        return true;
+    }
+    
+    bool Submit(uint32_t tag, uint8_t* buffer, size_t size, uint64_t offset) override {
+        unsigned tail = *sq_tail_ + pending_;
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        iovecs_[tag].iov_base = buffer;
+        iovecs_[tag].iov_len = size;
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = fd_;
+        sqe->off = offset;
+        sqe->addr = reinterpret_cast<uint64_t>(&iovecs_[tag]);
+        sqe->len = 1;
+        sqe->user_data = tag;
+        sq_array_[index] = index;
+        requests_[tag] = Request{buffer, size, offset};
+        done_[tag] = false;
+        ++pending_;
+        return true;
+    }
+    
+    void Flush() override {
+        if (pending_ == 0) {
+            return;
+        }
+        __atomic_store_n(sq_tail_, *sq_tail_ + pending_, __ATOMIC_RELEASE);
+        unsigned to_submit = pending_;
+        pending_ = 0;
+        while (to_submit > 0) {
+            long submitted = syscall(__NR_io_uring_enter, ring_fd_, to_submit, 0, 0, nullptr, 0);
+            if (submitted < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                return;
+            }
+            to_submit -= static_cast<unsigned>(submitted);
+            in_flight_ += static_cast<unsigned>(submitted);
+        }
+    }
+    
+    int64_t Wait(uint32_t tag) override {
+        Flush();
+        while (!done_[tag]) {
+            if (!Reap()) {
+                return -EIO;
+            }
+        }
+        
+        // A short read is finished synchronously rather than resubmitted
+        int64_t result = results_[tag];
+        const Request& request = requests_[tag];
+        if (result >= 0 && static_cast<size_t>(result) < request.size) {
+            int64_t rest = ReadFully(fd_, request.buffer + result, request.size - result, request.offset + result);
+            result = rest < 0 ? rest : result + rest;
+        }
+        return result;
+    }
+    
+private:
+    struct Request {
+        uint8_t* buffer;
+        size_t size;
+        uint64_t offset;
+    };
+    
+    // Record whatever has completed, waiting for at least one completion
+    // if none has; false if the ring fails or nothing is in flight
+    bool Reap() {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            if (in_flight_ == 0) {
+                return false;
+            }
+            long result = syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            return result >= 0 || errno == EINTR;
+        }
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            uint32_t completed = static_cast<uint32_t>(cqe.user_data);
+            results_[completed] = cqe.res;
+            done_[completed] = true;
+            --in_flight_;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return true;
+    }
+    
+    int fd_ = -1;
+    int ring_fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    void* sqes_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    size_t sqes_size_ = 0;
+    
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned pending_ = 0;
+    unsigned in_flight_ = 0;
+    
+    std::vector<iovec> iovecs_;
+    std::vector<Request> requests_;
+    std::vector<int64_t> results_;
+    std::vector<bool> done_;
+};
+
+#endif
+
+} // namespace
+
+ChunkedFileReader::~ChunkedFileReader() {
+    Close();
+}
+
+bool ChunkedFileReader::Open(const std::string& path, const FileReaderOptions& options) {
+    Close();
+    if (options.chunk_size == 0 || options.queue_depth == 0) {
+        return false;
+    }
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    
+    fd_ = fd;
+    file_size_ = static_cast<uint64_t>(info.st_size);
+    chunk_size_ = options.chunk_size;
+    depth_ = options.queue_depth;
+    chunk_count_ = (file_size_ + chunk_size_ - 1) / chunk_size_;
+    buffers_.resize(chunk_size_ * depth_);
+
+#ifdef MICROSTRUCTURE_HAVE_IO_URING
+    if (options.backend != ReadBackend::kThreadPool) {
+        auto engine = std::make_unique<IoUringEngine>();
+        if (engine->Init(fd_, depth_)) {
+            engine_ = std::move(engine);
+            backend_ = ReadBackend::kIoUring;
+        }
+    }
+#endif
+    if (!engine_) {
+        if (options.backend == ReadBackend::kIoUring) {
+            Close();
+            return false;
+        }
+        engine_ = std::make_unique<ThreadPoolEngine>(fd_, depth_, options.threads);
+        backend_ = ReadBackend::kThreadPool;
+    }
+    return true;
+}
+
+void ChunkedFileReader::Close() {
+    // The engine may still be reading into the buffers
+    engine_.reset();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    file_size_ = 0;
+    chunk_count_ = 0;
+    next_issue_ = 0;
+    next_chunk_ = 0;
+    bytes_read_ = 0;
+    wait_ns_ = 0;
+    error_ = false;
+}
+
+void ChunkedFileReader::IssueReads() {
+    // The chunk handed out last time is released, so its slot can be reused
+    uint64_t limit = std::min(chunk_count_, next_chunk_ + depth_);
+    for (; next_issue_ < limit; ++next_issue_) {
+        uint32_t slot = static_cast<uint32_t>(next_issue_ % depth_);
+        uint64_t offset = next_issue_ * chunk_size_;
+        size_t size = static_cast<size_t>(std::min<uint64_t>(chunk_size_, file_size_ - offset));
+        engine_->Submit(slot, buffers_.data() + slot * chunk_size_, size, offset);
+    }
+    engine_->Flush();
+}
+
+bool ChunkedFileReader::Next(FileChunk* chunk) {
+    if (!engine_ || error_ || next_chunk_ >= chunk_count_) {
+        return false;
+    }
+    IssueReads();
+    
+    uint32_t slot = static_cast<uint32_t>(next_chunk_ % depth_);
+    uint64_t offset = next_chunk_ * chunk_size_;
+    size_t expected = static_cast<size_t>(std::min<uint64_t>(chunk_size_, file_size_ - offset));
+    int64_t start_ns = NowNs();
+    int64_t result = engine_->Wait(slot);
+    wait_ns_ += NowNs() - start_ns;
+    if (result < 0 || static_cast<size_t>(result) != expected) {
+        // Failed, or the file shrank under us
+        error_ = true;
+        return false;
+    }
+    
+    chunk->data = buffers_.data() + slot * chunk_size_;
+    chunk->size = expected;
+    chunk->offset = offset;
+    bytes_read_ += expected;
+    ++next_chunk_;
+    return true;
+}
+
+} // namespace microstructure
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace microstructure {
+
+enum class ReadBackend {
+    kAuto,          // io_uring when the kernel allows it, otherwise the thread pool
+    kIoUring,
+    kThreadPool
+};
+
+struct FileReaderOptions {
+    size_t chunk_size = 1 << 20;
+    size_t queue_depth = 8;         // Reads in flight ahead of the consumer
+    size_t threads = 4;             // pread workers for the thread pool backend
+    ReadBackend backend = ReadBackend::kAuto;
+};
+
+struct FileChunk {
+    const uint8_t* data;
+    size_t size;
+    uint64_t offset;
+};
+
+// Source of completed reads; implemented over io_uring and over a pread
+// thread pool in file_reader.cpp
+class ReadEngine {
+public:
+    virtual ~ReadEngine() = default;
+    
+    // Queue a read of size bytes at offset into buffer; tag identifies it
+    virtual bool Submit(uint32_t tag, uint8_t* buffer, size_t size, uint64_t offset) = 0;
+    
+    // Hand queued reads to the kernel or the workers
+    virtual void Flush() {}
+    
+    // Block until the read with this tag completes; returns bytes read or
+    // a negative errno
+    virtual int64_t Wait(uint32_t tag) = 0;
+};
+
+// Sequential file read with queue_depth chunk reads kept in flight, so the
+// disk works ahead while the consumer processes earlier chunks. Chunks
+// come back in file order.
+class ChunkedFileReader {
+public:
+    ChunkedFileReader() = default;
+    ~ChunkedFileReader();
+    
+    ChunkedFileReader(const ChunkedFileReader&) = delete;
+    ChunkedFileReader& operator=(const ChunkedFileReader&) = delete;
+    
+    // Returns false if the file cannot be opened or the requested backend
+    // is unavailable
+    bool Open(const std::string& path, const FileReaderOptions& options);
+    void Close();
+    
+    // Next chunk in file order, blocking until it is read. The chunk stays
+    // valid until the following call. False at the end or on a read error.
+    bool Next(FileChunk* chunk);
+    
+    bool HasError() const { return error_; }
+    ReadBackend GetBackend() const { return backend_; }
+    uint64_t GetFileSize() const { return file_size_; }
+    uint64_t GetBytesRead() const { return bytes_read_; }
+    
+    // Time Next spent waiting on reads that had not completed
+    double GetWaitSeconds() const { return wait_ns_ / 1e9; }
+    
+private:
+    void IssueReads();
+    
+    int fd_ = -1;
+    ReadBackend backend_ = ReadBackend::kAuto;
+    std::unique_ptr<ReadEngine> engine_;
+    
+    size_t chunk_size_ = 0;
+    size_t depth_ = 0;
+    std::vector<uint8_t> buffers_;
+    
+    uint64_t file_size_ = 0;
+    uint64_t chunk_count_ = 0;
+    uint64_t next_issue_ = 0;       // First chunk not yet submitted
+    uint64_t next_chunk_ = 0;       // Next chunk to hand out
+    uint64_t bytes_read_ = 0;
+    int64_t wait_ns_ = 0;
+    bool error_ = false;
+};
+
+} // namespace microstructure
@@ -0,0 +1,188 @@
+import ctypes
+import logging
+import time
+from typing import Callable, Dict, Optional, Sequence
+
+import numpy as np
+
+from core.src.integration.cpp_interface import (
+    OrderBookInterface, EVENT_ADD, EVENT_MODIFY, EVENT_CANCEL, EVENT_REPLACE, EVENT_EXECUTE
+)
+
+EVENT_TYPES = {
+    "add": EVENT_ADD,
+    "modify": EVENT_MODIFY,
+    "cancel": EVENT_CANCEL,
+    "replace": EVENT_REPLACE,
+    "execute": EVENT_EXECUTE
+}
+
+# Mirrors ob_feed_event_t
+FEED_EVENT_DTYPE = np.dtype([
+    ("timestamp_ns", "<i8"),
+    ("order_id", "<u8"),
+    ("price", "<f8"),
+    ("quantity", "<f8"),
+    ("type", "u1"),
+    ("is_buy", "u1"),
+    ("reserved", "u1", (6,)),
+    ("book_index", "<u4"),
+    ("reserved2", "<u4"),
+])
+
+# Mirrors ob_book_update_t
+BOOK_UPDATE_DTYPE = np.dtype([
+    ("timestamp_ns", "<i8"),
+    ("order_id", "<u8"),
+    ("price", "<f8"),
+    ("quantity", "<f8"),
+    ("best_bid", "<f8"),
+    ("best_ask", "<f8"),
+    ("mid_price", "<f8"),
+    ("order_imbalance", "<f8"),
+    ("spread", "<f8"),
+    ("price_impact", "<f8"),
+    ("realized_volatility", "<f8"),
+    ("book_index", "<u4"),
+    ("type", "u1"),
+    ("is_buy", "u1"),
+    ("reserved", "u1", (2,)),
+])
+
+class FeedStats(ctypes.Structure):
+    """Pipeline counters (ob_feed_stats_t)"""
+    _fields_ = [
+        ("submitted", ctypes.c_uint64),
+        ("rejected", ctypes.c_uint64),
+        ("applied", ctypes.c_uint64),
+        ("delivered", ctypes.c_uint64),
+        ("callback_batches", ctypes.c_uint64),
+    ]
+
+UPDATE_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_void_p, ctypes.c_size_t, ctypes.c_void_p)
+
+class NativeFeedHandler:
+    def __init__(self,
+                order_book_interface: OrderBookInterface,
+                symbols: Sequence[str],
+                ring_capacity: int = 65536,
+                batch_size: int = 256,
+                busy_spin: bool = False,
+                analyzer_window: int = 0):
+        """Feed handler backed by the native SPSC pipeline.
+        
+        Events are applied to pipeline-owned books on a native thread and
+        subscribers receive book updates in batches as NumPy arrays of
+        BOOK_UPDATE_DTYPE, so the GIL is taken once per batch. Order IDs
+        must be numeric. Only one thread may submit events. A non-zero
+        analyzer_window runs the native MicrostructureAnalyzer per book and
+        fills the spread, price_impact and realized_volatility fields.
+        """
+        self.lib = order_book_interface.lib
+        self.symbols = list(symbols)
+        self.symbol_index = {symbol: i for i, symbol in enumerate(self.symbols)}
+        self._configure_lib()
+        
+        names = (ctypes.c_char_p * len(self.symbols))(*[s.encode('utf-8') for s in self.symbols])
+        self._handle = self.lib.create_feed_pipeline(names, len(self.symbols), ring_capacity,
+                                                     batch_size, busy_spin, analyzer_window)
+        
+        # Must stay referenced while the pipeline can call it
+        self._callback = UPDATE_CALLBACK(self._on_updates)
+        self._single_event = np.zeros(1, dtype=FEED_EVENT_DTYPE)
+        
+        self.is_running = False
+        self.order_book_subscribers = []
+        self.logger = logging.getLogger("NativeFeedHandler")
+        
+    def _configure_lib(self):
+        if getattr(self.lib, "_feed_configured", False):
+            return
+        self.lib.create_feed_pipeline.argtypes = [ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t,
+                                                  ctypes.c_size_t, ctypes.c_size_t, ctypes.c_bool,
+                                                  ctypes.c_size_t]
+        self.lib.create_feed_pipeline.restype = ctypes.c_void_p
+        self.lib.destroy_feed_pipeline.argtypes = [ctypes.c_void_p]
+        self.lib.start_feed_pipeline.argtypes = [ctypes.c_void_p, UPDATE_CALLBACK, ctypes.c_void_p]
+        self.lib.start_feed_pipeline.restype = ctypes.c_bool
+        self.lib.stop_feed_pipeline.argtypes = [ctypes.c_void_p]
+        self.lib.submit_feed_events.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+        self.lib.submit_feed_events.restype = ctypes.c_size_t
+        self.lib.get_feed_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(FeedStats)]
+        self.lib._feed_configured = True
+        
+    def start(self):
+        """Start the native book and analytics threads"""
+        if self.is_running:
+            return
+            
+        self.lib.start_feed_pipeline(self._handle, self._callback, None)
+        self.is_running = True
+        self.logger.info("Native feed handler started")
+        
+    def stop(self):
+        """Drain submitted events and stop the native threads"""
+        if not self.is_running:
+            return
+            
+        # ctypes releases the GIL here, so in-flight callbacks can finish
+        self.lib.stop_feed_pipeline(self._handle)
+        self.is_running = False
+        self.logger.info("Native feed handler stopped")
+        
+    def close(self):
+        """Stop the pipeline and free its books"""
+        self.stop()
+        if self._handle:
+            self.lib.destroy_feed_pipeline(self._handle)
+            self._handle = None
+            
+    def subscribe_to_order_book(self, callback: Callable):
+        """Subscribe to batches of book updates: callback(updates) with a
+        BOOK_UPDATE_DTYPE array; book_index indexes self.symbols"""
+        self.order_book_subscribers.append(callback)
+        
+    def submit_events(self, events: np.ndarray) -> int:
+        """Submit a FEED_EVENT_DTYPE array without blocking; returns the
+        number accepted (the rest did not fit in the ring)"""
+        events = np.ascontiguousarray(events, dtype=FEED_EVENT_DTYPE)
+        return self.lib.submit_feed_events(self._handle, events.ctypes.data, len(events))
+        
+    def submit_order_event(self,
+                          symbol: str,
+                          event_type: str,
+                          order_id: int,
+                          price: Optional[float] = None,
+                          quantity: Optional[float] = None,
+                          is_buy: Optional[bool] = None,
+                          timestamp_ns: Optional[int] = None) -> bool:
+        """Submit a single order event; returns False if the ring is full"""
+        if timestamp_ns is None:
+            timestamp_ns = time.time_ns()
+            
+        event = self._single_event[0]
+        event["timestamp_ns"] = timestamp_ns
+        event["order_id"] = int(order_id)
+        event["price"] = price or 0.0
+        event["quantity"] = quantity or 0.0
+        event["type"] = EVENT_TYPES[event_type]
+        event["is_buy"] = bool(is_buy)
+        event["book_index"] = self.symbol_index[symbol]
+        return self.submit_events(self._single_event) == 1
+        
+    def get_stats(self) -> Dict[str, int]:
+        """Pipeline counters"""
+        stats = FeedStats()
+        self.lib.get_feed_stats(self._handle, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in FeedStats._fields_}
+        
+    def _on_updates(self, updates_ptr, count, user_data):
+        # Runs on the native analytics thread; the buffer is reused after
+        # return, so subscribers get a copy
+        try:
+            buffer = (ctypes.c_char * (count * BOOK_UPDATE_DTYPE.itemsize)).from_address(updates_ptr)
+            updates = np.frombuffer(buffer, dtype=BOOK_UPDATE_DTYPE).copy()
+            for callback in self.order_book_subscribers:
+                callback(updates)
+        except Exception as e:
+            self.logger.error(f"Error in book update subscriber: {str(e)}")
@@ -0,0 +1,372 @@
+#include "pcap_reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace microstructure {
+
+namespace {
+
+constexpr uint32_t kPcapMagicMicro = 0xa1b2c3d4;
+constexpr uint32_t kPcapMagicNano = 0xa1b23c4d;
+constexpr uint32_t kPcapngSectionHeader = 0x0a0d0d0a;
+constexpr uint32_t kPcapngByteOrderMagic = 0x1a2b3c4d;
+constexpr uint32_t kPcapngInterfaceBlock = 1;
+constexpr uint32_t kPcapngSimplePacketBlock = 3;
+constexpr uint32_t kPcapngEnhancedPacketBlock = 6;
+constexpr uint16_t kOptionTimestampResolution = 9;
+
+constexpr uint16_t kLinkNull = 0;
+constexpr uint16_t kLinkEthernet = 1;
+constexpr uint16_t kLinkRawIp = 101;
+constexpr uint16_t kLinkRawIpAlt = 12;
+constexpr uint16_t kLinkLinuxSll = 113;
+constexpr uint16_t kLinkLinuxSll2 = 276;
+
+constexpr uint16_t kEtherTypeIpv4 = 0x0800;
+constexpr uint16_t kEtherTypeIpv6 = 0x86dd;
+constexpr uint16_t kEtherTypeVlan = 0x8100;
+constexpr uint16_t kEtherTypeQinQ = 0x88a8;
+constexpr uint8_t kProtocolUdp = 17;
+
+// Network headers are big-endian whatever the capture's byte order
+uint16_t LoadBe16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+} // namespace
+
+PcapReader::~PcapReader() {
+    Close();
+}
+
+bool PcapReader::Open(const std::string& path) {
+    Close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    // Captures are read front to back exactly once
+    madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+    
+    data_ = static_cast<const uint8_t*>(mapping);
+    size_ = info.st_size;
+    mapped_ = true;
+    if (!ParseHeader()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool PcapReader::OpenBuffer(const uint8_t* data, size_t size) {
+    Close();
+    data_ = data;
+    size_ = size;
+    if (!ParseHeader()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void PcapReader::Close() {
+    if (mapped_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    offset_ = 0;
+    mapped_ = false;
+}
+
+bool PcapReader::ParseHeader() {
+    if (size_ < 4) {
+        return false;
+    }
+    uint32_t magic;
+    std::memcpy(&magic, data_, sizeof(magic));
+    if (magic == kPcapngSectionHeader) {
+        pcapng_ = true;
+        first_record_ = 0;
+    } else {
+        pcapng_ = false;
+        if (size_ < 24) {
+            return false;
+        }
+        uint32_t swapped = __builtin_bswap32(magic);
+        if (magic == kPcapMagicMicro || magic == kPcapMagicNano) {
+            swapped_ = false;
+        } else if (swapped == kPcapMagicMicro || swapped == kPcapMagicNano) {
+            swapped_ = true;
+            magic = swapped;
+        } else {
+            return false;
+        }
+        nanosecond_ = magic == kPcapMagicNano;
+        // The upper bits of the link type field carry FCS flags
+        link_type_ = static_cast<uint16_t>(Read32(data_ + 20) & 0xffff);
+        first_record_ = 24;
+    }
+    Rewind();
+    return true;
+}
+
+void PcapReader::Rewind() {
+    offset_ = first_record_;
+    interfaces_.clear();
+    last_timestamp_ns_ = 0;
+    stats_ = PcapReaderStats{};
+}
+
+bool PcapReader::Next(CapturedPacket* packet) {
+    if (!data_) {
+        return false;
+    }
+    return pcapng_ ? NextPcapng(packet) : NextPcap(packet);
+}
+
+bool PcapReader::NextPcap(CapturedPacket* packet) {
+    while (size_ - offset_ >= 16) {
+        const uint8_t* record = data_ + offset_;
+        uint32_t seconds = Read32(record);
+        uint32_t fraction = Read32(record + 4);
+        uint32_t captured = Read32(record + 8);
+        if (captured > size_ - offset_ - 16) {
+            // The capture was cut off mid-record
+            return false;
+        }
+        offset_ += 16 + captured;
+        ++stats_.records;
+        
+        int64_t timestamp_ns = static_cast<int64_t>(seconds) * 1000000000LL +
+                               (nanosecond_ ? fraction : static_cast<int64_t>(fraction) * 1000);
+        if (ExtractUdp(link_type_, record + 16, captured, timestamp_ns, packet)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PcapReader::NextPcapng(CapturedPacket* packet) {
+    while (size_ - offset_ >= 12) {
+        const uint8_t* block = data_ + offset_;
+        uint32_t type;
+        std::memcpy(&type, block, sizeof(type));
+        if (type == kPcapngSectionHeader) {
+            // Each section declares its own byte order and interfaces
+            uint32_t byte_order;
+            std::memcpy(&byte_order, block + 8, sizeof(byte_order));
+            if (byte_order == kPcapngByteOrderMagic) {
+                swapped_ = false;
+            } else if (__builtin_bswap32(byte_order) == kPcapngByteOrderMagic) {
+                swapped_ = true;
+            } else {
+                return false;
+            }
+            interfaces_.clear();
+        } else {
+            type = Read32(block);
+        }
+        
+        uint32_t total_length = Read32(block + 4);
+        if (total_length < 12 || total_length > size_ - offset_) {
+            return false;
+        }
+        offset_ += total_length;
+        const uint8_t* body = block + 8;
+        size_t body_length = total_length - 12;
+        
+        if (type == kPcapngInterfaceBlock && body_length >= 8) {
+            Interface interface{Read16(body), 1000000};
+            size_t option = 8;
+            while (option + 4 <= body_length) {
+                uint16_t code = Read16(body + option);
+                uint16_t length = Read16(body + option + 2);
+                if (code == 0 || length > body_length - option - 4) {
+                    break;
+                }
+                if (code == kOptionTimestampResolution && length >= 1) {
+                    uint8_t resolution = body[option + 4];
+                    bool binary = resolution & 0x80;
+                    int exponent = resolution & 0x7f;
+                    uint64_t ticks = 1;
+                    if (exponent >= (binary ? 64 : 20)) {
+                        // Finer than a 64-bit tick rate can express; the
+                        // interface's packets are skipped
+                        ticks = 0;
+                    } else if (binary) {
+                        ticks <<= exponent;
+                    } else {
+                        for (int i = 0; i < exponent; ++i) {
+                            ticks *= 10;
+                        }
+                    }
+                    interface.ticks_per_second = ticks;
+                }
+                option += 4 + ((length + 3) & ~3u);
+            }
+            interfaces_.push_back(interface);
+        } else if (type == kPcapngEnhancedPacketBlock && body_length >= 20) {
+            ++stats_.records;
+            uint32_t interface_id = Read32(body);
+            uint64_t ticks = (static_cast<uint64_t>(Read32(body + 4)) << 32) | Read32(body + 8);
+            uint32_t captured = Read32(body + 12);
+            if (interface_id >= interfaces_.size() || captured > body_length - 20 ||
+                interfaces_[interface_id].ticks_per_second == 0) {
+                ++stats_.skipped;
+                continue;
+            }
+            const Interface& interface = interfaces_[interface_id];
+            uint64_t per_second = interface.ticks_per_second;
+            // The sub-second part is scaled in 128 bits: at picosecond or
+            // finer resolution it exceeds 64 bits once multiplied out
+            uint64_t fraction_ns = static_cast<uint64_t>(
+                static_cast<unsigned __int128>(ticks % per_second) * 1000000000ULL / per_second);
+            int64_t timestamp_ns = static_cast<int64_t>(ticks / per_second * 1000000000ULL + fraction_ns);
+            last_timestamp_ns_ = timestamp_ns;
+            if (ExtractUdp(interface.link_type, body + 20, captured, timestamp_ns, packet)) {
+                return true;
+            }
+        } else if (type == kPcapngSimplePacketBlock && body_length >= 4) {
+            // Simple packets carry no timestamp; they inherit the last one
+            ++stats_.records;
+            if (interfaces_.empty()) {
+                ++stats_.skipped;
+                continue;
+            }
+            uint32_t original = Read32(body);
+            size_t captured = std::min<size_t>(original, body_length - 4);
+            if (ExtractUdp(interfaces_[0].link_type, body + 4, captured, last_timestamp_ns_, packet)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool PcapReader::ExtractUdp(uint16_t link_type, const uint8_t* frame, size_t captured,
+                            int64_t timestamp_ns, CapturedPacket* packet) {
+    size_t offset = 0;
+    uint16_t ether_type = 0;
+    switch (link_type) {
+        case kLinkEthernet:
+            if (captured < 14) {
+                break;
+            }
+            ether_type = LoadBe16(frame + 12);
+            offset = 14;
+            while ((ether_type == kEtherTypeVlan || ether_type == kEtherTypeQinQ) && captured >= offset + 4) {
+                ether_type = LoadBe16(frame + offset + 2);
+                offset += 4;
+            }
+            break;
+        case kLinkRawIp:
+        case kLinkRawIpAlt:
+            if (captured >= 1) {
+                uint8_t version = frame[0] >> 4;
+                ether_type = version == 4 ? kEtherTypeIpv4 : version == 6 ? kEtherTypeIpv6 : 0;
+            }
+            break;
+        case kLinkNull:
+            if (captured >= 4) {
+                // Address family in the capturing host's byte order
+                uint32_t family = Read32(frame);
+                ether_type = family == 2 ? kEtherTypeIpv4
+                           : (family == 24 || family == 28 || family == 30) ? kEtherTypeIpv6 : 0;
+                offset = 4;
+            }
+            break;
+        case kLinkLinuxSll:
+            if (captured >= 16) {
+                ether_type = LoadBe16(frame + 14);
+                offset = 16;
+            }
+            break;
+        case kLinkLinuxSll2:
+            if (captured >= 20) {
+                ether_type = LoadBe16(frame);
+                offset = 20;
+            }
+            break;
+    }
+    
+    if (ether_type == kEtherTypeIpv4 && captured >= offset + 20) {
+        const uint8_t* ip = frame + offset;
+        size_t header_length = (ip[0] & 0x0f) * 4;
+        uint16_t fragment = LoadBe16(ip + 6);
+        // Only unfragmented datagrams carry a whole UDP payload
+        if (ip[9] != kProtocolUdp || (fragment & 0x3fff) != 0 || header_length < 20) {
+            ++stats_.skipped;
+            return false;
+        }
+        offset += header_length;
+    } else if (ether_type == kEtherTypeIpv6 && captured >= offset + 40) {
+        if (frame[offset + 6] != kProtocolUdp) {
+            ++stats_.skipped;
+            return false;
+        }
+        offset += 40;
+    } else {
+        ++stats_.skipped;
+        return false;
+    }
+    
+    if (captured < offset + 8) {
+        ++stats_.truncated;
+        return false;
+    }
+    const uint8_t* udp = frame + offset;
+    uint16_t dst_port = LoadBe16(udp + 2);
+    size_t udp_length = LoadBe16(udp + 4);
+    if (udp_length < 8) {
+        ++stats_.skipped;
+        return false;
+    }
+    if (port_filter_ != 0 && dst_port != port_filter_) {
+        ++stats_.skipped;
+        return false;
+    }
+    size_t payload_length = udp_length - 8;
+    if (captured < offset + 8 + payload_length) {
+        // The snap length cut the payload short
+        ++stats_.truncated;
+        return false;
+    }
+    
+    packet->timestamp_ns = timestamp_ns;
+    packet->payload = udp + 8;
+    packet->size = payload_length;
+    packet->dst_port = dst_port;
+    ++stats_.udp_packets;
+    return true;
+}
+
+uint16_t PcapReader::Read16(const uint8_t* p) const {
+    uint16_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return swapped_ ? __builtin_bswap16(value) : value;
+}
+
+uint32_t PcapReader::Read32(const uint8_t* p) const {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return swapped_ ? __builtin_bswap32(value) : value;
+}
+
+} // namespace microstructure
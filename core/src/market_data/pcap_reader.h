@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace microstructure {
+
+// UDP datagram found in a capture. payload points into the reader's
+// buffer and stays valid as long as the reader does.
+struct CapturedPacket {
+    int64_t timestamp_ns;
+    const uint8_t* payload;
+    size_t size;
+    uint16_t dst_port;
+};
+
+struct PcapReaderStats {
+    uint64_t records;           // Capture records seen
+    uint64_t udp_packets;       // Returned by Next
+    uint64_t skipped;           // Not IPv4/IPv6 UDP, filtered port, or a later fragment
+    uint64_t truncated;         // Cut short by the capture snap length
+};
+
+// Reads classic pcap (microsecond or nanosecond, either byte order) and
+// pcapng captures without libpcap. Link layers handled: Ethernet with
+// VLAN tags, raw IP, BSD loopback and Linux cooked (SLL, SLL2). The file
+// is mapped read-only and packets are returned in place.
+class PcapReader {
+public:
+    PcapReader() = default;
+    ~PcapReader();
+    
+    PcapReader(const PcapReader&) = delete;
+    PcapReader& operator=(const PcapReader&) = delete;
+    
+    // Map a capture file; returns false if it cannot be read or is neither
+    // pcap nor pcapng
+    bool Open(const std::string& path);
+    
+    // Read from a caller-owned buffer instead of a file
+    bool OpenBuffer(const uint8_t* data, size_t size);
+    
+    // Only return datagrams to this UDP destination port; 0 accepts all
+    void SetPortFilter(uint16_t port) { port_filter_ = port; }
+    
+    // Next UDP datagram; false at the end of the capture
+    bool Next(CapturedPacket* packet);
+    
+    // Start again from the first record
+    void Rewind();
+    
+    const PcapReaderStats& GetStats() const { return stats_; }
+    
+private:
+    struct Interface {
+        uint16_t link_type;
+        uint64_t ticks_per_second;  // 0 if the resolution is unusable
+    };
+    
+    bool ParseHeader();
+    bool NextPcap(CapturedPacket* packet);
+    bool NextPcapng(CapturedPacket* packet);
+    bool ExtractUdp(uint16_t link_type, const uint8_t* frame, size_t captured,
+                    int64_t timestamp_ns, CapturedPacket* packet);
+    uint16_t Read16(const uint8_t* p) const;
+    uint32_t Read32(const uint8_t* p) const;
+    void Close();
+    
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    size_t first_record_ = 0;
+    bool mapped_ = false;
+    
+    bool pcapng_ = false;
+    bool swapped_ = false;
+    bool nanosecond_ = false;
+    uint16_t link_type_ = 0;
+    std::vector<Interface> interfaces_;
+    int64_t last_timestamp_ns_ = 0;
+    
+    uint16_t port_filter_ = 0;
+    PcapReaderStats stats_{};
+};
+
+} // namespace microstructure
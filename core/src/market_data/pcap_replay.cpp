@@ -0,0 +1,109 @@
+#include "pcap_replay.h"
+#include "stage_latency.h"
+
+#include <chrono>
+#include <thread>
+
+namespace microstructure {
+
+namespace {
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Sleep until this close to a deadline, then spin
+constexpr int64_t kSpinWindowNs = 100000;
+
+} // namespace
+
+PcapReplay::PcapReplay(LimitOrderBook* const* books, size_t book_count, const ReplayOptions& options)
+    : books_(books, books + book_count), options_(options) {}
+
+ReplayStats PcapReplay::Run(PcapReader& reader) {
+    ReplayStats stats;
+    CapturedPacket packet;
+    int64_t first_capture_ns = 0;
+    int64_t last_capture_ns = 0;
+    int64_t start_ns = NowNs();
+    
+    while (reader.Next(&packet)) {
+        if (stats.packets == 0) {
+            first_capture_ns = packet.timestamp_ns;
+        }
+        last_capture_ns = packet.timestamp_ns;
+        
+        if (options_.speed > 0.0) {
+            int64_t offset_ns = static_cast<int64_t>((packet.timestamp_ns - first_capture_ns) / options_.speed);
+            WaitUntil(start_ns + offset_ns, stats);
+        }
+        
+        int64_t begin_ns = NowNs();
+        stats.messages += ApplyPacket(packet.payload, packet.size, stats);
+        stats.processing.Record(static_cast<uint64_t>(NowNs() - begin_ns));
+        stats.bytes += packet.size;
+        ++stats.packets;
+    }
+    
+    stats.elapsed_seconds = (NowNs() - start_ns) / 1e9;
+    stats.capture_seconds = (last_capture_ns - first_capture_ns) / 1e9;
+    return stats;
+}
+
+void PcapReplay::WaitUntil(int64_t deadline_ns, ReplayStats& stats) {
+    int64_t now_ns = NowNs();
+    if (deadline_ns - now_ns > kSpinWindowNs) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(deadline_ns - now_ns - kSpinWindowNs));
+    }
+    while ((now_ns = NowNs()) < deadline_ns) {
+    }
+    stats.lag.Record(static_cast<uint64_t>(now_ns - deadline_ns));
+}
+
+size_t PcapReplay::ApplyPacket(const uint8_t* data, size_t size, ReplayStats& stats) {
+    size_t before = decoder_.GetStats().messages;
+    BookDispatcher dispatcher(books_.data(), books_.size());
+    if (!options_.sequenced) {
+        DecodeWithStageTiming(decoder_, data, size, dispatcher);
+        return decoder_.GetStats().messages - before;
+    }
+    
+    if (size < wire::kPacketHeaderSize) {
+        return 0;
+    }
+    uint16_t channel = wire::Load<uint16_t>(data);
+    uint16_t count = wire::Load<uint16_t>(data + 2);
+    uint64_t sequence = wire::Load<uint64_t>(data + 4);
+    uint64_t end = sequence + count;
+    
+    // The first packet seen on a channel sets its sequence
+    auto inserted = next_sequence_.emplace(channel, sequence);
+    uint64_t& next = inserted.first->second;
+    if (count == 0) {
+        // A heartbeat only announces the next sequence: it can reveal a
+        // gap but is never a duplicate
+        if (sequence > next) {
+            ++stats.gaps;
+            next = sequence;
+        }
+        return 0;
+    }
+    if (end <= next) {
+        ++stats.duplicates;
+        return 0;
+    }
+    if (sequence > next) {
+        ++stats.gaps;
+        next = sequence;
+    }
+    
+    const uint8_t* body = data + wire::kPacketHeaderSize;
+    size_t body_size = size - wire::kPacketHeaderSize;
+    size_t offset = wire::SkipMessages(body, body_size, next - sequence);
+    DecodeWithStageTiming(decoder_, body + offset, body_size - offset, dispatcher);
+    next = end;
+    return decoder_.GetStats().messages - before;
+}
+
+} // namespace microstructure
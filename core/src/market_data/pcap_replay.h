@@ -0,0 +1,56 @@
+#pragma once
+
+#include "binary_protocol.h"
+#include "latency_histogram.h"
+#include "limit_order_book.h"
+#include "pcap_reader.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace microstructure {
+
+struct ReplayOptions {
+    double speed = 0.0;         // Multiple of recorded time; 0 replays as fast as possible
+    bool sequenced = true;      // Payloads are sequenced packets rather than bare messages
+};
+
+struct ReplayStats {
+    uint64_t packets = 0;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t gaps = 0;          // Sequence jumps; replay carries on past them
+    uint64_t duplicates = 0;    // Already applied, e.g. the second line of an A/B pair
+    double elapsed_seconds = 0.0;
+    double capture_seconds = 0.0;
+    
+    // Decode and apply time per packet, and in paced mode how late each
+    // packet started against its recorded schedule
+    LatencyHistogram processing;
+    LatencyHistogram lag;
+};
+
+// Drives books from captured UDP traffic. Each datagram goes through the
+// binary decoder into books[locate]; sequenced payloads have duplicates
+// dropped and overlaps trimmed per channel. Paced replay sleeps until a
+// packet is close to due and spins the rest, so lag stays in the
+// microseconds.
+class PcapReplay {
+public:
+    PcapReplay(LimitOrderBook* const* books, size_t book_count, const ReplayOptions& options);
+    
+    // Replay every datagram left in the reader
+    ReplayStats Run(PcapReader& reader);
+    
+private:
+    void WaitUntil(int64_t deadline_ns, ReplayStats& stats);
+    size_t ApplyPacket(const uint8_t* data, size_t size, ReplayStats& stats);
+    
+    std::vector<LimitOrderBook*> books_;
+    ReplayOptions options_;
+    BinaryDecoder decoder_;
+    std::unordered_map<uint16_t, uint64_t> next_sequence_;
+};
+
+} // namespace microstructure
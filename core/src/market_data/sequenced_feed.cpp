@@ -0,0 +1,343 @@
+#include "sequenced_feed.h"
+#include "stage_latency.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <limits>
+#include <utility>
+
+#include <sys/stat.h>
+
+namespace microstructure {
+
+namespace {
+
+constexpr uint64_t kSnapshotMagic = 0x313050414e53534dULL; // "MSSNAP01"
+
+struct SnapshotFileHeader {
+    uint64_t magic;
+    uint16_t channel;
+    uint16_t reserved[3];
+    uint64_t sequence;
+    uint64_t length;        // Bytes of add messages that follow
+};
+
+static_assert(sizeof(SnapshotFileHeader) == 32, "snapshot file header layout");
+
+} // namespace
+
+std::string SnapshotFileSource::GetPath(const std::string& directory, uint16_t channel) {
+    return directory + "/channel_" + std::to_string(channel) + ".snap";
+}
+
+bool SnapshotFileSource::Poll(uint16_t channel, ChannelSnapshot* snapshot) {
+    // Snapshots are replaced by rename, so a file with the same inode,
+    // size and mtime is the one already handed out; skip re-reading it
+    std::string path = GetPath(directory_, channel);
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    FileVersion version{static_cast<uint64_t>(info.st_ino), static_cast<int64_t>(info.st_size),
+                        static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec};
+    auto it = seen_.find(channel);
+    if (it != seen_.end() && it->second == version) {
+        return false;
+    }
+    if (!ReadSnapshotFile(path, channel, snapshot)) {
+        return false;
+    }
+    seen_[channel] = version;
+    return true;
+}
+
+void QueuedRecoverySource::Request(uint16_t channel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.push_back(channel);
+}
+
+bool QueuedRecoverySource::Poll(uint16_t channel, ChannelSnapshot* snapshot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ready_.find(channel);
+    if (it == ready_.end()) {
+        return false;
+    }
+    *snapshot = std::move(it->second);
+    ready_.erase(it);
+    return true;
+}
+
+bool QueuedRecoverySource::TakeRequest(uint16_t* channel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (requests_.empty()) {
+        return false;
+    }
+    *channel = requests_.front();
+    requests_.pop_front();
+    return true;
+}
+
+void QueuedRecoverySource::Provide(uint16_t channel, ChannelSnapshot snapshot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_[channel] = std::move(snapshot);
+}
+
+bool EncodeSnapshot(const LimitOrderBook* const* books, size_t book_count,
+                    const std::vector<uint16_t>& locates, std::vector<uint8_t>* out) {
+    BinaryEncoder encoder(*out);
+    bool encodable = true;
+    for (uint16_t locate : locates) {
+        if (locate >= book_count || !books[locate]) {
+            continue;
+        }
+        books[locate]->ForEachOrder([&](const Order& order) {
+            // Only what the feed itself shows: hidden orders are left out
+            // and an iceberg contributes its displayed tip
+            if (order.quantity <= 0) {
+                return;
+            }
+            if (order.quantity > std::numeric_limits<uint32_t>::max()) {
+                encodable = false;
+                return;
+            }
+            uint64_t order_id = 0;
+            const char* end = order.order_id.data() + order.order_id.size();
+            auto result = std::from_chars(order.order_id.data(), end, order_id);
+            if (result.ec != std::errc() || result.ptr != end) {
+                encodable = false;
+                return;
+            }
+            if (!encoder.Add(locate, order.timestamp_ns, order_id, order.is_buy,
+                             static_cast<uint32_t>(order.quantity), order.price)) {
+                encodable = false;
+            }
+        });
+    }
+    return encodable;
+}
+
+bool WriteSnapshotFile(const std::string& path, uint16_t channel, const ChannelSnapshot& snapshot) {
+    // Write aside and rename, so a recovering reader never sees half a file
+    std::string temp_path = path + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    SnapshotFileHeader header{};
+    header.magic = kSnapshotMagic;
+    header.channel = channel;
+    header.sequence = snapshot.sequence;
+    header.length = snapshot.orders.size();
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              (snapshot.orders.empty() ||
+               std::fwrite(snapshot.orders.data(), snapshot.orders.size(), 1, file) == 1);
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ReadSnapshotFile(const std::string& path, uint16_t channel, ChannelSnapshot* snapshot) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    // The header's length is untrusted: it must match what the file holds
+    // before anything is allocated for it
+    SnapshotFileHeader header;
+    struct stat info;
+    bool ok = fstat(fileno(file), &info) == 0 &&
+              std::fread(&header, sizeof(header), 1, file) == 1 &&
+              header.magic == kSnapshotMagic && header.channel == channel &&
+              header.length == static_cast<uint64_t>(info.st_size) - sizeof(header);
+    if (ok) {
+        snapshot->sequence = header.sequence;
+        snapshot->orders.resize(header.length);
+        ok = header.length == 0 ||
+             std::fread(snapshot->orders.data(), header.length, 1, file) == 1;
+    }
+    std::fclose(file);
+    return ok;
+}
+
+SequencedFeed::SequencedFeed(LimitOrderBook* const* books, size_t book_count, RecoverySource* source,
+                             size_t max_buffered_bytes)
+    : books_(books, books + book_count),
+      locate_owner_(book_count, -1),
+      source_(source),
+      max_buffered_bytes_(max_buffered_bytes) {}
+
+bool SequencedFeed::AddChannel(uint16_t channel, const std::vector<uint16_t>& locates, uint64_t next_sequence) {
+    if (channels_.count(channel)) {
+        return false;
+    }
+    for (uint16_t locate : locates) {
+        if (locate >= books_.size() || locate_owner_[locate] >= 0) {
+            return false;
+        }
+    }
+    for (uint16_t locate : locates) {
+        locate_owner_[locate] = channel;
+    }
+    Channel& state = channels_[channel];
+    state.id = channel;
+    state.locates = locates;
+    state.next_sequence = next_sequence;
+    return true;
+}
+
+bool SequencedFeed::OnPacket(const uint8_t* data, size_t size) {
+    if (size < wire::kPacketHeaderSize) {
+        return false;
+    }
+    auto it = channels_.find(wire::Load<uint16_t>(data));
+    if (it == channels_.end()) {
+        return false;
+    }
+    ProcessPacket(it->second, data, size);
+    return true;
+}
+
+void SequencedFeed::ProcessPacket(Channel& channel, const uint8_t* data, size_t size) {
+    ++channel.packets;
+    if (channel.recovering) {
+        BufferPacket(channel, data, size);
+        return;
+    }
+    
+    uint16_t count = wire::Load<uint16_t>(data + 2);
+    uint64_t sequence = wire::Load<uint64_t>(data + 4);
+    uint64_t end = sequence + count;
+    if (count == 0) {
+        // A heartbeat only announces the next sequence: it can reveal a
+        // gap but is never a duplicate
+        if (sequence <= channel.next_sequence) {
+            return;
+        }
+    } else if (end <= channel.next_sequence) {
+        ++channel.duplicates;
+        return;
+    }
+    if (sequence > channel.next_sequence) {
+        ++channel.gaps;
+        channel.recovering = true;
+        BufferPacket(channel, data, size);
+        if (source_) {
+            source_->Request(channel.id);
+        }
+        return;
+    }
+    
+    // Skip the part of an overlapping packet that was already applied
+    const uint8_t* body = data + wire::kPacketHeaderSize;
+    size_t body_size = size - wire::kPacketHeaderSize;
+    size_t offset = wire::SkipMessages(body, body_size, channel.next_sequence - sequence);
+    
+    // Messages for books outside the channel are ignored
+    int32_t owner = channel.id;
+    DecodeWithStageTiming(decoder_, body + offset, body_size - offset, [this, owner](uint16_t locate, const OrderEvent& event) {
+        if (locate < books_.size() && locate_owner_[locate] == owner && books_[locate]) {
+            books_[locate]->ApplyEvent(event);
+        }
+    });
+    channel.next_sequence = end;
+}
+
+void SequencedFeed::BufferPacket(Channel& channel, const uint8_t* data, size_t size) {
+    if (channel.buffer.size() + sizeof(uint32_t) + size > max_buffered_bytes_) {
+        // Replay will find the hole and request another snapshot
+        channel.buffer.clear();
+        channel.buffered_packets = 0;
+        ++channel.overflows;
+    }
+    size_t offset = channel.buffer.size();
+    channel.buffer.resize(offset + sizeof(uint32_t) + size);
+    wire::Store<uint32_t>(channel.buffer.data() + offset, static_cast<uint32_t>(size));
+    std::copy(data, data + size, channel.buffer.data() + offset + sizeof(uint32_t));
+    ++channel.buffered_packets;
+}
+
+size_t SequencedFeed::Poll() {
+    if (!source_) {
+        return 0;
+    }
+    size_t recovered = 0;
+    ChannelSnapshot snapshot;
+    for (auto& entry : channels_) {
+        Channel& channel = entry.second;
+        if (!channel.recovering || !source_->Poll(channel.id, &snapshot)) {
+            continue;
+        }
+        // A snapshot older than the buffered tail cannot close the gap
+        uint64_t first_buffered = wire::Load<uint64_t>(channel.buffer.data() + sizeof(uint32_t) + 4);
+        if (snapshot.sequence + 1 < first_buffered) {
+            ++channel.stale_snapshots;
+            source_->Request(channel.id);
+            continue;
+        }
+        Recover(channel, snapshot);
+        ++recovered;
+    }
+    return recovered;
+}
+
+void SequencedFeed::Recover(Channel& channel, const ChannelSnapshot& snapshot) {
+    // Group the snapshot by book, then rebuild each of the channel's books,
+    // including those the snapshot leaves empty
+    std::unordered_map<uint16_t, std::vector<OrderEvent>> orders;
+    BinaryDecoder loader;
+    loader.Decode(snapshot.orders.data(), snapshot.orders.size(), [&orders](uint16_t locate, const OrderEvent& event) {
+        orders[locate].push_back(event);
+    });
+    for (uint16_t locate : channel.locates) {
+        if (!books_[locate]) {
+            continue;
+        }
+        auto it = orders.find(locate);
+        if (it == orders.end()) {
+            books_[locate]->Clear();
+        } else {
+            books_[locate]->LoadOrders(it->second.data(), it->second.size());
+        }
+    }
+    channel.next_sequence = snapshot.sequence + 1;
+    channel.recovering = false;
+    ++channel.recoveries;
+    
+    // Replay the buffered tail; a packet past a remaining hole puts the
+    // channel back into recovery and the rest is buffered again
+    std::vector<uint8_t> pending;
+    pending.swap(channel.buffer);
+    channel.buffered_packets = 0;
+    size_t offset = 0;
+    while (offset < pending.size()) {
+        uint32_t size = wire::Load<uint32_t>(pending.data() + offset);
+        offset += sizeof(uint32_t);
+        --channel.packets;      // Counted when first received
+        ProcessPacket(channel, pending.data() + offset, size);
+        offset += size;
+    }
+}
+
+bool SequencedFeed::GetChannelStats(uint16_t channel, ChannelStats* out) const {
+    auto it = channels_.find(channel);
+    if (it == channels_.end()) {
+        return false;
+    }
+    const Channel& state = it->second;
+    out->next_sequence = state.next_sequence;
+    out->packets = state.packets;
+    out->duplicates = state.duplicates;
+    out->gaps = state.gaps;
+    out->recoveries = state.recoveries;
+    out->buffered_packets = state.buffered_packets;
+    out->overflows = state.overflows;
+    out->stale_snapshots = state.stale_snapshots;
+    out->recovering = state.recovering;
+    return true;
+}
+
+} // namespace microstructure
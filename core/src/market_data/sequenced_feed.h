@@ -0,0 +1,157 @@
+#pragma once
+
+#include "binary_protocol.h"
+#include "limit_order_book.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace microstructure {
+
+// Every displayed resting order of a channel's books as wire add messages,
+// in queue order within each level, as of `sequence`
+struct ChannelSnapshot {
+    uint64_t sequence = 0;
+    std::vector<uint8_t> orders;
+};
+
+// Where SequencedFeed gets snapshots from after a gap
+class RecoverySource {
+public:
+    virtual ~RecoverySource() = default;
+    
+    // Ask for a snapshot of the channel; must not block
+    virtual void Request(uint16_t channel) = 0;
+    
+    // Take the channel's snapshot if one is ready
+    virtual bool Poll(uint16_t channel, ChannelSnapshot* snapshot) = 0;
+};
+
+// Reads the snapshot files written by WriteSnapshotFile, one per channel.
+// Each file version is returned once; Poll reports nothing until the
+// writer replaces it.
+class SnapshotFileSource : public RecoverySource {
+public:
+    explicit SnapshotFileSource(const std::string& directory) : directory_(directory) {}
+    
+    void Request(uint16_t) override {}
+    bool Poll(uint16_t channel, ChannelSnapshot* snapshot) override;
+    
+    static std::string GetPath(const std::string& directory, uint16_t channel);
+    
+private:
+    struct FileVersion {
+        uint64_t inode;
+        int64_t size;
+        int64_t mtime_ns;
+        
+        bool operator==(const FileVersion& other) const {
+            return inode == other.inode && size == other.size && mtime_ns == other.mtime_ns;
+        }
+    };
+    
+    std::string directory_;
+    std::unordered_map<uint16_t, FileVersion> seen_;
+};
+
+// Stand-in for a venue recovery server: requests queue up for a responder
+// thread, which answers through Provide
+class QueuedRecoverySource : public RecoverySource {
+public:
+    void Request(uint16_t channel) override;
+    bool Poll(uint16_t channel, ChannelSnapshot* snapshot) override;
+    
+    // Responder side
+    bool TakeRequest(uint16_t* channel);
+    void Provide(uint16_t channel, ChannelSnapshot snapshot);
+    
+private:
+    std::mutex mutex_;
+    std::deque<uint16_t> requests_;
+    std::unordered_map<uint16_t, ChannelSnapshot> ready_;
+};
+
+// Encode the resting orders of books[locate] for each locate as the feed
+// would show them: displayed quantity only, so fully hidden orders are
+// skipped and icebergs contribute their current tip. Returns false if an
+// order ID is not numeric or a price or size does not fit the wire format.
+bool EncodeSnapshot(const LimitOrderBook* const* books, size_t book_count,
+                    const std::vector<uint16_t>& locates, std::vector<uint8_t>* out);
+
+// Write a snapshot file, replacing any previous one atomically
+bool WriteSnapshotFile(const std::string& path, uint16_t channel, const ChannelSnapshot& snapshot);
+bool ReadSnapshotFile(const std::string& path, uint16_t channel, ChannelSnapshot* snapshot);
+
+struct ChannelStats {
+    uint64_t next_sequence;
+    uint64_t packets;
+    uint64_t duplicates;        // Already applied, dropped
+    uint64_t gaps;
+    uint64_t recoveries;        // Snapshots loaded
+    uint64_t buffered_packets;  // Held while recovering
+    uint64_t overflows;         // Buffer limit hit and the buffered tail dropped
+    uint64_t stale_snapshots;   // Older than the buffered tail, re-requested
+    bool recovering;
+};
+
+// Sequenced packet intake with gap recovery. Each channel owns a set of
+// books (locates) and tracks the next expected sequence number. On a gap
+// the channel stops applying, buffers what follows and requests a
+// snapshot; Poll loads it into the channel's books and replays the buffer
+// from the snapshot's sequence on; a snapshot that does not reach the
+// buffered tail is re-requested. Other channels keep applying meanwhile.
+// Not thread-safe: call OnPacket and Poll from one thread.
+class SequencedFeed {
+public:
+    SequencedFeed(LimitOrderBook* const* books, size_t book_count, RecoverySource* source,
+                  size_t max_buffered_bytes = 64 << 20);
+    
+    // Returns false if the channel exists or a locate is out of range or
+    // already owned
+    bool AddChannel(uint16_t channel, const std::vector<uint16_t>& locates, uint64_t next_sequence = 1);
+    
+    // Returns false for a truncated packet or an unknown channel
+    bool OnPacket(const uint8_t* data, size_t size);
+    
+    // Complete recoveries whose snapshot is ready; returns the number loaded
+    size_t Poll();
+    
+    bool GetChannelStats(uint16_t channel, ChannelStats* out) const;
+    const DecodeStats& GetDecodeStats() const { return decoder_.GetStats(); }
+    
+private:
+    struct Channel {
+        uint16_t id;
+        std::vector<uint16_t> locates;
+        uint64_t next_sequence;
+        bool recovering = false;
+        
+        // Packets held during recovery, each prefixed by its uint32 size
+        std::vector<uint8_t> buffer;
+        
+        uint64_t packets = 0;
+        uint64_t duplicates = 0;
+        uint64_t gaps = 0;
+        uint64_t recoveries = 0;
+        uint64_t buffered_packets = 0;
+        uint64_t overflows = 0;
+        uint64_t stale_snapshots = 0;
+    };
+    
+    void ProcessPacket(Channel& channel, const uint8_t* data, size_t size);
+    void BufferPacket(Channel& channel, const uint8_t* data, size_t size);
+    void Recover(Channel& channel, const ChannelSnapshot& snapshot);
+    
+    std::vector<LimitOrderBook*> books_;
+    std::vector<int32_t> locate_owner_;     // Channel per locate, -1 if none
+    RecoverySource* source_;
+    size_t max_buffered_bytes_;
+    std::unordered_map<uint16_t, Channel> channels_;
+    BinaryDecoder decoder_;
+};
+
+} // namespace microstructure
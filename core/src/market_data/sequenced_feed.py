@@ -0,0 +1,111 @@
+import ctypes
+import logging
+from typing import Dict, Sequence
+
+import numpy as np
+
+from core.src.integration.cpp_interface import OrderBookInterface
+
+class ChannelStats(ctypes.Structure):
+    """Per-channel sequencing counters (ob_channel_stats_t)"""
+    _fields_ = [
+        ("next_sequence", ctypes.c_uint64),
+        ("packets", ctypes.c_uint64),
+        ("duplicates", ctypes.c_uint64),
+        ("gaps", ctypes.c_uint64),
+        ("recoveries", ctypes.c_uint64),
+        ("buffered_packets", ctypes.c_uint64),
+        ("overflows", ctypes.c_uint64),
+        ("stale_snapshots", ctypes.c_uint64),
+        ("recovering", ctypes.c_bool),
+    ]
+
+class SequencedFeed:
+    def __init__(self,
+                order_book_interface: OrderBookInterface,
+                symbols: Sequence[str],
+                snapshot_dir: str,
+                max_buffered_bytes: int = 0):
+        """Sequenced binary packets applied to the interface's books, with
+        gap recovery from snapshot files in snapshot_dir.
+        
+        Message locates index symbols. After a gap the affected channel
+        buffers its packets until poll_recovery finds a snapshot newer than
+        the gap; other channels keep applying.
+        """
+        self.lib = order_book_interface.lib
+        self.symbols = list(symbols)
+        self.snapshot_dir = snapshot_dir
+        self.channels = {}
+        self._configure_lib()
+        
+        self._books = (ctypes.c_void_p * len(self.symbols))(
+            *[order_book_interface._get_handle(s) for s in self.symbols])
+        self._handle = self.lib.create_sequenced_feed(self._books, len(self.symbols),
+                                                      snapshot_dir.encode('utf-8'), max_buffered_bytes)
+        self.logger = logging.getLogger("SequencedFeed")
+        
+    def _configure_lib(self):
+        if getattr(self.lib, "_sequenced_configured", False):
+            return
+        self.lib.create_sequenced_feed.argtypes = [ctypes.POINTER(ctypes.c_void_p), ctypes.c_size_t,
+                                                   ctypes.c_char_p, ctypes.c_size_t]
+        self.lib.create_sequenced_feed.restype = ctypes.c_void_p
+        self.lib.destroy_sequenced_feed.argtypes = [ctypes.c_void_p]
+        self.lib.add_sequenced_channel.argtypes = [ctypes.c_void_p, ctypes.c_uint16,
+                                                   ctypes.POINTER(ctypes.c_uint16), ctypes.c_size_t,
+                                                   ctypes.c_uint64]
+        self.lib.add_sequenced_channel.restype = ctypes.c_bool
+        self.lib.process_sequenced_packet.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+        self.lib.process_sequenced_packet.restype = ctypes.c_bool
+        self.lib.poll_sequenced_recovery.argtypes = [ctypes.c_void_p]
+        self.lib.poll_sequenced_recovery.restype = ctypes.c_size_t
+        self.lib.get_sequenced_channel_stats.argtypes = [ctypes.c_void_p, ctypes.c_uint16,
+                                                         ctypes.POINTER(ChannelStats)]
+        self.lib.get_sequenced_channel_stats.restype = ctypes.c_bool
+        self.lib.write_channel_snapshot.argtypes = [ctypes.c_char_p, ctypes.c_uint16, ctypes.c_uint64,
+                                                    ctypes.POINTER(ctypes.c_void_p), ctypes.c_size_t,
+                                                    ctypes.POINTER(ctypes.c_uint16), ctypes.c_size_t]
+        self.lib.write_channel_snapshot.restype = ctypes.c_bool
+        self.lib._sequenced_configured = True
+        
+    def add_channel(self, channel: int, symbols: Sequence[str], next_sequence: int = 1) -> bool:
+        """Register a channel carrying the given symbols"""
+        locates = [self.symbols.index(symbol) for symbol in symbols]
+        array = (ctypes.c_uint16 * len(locates))(*locates)
+        if not self.lib.add_sequenced_channel(self._handle, channel, array, len(locates), next_sequence):
+            return False
+        self.channels[channel] = array
+        return True
+        
+    def process_packet(self, packet) -> bool:
+        """Apply or buffer one packet; returns False if it is truncated or
+        its channel is unknown"""
+        buffer = np.frombuffer(packet, dtype=np.uint8)
+        return self.lib.process_sequenced_packet(self._handle, buffer.ctypes.data, len(buffer))
+        
+    def poll_recovery(self) -> int:
+        """Load any snapshots that close a gap; returns the number loaded"""
+        recovered = self.lib.poll_sequenced_recovery(self._handle)
+        if recovered:
+            self.logger.info(f"Recovered {recovered} channel(s) from snapshots")
+        return recovered
+        
+    def write_snapshot(self, channel: int, sequence: int) -> bool:
+        """Write the channel's books as its snapshot file at `sequence`"""
+        locates = self.channels[channel]
+        return self.lib.write_channel_snapshot(self.snapshot_dir.encode('utf-8'), channel, sequence,
+                                               self._books, len(self.symbols), locates, len(locates))
+        
+    def get_channel_stats(self, channel: int) -> Dict[str, int]:
+        """Sequencing counters for one channel"""
+        stats = ChannelStats()
+        if not self.lib.get_sequenced_channel_stats(self._handle, channel, ctypes.byref(stats)):
+            raise KeyError(channel)
+        return {name: getattr(stats, name) for name, _ in ChannelStats._fields_}
+        
+    def close(self):
+        """Free the native feed; the books stay with the interface"""
+        if self._handle:
+            self.lib.destroy_sequenced_feed(self._handle)
+            self._handle = None
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace microstructure {
+
+constexpr size_t kCacheLineSize = 64;
+
+// Bounded single-producer/single-consumer ring over preallocated slots.
+// Capacity is rounded up to a power of two. Each side caches the other's
+// index and only reloads it when the ring looks full (or empty), so in
+// steady state a push or pop touches one shared cache line.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+    
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+    
+    // Producer side
+    bool TryPush(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ > mask_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Producer side: push up to count items, returns how many fit
+    size_t TryPushBatch(const T* items, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t free = mask_ + 1 - (tail - cached_head_);
+        if (free < count) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            free = mask_ + 1 - (tail - cached_head_);
+        }
+        size_t pushed = count < free ? count : free;
+        for (size_t i = 0; i < pushed; ++i) {
+            slots_[(tail + i) & mask_] = items[i];
+        }
+        if (pushed > 0) {
+            tail_.store(tail + pushed, std::memory_order_release);
+        }
+        return pushed;
+    }
+    
+    // Consumer side: pop up to max_count items into out
+    size_t TryPopBatch(T* out, size_t max_count) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ == head) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (cached_tail_ == head) {
+                return 0;
+            }
+        }
+        size_t available = cached_tail_ - head;
+        size_t popped = available < max_count ? available : max_count;
+        for (size_t i = 0; i < popped; ++i) {
+            out[i] = slots_[(head + i) & mask_];
+        }
+        head_.store(head + popped, std::memory_order_release);
+        return popped;
+    }
+    
+    // Approximate when called concurrently with the other side
+    size_t GetSize() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    size_t GetCapacity() const { return mask_ + 1; }
+    
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+    
+    // Producer and consumer indices on separate lines, each next to the
+    // owning side's cached copy of the other index
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+};
+
+// Idle strategy for polling loops. kBusySpin never gives up the core and
+// gives the lowest wake-up latency; kAdaptive spins briefly, then yields,
+// then sleeps so an idle pipeline does not burn CPU.
+enum class WaitStrategy {
+    kBusySpin,
+    kAdaptive
+};
+
+class Backoff {
+public:
+    explicit Backoff(WaitStrategy strategy) : strategy_(strategy) {}
+    
+    void Idle() {
+        if (strategy_ == WaitStrategy::kBusySpin) {
+            CpuRelax();
+        } else if (idle_count_ < kSpinLimit) {
+            ++idle_count_;
+            CpuRelax();
+        } else if (idle_count_ < kYieldLimit) {
+            ++idle_count_;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    
+    void Reset() { idle_count_ = 0; }
+    
+private:
+    static constexpr int kSpinLimit = 1000;
+    static constexpr int kYieldLimit = 1100;
+    
+    static void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+    
+    WaitStrategy strategy_;
+    int idle_count_ = 0;
+};
+
+} // namespace microstructure
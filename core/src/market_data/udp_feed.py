@@ -0,0 +1,153 @@
+import contextlib
+import ctypes
+import logging
+from typing import Dict, Sequence
+
+from core.src.integration.cpp_interface import OrderBookInterface
+from core.src.market_data.sequenced_feed import ChannelStats
+
+class UdpSocketStats(ctypes.Structure):
+    """Per-socket receive counters (ob_udp_socket_stats_t)"""
+    _fields_ = [
+        ("datagrams", ctypes.c_uint64),
+        ("bytes", ctypes.c_uint64),
+        ("syscalls", ctypes.c_uint64),
+        ("truncated", ctypes.c_uint64),
+        ("kernel_drops", ctypes.c_uint64),
+        ("receive_buffer_bytes", ctypes.c_int32),
+    ]
+
+class UdpFeed:
+    def __init__(self,
+                order_book_interface: OrderBookInterface,
+                symbols: Sequence[str],
+                snapshot_dir: str = ".",
+                sequenced: bool = True,
+                batch_size: int = 0,
+                receive_buffer_bytes: int = 0):
+        """Native UDP ingestion into the interface's books.
+        
+        A native thread receives datagrams in batches and applies them
+        without returning to Python; message locates index symbols. With
+        sequenced set, datagrams are sequenced packets recovered from
+        snapshot files in snapshot_dir after a gap.
+        
+        While the feed runs its books belong to the receive thread: the
+        interface refuses them with RuntimeError until stop, and hold_books
+        lends them back between batches.
+        """
+        self.interface = order_book_interface
+        self.lib = order_book_interface.lib
+        self.symbols = list(symbols)
+        self.channels = {}
+        self._running = False
+        self._configure_lib()
+        
+        self._books = (ctypes.c_void_p * len(self.symbols))(
+            *[order_book_interface._get_handle(s) for s in self.symbols])
+        self._handle = self.lib.create_udp_feed(self._books, len(self.symbols), snapshot_dir.encode('utf-8'),
+                                                sequenced, batch_size, receive_buffer_bytes)
+        self.logger = logging.getLogger("UdpFeed")
+        
+    def _configure_lib(self):
+        if getattr(self.lib, "_udp_configured", False):
+            return
+        self.lib.create_udp_feed.argtypes = [ctypes.POINTER(ctypes.c_void_p), ctypes.c_size_t, ctypes.c_char_p,
+                                             ctypes.c_bool, ctypes.c_size_t, ctypes.c_int]
+        self.lib.create_udp_feed.restype = ctypes.c_void_p
+        self.lib.destroy_udp_feed.argtypes = [ctypes.c_void_p]
+        self.lib.add_udp_socket.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_uint16, ctypes.c_char_p]
+        self.lib.add_udp_socket.restype = ctypes.c_int
+        self.lib.get_udp_socket_port.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+        self.lib.get_udp_socket_port.restype = ctypes.c_uint16
+        self.lib.add_udp_channel.argtypes = [ctypes.c_void_p, ctypes.c_uint16, ctypes.POINTER(ctypes.c_uint16),
+                                             ctypes.c_size_t, ctypes.c_uint64]
+        self.lib.add_udp_channel.restype = ctypes.c_bool
+        self.lib.start_udp_feed.argtypes = [ctypes.c_void_p]
+        self.lib.start_udp_feed.restype = ctypes.c_bool
+        self.lib.stop_udp_feed.argtypes = [ctypes.c_void_p]
+        self.lib.get_udp_socket_stats.argtypes = [ctypes.c_void_p, ctypes.c_size_t,
+                                                  ctypes.POINTER(UdpSocketStats)]
+        self.lib.get_udp_socket_stats.restype = ctypes.c_bool
+        self.lib.get_udp_channel_stats.argtypes = [ctypes.c_void_p, ctypes.c_uint16,
+                                                   ctypes.POINTER(ChannelStats)]
+        self.lib.get_udp_channel_stats.restype = ctypes.c_bool
+        self.lib.lock_udp_feed_books.argtypes = [ctypes.c_void_p]
+        self.lib.unlock_udp_feed_books.argtypes = [ctypes.c_void_p]
+        self.lib._udp_configured = True
+        
+    def add_socket(self, address: str, port: int, interface_address: str = "") -> int:
+        """Join a multicast group, or bind a local address; port 0 picks a
+        free port. Returns the socket index."""
+        socket_index = self.lib.add_udp_socket(self._handle, address.encode('utf-8'), port,
+                                               interface_address.encode('utf-8'))
+        if socket_index < 0:
+            raise OSError(f"Cannot listen on {address}:{port}")
+        return socket_index
+        
+    def get_port(self, socket_index: int = 0) -> int:
+        """Local port of a socket, for sockets bound to port 0"""
+        return self.lib.get_udp_socket_port(self._handle, socket_index)
+        
+    def add_channel(self, channel: int, symbols: Sequence[str], next_sequence: int = 1) -> bool:
+        """Register a channel carrying the given symbols"""
+        locates = [self.symbols.index(symbol) for symbol in symbols]
+        array = (ctypes.c_uint16 * len(locates))(*locates)
+        if not self.lib.add_udp_channel(self._handle, channel, array, len(locates), next_sequence):
+            return False
+        self.channels[channel] = array
+        return True
+        
+    def start(self) -> bool:
+        """Start the receive thread; sockets and channels are fixed from here,
+        and the books belong to the thread until stop"""
+        self.interface._lease_books(self.symbols, "UdpFeed")
+        if not self.lib.start_udp_feed(self._handle):
+            self.interface._release_books(self.symbols)
+            return False
+        self._running = True
+        return True
+        
+    def stop(self) -> None:
+        """Apply what has been received so far and stop the thread"""
+        self.lib.stop_udp_feed(self._handle)
+        self._running = False
+        self.interface._release_books(self.symbols)
+        
+    @contextlib.contextmanager
+    def hold_books(self):
+        """Pause the receive thread between batches so the interface may use
+        the books inside the block; keep the block short, since datagrams
+        queue in the socket buffers meanwhile. The feed's own methods wait
+        for the block to end, so call only the interface inside it."""
+        self.lib.lock_udp_feed_books(self._handle)
+        running = self._running
+        self.interface._release_books(self.symbols)
+        try:
+            yield self.interface
+        finally:
+            if running:
+                self.interface._lease_books(self.symbols, "UdpFeed")
+            self.lib.unlock_udp_feed_books(self._handle)
+        
+    def get_socket_stats(self, socket_index: int = 0) -> Dict[str, int]:
+        """Receive counters for one socket, including kernel drops"""
+        stats = UdpSocketStats()
+        if not self.lib.get_udp_socket_stats(self._handle, socket_index, ctypes.byref(stats)):
+            raise KeyError(socket_index)
+        return {name: getattr(stats, name) for name, _ in UdpSocketStats._fields_}
+        
+    def get_channel_stats(self, channel: int) -> Dict[str, int]:
+        """Sequencing counters for one channel"""
+        stats = ChannelStats()
+        if not self.lib.get_udp_channel_stats(self._handle, channel, ctypes.byref(stats)):
+            raise KeyError(channel)
+        return {name: getattr(stats, name) for name, _ in ChannelStats._fields_}
+        
+    def close(self):
+        """Stop and free the native feed; the books stay with the interface"""
+        if self._handle:
+            self.lib.destroy_udp_feed(self._handle)
+            self._handle = None
+            self._running = False
+            self.interface._release_books(self.symbols)
@@ -0,0 +1,169 @@
+#include "udp_publisher.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace microstructure {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Paced batches span at most this long, so low rates send one at a time
+constexpr double kMaxBatchSpanSeconds = 100e-6;
+
+// Sleep until this close to a deadline, then spin
+constexpr auto kSpinWindow = std::chrono::microseconds(100);
+
+void WaitUntil(Clock::time_point deadline) {
+    auto now = Clock::now();
+    if (deadline - now > kSpinWindow) {
+        std::this_thread::sleep_for(deadline - now - kSpinWindow);
+    }
+    while (Clock::now() < deadline) {
+    }
+}
+
+} // namespace
+
+UdpPublisher::~UdpPublisher() {
+    Close();
+}
+
+bool UdpPublisher::Open(const UdpEndpoint& destination, const UdpPublisherOptions& options) {
+    Close();
+    if (options.batch_size == 0) {
+        return false;
+    }
+    sockaddr_in target{};
+    target.sin_family = AF_INET;
+    target.sin_port = htons(destination.port);
+    if (inet_pton(AF_INET, destination.address.c_str(), &target.sin_addr) != 1) {
+        return false;
+    }
+    
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (options.send_buffer_bytes > 0) {
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &options.send_buffer_bytes, sizeof(options.send_buffer_bytes));
+    }
+    if (IN_MULTICAST(ntohl(target.sin_addr.s_addr))) {
+        unsigned char ttl = static_cast<unsigned char>(options.ttl);
+        unsigned char loopback = options.loopback ? 1 : 0;
+        in_addr interface{};
+        if (inet_pton(AF_INET, options.interface_address.c_str(), &interface) != 1 ||
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) != 0 ||
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loopback, sizeof(loopback)) != 0 ||
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) != 0) {
+            ::close(fd);
+            return false;
+        }
+    }
+    // Connected, so each message needs no address of its own
+    if (connect(fd, reinterpret_cast<sockaddr*>(&target), sizeof(target)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    
+    fd_ = fd;
+    options_ = options;
+    stats_ = PublishStats{};
+    messages_.reset(new mmsghdr[options.batch_size]());
+    iovecs_.reset(new iovec[options.batch_size]());
+    for (size_t i = 0; i < options.batch_size; ++i) {
+        messages_[i].msg_hdr.msg_iov = &iovecs_[i];
+        messages_[i].msg_hdr.msg_iovlen = 1;
+    }
+    return true;
+}
+
+void UdpPublisher::Close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+}
+
+size_t UdpPublisher::Send(const uint8_t* const* payloads, const size_t* sizes, size_t count) {
+    if (fd_ < 0) {
+        return 0;
+    }
+    count = std::min(count, options_.batch_size);
+    for (size_t i = 0; i < count; ++i) {
+        iovecs_[i].iov_base = const_cast<uint8_t*>(payloads[i]);
+        iovecs_[i].iov_len = sizes[i];
+    }
+    
+    size_t sent = 0;
+    while (sent < count) {
+        int result = sendmmsg(fd_, messages_.get() + sent, static_cast<unsigned int>(count - sent), 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Give up on the first datagram and carry on with the rest
+            ++stats_.send_errors;
+            ++sent;
+            continue;
+        }
+        ++stats_.syscalls;
+        for (int i = 0; i < result; ++i) {
+            stats_.bytes += sizes[sent + i];
+        }
+        stats_.packets += result;
+        sent += result;
+    }
+    return sent;
+}
+
+PublishStats UdpPublisher::PublishCapture(PcapReader& reader, double packets_per_second) {
+    size_t batch = options_.batch_size;
+    if (packets_per_second > 0.0) {
+        batch = std::clamp<size_t>(static_cast<size_t>(packets_per_second * kMaxBatchSpanSeconds), 1, batch);
+    }
+    std::vector<const uint8_t*> payloads(batch);
+    std::vector<size_t> sizes(batch);
+    PublishStats before = stats_;
+    
+    auto start = Clock::now();
+    uint64_t queued = 0;
+    CapturedPacket packet;
+    bool more = true;
+    while (more) {
+        size_t count = 0;
+        while (count < batch && (more = reader.Next(&packet))) {
+            payloads[count] = packet.payload;
+            sizes[count] = packet.size;
+            ++count;
+        }
+        if (count == 0) {
+            break;
+        }
+        if (packets_per_second > 0.0) {
+            // The batch leaves when its first packet is due
+            WaitUntil(start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(queued / packets_per_second)));
+        }
+        Send(payloads.data(), sizes.data(), count);
+        queued += count;
+    }
+    
+    PublishStats result;
+    result.packets = stats_.packets - before.packets;
+    result.bytes = stats_.bytes - before.bytes;
+    result.syscalls = stats_.syscalls - before.syscalls;
+    result.send_errors = stats_.send_errors - before.send_errors;
+    result.elapsed_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+} // namespace microstructure
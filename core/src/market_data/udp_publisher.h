@@ -0,0 +1,59 @@
+#pragma once
+
+#include "pcap_reader.h"
+#include "udp_receiver.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace microstructure {
+
+struct UdpPublisherOptions {
+    std::string interface_address = "0.0.0.0";  // Outgoing interface for multicast
+    int ttl = 1;
+    bool loopback = true;           // Deliver multicast to listeners on this host
+    size_t batch_size = 32;         // Datagrams per sendmmsg call
+    int send_buffer_bytes = 4 << 20;
+};
+
+struct PublishStats {
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t syscalls;
+    uint64_t send_errors;           // Datagrams the kernel refused, e.g. ENOBUFS
+    double elapsed_seconds;
+};
+
+// Sends datagrams to one group or address with sendmmsg. Used as the
+// loopback source when benchmarking UdpFeed on a single host.
+class UdpPublisher {
+public:
+    UdpPublisher() = default;
+    ~UdpPublisher();
+    
+    UdpPublisher(const UdpPublisher&) = delete;
+    UdpPublisher& operator=(const UdpPublisher&) = delete;
+    
+    bool Open(const UdpEndpoint& destination, const UdpPublisherOptions& options);
+    void Close();
+    
+    // Send up to batch_size datagrams per call; returns the number sent
+    size_t Send(const uint8_t* const* payloads, const size_t* sizes, size_t count);
+    
+    // Send every UDP payload left in the capture, in order, at
+    // packets_per_second (0 for as fast as the socket takes them)
+    PublishStats PublishCapture(PcapReader& reader, double packets_per_second);
+    
+    const PublishStats& GetStats() const { return stats_; }
+    
+private:
+    int fd_ = -1;
+    UdpPublisherOptions options_;
+    std::unique_ptr<mmsghdr[]> messages_;
+    std::unique_ptr<iovec[]> iovecs_;
+    PublishStats stats_{};
+};
+
+} // namespace microstructure
@@ -0,0 +1,288 @@
+#include "udp_receiver.h"
+#include "stage_latency.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace microstructure {
+
+namespace {
+
+// Room for the SO_RXQ_OVFL drop counter on each datagram
+constexpr size_t kControlSize = CMSG_SPACE(sizeof(uint32_t));
+
+} // namespace
+
+UdpReceiver::~UdpReceiver() {
+    Close();
+}
+
+bool UdpReceiver::Open(const UdpEndpoint& endpoint, const UdpReceiverOptions& options) {
+    Close();
+    if (options.batch_size == 0 || options.max_datagram_size == 0) {
+        return false;
+    }
+    in_addr address{};
+    const char* text = endpoint.address.empty() ? "0.0.0.0" : endpoint.address.c_str();
+    if (inet_pton(AF_INET, text, &address) != 1) {
+        return false;
+    }
+    bool multicast = IN_MULTICAST(ntohl(address.s_addr));
+    
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int one = 1;
+    // Several processes may listen to the same group and port
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+    
+    // SO_RCVBUFFORCE may exceed net.core.rmem_max but needs CAP_NET_ADMIN;
+    // otherwise the request is capped at rmem_max
+    int requested = options.receive_buffer_bytes;
+    if (requested > 0 && setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &requested, sizeof(requested)) != 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &requested, sizeof(requested));
+    }
+    
+    // Binding the group address rather than INADDR_ANY keeps other groups
+    // on the same port out of this socket
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(endpoint.port);
+    local.sin_addr = address;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (multicast) {
+        ip_mreq request{};
+        request.imr_multiaddr = address;
+        if (inet_pton(AF_INET, endpoint.interface_address.c_str(), &request.imr_interface) != 1 ||
+            setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) != 0) {
+            ::close(fd);
+            return false;
+        }
+    }
+    
+    socklen_t length = sizeof(local);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&local), &length);
+    int granted = 0;
+    length = sizeof(granted);
+    getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &granted, &length);
+    
+    fd_ = fd;
+    port_ = ntohs(local.sin_port);
+    options_ = options;
+    stats_ = UdpSocketStats{};
+    stats_.receive_buffer_bytes = granted;
+    
+    size_t batch = options.batch_size;
+    buffers_.assign(batch * options.max_datagram_size, 0);
+    control_.assign(batch * kControlSize, 0);
+    sizes_.assign(batch, 0);
+    messages_.reset(new mmsghdr[batch]());
+    iovecs_.reset(new iovec[batch]());
+    for (size_t i = 0; i < batch; ++i) {
+        iovecs_[i].iov_base = buffers_.data() + i * options.max_datagram_size;
+        iovecs_[i].iov_len = options.max_datagram_size;
+        messages_[i].msg_hdr.msg_iov = &iovecs_[i];
+        messages_[i].msg_hdr.msg_iovlen = 1;
+        messages_[i].msg_hdr.msg_control = control_.data() + i * kControlSize;
+    }
+    return true;
+}
+
+void UdpReceiver::Close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    port_ = 0;
+}
+
+int UdpReceiver::Receive() {
+    if (fd_ < 0) {
+        return -1;
+    }
+    size_t batch = options_.batch_size;
+    for (size_t i = 0; i < batch; ++i) {
+        // The kernel overwrites these on every call
+        messages_[i].msg_hdr.msg_controllen = kControlSize;
+        messages_[i].msg_hdr.msg_flags = 0;
+    }
+    int count = recvmmsg(fd_, messages_.get(), static_cast<unsigned int>(batch), MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    ++stats_.syscalls;
+    
+    for (int i = 0; i < count; ++i) {
+        msghdr& header = messages_[i].msg_hdr;
+        if (header.msg_flags & MSG_TRUNC) {
+            // Only part of the datagram fit; its messages cannot be trusted
+            sizes_[i] = 0;
+            ++stats_.truncated;
+        } else {
+            sizes_[i] = messages_[i].msg_len;
+            ++stats_.datagrams;
+            stats_.bytes += sizes_[i];
+        }
+        // The counter is the socket's running total and only comes once
+        // something has been dropped
+        for (cmsghdr* control = CMSG_FIRSTHDR(&header); control; control = CMSG_NXTHDR(&header, control)) {
+            if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t drops;
+                std::memcpy(&drops, CMSG_DATA(control), sizeof(drops));
+                stats_.kernel_drops = std::max<uint64_t>(stats_.kernel_drops, drops);
+            }
+        }
+    }
+    return count;
+}
+
+const uint8_t* UdpReceiver::GetData(size_t index) const {
+    return buffers_.data() + index * options_.max_datagram_size;
+}
+
+UdpFeed::UdpFeed(LimitOrderBook* const* books, size_t book_count, RecoverySource* source,
+                 const UdpFeedOptions& options)
+    : books_(books, books + book_count),
+      options_(options),
+      sequenced_(books, book_count, source) {}
+
+UdpFeed::~UdpFeed() {
+    Stop();
+}
+
+int UdpFeed::AddSocket(const UdpEndpoint& endpoint) {
+    if (IsRunning()) {
+        return -1;
+    }
+    auto receiver = std::make_unique<UdpReceiver>();
+    if (!receiver->Open(endpoint, options_.receiver)) {
+        return -1;
+    }
+    // Metrics scrapes walk the sockets from another thread
+    std::lock_guard<std::mutex> lock(mutex_);
+    receivers_.push_back(std::move(receiver));
+    return static_cast<int>(receivers_.size() - 1);
+}
+
+bool UdpFeed::AddChannel(uint16_t channel, const std::vector<uint16_t>& locates, uint64_t next_sequence) {
+    if (IsRunning()) {
+        return false;
+    }
+    return sequenced_.AddChannel(channel, locates, next_sequence);
+}
+
+bool UdpFeed::Start() {
+    if (IsRunning() || receivers_.empty()) {
+        return false;
+    }
+    stopping_.store(false, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&UdpFeed::Run, this);
+    return true;
+}
+
+void UdpFeed::Stop() {
+    if (!IsRunning()) {
+        return;
+    }
+    stopping_.store(true, std::memory_order_release);
+    thread_.join();
+    running_.store(false, std::memory_order_release);
+}
+
+uint16_t UdpFeed::GetPort(size_t socket) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return socket < receivers_.size() ? receivers_[socket]->GetPort() : 0;
+}
+
+bool UdpFeed::GetSocketStats(size_t socket, UdpSocketStats* out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (socket >= receivers_.size()) {
+        return false;
+    }
+    *out = receivers_[socket]->GetStats();
+    return true;
+}
+
+bool UdpFeed::GetChannelStats(uint16_t channel, ChannelStats* out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sequenced_.GetChannelStats(channel, out);
+}
+
+DecodeStats UdpFeed::GetDecodeStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_.sequenced ? sequenced_.GetDecodeStats() : decoder_.GetStats();
+}
+
+void UdpFeed::Run() {
+    std::vector<pollfd> fds(receivers_.size());
+    for (size_t i = 0; i < receivers_.size(); ++i) {
+        fds[i].fd = receivers_[i]->GetFd();
+        fds[i].events = POLLIN;
+    }
+    auto poll_interval = std::chrono::milliseconds(options_.poll_timeout_ms);
+    auto next_recovery_poll = std::chrono::steady_clock::now();
+    
+    while (!stopping_.load(std::memory_order_acquire)) {
+        if (poll(fds.data(), fds.size(), options_.poll_timeout_ms) > 0) {
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (fds[i].revents & POLLIN) {
+                    Drain(*receivers_[i]);
+                }
+            }
+        }
+        // Snapshot sources are checked at the poll interval, not per batch
+        auto now = std::chrono::steady_clock::now();
+        if (options_.sequenced && now >= next_recovery_poll) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sequenced_.Poll();
+            next_recovery_poll = now + poll_interval;
+        }
+    }
+    
+    for (auto& receiver : receivers_) {
+        Drain(*receiver);
+    }
+}
+
+size_t UdpFeed::Drain(UdpReceiver& receiver) {
+    BookDispatcher dispatcher(books_.data(), books_.size());
+    size_t total = 0;
+    int count;
+    // A short batch means the socket queue is empty
+    do {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count = receiver.Receive();
+        for (int i = 0; i < count; ++i) {
+            size_t size = receiver.GetSize(i);
+            if (size == 0) {
+                continue;
+            }
+            if (options_.sequenced) {
+                sequenced_.OnPacket(receiver.GetData(i), size);
+            } else {
+                DecodeWithStageTiming(decoder_, receiver.GetData(i), size, dispatcher);
+            }
+        }
+        total += std::max(count, 0);
+    } while (count == static_cast<int>(options_.receiver.batch_size));
+    return total;
+}
+
+} // namespace microstructure
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "binary_protocol.h"
+#include "limit_order_book.h"
+#include "sequenced_feed.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+namespace microstructure {
+
+struct UdpEndpoint {
+    std::string address;                        // Multicast group or local unicast address
+    uint16_t port = 0;                          // 0 binds an ephemeral port
+    std::string interface_address = "0.0.0.0";  // Interface the group is joined on
+};
+
+struct UdpReceiverOptions {
+    size_t batch_size = 64;                     // Datagrams per recvmmsg call
+    size_t max_datagram_size = 2048;
+    int receive_buffer_bytes = 16 << 20;        // SO_RCVBUF request; the kernel may grant less
+};
+
+struct UdpSocketStats {
+    uint64_t datagrams;
+    uint64_t bytes;
+    uint64_t syscalls;          // recvmmsg calls that returned data
+    uint64_t truncated;         // Larger than max_datagram_size, dropped
+    uint64_t kernel_drops;      // Lost to a full receive buffer (SO_RXQ_OVFL)
+    int receive_buffer_bytes;   // Granted by the kernel
+};
+
+// Non-blocking UDP socket read with recvmmsg into preallocated buffers.
+// Joins the group when the address is multicast, otherwise binds it.
+class UdpReceiver {
+public:
+    UdpReceiver() = default;
+    ~UdpReceiver();
+    
+    UdpReceiver(const UdpReceiver&) = delete;
+    UdpReceiver& operator=(const UdpReceiver&) = delete;
+    
+    // Returns false if the socket cannot be bound or the group joined
+    bool Open(const UdpEndpoint& endpoint, const UdpReceiverOptions& options);
+    void Close();
+    
+    // Take whatever is queued, up to batch_size datagrams; returns the
+    // number received, 0 if none are waiting and -1 on a socket error
+    int Receive();
+    
+    const uint8_t* GetData(size_t index) const;
+    size_t GetSize(size_t index) const { return sizes_[index]; }
+    
+    int GetFd() const { return fd_; }
+    uint16_t GetPort() const { return port_; }
+    const UdpSocketStats& GetStats() const { return stats_; }
+    
+private:
+    int fd_ = -1;
+    uint16_t port_ = 0;
+    UdpReceiverOptions options_;
+    
+    std::vector<uint8_t> buffers_;
+    std::vector<uint8_t> control_;
+    std::vector<size_t> sizes_;
+    std::unique_ptr<mmsghdr[]> messages_;
+    std::unique_ptr<iovec[]> iovecs_;
+    
+    UdpSocketStats stats_{};
+};
+
+struct UdpFeedOptions {
+    UdpReceiverOptions receiver;
+    bool sequenced = true;      // Datagrams are sequenced packets rather than bare messages
+    int poll_timeout_ms = 50;
+};
+
+// Live ingestion: one thread polls every socket, drains each with
+// recvmmsg and applies the datagrams to books[locate], through
+// SequencedFeed (duplicates, gaps and snapshot recovery) or straight
+// through the decoder. Sockets and channels are added before Start; stats
+// may be read while running. The books belong to the feed thread while it
+// runs: other threads touch them only between LockBooks and UnlockBooks.
+class UdpFeed {
+public:
+    // source may be null when options.sequenced is false
+    UdpFeed(LimitOrderBook* const* books, size_t book_count, RecoverySource* source,
+            const UdpFeedOptions& options);
+    ~UdpFeed();
+    
+    UdpFeed(const UdpFeed&) = delete;
+    UdpFeed& operator=(const UdpFeed&) = delete;
+    
+    // Returns the socket index, or -1 if it cannot be opened or the feed
+    // is running
+    int AddSocket(const UdpEndpoint& endpoint);
+    bool AddChannel(uint16_t channel, const std::vector<uint16_t>& locates, uint64_t next_sequence = 1);
+    
+    bool Start();
+    
+    // Apply what has already been received, then join the thread
+    void Stop();
+    
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+    uint16_t GetPort(size_t socket) const;
+    bool GetSocketStats(size_t socket, UdpSocketStats* out) const;
+    bool GetChannelStats(uint16_t channel, ChannelStats* out) const;
+    DecodeStats GetDecodeStats() const;
+    
+    // Hold the feed thread between batches so the caller may read or modify
+    // the books; every LockBooks needs an UnlockBooks, and the stats getters
+    // wait for it
+    void LockBooks() const { mutex_.lock(); }
+    void UnlockBooks() const { mutex_.unlock(); }
+    
+private:
+    void Run();
+    size_t Drain(UdpReceiver& receiver);
+    
+    std::vector<LimitOrderBook*> books_;
+    UdpFeedOptions options_;
+    std::vector<std::unique_ptr<UdpReceiver>> receivers_;
+    SequencedFeed sequenced_;
+    BinaryDecoder decoder_;
+    
+    // Held by the feed thread per batch, by stats readers and while sockets
+    // are added
+    mutable std::mutex mutex_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopping_{false};
+};
+
+} // namespace microstructure
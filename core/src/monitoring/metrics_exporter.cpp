@@ -0,0 +1,223 @@
+#include "metrics_exporter.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace microstructure {
+
+namespace {
+
+// Label values may hold any UTF-8; backslash, quote and newline are escaped
+std::string EscapeLabel(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string FormatValue(double value) {
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    char buffer[32];
+    // Counters are integral; print them without an exponent
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+    return buffer;
+}
+
+bool SendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+} // namespace
+
+void MetricsSnapshot::Add(const std::string& name, MetricType type, const std::string& help,
+                          const std::vector<std::pair<std::string, std::string>>& labels, double value) {
+    std::string rendered;
+    for (const auto& label : labels) {
+        rendered += rendered.empty() ? "{" : ",";
+        rendered += label.first + "=\"" + EscapeLabel(label.second) + "\"";
+    }
+    if (!rendered.empty()) {
+        rendered += "}";
+    }
+    
+    auto inserted = families_.emplace(name, Family{type, help, {}});
+    inserted.first->second.samples[rendered] += value;
+}
+
+std::string MetricsSnapshot::Render() const {
+    std::string text;
+    for (const auto& entry : families_) {
+        const Family& family = entry.second;
+        text += "# HELP " + entry.first + " " + family.help + "\n";
+        text += "# TYPE " + entry.first + (family.type == MetricType::kCounter ? " counter\n" : " gauge\n");
+        for (const auto& sample : family.samples) {
+            text += entry.first + sample.first + " " + FormatValue(sample.second) + "\n";
+        }
+    }
+    return text;
+}
+
+uint64_t MetricsRegistry::AddCollector(MetricsCollector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t id = next_id_++;
+    collectors_.emplace(id, std::move(collector));
+    return id;
+}
+
+void MetricsRegistry::RemoveCollector(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collectors_.erase(id);
+}
+
+std::string MetricsRegistry::Scrape() {
+    MetricsSnapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : collectors_) {
+            entry.second(snapshot);
+        }
+    }
+    return snapshot.Render();
+}
+
+MetricsHttpServer::~MetricsHttpServer() {
+    Stop();
+}
+
+bool MetricsHttpServer::Start(MetricsRegistry* registry, const std::string& address, uint16_t port) {
+    if (thread_.joinable()) {
+        return false;
+    }
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.empty() ? "127.0.0.1" : address.c_str(), &addr.sin_addr) != 1) {
+        return false;
+    }
+    
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    socklen_t length = sizeof(addr);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 16) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        close(fd);
+        return false;
+    }
+    
+    registry_ = registry;
+    fd_ = fd;
+    port_ = ntohs(addr.sin_port);
+    stopping_.store(false, std::memory_order_relaxed);
+    thread_ = std::thread(&MetricsHttpServer::Run, this);
+    return true;
+}
+
+void MetricsHttpServer::Stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    stopping_.store(true, std::memory_order_relaxed);
+    thread_.join();
+    close(fd_);
+    fd_ = -1;
+}
+
+void MetricsHttpServer::Run() {
+    pollfd listener{fd_, POLLIN, 0};
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        // Wake regularly to notice Stop
+        listener.revents = 0;
+        if (poll(&listener, 1, 100) <= 0) {
+            continue;
+        }
+        int client = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        Serve(client);
+        close(client);
+    }
+}
+
+void MetricsHttpServer::Serve(int client) {
+    // Read the request head; a slow or silent client is dropped after a second
+    char request[2048];
+    size_t used = 0;
+    pollfd readable{client, POLLIN, 0};
+    while (used < sizeof(request) - 1) {
+        if (poll(&readable, 1, 1000) <= 0) {
+            return;
+        }
+        ssize_t n = recv(client, request + used, sizeof(request) - 1 - used, 0);
+        if (n <= 0) {
+            return;
+        }
+        used += static_cast<size_t>(n);
+        request[used] = '\0';
+        if (std::strstr(request, "\r\n\r\n") || std::strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    
+    std::string status = "200 OK";
+    std::string body;
+    if (std::strncmp(request, "GET /metrics ", 13) == 0 || std::strncmp(request, "GET /metrics?", 13) == 0) {
+        body = registry_->Scrape();
+    } else if (std::strncmp(request, "GET ", 4) == 0) {
+        status = "404 Not Found";
+        body = "try /metrics\n";
+    } else {
+        status = "405 Method Not Allowed";
+    }
+    
+    std::string response = "HTTP/1.0 " + status + "\r\n"
+                           "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+    SendAll(client, response.data(), response.size());
+}
+
+} // namespace microstructure
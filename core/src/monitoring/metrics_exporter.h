@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace microstructure {
+
+enum class MetricType {
+    kCounter,
+    kGauge
+};
+
+// Samples gathered during one scrape, rendered in the Prometheus text
+// exposition format. Samples with the same name and labels are summed, so
+// collectors for several threads or books of one symbol aggregate here.
+class MetricsSnapshot {
+public:
+    // labels is a list of name/value pairs; values are escaped on render
+    void Add(const std::string& name, MetricType type, const std::string& help,
+             const std::vector<std::pair<std::string, std::string>>& labels, double value);
+    
+    std::string Render() const;
+    
+private:
+    struct Family {
+        MetricType type;
+        std::string help;
+        std::map<std::string, double> samples;      // Rendered label set -> value
+    };
+    
+    std::map<std::string, Family> families_;
+};
+
+using MetricsCollector = std::function<void(MetricsSnapshot& snapshot)>;
+
+// Collectors registered by the components that own the counters. Nothing
+// is gathered until a scrape, which runs every collector on the scraping
+// thread; counters read there must be safe to load concurrently.
+class MetricsRegistry {
+public:
+    // Returns an ID for RemoveCollector
+    uint64_t AddCollector(MetricsCollector collector);
+    
+    // Blocks until a scrape already running it has finished
+    void RemoveCollector(uint64_t id);
+    
+    std::string Scrape();
+    
+private:
+    std::mutex mutex_;
+    std::map<uint64_t, MetricsCollector> collectors_;
+    uint64_t next_id_ = 1;
+};
+
+// Minimal HTTP/1.0 server answering GET /metrics with a registry scrape,
+// one connection at a time on its own thread
+class MetricsHttpServer {
+public:
+    MetricsHttpServer() = default;
+    ~MetricsHttpServer();
+    
+    MetricsHttpServer(const MetricsHttpServer&) = delete;
+    MetricsHttpServer& operator=(const MetricsHttpServer&) = delete;
+    
+    // Port 0 picks a free port, see GetPort; false if already running or
+    // the address cannot be bound
+    bool Start(MetricsRegistry* registry, const std::string& address, uint16_t port);
+    void Stop();
+    
+    bool IsRunning() const { return thread_.joinable(); }
+    uint16_t GetPort() const { return port_; }
+    uint64_t GetRequestCount() const { return requests_.load(std::memory_order_relaxed); }
+    
+private:
+    void Run();
+    void Serve(int client);
+    
+    MetricsRegistry* registry_ = nullptr;
+    int fd_ = -1;
+    uint16_t port_ = 0;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> requests_{0};
+};
+
+} // namespace microstructure
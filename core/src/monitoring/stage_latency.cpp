@@ -0,0 +1,241 @@
+#include "stage_latency.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace microstructure {
+
+namespace stage_timing {
+std::atomic<bool> g_enabled{false};
+double g_ns_per_tick = 1.0;
+} // namespace stage_timing
+
+namespace {
+
+constexpr size_t kBuckets = LatencyHistogram::GetNumBuckets();
+
+// Only the owning thread writes, so a relaxed load and store stands in for
+// an atomic increment; the atomics just make concurrent reads well defined
+inline void Add(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct StageCounters {
+    std::atomic<uint64_t> counts[kBuckets];
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> min;
+    std::atomic<uint64_t> max;
+};
+
+struct ThreadSlot {
+    void Clear() {
+        for (StageCounters& stage : stages) {
+            for (std::atomic<uint64_t>& count : stage.counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+            stage.sum.store(0, std::memory_order_relaxed);
+            stage.min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+            stage.max.store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    StageCounters stages[kPipelineStageCount];
+    std::atomic<uint64_t> epoch{0};     // Counts are valid only while this matches the registry
+    std::atomic<bool> in_use{false};
+};
+
+// Slots outlive their threads and are handed to new threads, so the
+// registry only grows to the peak number of recording threads. It is
+// never freed, which keeps thread exit safe during process shutdown.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadSlot>> slots;
+    std::atomic<uint64_t> epoch{1};
+};
+
+Registry& GetRegistry() {
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+ThreadSlot* AcquireSlot() {
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& slot : registry.slots) {
+        if (!slot->in_use.load(std::memory_order_acquire)) {
+            slot->in_use.store(true, std::memory_order_relaxed);
+            return slot.get();
+        }
+    }
+    registry.slots.push_back(std::make_unique<ThreadSlot>());
+    ThreadSlot* slot = registry.slots.back().get();
+    slot->Clear();
+    slot->in_use.store(true, std::memory_order_relaxed);
+    return slot;
+}
+
+struct SlotHandle {
+    ~SlotHandle() {
+        if (slot) {
+            slot->in_use.store(false, std::memory_order_release);
+        }
+    }
+    
+    ThreadSlot* slot = nullptr;
+};
+
+thread_local SlotHandle t_slot;
+
+double CalibrateClock() {
+#if defined(__x86_64__) || defined(__i386__)
+    auto wall_begin = std::chrono::steady_clock::now();
+    uint64_t ticks_begin = ReadStageClock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    uint64_t ticks = ReadStageClock() - ticks_begin;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wall_begin).count();
+    return ticks > 0 ? ns / ticks : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+} // namespace
+
+const char* GetStageName(PipelineStage stage) {
+    switch (stage) {
+        case PipelineStage::kDecode:
+            return "decode";
+        case PipelineStage::kQueueWait:
+            return "queue_wait";
+        case PipelineStage::kApply:
+            return "apply";
+        case PipelineStage::kMetrics:
+            return "metrics";
+        case PipelineStage::kPublish:
+            return "publish";
+    }
+    return "unknown";
+}
+
+void SetStageTimingEnabled(bool enabled) {
+    static std::once_flag calibrated;
+    if (enabled) {
+        std::call_once(calibrated, [] { stage_timing::g_ns_per_tick = CalibrateClock(); });
+    }
+    stage_timing::g_enabled.store(enabled, std::memory_order_release);
+}
+
+void RecordStageLatency(PipelineStage stage, uint64_t latency_ns) {
+    ThreadSlot* slot = t_slot.slot;
+    if (!slot) {
+        slot = t_slot.slot = AcquireSlot();
+    }
+    uint64_t epoch = GetRegistry().epoch.load(std::memory_order_relaxed);
+    if (slot->epoch.load(std::memory_order_relaxed) != epoch) {
+        slot->Clear();
+        slot->epoch.store(epoch, std::memory_order_release);
+    }
+    
+    StageCounters& counters = slot->stages[static_cast<size_t>(stage)];
+    Add(counters.counts[LatencyHistogram::GetBucketIndex(latency_ns)], 1);
+    Add(counters.sum, latency_ns);
+    if (latency_ns < counters.min.load(std::memory_order_relaxed)) {
+        counters.min.store(latency_ns, std::memory_order_relaxed);
+    }
+    if (latency_ns > counters.max.load(std::memory_order_relaxed)) {
+        counters.max.store(latency_ns, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram GetStageLatency(PipelineStage stage) {
+    LatencyHistogram merged;
+    std::vector<uint64_t> counts(kBuckets);
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    uint64_t epoch = registry.epoch.load(std::memory_order_relaxed);
+    for (auto& slot : registry.slots) {
+        // A stale slot was reset but its thread has not recorded since
+        if (slot->epoch.load(std::memory_order_acquire) != epoch) {
+            continue;
+        }
+        const StageCounters& counters = slot->stages[static_cast<size_t>(stage)];
+        for (size_t i = 0; i < kBuckets; ++i) {
+            counts[i] = counters.counts[i].load(std::memory_order_relaxed);
+        }
+        merged.MergeBuckets(counts.data(), counters.sum.load(std::memory_order_relaxed),
+                            counters.min.load(std::memory_order_relaxed),
+                            counters.max.load(std::memory_order_relaxed));
+    }
+    return merged;
+}
+
+void ResetStageLatency() {
+    GetRegistry().epoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::string FormatStageLatency() {
+    std::string text;
+    char line[256];
+    for (size_t i = 0; i < kPipelineStageCount; ++i) {
+        PipelineStage stage = static_cast<PipelineStage>(i);
+        LatencyHistogram histogram = GetStageLatency(stage);
+        std::snprintf(line, sizeof(line),
+                      "%-10s count %llu mean %.0f p50 %llu p90 %llu p99 %llu p99.9 %llu max %llu ns\n",
+                      GetStageName(stage), static_cast<unsigned long long>(histogram.GetCount()),
+                      histogram.GetMean(),
+                      static_cast<unsigned long long>(histogram.GetValueAtPercentile(50.0)),
+                      static_cast<unsigned long long>(histogram.GetValueAtPercentile(90.0)),
+                      static_cast<unsigned long long>(histogram.GetValueAtPercentile(99.0)),
+                      static_cast<unsigned long long>(histogram.GetValueAtPercentile(99.9)),
+                      static_cast<unsigned long long>(histogram.GetMax()));
+        text += line;
+    }
+    return text;
+}
+
+StageLatencyReporter::~StageLatencyReporter() {
+    Stop();
+}
+
+bool StageLatencyReporter::Start(uint32_t interval_ms, const std::string& path) {
+    if (thread_.joinable()) {
+        return false;
+    }
+    std::FILE* out = stderr;
+    if (!path.empty()) {
+        out = std::fopen(path.c_str(), "a");
+        if (!out) {
+            return false;
+        }
+    }
+    stopping_ = false;
+    thread_ = std::thread(&StageLatencyReporter::Run, this, std::max<uint32_t>(interval_ms, 1), out);
+    return true;
+}
+
+void StageLatencyReporter::Stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void StageLatencyReporter::Run(uint32_t interval_ms, std::FILE* out) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wake_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return stopping_; })) {
+        std::string text = FormatStageLatency();
+        std::fprintf(out, "stage latency\n%s", text.c_str());
+        std::fflush(out);
+    }
+    if (out != stderr) {
+        std::fclose(out);
+    }
+}
+
+} // namespace microstructure
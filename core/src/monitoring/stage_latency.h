@@ -0,0 +1,143 @@
+#pragma once
+
+#include "latency_histogram.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+namespace microstructure {
+
+// Where an event spends its time on the way from the wire to a subscriber
+enum class PipelineStage : uint8_t {
+    kDecode,        // Parsing a wire message
+    kQueueWait,     // Sitting in the feed pipeline input ring
+    kApply,         // LimitOrderBook::ApplyEvent
+    kMetrics,       // Best prices, mid and imbalance for the update
+    kPublish        // Subscriber callback, per batch
+};
+
+constexpr size_t kPipelineStageCount = 5;
+
+const char* GetStageName(PipelineStage stage);
+
+namespace stage_timing {
+extern std::atomic<bool> g_enabled;
+extern double g_ns_per_tick;
+} // namespace stage_timing
+
+// Cheap monotonic timestamp: the TSC on x86 (invariant and synchronised
+// across cores on anything recent), CLOCK_MONOTONIC elsewhere. Convert
+// differences with StageTicksToNs.
+inline uint64_t ReadStageClock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+inline uint64_t StageTicksToNs(uint64_t ticks) {
+    return static_cast<uint64_t>(ticks * stage_timing::g_ns_per_tick);
+}
+
+// Timing is off until enabled, and instrumented code skips the clock reads
+// entirely while it is. Enabling calibrates the clock the first time.
+void SetStageTimingEnabled(bool enabled);
+
+inline bool IsStageTimingEnabled() {
+    return stage_timing::g_enabled.load(std::memory_order_acquire);
+}
+
+// Record into the calling thread's own histograms. Each thread writes only
+// to its own set, so recording takes no lock and no atomic read-modify-
+// write; readers merge every thread's set.
+void RecordStageLatency(PipelineStage stage, uint64_t latency_ns);
+
+inline void RecordStageTicks(PipelineStage stage, uint64_t begin, uint64_t end) {
+    RecordStageLatency(stage, end > begin ? StageTicksToNs(end - begin) : 0);
+}
+
+// Histogram of one stage merged across all threads since the last reset
+LatencyHistogram GetStageLatency(PipelineStage stage);
+
+// Clears every thread's histograms; each thread clears its own on its next
+// record, so counts recorded concurrently with the reset may be lost
+void ResetStageLatency();
+
+// One line per stage with count, mean and percentiles in ns
+std::string FormatStageLatency();
+
+// Handler wrapper for BinaryDecoder::Decode that splits the time between
+// messages (parsing) from the time inside the handler (applying)
+template <typename Handler>
+class StageTimedHandler {
+public:
+    explicit StageTimedHandler(Handler& handler) : handler_(handler), last_(ReadStageClock()) {}
+    
+    template <typename... Args>
+    void operator()(Args&&... args) {
+        uint64_t begin = ReadStageClock();
+        RecordStageTicks(PipelineStage::kDecode, last_, begin);
+        handler_(std::forward<Args>(args)...);
+        last_ = ReadStageClock();
+        RecordStageTicks(PipelineStage::kApply, begin, last_);
+    }
+    
+private:
+    Handler& handler_;
+    uint64_t last_;
+};
+
+// decoder.Decode(data, size, handler), timed per message while stage
+// timing is enabled
+template <typename Decoder, typename Handler>
+size_t DecodeWithStageTiming(Decoder& decoder, const uint8_t* data, size_t size, Handler&& handler) {
+    if (!IsStageTimingEnabled()) {
+        return decoder.Decode(data, size, handler);
+    }
+    StageTimedHandler<std::remove_reference_t<Handler>> timed(handler);
+    return decoder.Decode(data, size, timed);
+}
+
+// Writes FormatStageLatency to a file (appending) or stderr at a fixed
+// interval from a background thread
+class StageLatencyReporter {
+public:
+    StageLatencyReporter() = default;
+    ~StageLatencyReporter();
+    
+    StageLatencyReporter(const StageLatencyReporter&) = delete;
+    StageLatencyReporter& operator=(const StageLatencyReporter&) = delete;
+    
+    // Empty path writes to stderr; false if already running or the file
+    // cannot be opened
+    bool Start(uint32_t interval_ms, const std::string& path);
+    void Stop();
+    bool IsRunning() const { return thread_.joinable(); }
+    
+private:
+    void Run(uint32_t interval_ms, std::FILE* out);
+    
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+};
+
+} // namespace microstructure
@@ -0,0 +1,186 @@
+#include "arrow_export.h"
+
+#include <limits>
+#include <utility>
+
+namespace microstructure {
+
+namespace {
+
+// Data buffer handed out for empty columns, which importers expect non-null
+alignas(8) const uint8_t kEmptyBuffer[8] = {};
+
+// Owned state behind an exported schema node
+struct SchemaData {
+    std::string format;
+    std::string name;
+    std::vector<ArrowSchema*> children;
+};
+
+// Owned state behind an exported array node
+struct ArrayData {
+    std::vector<uint8_t> values;
+    std::vector<const void*> buffers;
+    std::vector<ArrowArray*> children;
+};
+
+void ReleaseSchema(ArrowSchema* schema) {
+    auto* data = static_cast<SchemaData*>(schema->private_data);
+    for (ArrowSchema* child : data->children) {
+        if (child->release) {
+            child->release(child);
+        }
+        delete child;
+    }
+    delete data;
+    schema->release = nullptr;
+}
+
+void ReleaseArray(ArrowArray* array) {
+    auto* data = static_cast<ArrayData*>(array->private_data);
+    for (ArrowArray* child : data->children) {
+        if (child->release) {
+            child->release(child);
+        }
+        delete child;
+    }
+    delete data;
+    array->release = nullptr;
+}
+
+void FillSchema(ArrowSchema* out, std::string format, std::string name, std::vector<ArrowSchema*> children) {
+    auto* data = new SchemaData{std::move(format), std::move(name), std::move(children)};
+    out->format = data->format.c_str();
+    out->name = data->name.c_str();
+    out->metadata = nullptr;
+    out->flags = 0;
+    out->n_children = static_cast<int64_t>(data->children.size());
+    out->children = data->children.empty() ? nullptr : data->children.data();
+    out->dictionary = nullptr;
+    out->release = ReleaseSchema;
+    out->private_data = data;
+}
+
+// Arrays carry no validity bitmaps: buffer 0 is always null
+void FillArray(ArrowArray* out, int64_t length, std::vector<uint8_t> values, bool has_values,
+               std::vector<ArrowArray*> children) {
+    auto* data = new ArrayData{std::move(values), {}, std::move(children)};
+    data->buffers.push_back(nullptr);
+    if (has_values) {
+        data->buffers.push_back(data->values.empty() ? kEmptyBuffer : data->values.data());
+    }
+    out->length = length;
+    out->null_count = 0;
+    out->offset = 0;
+    out->n_buffers = static_cast<int64_t>(data->buffers.size());
+    out->n_children = static_cast<int64_t>(data->children.size());
+    out->buffers = data->buffers.data();
+    out->children = data->children.empty() ? nullptr : data->children.data();
+    out->dictionary = nullptr;
+    out->release = ReleaseArray;
+    out->private_data = data;
+}
+
+} // namespace
+
+int RecordBatchBuilder::AddColumn(const std::string& name, const std::string& format,
+                                  size_t value_size, int list_size) {
+    columns_.push_back(Column{name, format, value_size, list_size, {}});
+    return static_cast<int>(columns_.size()) - 1;
+}
+
+void RecordBatchBuilder::Reserve(size_t rows) {
+    for (auto& column : columns_) {
+        size_t per_row = column.value_size * (column.list_size > 0 ? column.list_size : 1);
+        column.data.reserve(rows * per_row);
+    }
+}
+
+void RecordBatchBuilder::Export(ArrowArray* out_array, ArrowSchema* out_schema) {
+    const int64_t length = static_cast<int64_t>(rows_);
+    std::vector<ArrowSchema*> field_schemas;
+    std::vector<ArrowArray*> field_arrays;
+    
+    for (auto& column : columns_) {
+        auto* schema = new ArrowSchema;
+        auto* array = new ArrowArray;
+        if (column.list_size > 0) {
+            auto* value_schema = new ArrowSchema;
+            auto* value_array = new ArrowArray;
+            FillSchema(value_schema, "g", "item", {});
+            FillArray(value_array, length * column.list_size, std::move(column.data), true, {});
+            FillSchema(schema, column.format, column.name, {value_schema});
+            FillArray(array, length, {}, false, {value_array});
+        } else {
+            FillSchema(schema, column.format, column.name, {});
+            FillArray(array, length, std::move(column.data), true, {});
+        }
+        column.data = std::vector<uint8_t>();
+        field_schemas.push_back(schema);
+        field_arrays.push_back(array);
+    }
+    
+    FillSchema(out_schema, "+s", "", std::move(field_schemas));
+    FillArray(out_array, length, {}, false, std::move(field_arrays));
+    rows_ = 0;
+}
+
+SnapshotBatchBuilder::SnapshotBatchBuilder(int depth) : depth_(depth > 0 ? depth : 1) {
+    timestamp_col_ = builder_.AddInt64Column("timestamp_ns");
+    symbol_col_ = builder_.AddUInt32Column("symbol_id");
+    mid_col_ = builder_.AddDoubleColumn("mid_price");
+    spread_col_ = builder_.AddDoubleColumn("spread");
+    imbalance_col_ = builder_.AddDoubleColumn("order_imbalance");
+    bid_count_col_ = builder_.AddInt32Column("bid_count");
+    ask_count_col_ = builder_.AddInt32Column("ask_count");
+    bid_prices_col_ = builder_.AddDoubleListColumn("bid_prices", depth_);
+    bid_volumes_col_ = builder_.AddDoubleListColumn("bid_volumes", depth_);
+    ask_prices_col_ = builder_.AddDoubleListColumn("ask_prices", depth_);
+    ask_volumes_col_ = builder_.AddDoubleListColumn("ask_volumes", depth_);
+}
+
+void SnapshotBatchBuilder::Append(uint32_t symbol_id, const LimitOrderBook& book) {
+    builder_.Append<int64_t>(timestamp_col_, book.GetCurrentTime());
+    builder_.Append<uint32_t>(symbol_col_, symbol_id);
+    builder_.Append<double>(mid_col_, book.GetMidPrice());
+    builder_.Append<double>(spread_col_, book.GetSpread());
+    builder_.Append<double>(imbalance_col_, book.GetOrderImbalance());
+    
+    double* bid_prices = builder_.AppendList(bid_prices_col_);
+    double* bid_volumes = builder_.AppendList(bid_volumes_col_);
+    double* ask_prices = builder_.AppendList(ask_prices_col_);
+    double* ask_volumes = builder_.AppendList(ask_volumes_col_);
+    int bid_count = book.GetBidLevels(bid_prices, bid_volumes, depth_);
+    int ask_count = book.GetAskLevels(ask_prices, ask_volumes, depth_);
+    
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (int i = bid_count; i < depth_; ++i) {
+        bid_prices[i] = bid_volumes[i] = nan;
+    }
+    for (int i = ask_count; i < depth_; ++i) {
+        ask_prices[i] = ask_volumes[i] = nan;
+    }
+    builder_.Append<int32_t>(bid_count_col_, bid_count);
+    builder_.Append<int32_t>(ask_count_col_, ask_count);
+    builder_.FinishRow();
+}
+
+MetricBatchBuilder::MetricBatchBuilder(const std::vector<std::string>& metric_names)
+    : metric_names_(metric_names) {
+    timestamp_col_ = builder_.AddInt64Column("timestamp_ns");
+    symbol_col_ = builder_.AddUInt32Column("symbol_id");
+    for (const auto& name : metric_names) {
+        metric_cols_.push_back(builder_.AddDoubleColumn(name));
+    }
+}
+
+void MetricBatchBuilder::Append(int64_t timestamp_ns, uint32_t symbol_id, const double* values) {
+    builder_.Append<int64_t>(timestamp_col_, timestamp_ns);
+    builder_.Append<uint32_t>(symbol_col_, symbol_id);
+    for (size_t i = 0; i < metric_cols_.size(); ++i) {
+        builder_.Append<double>(metric_cols_[i], values[i]);
+    }
+    builder_.FinishRow();
+}
+
+} // namespace microstructure
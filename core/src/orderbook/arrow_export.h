@@ -0,0 +1,150 @@
+#pragma once
+
+#include "limit_order_book.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Arrow C Data Interface structs, as specified by Apache Arrow. Guarded so
+// they can coexist with the definitions in arrow/c/abi.h.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace microstructure {
+
+// Accumulates rows of fixed-width columns and hands them out as a struct
+// array through the Arrow C Data Interface, without depending on the Arrow
+// library. Export moves the buffers into the exported array, so consumers
+// such as pyarrow or polars import them without a copy.
+class RecordBatchBuilder {
+public:
+    int AddInt64Column(const std::string& name) { return AddColumn(name, "l", sizeof(int64_t), 0); }
+    int AddInt32Column(const std::string& name) { return AddColumn(name, "i", sizeof(int32_t), 0); }
+    int AddUInt32Column(const std::string& name) { return AddColumn(name, "I", sizeof(uint32_t), 0); }
+    int AddDoubleColumn(const std::string& name) { return AddColumn(name, "g", sizeof(double), 0); }
+    
+    // Fixed-size list of float64 with list_size values per row
+    int AddDoubleListColumn(const std::string& name, int list_size) {
+        return AddColumn(name, "+w:" + std::to_string(list_size), sizeof(double), list_size);
+    }
+    
+    template <typename T>
+    void Append(int column, T value) {
+        std::vector<uint8_t>& data = columns_[column].data;
+        size_t offset = data.size();
+        data.resize(offset + sizeof(T));
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+    
+    // Space for one row of a list column, to be filled by the caller
+    double* AppendList(int column) {
+        Column& col = columns_[column];
+        size_t offset = col.data.size();
+        col.data.resize(offset + sizeof(double) * col.list_size);
+        return reinterpret_cast<double*>(col.data.data() + offset);
+    }
+    
+    // Call once every column has received its value for the row
+    void FinishRow() { ++rows_; }
+    
+    void Reserve(size_t rows);
+    size_t GetRowCount() const { return rows_; }
+    
+    // Move the accumulated rows out as a struct array. The builder keeps
+    // its columns and starts the next batch empty. The caller owns both
+    // structs and must call their release callbacks.
+    void Export(ArrowArray* out_array, ArrowSchema* out_schema);
+    
+private:
+    struct Column {
+        std::string name;
+        std::string format;
+        size_t value_size;
+        int list_size;              // 0 for primitive columns
+        std::vector<uint8_t> data;
+    };
+    
+    int AddColumn(const std::string& name, const std::string& format, size_t value_size, int list_size);
+    
+    std::vector<Column> columns_;
+    size_t rows_ = 0;
+};
+
+// Top-of-book snapshots for a batch of (time, symbol) rows. Levels beyond
+// a side's depth are NaN; bid_count/ask_count give the populated length.
+class SnapshotBatchBuilder {
+public:
+    explicit SnapshotBatchBuilder(int depth);
+    
+    void Append(uint32_t symbol_id, const LimitOrderBook& book);
+    size_t GetRowCount() const { return builder_.GetRowCount(); }
+    int GetDepth() const { return depth_; }
+    
+    void Export(ArrowArray* out_array, ArrowSchema* out_schema) { builder_.Export(out_array, out_schema); }
+    
+private:
+    int depth_;
+    RecordBatchBuilder builder_;
+    int timestamp_col_, symbol_col_, mid_col_, spread_col_, imbalance_col_;
+    int bid_count_col_, ask_count_col_;
+    int bid_prices_col_, bid_volumes_col_, ask_prices_col_, ask_volumes_col_;
+};
+
+// Rows of named float64 metrics keyed by time and symbol
+class MetricBatchBuilder {
+public:
+    explicit MetricBatchBuilder(const std::vector<std::string>& metric_names);
+    
+    // values holds one entry per metric, in constructor order
+    void Append(int64_t timestamp_ns, uint32_t symbol_id, const double* values);
+    size_t GetRowCount() const { return builder_.GetRowCount(); }
+    size_t GetMetricCount() const { return metric_cols_.size(); }
+    const std::vector<std::string>& GetMetricNames() const { return metric_names_; }
+    
+    void Export(ArrowArray* out_array, ArrowSchema* out_schema) { builder_.Export(out_array, out_schema); }
+    
+private:
+    RecordBatchBuilder builder_;
+    int timestamp_col_, symbol_col_;
+    std::vector<int> metric_cols_;
+    std::vector<std::string> metric_names_;
+};
+
+} // namespace microstructure
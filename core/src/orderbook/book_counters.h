@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace microstructure {
+
+enum class BookCounter : uint8_t {
+    kOrdersAdded,
+    kOrdersRecovered,   // Loaded from a recovery snapshot rather than added
+    kOrdersCancelled,   // Including mass cancels, expiries and clears
+    kOrdersExecuted,
+    kUnknownOrders,     // Modify, cancel or execute for an ID not in the book
+    kLevelsCreated,     // Price map insertions
+    kLevelsDeleted,     // Price map erasures of emptied levels
+    kCrossedBook        // Transitions into best bid >= best ask
+};
+
+constexpr size_t kBookCounterCount = 8;
+
+inline const char* GetBookCounterName(BookCounter counter) {
+    switch (counter) {
+        case BookCounter::kOrdersAdded:
+            return "orders_added";
+        case BookCounter::kOrdersRecovered:
+            return "orders_recovered";
+        case BookCounter::kOrdersCancelled:
+            return "orders_cancelled";
+        case BookCounter::kOrdersExecuted:
+            return "orders_executed";
+        case BookCounter::kUnknownOrders:
+            return "unknown_order_events";
+        case BookCounter::kLevelsCreated:
+            return "levels_created";
+        case BookCounter::kLevelsDeleted:
+            return "levels_deleted";
+        case BookCounter::kCrossedBook:
+            return "crossed_book";
+    }
+    return "unknown";
+}
+
+inline const char* GetBookCounterHelp(BookCounter counter) {
+    switch (counter) {
+        case BookCounter::kOrdersAdded:
+            return "Orders added to the book";
+        case BookCounter::kOrdersRecovered:
+            return "Orders loaded from a recovery snapshot";
+        case BookCounter::kOrdersCancelled:
+            return "Orders cancelled, including mass cancels, expiries and clears";
+        case BookCounter::kOrdersExecuted:
+            return "Executions against resting orders";
+        case BookCounter::kUnknownOrders:
+            return "Modify, cancel or execute events for an order not in the book";
+        case BookCounter::kLevelsCreated:
+            return "Price levels inserted into the price map";
+        case BookCounter::kLevelsDeleted:
+            return "Emptied price levels erased from the price map";
+        case BookCounter::kCrossedBook:
+            return "Times the best bid reached or passed the best ask";
+    }
+    return "";
+}
+
+// Operational counters of one book. A book has one writer thread at a
+// time, so an increment is a relaxed load and store with no locked
+// instruction, and the block sits on its own cache line so a scraper
+// reading it never contends with the rest of the book.
+class alignas(64) BookCounters {
+public:
+    void Increment(BookCounter counter) {
+        std::atomic<uint64_t>& value = values_[static_cast<size_t>(counter)];
+        value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    
+    void Add(BookCounter counter, uint64_t amount) {
+        std::atomic<uint64_t>& value = values_[static_cast<size_t>(counter)];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    
+    // Safe from any thread
+    uint64_t Get(BookCounter counter) const {
+        return values_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+    
+private:
+    std::atomic<uint64_t> values_[kBookCounterCount] = {};
+};
+
+} // namespace microstructure
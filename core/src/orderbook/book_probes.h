@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+// USDT (SystemTap/DTrace style) static probes in the book hot path, so
+// bpftrace or perf can attach to a running process without a rebuild.
+// Each probe is a single nop plus an ELF note; the arguments are placed in
+// registers but nothing is recorded unless a tracer is attached. The
+// probes need <sys/sdt.h> (systemtap-sdt-dev); without it, or with
+// MICROSTRUCTURE_NO_PROBES defined, the macros expand to nothing.
+//
+// Provider "microstructure":
+//   add_order(symbol, order_id, price, qty, is_buy)    add_order_done(symbol, order_id)
+//   cancel_order(symbol, order_id)                      cancel_order_done(symbol, order_id, found)
+//   modify_order(symbol, order_id, qty)                 modify_order_done(symbol, order_id, found)
+//   level_create(symbol, is_buy, price)                 level_delete(symbol, is_buy, price)
+//   apply_batch(symbol, count)                          apply_batch_done(symbol, applied)
+//   pipeline_batch(count)                               pipeline_batch_done(applied)
+//
+// Strings are const char*. bpftrace has no floating point, so prices and
+// quantities are int64 in units of 1e-8 (ToProbeFixed). See
+// core/tools/bpftrace for sample scripts; list the probes with
+//   readelf -n liborderbook.so | grep -A4 stapsdt
+
+#if !defined(MICROSTRUCTURE_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define MICROSTRUCTURE_HAS_PROBES 1
+#endif
+#endif
+
+#ifdef MICROSTRUCTURE_HAS_PROBES
+#define BOOK_PROBE1(name, a1) DTRACE_PROBE1(microstructure, name, a1)
+#define BOOK_PROBE2(name, a1, a2) DTRACE_PROBE2(microstructure, name, a1, a2)
+#define BOOK_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(microstructure, name, a1, a2, a3)
+#define BOOK_PROBE5(name, a1, a2, a3, a4, a5) DTRACE_PROBE5(microstructure, name, a1, a2, a3, a4, a5)
+#else
+#define BOOK_PROBE1(name, a1) do {} while (0)
+#define BOOK_PROBE2(name, a1, a2) do {} while (0)
+#define BOOK_PROBE3(name, a1, a2, a3) do {} while (0)
+#define BOOK_PROBE5(name, a1, a2, a3, a4, a5) do {} while (0)
+#endif
+
+namespace microstructure {
+
+constexpr double kProbeFixedScale = 1e8;
+
+inline int64_t ToProbeFixed(double value) {
+    return static_cast<int64_t>(value * kProbeFixedScale);
+}
+
+} // namespace microstructure
@@ -0,0 +1,64 @@
+#include "event_columns.h"
+
+#include <limits>
+
+namespace microstructure {
+
+namespace {
+
+bool HasDerived(const DerivedColumns* derived) {
+    return derived && (derived->best_bid || derived->best_ask ||
+                       derived->mid_price || derived->order_imbalance);
+}
+
+void WriteDerived(const DerivedColumns& derived, size_t row, const LimitOrderBook* book) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    if (derived.best_bid) {
+        derived.best_bid[row] = book ? book->GetBestBid() : nan;
+    }
+    if (derived.best_ask) {
+        derived.best_ask[row] = book ? book->GetBestAsk() : nan;
+    }
+    if (derived.mid_price) {
+        derived.mid_price[row] = book ? book->GetMidPrice() : nan;
+    }
+    if (derived.order_imbalance) {
+        derived.order_imbalance[row] = book ? book->GetOrderImbalance(derived.imbalance_levels) : nan;
+    }
+}
+
+} // namespace
+
+size_t ApplyEventColumns(LimitOrderBook* const* books, size_t book_count,
+                         const EventColumns& columns, size_t count,
+                         const DerivedColumns* derived) {
+    const bool sample = HasDerived(derived);
+    size_t applied = 0;
+    OrderEvent event{};
+    
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t index = columns.book_index ? columns.book_index[i] : 0;
+        LimitOrderBook* book = index < book_count ? books[index] : nullptr;
+        
+        if (book) {
+            event.timestamp_ns = columns.timestamp_ns[i];
+            event.order_id = columns.order_id[i];
+            event.price = columns.price[i];
+            event.quantity = columns.quantity[i];
+            event.type = columns.type[i];
+            event.is_buy = columns.is_buy[i];
+            if (book->ApplyEvent(event)) {
+                ++applied;
+            } else {
+                book = nullptr;
+            }
+        }
+        
+        if (sample) {
+            WriteDerived(*derived, i, book);
+        }
+    }
+    return applied;
+}
+
+} // namespace microstructure
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "limit_order_book.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace microstructure {
+
+// Column-oriented view of an event stream, one entry per event. Field
+// meanings follow OrderEvent; nothing is copied into row form.
+struct EventColumns {
+    const int64_t* timestamp_ns = nullptr;
+    const uint8_t* type = nullptr;
+    const uint64_t* order_id = nullptr;
+    const double* price = nullptr;
+    const double* quantity = nullptr;
+    const uint8_t* is_buy = nullptr;
+    const uint32_t* book_index = nullptr;   // Optional; null routes every event to book 0
+};
+
+// Optional per-event outputs, sampled from the routed book after each
+// event is applied. Any column left null is not computed.
+struct DerivedColumns {
+    double* best_bid = nullptr;
+    double* best_ask = nullptr;
+    double* mid_price = nullptr;
+    double* order_imbalance = nullptr;
+    int imbalance_levels = 5;
+};
+
+// Apply count events across a set of books in stream order. Events with an
+// unknown type or an out-of-range book index are skipped; their derived
+// rows are NaN. Returns the number of events applied.
+size_t ApplyEventColumns(LimitOrderBook* const* books, size_t book_count,
+                         const EventColumns& columns, size_t count,
+                         const DerivedColumns* derived = nullptr);
+
+} // namespace microstructure
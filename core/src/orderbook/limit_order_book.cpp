@@ -1,116 +1,479 @@
 #include "limit_order_book.h"
 #include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <limits>
+#include <type_traits>
 
 namespace microstructure {
 
-void PriceLevel::AddOrder(const OrderPtr& order) {
-    orders_.push_back(order);
+void PriceLevel::LinkTail(Order* order) {
+    order->prev = tail_;
+    order->next = nullptr;
+    if (tail_) {
+        tail_->next = order;
+    } else {
+        head_ = order;
+    }
+    tail_ = order;
+}
+
+void PriceLevel::Unlink(Order* order) {
+    if (order->prev) {
+        order->prev->next = order->next;
+    } else {
+        head_ = order->next;
+    }
+    if (order->next) {
+        order->next->prev = order->prev;
+    } else {
+        tail_ = order->prev;
+    }
+    order->prev = nullptr;
+    order->next = nullptr;
+}
+
+void PriceLevel::AddOrder(Order* order) {
+    order->level = this;
+    LinkTail(order);
+    ++order_count_;
     total_volume_ += order->quantity;
+    hidden_volume_ += order->hidden_quantity;
 }
 
-void PriceLevel::RemoveOrder(const std::string& order_id) {
-    auto it = std::find_if(orders_.begin(), orders_.end(),
-                          [&order_id](const OrderPtr& order) {
-                              return order->order_id == order_id;
-                          });
+void PriceLevel::RemoveOrder(Order* order) {
+    Unlink(order);
+    order->level = nullptr;
+    --order_count_;
+    total_volume_ -= order->quantity;
+    hidden_volume_ -= order->hidden_quantity;
+}
+
+void PriceLevel::UpdateQuantity(Order* order, double new_quantity) {
+    total_volume_ += new_quantity - order->quantity;
+    order->quantity = new_quantity;
+}
+
+bool PriceLevel::ReplenishOrder(Order* order) {
+    if (order->hidden_quantity <= 0) {
+        return false;
+    }
+    
+    // A hidden order without a peak exposes its whole reserve
+    double refill = order->IsIceberg()
+        ? std::min(order->peak_quantity, order->hidden_quantity)
+        : order->hidden_quantity;
+    
+    total_volume_ += refill;
+    hidden_volume_ -= refill;
+    order->quantity += refill;
+    order->hidden_quantity -= refill;
     
-    if (it != orders_.end()) {
-        total_volume_ -= (*it)->quantity;
-        orders_.erase(it);
+    // Refilled tips lose time priority; re-queue the same node at the tail
+    if (order != tail_) {
+        Unlink(order);
+        LinkTail(order);
     }
+    return true;
 }
 
 double PriceLevel::GetTotalVolume() const {
     return total_volume_;
 }
 
-const std::vector<OrderPtr>& PriceLevel::GetOrders() const {
-    return orders_;
+void LimitOrderBook::AddOrder(const OrderPtr& order) {
+    BOOK_PROBE5(add_order, symbol_.c_str(), order->order_id.c_str(), ToProbeFixed(order->price),
+                ToProbeFixed(order->quantity), order->is_buy);
+    RaiseEventTime(order->timestamp_ns);
+    InsertOrder(order);
+    counters_.Increment(BookCounter::kOrdersAdded);
+    UpdateBestPrices();
+    BOOK_PROBE2(add_order_done, symbol_.c_str(), order->order_id.c_str());
 }
 
-void LimitOrderBook::AddOrder(const OrderPtr& order) {
+void LimitOrderBook::InsertOrder(const OrderPtr& order) {
+    // A reused ID replaces the live order rather than leaving it queued
+    auto existing = orders_.find(order->order_id);
+    if (existing != orders_.end()) {
+        EraseOrder(existing);
+    }
+    
     // Store the order in the lookup map
     orders_[order->order_id] = order;
+    event_time_ns_ = std::max(event_time_ns_, order->timestamp_ns);
     
-    // Add to the appropriate side of the book
-    if (order->is_buy) {
-        auto it = bids_.find(order->price);
-        if (it == bids_.end()) {
-            auto level = std::make_shared<PriceLevel>(order->price);
-            level->AddOrder(order);
-            bids_[order->price] = level;
-        } else {
-            it->second->AddOrder(order);
-        }
-    } else {
-        auto it = asks_.find(order->price);
-        if (it == asks_.end()) {
-            auto level = std::make_shared<PriceLevel>(order->price);
-            level->AddOrder(order);
-            asks_[order->price] = level;
-        } else {
-            it->second->AddOrder(order);
-        }
+    if (order->expire_time_ns > 0) {
+        order->expiry_timer = expiry_wheel_.Schedule(order->expire_time_ns, order->order_id);
+    }
+    if (order->owner_id != 0) {
+        LinkOwner(order.get());
     }
     
-    UpdateBestPrices();
+    // Add to the appropriate side of the book
+    GetOrCreateLevel(order->is_buy, order->price)->AddOrder(order.get());
 }
 
 void LimitOrderBook::ModifyOrder(const std::string& order_id, double new_quantity) {
+    BOOK_PROBE3(modify_order, symbol_.c_str(), order_id.c_str(), ToProbeFixed(new_quantity));
     auto it = orders_.find(order_id);
     if (it == orders_.end()) {
+        counters_.Increment(BookCounter::kUnknownOrders);
+        BOOK_PROBE3(modify_order_done, symbol_.c_str(), order_id.c_str(), false);
         return;
     }
     
-    OrderPtr order = it->second;
-    double delta = new_quantity - order->quantity;
-    order->quantity = new_quantity;
+    ResizeOrder(it, new_quantity);
+    BOOK_PROBE3(modify_order_done, symbol_.c_str(), order_id.c_str(), true);
+}
+
+bool LimitOrderBook::ReplaceOrder(const std::string& order_id, double new_price, double new_quantity) {
+    auto it = orders_.find(order_id);
+    if (it == orders_.end()) {
+        counters_.Increment(BookCounter::kUnknownOrders);
+        return false;
+    }
     
-    // Update the price level totals
-    if (order->is_buy) {
-        bids_[order->price]->AddOrder(order);
-    } else {
-        asks_[order->price]->AddOrder(order);
+    Order* order = it->second.get();
+    if (new_price == order->price) {
+        ResizeOrder(it, new_quantity);
+        return true;
+    }
+    
+    if (new_quantity <= 0 && order->hidden_quantity <= 0) {
+        EraseOrder(it);
+        UpdateBestPrices();
+        return true;
+    }
+    
+    // A price change always loses priority: the same node moves to the
+    // tail of the destination level
+    PriceLevel* level = order->level;
+    level->RemoveOrder(order);
+    RemoveLevelIfEmpty(level, order->is_buy);
+    
+    order->price = new_price;
+    order->quantity = std::max(new_quantity, 0.0);
+    GetOrCreateLevel(order->is_buy, new_price)->AddOrder(order);
+    
+    UpdateBestPrices();
+    return true;
+}
+
+void LimitOrderBook::ResizeOrder(std::unordered_map<std::string, OrderPtr>::iterator it, double new_quantity) {
+    Order* order = it->second.get();
+    PriceLevel* level = order->level;
+    if (!level) {
+        return;
+    }
+    
+    new_quantity = std::max(new_quantity, 0.0);
+    if (new_quantity > order->quantity) {
+        // Increasing size loses time priority
+        level->RemoveOrder(order);
+        order->quantity = new_quantity;
+        level->AddOrder(order);
+        return;
+    }
+    
+    // Reducing size keeps the order's place in the queue
+    level->UpdateQuantity(order, new_quantity);
+    
+    // An exhausted iceberg tip is refilled from its reserve
+    if (order->quantity <= 0 && order->IsIceberg()) {
+        level->ReplenishOrder(order);
+    }
+    
+    if (order->GetTotalQuantity() <= 0) {
+        EraseOrder(it);
+        UpdateBestPrices();
     }
 }
 
 void LimitOrderBook::CancelOrder(const std::string& order_id) {
+    BOOK_PROBE2(cancel_order, symbol_.c_str(), order_id.c_str());
     auto it = orders_.find(order_id);
     if (it == orders_.end()) {
+        counters_.Increment(BookCounter::kUnknownOrders);
+        BOOK_PROBE3(cancel_order_done, symbol_.c_str(), order_id.c_str(), false);
         return;
     }
     
-    OrderPtr order = it->second;
+    EraseOrder(it);
+    counters_.Increment(BookCounter::kOrdersCancelled);
+    UpdateBestPrices();
+    BOOK_PROBE3(cancel_order_done, symbol_.c_str(), order_id.c_str(), true);
+}
+
+void LimitOrderBook::EraseOrder(std::unordered_map<std::string, OrderPtr>::iterator it) {
+    Order* order = it->second.get();
     
     // Remove from the appropriate side of the book
-    if (order->is_buy) {
-        auto level_it = bids_.find(order->price);
-        if (level_it != bids_.end()) {
-            level_it->second->RemoveOrder(order_id);
-            
-            // If level is empty, remove it
-            if (level_it->second->GetTotalVolume() <= 0) {
-                bids_.erase(level_it);
+    PriceLevel* level = order->level;
+    if (level) {
+        level->RemoveOrder(order);
+        
+        // If level is empty, remove it
+        RemoveLevelIfEmpty(level, order->is_buy);
+    }
+    if (order->owner_id != 0) {
+        UnlinkOwner(order);
+    }
+    if (order->expiry_timer != 0) {
+        expiry_wheel_.Cancel(order->expiry_timer);
+        order->expiry_timer = 0;
+    }
+    
+    // Remove from the lookup map
+    orders_.erase(it);
+}
+
+size_t LimitOrderBook::MassCancel(const MassCancelFilter& filter) {
+    size_t cancelled = 0;
+    
+    if (filter.owner_id != 0) {
+        auto owner_it = owner_heads_.find(filter.owner_id);
+        Order* order = owner_it != owner_heads_.end() ? owner_it->second : nullptr;
+        while (order) {
+            Order* next = order->owner_next;
+            bool side_match = order->is_buy ? filter.include_bids : filter.include_asks;
+            if (side_match && order->price >= filter.min_price && order->price <= filter.max_price) {
+                EraseOrder(orders_.find(order->order_id));
+                ++cancelled;
             }
+            order = next;
         }
     } else {
-        auto level_it = asks_.find(order->price);
-        if (level_it != asks_.end()) {
-            level_it->second->RemoveOrder(order_id);
-            
-            // If level is empty, remove it
-            if (level_it->second->GetTotalVolume() <= 0) {
-                asks_.erase(level_it);
+        if (filter.include_bids) {
+            // Bids are ordered high to low
+            cancelled += CancelLevels(bids_, bids_.lower_bound(filter.max_price),
+                                      bids_.upper_bound(filter.min_price));
+        }
+        if (filter.include_asks) {
+            cancelled += CancelLevels(asks_, asks_.lower_bound(filter.min_price),
+                                      asks_.upper_bound(filter.max_price));
+        }
+    }
+    
+    if (cancelled > 0) {
+        counters_.Add(BookCounter::kOrdersCancelled, cancelled);
+        UpdateBestPrices();
+    }
+    return cancelled;
+}
+
+bool LimitOrderBook::ApplyEvent(const OrderEvent& event) {
+    if (event.type < kEventAdd || event.type > kEventExecute) {
+        return false;
+    }
+    
+    // Every event carries its exchange time; trades it causes are stamped
+    // with it, and modifies or executes must not be dated by the last add
+    RaiseEventTime(event.timestamp_ns);
+    FormatOrderId(event.order_id);
+    
+    switch (event.type) {
+        case kEventAdd:
+            AddOrder(std::make_shared<Order>(Order{
+                id_buffer_, event.price, event.quantity, event.is_buy != 0, event.timestamp_ns}));
+            break;
+        case kEventModify:
+            ModifyOrder(id_buffer_, event.quantity);
+            break;
+        case kEventCancel:
+            CancelOrder(id_buffer_);
+            break;
+        case kEventReplace:
+            ReplaceOrder(id_buffer_, event.price, event.quantity);
+            break;
+        case kEventExecute:
+            ExecuteOrder(id_buffer_, event.quantity, event.price);
+            break;
+    }
+    return true;
+}
+
+size_t LimitOrderBook::ApplyEvents(const OrderEvent* events, size_t count) {
+    BOOK_PROBE2(apply_batch, symbol_.c_str(), count);
+    size_t applied = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (ApplyEvent(events[i])) {
+            ++applied;
+        }
+    }
+    BOOK_PROBE2(apply_batch_done, symbol_.c_str(), applied);
+    return applied;
+}
+
+void LimitOrderBook::Clear() {
+    ClearOrders();
+    triggers_.Clear();
+    pending_triggers_.clear();
+    UpdateBestPrices();
+}
+
+void LimitOrderBook::ClearOrders() {
+    counters_.Add(BookCounter::kOrdersCancelled, orders_.size());
+    counters_.Add(BookCounter::kLevelsDeleted, bids_.size() + asks_.size());
+    orders_.clear();
+    bids_.clear();
+    asks_.clear();
+    owner_heads_.clear();
+    expiry_wheel_.Clear();
+}
+
+size_t LimitOrderBook::LoadOrders(const OrderEvent* orders, size_t count) {
+    ClearOrders();
+    orders_.reserve(count);
+    
+    size_t loaded = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const OrderEvent& event = orders[i];
+        if (event.type != kEventAdd) {
+            continue;
+        }
+        InsertOrder(std::make_shared<Order>(Order{
+            FormatOrderId(event.order_id), event.price, event.quantity, event.is_buy != 0, event.timestamp_ns}));
+        ++loaded;
+    }
+    counters_.Add(BookCounter::kOrdersRecovered, loaded);
+    UpdateBestPrices();
+    return loaded;
+}
+
+const std::string& LimitOrderBook::FormatOrderId(uint64_t order_id) {
+    // The ID buffer keeps its capacity, so lookups do not allocate
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), order_id);
+    id_buffer_.assign(digits, result.ptr);
+    return id_buffer_;
+}
+
+template <typename LevelMap>
+size_t LimitOrderBook::CancelLevels(LevelMap& levels, typename LevelMap::iterator first,
+                                    typename LevelMap::iterator last) {
+    size_t cancelled = 0;
+    for (auto it = first; it != last; ++it) {
+        // The level is dropped as a whole below, so its queue is only
+        // walked to release the orders, not unlinked node by node
+        Order* order = it->second->GetFrontOrder();
+        while (order) {
+            Order* next = order->next;
+            if (order->owner_id != 0) {
+                UnlinkOwner(order);
+            }
+            if (order->expiry_timer != 0) {
+                expiry_wheel_.Cancel(order->expiry_timer);
             }
+            orders_.erase(orders_.find(order->order_id));
+            order = next;
+            ++cancelled;
+        }
+        counters_.Increment(BookCounter::kLevelsDeleted);
+        // Bids and asks are ordered differently, so the map type gives the side
+        BOOK_PROBE3(level_delete, symbol_.c_str(), (std::is_same<LevelMap, decltype(bids_)>::value),
+                    ToProbeFixed(it->second->GetPrice()));
+    }
+    levels.erase(first, last);
+    return cancelled;
+}
+
+void LimitOrderBook::LinkOwner(Order* order) {
+    Order*& head = owner_heads_[order->owner_id];
+    order->owner_prev = nullptr;
+    order->owner_next = head;
+    if (head) {
+        head->owner_prev = order;
+    }
+    head = order;
+}
+
+void LimitOrderBook::UnlinkOwner(Order* order) {
+    if (order->owner_next) {
+        order->owner_next->owner_prev = order->owner_prev;
+    }
+    if (order->owner_prev) {
+        order->owner_prev->owner_next = order->owner_next;
+    } else if (order->owner_next) {
+        owner_heads_[order->owner_id] = order->owner_next;
+    } else {
+        owner_heads_.erase(order->owner_id);
+    }
+    order->owner_prev = nullptr;
+    order->owner_next = nullptr;
+}
+
+size_t LimitOrderBook::AdvanceTime(int64_t now_ns) {
+    event_time_ns_ = std::max(event_time_ns_, now_ns);
+    
+    size_t expired = 0;
+    expiry_wheel_.Advance(now_ns, [this, &expired](const std::string& order_id) {
+        // Erasing or clearing an order cancels its timer, so the order is live
+        auto it = orders_.find(order_id);
+        if (it == orders_.end()) {
+            return;
         }
+        it->second->expiry_timer = 0;
+        EraseOrder(it);
+        ++expired;
+    });
+    
+    // Best prices and stop triggers are refreshed once for the whole batch
+    if (expired > 0) {
+        counters_.Add(BookCounter::kOrdersCancelled, expired);
+        UpdateBestPrices();
+    }
+    return expired;
+}
+
+void LimitOrderBook::RaiseEventTime(int64_t timestamp_ns) {
+    // Orders whose expiry the new time has passed leave before the event
+    // applies, so feeds expire good-till-time orders without AdvanceTime
+    if (expiry_wheel_.IsBehind(timestamp_ns)) {
+        AdvanceTime(timestamp_ns);
+    } else {
+        event_time_ns_ = std::max(event_time_ns_, timestamp_ns);
     }
+}
+
+int64_t LimitOrderBook::GetCurrentTime() const {
+    return event_time_ns_;
+}
+
+double LimitOrderBook::ExecuteOrder(const std::string& order_id, double exec_qty, double trade_price) {
+    auto it = orders_.find(order_id);
+    if (it == orders_.end()) {
+        counters_.Increment(BookCounter::kUnknownOrders);
+        return 0.0;
+    }
+    if (exec_qty <= 0) {
+        return 0.0;
+    }
+    counters_.Increment(BookCounter::kOrdersExecuted);
     
-    // Remove from the lookup map
-    orders_.erase(it);
+    // Executions larger than an iceberg's tip continue into the refilled
+    // tip of the same order, as reported by the venue
+    Order* order = it->second.get();
+    if (!(trade_price > 0)) {
+        // Feeds may omit the price; the fill happened at the resting price
+        trade_price = order->price;
+    }
+    double executed = 0.0;
+    while (executed < exec_qty) {
+        double available = order->GetTotalQuantity();
+        double fill = FillRestingOrder(order, exec_qty - executed, trade_price);
+        executed += fill;
+        if (fill <= 0 || fill >= available) {
+            break;
+        }
+    }
     
     UpdateBestPrices();
+    OnTradePrice(trade_price);
+    return executed;
+}
+
+std::vector<Trade> LimitOrderBook::GetRecentTrades(size_t count) const {
+    return trade_tape_.GetRecentTrades(count);
 }
 
 double LimitOrderBook::GetBestBid() const {
@@ -138,6 +501,164 @@ double LimitOrderBook::GetSpread() const {
 void LimitOrderBook::UpdateBestPrices() {
     best_bid_ = bids_.empty() ? 0.0 : bids_.begin()->first;
     best_ask_ = asks_.empty() ? std::numeric_limits<double>::max() : asks_.begin()->first;
+    
+    // Count each time the book becomes crossed, not every update while it is
+    bool crossed = !bids_.empty() && !asks_.empty() && best_bid_ >= best_ask_;
+    if (crossed && !crossed_) {
+        counters_.Increment(BookCounter::kCrossedBook);
+    }
+    crossed_ = crossed;
+    
+    if (!triggers_.IsEmpty()) {
+        // An empty side must not trigger anything
+        FireTriggers(asks_.empty() ? -std::numeric_limits<double>::max() : best_ask_,
+                     bids_.empty() ? std::numeric_limits<double>::max() : best_bid_);
+    }
+}
+
+bool LimitOrderBook::AddStopOrder(const StopOrder& order) {
+    // A stop-limit's unfilled part rests under its ID, which would replace
+    // the live order
+    if (orders_.find(order.order_id) != orders_.end()) {
+        return false;
+    }
+    triggers_.AddStopOrder(order);
+    
+    // A stop that is already through the market fires straight away
+    UpdateBestPrices();
+    return true;
+}
+
+bool LimitOrderBook::CancelStopOrder(const std::string& order_id) {
+    return triggers_.CancelStopOrder(order_id);
+}
+
+size_t LimitOrderBook::GetStopOrderCount() const {
+    return triggers_.GetStopOrderCount();
+}
+
+void LimitOrderBook::OnTradePrice(double price) {
+    // A missing price would read as a crash through every sell stop
+    if (price > 0 && !triggers_.IsEmpty()) {
+        FireTriggers(price, price);
+    }
+}
+
+void LimitOrderBook::FireTriggers(double buy_reference, double sell_reference) {
+    triggers_.Trigger(buy_reference, sell_reference, pending_triggers_);
+    
+    // Matching a fired stop moves prices and may fire further stops; those
+    // are queued and drained by the outermost call rather than recursing
+    if (processing_triggers_) {
+        return;
+    }
+    
+    processing_triggers_ = true;
+    while (!pending_triggers_.empty()) {
+        StopOrder stop = std::move(pending_triggers_.front());
+        pending_triggers_.pop_front();
+        MatchStopOrder(stop);
+    }
+    processing_triggers_ = false;
+}
+
+void LimitOrderBook::MatchStopOrder(const StopOrder& stop) {
+    // Stop-market orders sweep without a price limit
+    double limit = stop.IsStopLimit()
+        ? stop.limit_price
+        : (stop.is_buy ? std::numeric_limits<double>::max() : 0.0);
+    double remaining = stop.quantity;
+    
+    while (remaining > 0) {
+        PriceLevel* level = nullptr;
+        if (stop.is_buy) {
+            if (asks_.empty() || asks_.begin()->first > limit) {
+                break;
+            }
+            level = asks_.begin()->second.get();
+        } else {
+            if (bids_.empty() || bids_.begin()->first < limit) {
+                break;
+            }
+            level = bids_.begin()->second.get();
+        }
+        
+        double price = level->GetPrice();
+        remaining -= FillRestingOrder(level->GetFrontOrder(), remaining, price);
+        UpdateBestPrices();
+        OnTradePrice(price);
+    }
+    
+    // The unfilled part of a stop-limit rests as a regular limit order,
+    // unless an order added since the stop has taken its ID
+    if (remaining > 0 && stop.IsStopLimit() && orders_.find(stop.order_id) == orders_.end()) {
+        AddOrder(std::make_shared<Order>(Order{
+            stop.order_id, stop.limit_price, remaining, stop.is_buy, stop.timestamp_ns}));
+    }
+}
+
+double LimitOrderBook::FillRestingOrder(Order* order, double quantity, double trade_price) {
+    PriceLevel* level = order->level;
+    
+    // A hidden order executes against its reserve
+    if (order->quantity <= 0) {
+        level->ReplenishOrder(order);
+    }
+    
+    double fill = std::min(quantity, order->quantity);
+    level->UpdateQuantity(order, order->quantity - fill);
+    if (fill > 0) {
+        trade_tape_.Record(order->order_id, trade_price, fill, order->is_buy, event_time_ns_);
+    }
+    
+    if (order->quantity <= 0 && !level->ReplenishOrder(order)) {
+        // Fully filled: the order leaves the book without a price lookup
+        EraseOrder(orders_.find(order->order_id));
+    }
+    return fill;
+}
+
+PriceLevel* LimitOrderBook::GetOrCreateLevel(bool is_buy, double price) {
+    if (is_buy) {
+        PriceLevelPtr& level = bids_[price];
+        if (!level) {
+            level = std::make_shared<PriceLevel>(price);
+            counters_.Increment(BookCounter::kLevelsCreated);
+            BOOK_PROBE3(level_create, symbol_.c_str(), true, ToProbeFixed(price));
+        }
+        return level.get();
+    }
+    PriceLevelPtr& level = asks_[price];
+    if (!level) {
+        level = std::make_shared<PriceLevel>(price);
+        counters_.Increment(BookCounter::kLevelsCreated);
+        BOOK_PROBE3(level_create, symbol_.c_str(), false, ToProbeFixed(price));
+    }
+    return level.get();
+}
+
+void LimitOrderBook::RemoveLevelIfEmpty(PriceLevel* level, bool is_buy) {
+    // Levels holding only hidden orders have no displayed volume but are
+    // still live, so emptiness is decided by the order count
+    if (!level->IsEmpty()) {
+        return;
+    }
+    counters_.Increment(BookCounter::kLevelsDeleted);
+    BOOK_PROBE3(level_delete, symbol_.c_str(), is_buy, ToProbeFixed(level->GetPrice()));
+    if (is_buy) {
+        bids_.erase(level->GetPrice());
+    } else {
+        asks_.erase(level->GetPrice());
+    }
+}
+
+double LimitOrderBook::GetHiddenVolume(bool is_buy, double price) const {
+    if (is_buy) {
+        auto it = bids_.find(price);
+        return it != bids_.end() ? it->second->GetHiddenVolume() : 0.0;
+    }
+    auto it = asks_.find(price);
+    return it != asks_.end() ? it->second->GetHiddenVolume() : 0.0;
 }
 
 double LimitOrderBook::GetOrderImbalance(int levels) const {
@@ -179,6 +700,41 @@ std::vector<std::pair<double, double>> LimitOrderBook::GetAskLevels(int count) c
     return levels;
 }
 
+int LimitOrderBook::GetBidLevels(double* prices, double* volumes, int count) const {
+    int i = 0;
+    for (auto it = bids_.begin(); it != bids_.end() && i < count; ++it, ++i) {
+        prices[i] = it->first;
+        volumes[i] = it->second->GetTotalVolume();
+    }
+    return i;
+}
+
+int LimitOrderBook::GetAskLevels(double* prices, double* volumes, int count) const {
+    int i = 0;
+    for (auto it = asks_.begin(); it != asks_.end() && i < count; ++it, ++i) {
+        prices[i] = it->first;
+        volumes[i] = it->second->GetTotalVolume();
+    }
+    return i;
+}
+
+const Order* LimitOrderBook::GetOrder(const std::string& order_id) const {
+    auto it = orders_.find(order_id);
+    return it != orders_.end() ? it->second.get() : nullptr;
+}
+
+int64_t LimitOrderBook::GetQueuePosition(const std::string& order_id) const {
+    const Order* order = GetOrder(order_id);
+    if (!order) {
+        return -1;
+    }
+    int64_t ahead = 0;
+    for (const Order* prev = order->prev; prev; prev = prev->prev) {
+        ++ahead;
+    }
+    return ahead;
+}
+
 double LimitOrderBook::EstimateMarketImpact(bool is_buy, double quantity) const {
     double remaining_quantity = quantity;
     double weighted_price = 0.0;
@@ -5,43 +5,126 @@
 #include <string>
 #include <memory>
 #include <cstdint>
+#include <limits>
 #include <vector>
 
+#include "book_counters.h"
+#include "book_probes.h"
+#include "timer_wheel.h"
+#include "trade_tape.h"
+#include "trigger_book.h"
+
 namespace microstructure {
 
+// Forward declarations
+class PriceLevel;
+
 struct Order {
     std::string order_id;
     double price;
-    double quantity;
+    double quantity;            // Displayed (visible) quantity
     bool is_buy;
     int64_t timestamp_ns;
     
+    // Iceberg / hidden support. A plain limit order leaves both at zero.
+    // A fully hidden order rests with quantity == 0 and its size in
+    // hidden_quantity; an iceberg shows peak_quantity at a time and
+    // refills its tip from hidden_quantity when the tip is consumed.
+    double hidden_quantity = 0.0;
+    double peak_quantity = 0.0;
+    
+    // Good-till-time expiry in event time; 0 means the order never expires
+    int64_t expire_time_ns = 0;
+    uint64_t expiry_timer = 0;  // Pending expiry in the book's wheel, 0 if none
+    
+    // Participant tag used by mass cancel; 0 means untagged
+    uint32_t owner_id = 0;
+    
+    // Intrusive queue links owned by the resting PriceLevel
+    PriceLevel* level = nullptr;
+    Order* prev = nullptr;
+    Order* next = nullptr;
+    
+    // Intrusive per-owner list maintained by the LimitOrderBook
+    Order* owner_prev = nullptr;
+    Order* owner_next = nullptr;
+    
+    bool IsIceberg() const { return peak_quantity > 0.0; }
+    double GetTotalQuantity() const { return quantity + hidden_quantity; }
+    
     // Comparison operators for efficient management
     bool operator==(const Order& other) const {
         return order_id == other.order_id;
     }
 };
 
-// Forward declarations
-class PriceLevel;
-
 using OrderPtr = std::shared_ptr<Order>;
 using PriceLevelPtr = std::shared_ptr<PriceLevel>;
 
-// Price level in the order book
+// Price level in the order book. Orders are kept in an intrusive FIFO so
+// that removal, in-place resizing and tail re-queueing never allocate.
 class PriceLevel {
 public:
     explicit PriceLevel(double price) : price_(price) {}
     
-    void AddOrder(const OrderPtr& order);
-    void RemoveOrder(const std::string& order_id);
+    void AddOrder(Order* order);
+    void RemoveOrder(Order* order);
+    
+    // Change an order's displayed quantity in place, keeping its position
+    void UpdateQuantity(Order* order, double new_quantity);
+    
+    // Refill an iceberg tip from its reserve and move it to the tail.
+    // Returns false if the order has no reserve left.
+    bool ReplenishOrder(Order* order);
+    
+    double GetPrice() const { return price_; }
     double GetTotalVolume() const;
-    const std::vector<OrderPtr>& GetOrders() const;
+    double GetHiddenVolume() const { return hidden_volume_; }
+    size_t GetOrderCount() const { return order_count_; }
+    bool IsEmpty() const { return head_ == nullptr; }
+    const Order* GetFrontOrder() const { return head_; }
+    Order* GetFrontOrder() { return head_; }
     
 private:
+    void Unlink(Order* order);
+    void LinkTail(Order* order);
+    
     double price_;
-    std::vector<OrderPtr> orders_;
-    double total_volume_ = 0.0;
+    Order* head_ = nullptr;
+    Order* tail_ = nullptr;
+    size_t order_count_ = 0;
+    double total_volume_ = 0.0;     // Displayed volume only
+    double hidden_volume_ = 0.0;
+};
+
+// Packed order event with a numeric ID, as applied by
+// LimitOrderBook::ApplyEvents. Layout matches ob_event_t in the C ABI.
+enum OrderEventType : uint8_t {
+    kEventAdd = 1,
+    kEventModify = 2,
+    kEventCancel = 3,
+    kEventReplace = 4,
+    kEventExecute = 5
+};
+
+struct OrderEvent {
+    int64_t timestamp_ns;
+    uint64_t order_id;          // Maps onto the order ID's decimal string
+    double price;               // Trade price for executions
+    double quantity;
+    uint8_t type;
+    uint8_t is_buy;
+    uint8_t reserved[6];
+};
+
+// Selection for LimitOrderBook::MassCancel. Every criterion must match;
+// the default filter cancels the whole book.
+struct MassCancelFilter {
+    bool include_bids = true;
+    bool include_asks = true;
+    double min_price = 0.0;
+    double max_price = std::numeric_limits<double>::max();
+    uint32_t owner_id = 0;      // 0 matches every participant
 };
 
 // Main limit order book implementation
@@ -54,6 +137,56 @@ public:
     void ModifyOrder(const std::string& order_id, double new_quantity);
     void CancelOrder(const std::string& order_id);
     
+    // Cancel/replace in a single lookup. The order keeps its queue position
+    // when only its size goes down; a size increase or a price change sends
+    // it to the back of the destination level. Returns false if unknown.
+    bool ReplaceOrder(const std::string& order_id, double new_price, double new_quantity);
+    
+    // Apply an execution reported against a resting order. The order is
+    // reduced in place and leaves its level in O(1) once fully filled; the
+    // fill is recorded on the trade tape. A trade_price of 0 or less means
+    // none was reported, and the order's own price is used. Returns the
+    // quantity executed.
+    double ExecuteOrder(const std::string& order_id, double exec_qty, double trade_price);
+    
+    // Cancel every resting order matching the filter. Owner-scoped
+    // cancels walk that owner's orders only; otherwise whole levels in the
+    // price band are released at once. Returns the number cancelled.
+    size_t MassCancel(const MassCancelFilter& filter);
+    
+    // Apply one packed event; returns false for an unknown type
+    bool ApplyEvent(const OrderEvent& event);
+    
+    // Apply a batch of packed events in order; unknown types are skipped.
+    // Returns the number of events applied.
+    size_t ApplyEvents(const OrderEvent* events, size_t count);
+    
+    // Drop every resting order, its expiry timer and every stop order. The
+    // trade tape and event time are kept.
+    void Clear();
+    
+    // Rebuild the resting orders from a snapshot of add events, given in
+    // queue order within each level; other event types are skipped. Stop
+    // orders stay armed: best prices and stop triggers are refreshed once
+    // at the end. Returns the number of orders loaded.
+    size_t LoadOrders(const OrderEvent* orders, size_t count);
+    
+    // Visit resting orders: bids best to worst, then asks, each level in
+    // queue order
+    template <typename Fn>
+    void ForEachOrder(Fn&& fn) const {
+        for (const auto& entry : bids_) {
+            for (const Order* order = entry.second->GetFrontOrder(); order; order = order->next) {
+                fn(*order);
+            }
+        }
+        for (const auto& entry : asks_) {
+            for (const Order* order = entry.second->GetFrontOrder(); order; order = order->next) {
+                fn(*order);
+            }
+        }
+    }
+    
     // Order book queries
     double GetBestBid() const;
     double GetBestAsk() const;
@@ -68,6 +201,49 @@ public:
     std::vector<std::pair<double, double>> GetBidLevels(int count = 10) const;
     std::vector<std::pair<double, double>> GetAskLevels(int count = 10) const;
     
+    // Allocation-free variants filling caller-owned arrays; return the
+    // number of levels written
+    int GetBidLevels(double* prices, double* volumes, int count) const;
+    int GetAskLevels(double* prices, double* volumes, int count) const;
+    
+    // Order lookups
+    size_t GetOrderCount() const { return orders_.size(); }
+    const Order* GetOrder(const std::string& order_id) const;
+    
+    // Orders ahead of order_id in its level's queue, -1 if unknown. Walks
+    // the queue, so it is meant for inspection rather than the hot path.
+    int64_t GetQueuePosition(const std::string& order_id) const;
+    const std::string& GetSymbol() const { return symbol_; }
+    
+    // Reserve (non-displayed) volume resting at a price, 0 if none
+    double GetHiddenVolume(bool is_buy, double price) const;
+    
+    // Stop orders. Buy stops trigger on the best ask or a trade rising to
+    // the stop, sell stops on the best bid or a trade falling to it; fired
+    // stops are matched against the opposite side immediately. A stop may
+    // not take the ID of a resting order; AddStopOrder returns false for one.
+    bool AddStopOrder(const StopOrder& order);
+    bool CancelStopOrder(const std::string& order_id);
+    size_t GetStopOrderCount() const;
+    
+    // A trade printed at price; non-positive prices are ignored
+    void OnTradePrice(double price);
+    
+    // Advance event time, cancelling every order whose expiry has passed.
+    // Expiries resolve on a 1 ms tick. AddOrder and ApplyEvent do the same
+    // with their timestamps, so feeds need not call it. Returns the number
+    // of orders expired.
+    size_t AdvanceTime(int64_t now_ns);
+    int64_t GetCurrentTime() const;
+    size_t GetPendingExpiryCount() const { return expiry_wheel_.GetPendingCount(); }
+    
+    // Trade tape
+    std::vector<Trade> GetRecentTrades(size_t count = 100) const;
+    const TradeTape& GetTradeTape() const { return trade_tape_; }
+    
+    // Operational counters; readable from any thread while the book runs
+    const BookCounters& GetCounters() const { return counters_; }
+    
 private:
     std::string symbol_;
     
@@ -81,9 +257,48 @@ private:
     // Statistics for quick access
     double best_bid_ = 0.0;
     double best_ask_ = std::numeric_limits<double>::max();
+    bool crossed_ = false;
+    
+    // Stop orders waiting for their trigger price
+    TriggerBook triggers_;
+    std::deque<StopOrder> pending_triggers_;
+    bool processing_triggers_ = false;
+    
+    // Head of each participant's intrusive order list
+    std::unordered_map<uint32_t, Order*> owner_heads_;
+    
+    // Pending good-till-time expiries keyed by order ID
+    TimerWheel<std::string> expiry_wheel_;
+    
+    // Latest event time seen from orders or AdvanceTime
+    int64_t event_time_ns_ = 0;
+    
+    // Recent executions for analytics
+    TradeTape trade_tape_;
+    
+    // Scratch string for numeric order IDs in batch paths
+    std::string id_buffer_;
+    
+    BookCounters counters_;
     
-    // Helper methods
+    // Helper methods; InsertOrder leaves counting to its caller
+    void InsertOrder(const OrderPtr& order);
+    void RaiseEventTime(int64_t timestamp_ns);
+    const std::string& FormatOrderId(uint64_t order_id);
     void UpdateBestPrices();
+    PriceLevel* GetOrCreateLevel(bool is_buy, double price);
+    void RemoveLevelIfEmpty(PriceLevel* level, bool is_buy);
+    void ResizeOrder(std::unordered_map<std::string, OrderPtr>::iterator it, double new_quantity);
+    void LinkOwner(Order* order);
+    void UnlinkOwner(Order* order);
+    template <typename LevelMap>
+    size_t CancelLevels(LevelMap& levels, typename LevelMap::iterator first,
+                        typename LevelMap::iterator last);
+    void EraseOrder(std::unordered_map<std::string, OrderPtr>::iterator it);
+    void ClearOrders();
+    void FireTriggers(double buy_reference, double sell_reference);
+    void MatchStopOrder(const StopOrder& stop);
+    double FillRestingOrder(Order* order, double quantity, double trade_price);
 };
 
 } // namespace microstructure 
\ No newline at end of file
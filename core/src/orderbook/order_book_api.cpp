@@ -0,0 +1,1056 @@
+#include "order_book_api.h"
+#include "limit_order_book.h"
+#include "arrow_export.h"
+#include "binary_protocol.h"
+#include "event_columns.h"
+#include "event_file_replay.h"
+#include "feed_pipeline.h"
+#include "metrics_exporter.h"
+#include "microstructure_analyzer.h"
+#include "pcap_replay.h"
+#include "sequenced_feed.h"
+#include "snapshot_region.h"
+#include "stage_latency.h"
+#include "toxic_flow_detector.h"
+#include "udp_receiver.h"
+#include "vpin_calculator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+using microstructure::LimitOrderBook;
+using microstructure::Order;
+
+// Process-wide, leaked so handles destroyed during exit can still
+// unregister
+static microstructure::MetricsRegistry& GetMetricsRegistry() {
+    static microstructure::MetricsRegistry* registry = new microstructure::MetricsRegistry();
+    return *registry;
+}
+
+static void CollectBookCounters(const std::string& symbol, const microstructure::BookCounters& counters,
+                                microstructure::MetricsSnapshot& snapshot) {
+    for (size_t i = 0; i < microstructure::kBookCounterCount; ++i) {
+        auto counter = static_cast<microstructure::BookCounter>(i);
+        snapshot.Add(std::string("microstructure_") + microstructure::GetBookCounterName(counter) + "_total",
+                     microstructure::MetricType::kCounter, microstructure::GetBookCounterHelp(counter),
+                     {{"symbol", symbol}},
+                     static_cast<double>(counters.Get(counter)));
+    }
+}
+
+// Keeps a collector registered for the lifetime of the handle that owns
+// it; declared last so it unregisters before the state it reads is gone
+struct MetricsRegistration {
+    explicit MetricsRegistration(microstructure::MetricsCollector collector)
+        : id(GetMetricsRegistry().AddCollector(std::move(collector))) {}
+    ~MetricsRegistration() { GetMetricsRegistry().RemoveCollector(id); }
+    
+    MetricsRegistration(const MetricsRegistration&) = delete;
+    MetricsRegistration& operator=(const MetricsRegistration&) = delete;
+    
+    uint64_t id;
+};
+
+struct ob_book {
+    explicit ob_book(const char* symbol)
+        : book(symbol ? symbol : ""),
+          metrics([this](microstructure::MetricsSnapshot& snapshot) {
+              CollectBookCounters(book.GetSymbol(), book.GetCounters(), snapshot);
+          }) {}
+    
+    LimitOrderBook book;
+    
+    // Reused for string IDs so lookups do not allocate
+    std::string id_buffer;
+    
+    MetricsRegistration metrics;
+};
+
+struct ob_trigger_book {
+    microstructure::TriggerBook triggers;
+    std::deque<microstructure::StopOrder> fired;
+};
+
+struct ob_region {
+    std::string name;
+    std::unique_ptr<microstructure::SnapshotRegion> region;
+};
+
+struct ob_snapshot_batch {
+    explicit ob_snapshot_batch(int depth) : builder(depth) {}
+    
+    microstructure::SnapshotBatchBuilder builder;
+};
+
+struct ob_metric_batch {
+    explicit ob_metric_batch(const std::vector<std::string>& names) : builder(names) {}
+    
+    microstructure::MetricBatchBuilder builder;
+};
+
+struct ob_analyzer {
+    explicit ob_analyzer(const microstructure::MicrostructureAnalyzer::Options& options) : analyzer(options) {}
+    
+    microstructure::MicrostructureAnalyzer analyzer;
+};
+
+struct ob_toxic_detector {
+    ob_toxic_detector(size_t symbol_count, const microstructure::ToxicFlowDetector::Options& options)
+        : detector(symbol_count, options) {}
+    
+    microstructure::ToxicFlowDetector detector;
+};
+
+struct ob_vpin {
+    ob_vpin(size_t symbol_count, const microstructure::VpinCalculator::Options& options)
+        : calculator(symbol_count, options) {}
+    
+    microstructure::VpinCalculator calculator;
+};
+
+struct ob_sequenced_feed {
+    ob_sequenced_feed(const std::vector<LimitOrderBook*>& books, const char* snapshot_dir,
+                      size_t max_buffered_bytes)
+        : source(snapshot_dir ? snapshot_dir : "."),
+          feed(books.data(), books.size(), &source, max_buffered_bytes) {}
+    
+    microstructure::SnapshotFileSource source;
+    microstructure::SequencedFeed feed;
+};
+
+struct ob_udp_feed {
+    ob_udp_feed(const std::vector<LimitOrderBook*>& books, const char* snapshot_dir,
+                const microstructure::UdpFeedOptions& options)
+        : source(snapshot_dir ? snapshot_dir : "."),
+          feed(books.data(), books.size(), &source, options),
+          metrics([this](microstructure::MetricsSnapshot& snapshot) { Collect(snapshot); }) {}
+    
+    // Books are ob_book handles and export their own counters
+    void Collect(microstructure::MetricsSnapshot& snapshot) const {
+        microstructure::UdpSocketStats stats;
+        for (size_t i = 0; feed.GetSocketStats(i, &stats); ++i) {
+            std::vector<std::pair<std::string, std::string>> labels = {
+                {"port", std::to_string(feed.GetPort(i))}};
+            snapshot.Add("microstructure_udp_datagrams_total", microstructure::MetricType::kCounter,
+                         "Datagrams received", labels, static_cast<double>(stats.datagrams));
+            snapshot.Add("microstructure_udp_kernel_drops_total", microstructure::MetricType::kCounter,
+                         "Datagrams lost to a full socket receive buffer", labels,
+                         static_cast<double>(stats.kernel_drops));
+            snapshot.Add("microstructure_udp_truncated_total", microstructure::MetricType::kCounter,
+                         "Datagrams dropped as larger than the receive buffer", labels,
+                         static_cast<double>(stats.truncated));
+        }
+    }
+    
+    microstructure::SnapshotFileSource source;
+    microstructure::UdpFeed feed;
+    MetricsRegistration metrics;
+};
+
+struct ob_feed {
+    ob_feed(const std::vector<std::string>& symbols,
+            const microstructure::FeedPipeline::Options& options)
+        : pipeline(symbols, options),
+          metrics([this](microstructure::MetricsSnapshot& snapshot) { Collect(snapshot); }) {}
+    
+    void Collect(microstructure::MetricsSnapshot& snapshot) const {
+        using microstructure::MetricType;
+        microstructure::FeedPipelineStats stats = pipeline.GetStats();
+        snapshot.Add("microstructure_pipeline_submitted_total", MetricType::kCounter,
+                     "Events accepted by the feed pipeline", {}, static_cast<double>(stats.submitted));
+        snapshot.Add("microstructure_pipeline_rejected_total", MetricType::kCounter,
+                     "Events refused because the input ring was full", {},
+                     static_cast<double>(stats.rejected));
+        snapshot.Add("microstructure_pipeline_applied_total", MetricType::kCounter,
+                     "Events applied to a book", {}, static_cast<double>(stats.applied));
+        snapshot.Add("microstructure_pipeline_delivered_total", MetricType::kCounter,
+                     "Updates handed to the subscriber", {}, static_cast<double>(stats.delivered));
+        snapshot.Add("microstructure_pipeline_queue_depth", MetricType::kGauge,
+                     "Entries waiting in a pipeline ring", {{"queue", "input"}},
+                     static_cast<double>(pipeline.GetInputDepth()));
+        snapshot.Add("microstructure_pipeline_queue_depth", MetricType::kGauge,
+                     "Entries waiting in a pipeline ring", {{"queue", "update"}},
+                     static_cast<double>(pipeline.GetUpdateDepth()));
+        for (size_t i = 0; i < pipeline.GetBookCount(); ++i) {
+            CollectBookCounters(pipeline.GetSymbol(i), pipeline.GetBookCounters(i), snapshot);
+        }
+    }
+    
+    microstructure::FeedPipeline pipeline;
+    MetricsRegistration metrics;
+};
+
+static_assert(sizeof(ob_event_t) == sizeof(microstructure::OrderEvent),
+              "ob_event_t must match microstructure::OrderEvent");
+static_assert(offsetof(ob_event_t, type) == offsetof(microstructure::OrderEvent, type),
+              "ob_event_t must match microstructure::OrderEvent");
+
+static_assert(sizeof(ob_microstructure_metrics_t) == sizeof(microstructure::MicrostructureMetrics),
+              "ob_microstructure_metrics_t must match microstructure::MicrostructureMetrics");
+
+static_assert(sizeof(ob_toxic_event_t) == sizeof(microstructure::ToxicFlowEvent),
+              "ob_toxic_event_t must match microstructure::ToxicFlowEvent");
+static_assert(sizeof(ob_toxic_score_t) == sizeof(microstructure::ToxicFlowScore),
+              "ob_toxic_score_t must match microstructure::ToxicFlowScore");
+static_assert(offsetof(ob_toxic_score_t, is_toxic) == offsetof(microstructure::ToxicFlowScore, is_toxic),
+              "ob_toxic_score_t must match microstructure::ToxicFlowScore");
+
+static_assert(sizeof(ob_vpin_trade_t) == sizeof(microstructure::VpinTrade),
+              "ob_vpin_trade_t must match microstructure::VpinTrade");
+static_assert(sizeof(ob_vpin_state_t) == sizeof(microstructure::VpinState),
+              "ob_vpin_state_t must match microstructure::VpinState");
+
+static microstructure::StopOrder MakeStopOrder(const char* order_id, const ob_stop_order_t& stop) {
+    return microstructure::StopOrder{order_id, stop.stop_price, stop.limit_price, stop.quantity,
+                                     stop.is_buy != 0, stop.timestamp_ns};
+}
+
+static microstructure::VpinCalculator::Options MakeVpinOptions(double bucket_volume, size_t window_buckets,
+                                                               int classification) {
+    microstructure::VpinCalculator::Options options;
+    if (bucket_volume > 0) {
+        options.bucket_volume = bucket_volume;
+    }
+    if (window_buckets > 0) {
+        options.window_buckets = window_buckets;
+    }
+    if (classification >= OB_VPIN_TICK_RULE && classification <= OB_VPIN_AGGRESSOR) {
+        options.classification = static_cast<microstructure::VpinClassification>(classification);
+    }
+    return options;
+}
+
+static_assert(sizeof(ob_feed_event_t) == sizeof(microstructure::FeedEvent),
+              "ob_feed_event_t must match microstructure::FeedEvent");
+static_assert(sizeof(ob_book_update_t) == sizeof(microstructure::BookUpdate),
+              "ob_book_update_t must match microstructure::BookUpdate");
+static_assert(offsetof(ob_book_update_t, book_index) == offsetof(microstructure::BookUpdate, book_index),
+              "ob_book_update_t must match microstructure::BookUpdate");
+
+static void CopyChannelStats(const microstructure::ChannelStats& stats, ob_channel_stats_t* out) {
+    out->next_sequence = stats.next_sequence;
+    out->packets = stats.packets;
+    out->duplicates = stats.duplicates;
+    out->gaps = stats.gaps;
+    out->recoveries = stats.recoveries;
+    out->buffered_packets = stats.buffered_packets;
+    out->overflows = stats.overflows;
+    out->stale_snapshots = stats.stale_snapshots;
+    out->recovering = stats.recovering;
+}
+
+// Books behind an array of handles. Entry points convert once through
+// this instead of building a vector on every call; the usual handful of
+// books fits inline, so hot paths such as apply_binary_messages do not
+// allocate. Null handles map to null books, which drop their messages.
+class BookTargets {
+public:
+    BookTargets(ob_book_t* const* books, size_t count) : count_(count) {
+        if (count > kInline) {
+            overflow_.resize(count);
+            data_ = overflow_.data();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            data_[i] = books[i] ? &books[i]->book : nullptr;
+        }
+    }
+    BookTargets(const BookTargets&) = delete;
+    BookTargets& operator=(const BookTargets&) = delete;
+    
+    LimitOrderBook* const* data() const { return data_; }
+    size_t size() const { return count_; }
+    std::vector<LimitOrderBook*> ToVector() const { return std::vector<LimitOrderBook*>(data_, data_ + count_); }
+    
+private:
+    static constexpr size_t kInline = 16;
+    
+    size_t count_;
+    LimitOrderBook* inline_[kInline];
+    LimitOrderBook** data_ = inline_;
+    std::vector<LimitOrderBook*> overflow_;
+};
+
+// One process-wide dump, like the histograms it reports
+static microstructure::StageLatencyReporter& GetStageLatencyReporter() {
+    static microstructure::StageLatencyReporter reporter;
+    return reporter;
+}
+
+static microstructure::MetricsHttpServer& GetMetricsServer() {
+    static microstructure::MetricsHttpServer server;
+    return server;
+}
+
+extern "C" {
+
+ob_book_t* create_order_book(const char* symbol) {
+    return new ob_book(symbol);
+}
+
+void destroy_order_book(ob_book_t* book) {
+    delete book;
+}
+
+void add_order(ob_book_t* book, const char* order_id, double price, double quantity,
+               bool is_buy, long long timestamp_ns) {
+    book->book.AddOrder(std::make_shared<Order>(Order{
+        order_id, price, quantity, is_buy, static_cast<int64_t>(timestamp_ns)}));
+}
+
+void add_order_with_options(ob_book_t* book, const char* order_id, double price, double quantity,
+                            bool is_buy, long long timestamp_ns, const ob_order_options_t* options) {
+    auto order = std::make_shared<Order>(Order{
+        order_id, price, quantity, is_buy, static_cast<int64_t>(timestamp_ns)});
+    if (options) {
+        order->hidden_quantity = std::max(options->hidden_quantity, 0.0);
+        order->peak_quantity = std::max(options->peak_quantity, 0.0);
+        order->expire_time_ns = std::max<int64_t>(options->expire_time_ns, 0);
+        order->owner_id = options->owner_id;
+    }
+    book->book.AddOrder(order);
+}
+
+void modify_order(ob_book_t* book, const char* order_id, double new_quantity) {
+    book->id_buffer.assign(order_id);
+    book->book.ModifyOrder(book->id_buffer, new_quantity);
+}
+
+void cancel_order(ob_book_t* book, const char* order_id) {
+    book->id_buffer.assign(order_id);
+    book->book.CancelOrder(book->id_buffer);
+}
+
+bool replace_order(ob_book_t* book, const char* order_id, double new_price, double new_quantity) {
+    book->id_buffer.assign(order_id);
+    return book->book.ReplaceOrder(book->id_buffer, new_price, new_quantity);
+}
+
+double execute_order(ob_book_t* book, const char* order_id, double exec_qty, double trade_price) {
+    book->id_buffer.assign(order_id);
+    return book->book.ExecuteOrder(book->id_buffer, exec_qty, trade_price);
+}
+
+size_t advance_time(ob_book_t* book, long long now_ns) {
+    return book->book.AdvanceTime(static_cast<int64_t>(now_ns));
+}
+
+size_t get_pending_expiry_count(ob_book_t* book) {
+    return book->book.GetPendingExpiryCount();
+}
+
+void clear_order_book(ob_book_t* book) {
+    book->book.Clear();
+}
+
+size_t mass_cancel(ob_book_t* book, bool include_bids, bool include_asks,
+                   double min_price, double max_price, uint32_t owner_id) {
+    microstructure::MassCancelFilter filter;
+    filter.include_bids = include_bids;
+    filter.include_asks = include_asks;
+    filter.min_price = min_price;
+    filter.max_price = max_price;
+    filter.owner_id = owner_id;
+    return book->book.MassCancel(filter);
+}
+
+double get_best_bid(ob_book_t* book) {
+    return book->book.GetBestBid();
+}
+
+double get_best_ask(ob_book_t* book) {
+    return book->book.GetBestAsk();
+}
+
+double get_mid_price(ob_book_t* book) {
+    return book->book.GetMidPrice();
+}
+
+double get_spread(ob_book_t* book) {
+    return book->book.GetSpread();
+}
+
+double get_order_imbalance(ob_book_t* book, int levels) {
+    return book->book.GetOrderImbalance(levels);
+}
+
+size_t get_order_count(ob_book_t* book) {
+    return book->book.GetOrderCount();
+}
+
+bool get_order_info(ob_book_t* book, const char* order_id, ob_order_info_t* out) {
+    book->id_buffer.assign(order_id);
+    const Order* order = book->book.GetOrder(book->id_buffer);
+    if (!order) {
+        return false;
+    }
+    out->price = order->price;
+    out->quantity = order->quantity;
+    out->hidden_quantity = order->hidden_quantity;
+    out->timestamp_ns = order->timestamp_ns;
+    out->is_buy = order->is_buy ? 1 : 0;
+    return true;
+}
+
+long long get_queue_position(ob_book_t* book, const char* order_id) {
+    book->id_buffer.assign(order_id);
+    return book->book.GetQueuePosition(book->id_buffer);
+}
+
+double get_hidden_volume(ob_book_t* book, bool is_buy, double price) {
+    return book->book.GetHiddenVolume(is_buy, price);
+}
+
+size_t get_recent_trades(ob_book_t* book, ob_trade_t* out, size_t count) {
+    size_t written = 0;
+    book->book.GetTradeTape().ForEachRecent(count, [&](const microstructure::Trade& trade) {
+        ob_trade_t& row = out[written++];
+        row.price = trade.price;
+        row.quantity = trade.quantity;
+        row.timestamp_ns = trade.timestamp_ns;
+        row.is_buy = trade.is_buy ? 1 : 0;
+    });
+    return written;
+}
+
+bool add_stop_order(ob_book_t* book, const char* order_id, const ob_stop_order_t* stop) {
+    return book->book.AddStopOrder(MakeStopOrder(order_id, *stop));
+}
+
+bool cancel_stop_order(ob_book_t* book, const char* order_id) {
+    book->id_buffer.assign(order_id);
+    return book->book.CancelStopOrder(book->id_buffer);
+}
+
+size_t get_stop_order_count(ob_book_t* book) {
+    return book->book.GetStopOrderCount();
+}
+
+void report_trade_price(ob_book_t* book, double price) {
+    book->book.OnTradePrice(price);
+}
+
+ob_trigger_book_t* create_trigger_book(void) {
+    return new ob_trigger_book();
+}
+
+void destroy_trigger_book(ob_trigger_book_t* triggers) {
+    delete triggers;
+}
+
+void add_trigger_stop(ob_trigger_book_t* triggers, const char* order_id, const ob_stop_order_t* stop) {
+    triggers->triggers.AddStopOrder(MakeStopOrder(order_id, *stop));
+}
+
+bool cancel_trigger_stop(ob_trigger_book_t* triggers, const char* order_id) {
+    return triggers->triggers.CancelStopOrder(order_id);
+}
+
+size_t get_trigger_stop_count(ob_trigger_book_t* triggers) {
+    return triggers->triggers.GetStopOrderCount();
+}
+
+size_t fire_trigger_stops(ob_trigger_book_t* triggers, double buy_reference, double sell_reference) {
+    return triggers->triggers.Trigger(buy_reference, sell_reference, triggers->fired);
+}
+
+bool pop_fired_stop(ob_trigger_book_t* triggers, ob_stop_order_t* out, char* order_id, size_t order_id_size) {
+    if (triggers->fired.empty()) {
+        return false;
+    }
+    const microstructure::StopOrder& stop = triggers->fired.front();
+    out->stop_price = stop.stop_price;
+    out->limit_price = stop.limit_price;
+    out->quantity = stop.quantity;
+    out->timestamp_ns = stop.timestamp_ns;
+    out->is_buy = stop.is_buy ? 1 : 0;
+    if (order_id && order_id_size > 0) {
+        size_t length = std::min(stop.order_id.size(), order_id_size - 1);
+        std::memcpy(order_id, stop.order_id.data(), length);
+        order_id[length] = '\0';
+    }
+    triggers->fired.pop_front();
+    return true;
+}
+
+double get_bid_level_price(ob_book_t* book, int index) {
+    auto levels = book->book.GetBidLevels(index + 1);
+    return index < static_cast<int>(levels.size()) ? levels[index].first : 0.0;
+}
+
+double get_bid_level_volume(ob_book_t* book, int index) {
+    auto levels = book->book.GetBidLevels(index + 1);
+    return index < static_cast<int>(levels.size()) ? levels[index].second : 0.0;
+}
+
+double get_ask_level_price(ob_book_t* book, int index) {
+    auto levels = book->book.GetAskLevels(index + 1);
+    return index < static_cast<int>(levels.size())
+        ? levels[index].first
+        : std::numeric_limits<double>::infinity();
+}
+
+double get_ask_level_volume(ob_book_t* book, int index) {
+    auto levels = book->book.GetAskLevels(index + 1);
+    return index < static_cast<int>(levels.size()) ? levels[index].second : 0.0;
+}
+
+size_t apply_order_events(ob_book_t* book, const ob_event_t* events, size_t count) {
+    return book->book.ApplyEvents(reinterpret_cast<const microstructure::OrderEvent*>(events), count);
+}
+
+void fill_order_book_snapshot(ob_book_t* book, int levels,
+                              double* bid_prices, double* bid_volumes,
+                              double* ask_prices, double* ask_volumes,
+                              ob_snapshot_t* out) {
+    const LimitOrderBook& lob = book->book;
+    out->timestamp_ns = lob.GetCurrentTime();
+    out->best_bid = lob.GetBestBid();
+    out->best_ask = lob.GetBestAsk();
+    out->mid_price = lob.GetMidPrice();
+    out->spread = lob.GetSpread();
+    out->order_imbalance = lob.GetOrderImbalance();
+    out->bid_count = lob.GetBidLevels(bid_prices, bid_volumes, levels);
+    out->ask_count = lob.GetAskLevels(ask_prices, ask_volumes, levels);
+}
+
+size_t apply_order_event_columns(ob_book_t* const* books, size_t book_count,
+                                 const ob_event_columns_t* columns, size_t count,
+                                 const ob_derived_columns_t* derived) {
+    BookTargets targets(books, book_count);
+    
+    microstructure::EventColumns input;
+    input.timestamp_ns = columns->timestamp_ns;
+    input.type = columns->type;
+    input.order_id = columns->order_id;
+    input.price = columns->price;
+    input.quantity = columns->quantity;
+    input.is_buy = columns->is_buy;
+    input.book_index = columns->book_index;
+    
+    if (!derived) {
+        return microstructure::ApplyEventColumns(targets.data(), book_count, input, count);
+    }
+    microstructure::DerivedColumns output;
+    output.best_bid = derived->best_bid;
+    output.best_ask = derived->best_ask;
+    output.mid_price = derived->mid_price;
+    output.order_imbalance = derived->order_imbalance;
+    output.imbalance_levels = derived->imbalance_levels > 0 ? derived->imbalance_levels : 5;
+    return microstructure::ApplyEventColumns(targets.data(), book_count, input, count, &output);
+}
+
+size_t apply_binary_messages(ob_book_t* const* books, size_t book_count,
+                             const uint8_t* data, size_t size, ob_decode_stats_t* stats) {
+    BookTargets targets(books, book_count);
+    
+    microstructure::BinaryDecoder decoder;
+    microstructure::BookDispatcher dispatcher(targets.data(), book_count);
+    size_t consumed = microstructure::DecodeWithStageTiming(decoder, data, size, dispatcher);
+    if (stats) {
+        const auto& counts = decoder.GetStats();
+        stats->messages += counts.messages;
+        stats->skipped += counts.skipped;
+        stats->malformed += counts.malformed;
+    }
+    return consumed;
+}
+
+ob_sequenced_feed_t* create_sequenced_feed(ob_book_t* const* books, size_t book_count,
+                                           const char* snapshot_dir, size_t max_buffered_bytes) {
+    BookTargets targets(books, book_count);
+    return new ob_sequenced_feed(targets.ToVector(), snapshot_dir, max_buffered_bytes > 0 ? max_buffered_bytes : 64 << 20);
+}
+
+void destroy_sequenced_feed(ob_sequenced_feed_t* feed) {
+    delete feed;
+}
+
+bool add_sequenced_channel(ob_sequenced_feed_t* feed, uint16_t channel, const uint16_t* locates,
+                           size_t locate_count, uint64_t next_sequence) {
+    return feed->feed.AddChannel(channel, std::vector<uint16_t>(locates, locates + locate_count), next_sequence);
+}
+
+bool process_sequenced_packet(ob_sequenced_feed_t* feed, const uint8_t* data, size_t size) {
+    return feed->feed.OnPacket(data, size);
+}
+
+size_t poll_sequenced_recovery(ob_sequenced_feed_t* feed) {
+    return feed->feed.Poll();
+}
+
+bool get_sequenced_channel_stats(ob_sequenced_feed_t* feed, uint16_t channel, ob_channel_stats_t* out) {
+    microstructure::ChannelStats stats;
+    if (!feed->feed.GetChannelStats(channel, &stats)) {
+        return false;
+    }
+    CopyChannelStats(stats, out);
+    return true;
+}
+
+bool write_channel_snapshot(const char* snapshot_dir, uint16_t channel, uint64_t sequence,
+                            ob_book_t* const* books, size_t book_count,
+                            const uint16_t* locates, size_t locate_count) {
+    BookTargets sources(books, book_count);
+    
+    microstructure::ChannelSnapshot snapshot;
+    snapshot.sequence = sequence;
+    if (!microstructure::EncodeSnapshot(sources.data(), book_count,
+                                        std::vector<uint16_t>(locates, locates + locate_count),
+                                        &snapshot.orders)) {
+        return false;
+    }
+    std::string path = microstructure::SnapshotFileSource::GetPath(snapshot_dir ? snapshot_dir : ".", channel);
+    return microstructure::WriteSnapshotFile(path, channel, snapshot);
+}
+
+bool replay_pcap_file(const char* path, ob_book_t* const* books, size_t book_count,
+                      const ob_replay_options_t* options, ob_replay_stats_t* out) {
+    microstructure::PcapReader reader;
+    if (!path || !reader.Open(path)) {
+        return false;
+    }
+    microstructure::ReplayOptions replay_options;
+    if (options) {
+        replay_options.speed = options->speed;
+        replay_options.sequenced = options->sequenced;
+        reader.SetPortFilter(options->udp_port);
+    }
+    
+    BookTargets targets(books, book_count);
+    microstructure::PcapReplay replay(targets.data(), book_count, replay_options);
+    microstructure::ReplayStats stats = replay.Run(reader);
+    
+    out->packets = stats.packets;
+    out->messages = stats.messages;
+    out->bytes = stats.bytes;
+    out->gaps = stats.gaps;
+    out->duplicates = stats.duplicates;
+    out->skipped_records = reader.GetStats().skipped + reader.GetStats().truncated;
+    out->elapsed_seconds = stats.elapsed_seconds;
+    out->capture_seconds = stats.capture_seconds;
+    out->latency_mean_ns = stats.processing.GetMean();
+    out->latency_p50_ns = stats.processing.GetValueAtPercentile(50.0);
+    out->latency_p99_ns = stats.processing.GetValueAtPercentile(99.0);
+    out->latency_p999_ns = stats.processing.GetValueAtPercentile(99.9);
+    out->latency_max_ns = stats.processing.GetMax();
+    out->lag_p99_ns = stats.lag.GetValueAtPercentile(99.0);
+    out->lag_max_ns = stats.lag.GetMax();
+    return true;
+}
+
+bool replay_event_file(const char* path, ob_book_t* const* books, size_t book_count,
+                       const ob_event_file_options_t* options, ob_event_file_stats_t* out) {
+    BookTargets targets(books, book_count);
+    microstructure::EventFileOptions settings;
+    if (options) {
+        if (options->chunk_size > 0) {
+            settings.reader.chunk_size = options->chunk_size;
+        }
+        if (options->queue_depth > 0) {
+            settings.reader.queue_depth = options->queue_depth;
+        }
+        if (options->threads > 0) {
+            settings.reader.threads = options->threads;
+        }
+        if (options->block_size > 0) {
+            settings.block_size = options->block_size;
+        }
+        settings.reader.backend = static_cast<microstructure::ReadBackend>(options->backend);
+    }
+    
+    microstructure::EventFileReplay replay(targets.data(), targets.size(), settings);
+    microstructure::EventFileStats stats;
+    bool ok = replay.Run(path, &stats);
+    out->bytes_read = stats.bytes_read;
+    out->bytes_decompressed = stats.bytes_decompressed;
+    out->messages = stats.messages;
+    out->skipped = stats.skipped;
+    out->malformed = stats.malformed;
+    out->truncated_bytes = stats.truncated_bytes;
+    out->compressed = stats.compressed;
+    out->backend = static_cast<int32_t>(stats.backend);
+    out->elapsed_seconds = stats.elapsed_seconds;
+    out->read_wait_seconds = stats.read_wait_seconds;
+    out->decompress_seconds = stats.decompress_seconds;
+    out->apply_seconds = stats.apply_seconds;
+    out->apply_wait_seconds = stats.apply_wait_seconds;
+    return ok;
+}
+
+ob_udp_feed_t* create_udp_feed(ob_book_t* const* books, size_t book_count, const char* snapshot_dir,
+                               bool sequenced, size_t batch_size, int receive_buffer_bytes) {
+    BookTargets targets(books, book_count);
+    microstructure::UdpFeedOptions options;
+    options.sequenced = sequenced;
+    if (batch_size > 0) {
+        options.receiver.batch_size = batch_size;
+    }
+    if (receive_buffer_bytes > 0) {
+        options.receiver.receive_buffer_bytes = receive_buffer_bytes;
+    }
+    return new ob_udp_feed(targets.ToVector(), snapshot_dir, options);
+}
+
+void destroy_udp_feed(ob_udp_feed_t* feed) {
+    delete feed;
+}
+
+int add_udp_socket(ob_udp_feed_t* feed, const char* address, uint16_t port, const char* interface_address) {
+    microstructure::UdpEndpoint endpoint;
+    endpoint.address = address ? address : "";
+    endpoint.port = port;
+    if (interface_address && *interface_address) {
+        endpoint.interface_address = interface_address;
+    }
+    return feed->feed.AddSocket(endpoint);
+}
+
+uint16_t get_udp_socket_port(ob_udp_feed_t* feed, size_t socket) {
+    return feed->feed.GetPort(socket);
+}
+
+bool add_udp_channel(ob_udp_feed_t* feed, uint16_t channel, const uint16_t* locates,
+                     size_t locate_count, uint64_t next_sequence) {
+    return feed->feed.AddChannel(channel, std::vector<uint16_t>(locates, locates + locate_count), next_sequence);
+}
+
+bool start_udp_feed(ob_udp_feed_t* feed) {
+    return feed->feed.Start();
+}
+
+void stop_udp_feed(ob_udp_feed_t* feed) {
+    feed->feed.Stop();
+}
+
+bool get_udp_socket_stats(ob_udp_feed_t* feed, size_t socket, ob_udp_socket_stats_t* out) {
+    microstructure::UdpSocketStats stats;
+    if (!feed->feed.GetSocketStats(socket, &stats)) {
+        return false;
+    }
+    out->datagrams = stats.datagrams;
+    out->bytes = stats.bytes;
+    out->syscalls = stats.syscalls;
+    out->truncated = stats.truncated;
+    out->kernel_drops = stats.kernel_drops;
+    out->receive_buffer_bytes = stats.receive_buffer_bytes;
+    return true;
+}
+
+bool get_udp_channel_stats(ob_udp_feed_t* feed, uint16_t channel, ob_channel_stats_t* out) {
+    microstructure::ChannelStats stats;
+    if (!feed->feed.GetChannelStats(channel, &stats)) {
+        return false;
+    }
+    CopyChannelStats(stats, out);
+    return true;
+}
+
+void lock_udp_feed_books(ob_udp_feed_t* feed) {
+    feed->feed.LockBooks();
+}
+
+void unlock_udp_feed_books(ob_udp_feed_t* feed) {
+    feed->feed.UnlockBooks();
+}
+
+ob_region_t* create_snapshot_region(const char* name, uint32_t slot_count, uint32_t depth) {
+    auto region = microstructure::SnapshotRegion::Create(name, slot_count, depth);
+    if (!region) {
+        return nullptr;
+    }
+    return new ob_region{name, std::move(region)};
+}
+
+void destroy_snapshot_region(ob_region_t* region, bool unlink) {
+    if (!region) {
+        return;
+    }
+    if (unlink) {
+        microstructure::SnapshotRegion::Unlink(region->name);
+    }
+    delete region;
+}
+
+int get_snapshot_region_slot(ob_region_t* region, const char* symbol) {
+    return region->region->GetOrAssignSlot(symbol);
+}
+
+void publish_order_book_snapshot(ob_region_t* region, int slot, ob_book_t* book) {
+    region->region->Publish(slot, book->book);
+}
+
+ob_snapshot_batch_t* create_snapshot_batch(int depth) {
+    return new ob_snapshot_batch(depth);
+}
+
+void destroy_snapshot_batch(ob_snapshot_batch_t* batch) {
+    delete batch;
+}
+
+void append_snapshot_row(ob_snapshot_batch_t* batch, uint32_t symbol_id, ob_book_t* book) {
+    batch->builder.Append(symbol_id, book->book);
+}
+
+size_t get_snapshot_batch_rows(ob_snapshot_batch_t* batch) {
+    return batch->builder.GetRowCount();
+}
+
+void export_snapshot_batch(ob_snapshot_batch_t* batch, struct ArrowArray* out_array,
+                           struct ArrowSchema* out_schema) {
+    batch->builder.Export(out_array, out_schema);
+}
+
+ob_metric_batch_t* create_metric_batch(const char* const* metric_names, size_t metric_count) {
+    return new ob_metric_batch(std::vector<std::string>(metric_names, metric_names + metric_count));
+}
+
+void destroy_metric_batch(ob_metric_batch_t* batch) {
+    delete batch;
+}
+
+void append_metric_row(ob_metric_batch_t* batch, int64_t timestamp_ns, uint32_t symbol_id,
+                       const double* values) {
+    batch->builder.Append(timestamp_ns, symbol_id, values);
+}
+
+size_t get_metric_batch_rows(ob_metric_batch_t* batch) {
+    return batch->builder.GetRowCount();
+}
+
+void export_metric_batch(ob_metric_batch_t* batch, struct ArrowArray* out_array,
+                         struct ArrowSchema* out_schema) {
+    batch->builder.Export(out_array, out_schema);
+}
+
+ob_analyzer_t* create_microstructure_analyzer(size_t window_size, int imbalance_levels, double impact_size) {
+    microstructure::MicrostructureAnalyzer::Options options;
+    if (window_size > 0) {
+        options.window_size = window_size;
+    }
+    if (imbalance_levels > 0) {
+        options.imbalance_levels = imbalance_levels;
+    }
+    if (impact_size > 0) {
+        options.impact_size = impact_size;
+    }
+    return new ob_analyzer(options);
+}
+
+void destroy_microstructure_analyzer(ob_analyzer_t* analyzer) {
+    delete analyzer;
+}
+
+void update_microstructure_analyzer(ob_analyzer_t* analyzer, ob_book_t* book, int64_t timestamp_ns,
+                                    ob_microstructure_metrics_t* out) {
+    const microstructure::MicrostructureMetrics& metrics = analyzer->analyzer.Update(book->book, timestamp_ns);
+    if (out) {
+        std::memcpy(out, &metrics, sizeof(*out));
+    }
+}
+
+void reset_microstructure_analyzer(ob_analyzer_t* analyzer) {
+    analyzer->analyzer.Reset();
+}
+
+bool append_analyzer_metrics(ob_analyzer_t* analyzer, ob_metric_batch_t* batch, uint32_t symbol_id) {
+    // Same names in the same order, so no value lands under another label
+    if (batch->builder.GetMetricNames() != microstructure::MicrostructureAnalyzer::GetMetricNames()) {
+        return false;
+    }
+    analyzer->analyzer.AppendTo(batch->builder, symbol_id);
+    return true;
+}
+
+ob_toxic_detector_t* create_toxic_flow_detector(size_t symbol_count, size_t window_size,
+                                                double large_order_multiple, double large_order_quantile,
+                                                double threshold) {
+    microstructure::ToxicFlowDetector::Options options;
+    if (window_size > 0) {
+        options.window_size = window_size;
+    }
+    if (large_order_multiple > 0) {
+        options.large_order_multiple = large_order_multiple;
+    }
+    if (large_order_quantile > 0) {
+        options.large_order_quantile = std::min(large_order_quantile, 1.0);
+    }
+    if (threshold >= 0) {
+        options.threshold = threshold;
+    }
+    return new ob_toxic_detector(symbol_count, options);
+}
+
+void destroy_toxic_flow_detector(ob_toxic_detector_t* detector) {
+    delete detector;
+}
+
+size_t apply_toxic_flow_events(ob_toxic_detector_t* detector, const ob_toxic_event_t* events, size_t count) {
+    return detector->detector.Apply(reinterpret_cast<const microstructure::ToxicFlowEvent*>(events), count);
+}
+
+bool score_toxic_flow(ob_toxic_detector_t* detector, uint32_t symbol_id, ob_toxic_score_t* out) {
+    return detector->detector.Score(symbol_id, reinterpret_cast<microstructure::ToxicFlowScore*>(out));
+}
+
+void score_all_toxic_flow(ob_toxic_detector_t* detector, ob_toxic_score_t* out) {
+    detector->detector.ScoreAll(reinterpret_cast<microstructure::ToxicFlowScore*>(out));
+}
+
+double get_toxic_order_size_quantile(ob_toxic_detector_t* detector, uint32_t symbol_id, double q) {
+    return detector->detector.GetOrderSizeQuantile(symbol_id, q);
+}
+
+void reset_toxic_flow_symbol(ob_toxic_detector_t* detector, uint32_t symbol_id) {
+    detector->detector.Reset(symbol_id);
+}
+
+ob_vpin_t* create_vpin_calculator(size_t symbol_count, double bucket_volume, size_t window_buckets,
+                                  int classification) {
+    return new ob_vpin(symbol_count, MakeVpinOptions(bucket_volume, window_buckets, classification));
+}
+
+void destroy_vpin_calculator(ob_vpin_t* vpin) {
+    delete vpin;
+}
+
+size_t apply_vpin_trades(ob_vpin_t* vpin, const ob_vpin_trade_t* trades, size_t count) {
+    return vpin->calculator.Apply(reinterpret_cast<const microstructure::VpinTrade*>(trades), count);
+}
+
+size_t update_vpin_from_book(ob_vpin_t* vpin, uint32_t symbol_id, ob_book_t* book) {
+    return vpin->calculator.UpdateFromBook(symbol_id, book->book);
+}
+
+bool get_vpin_state(ob_vpin_t* vpin, uint32_t symbol_id, ob_vpin_state_t* out) {
+    return vpin->calculator.GetState(symbol_id, reinterpret_cast<microstructure::VpinState*>(out));
+}
+
+void get_all_vpin_states(ob_vpin_t* vpin, ob_vpin_state_t* out) {
+    vpin->calculator.GetAllStates(reinterpret_cast<microstructure::VpinState*>(out));
+}
+
+bool set_vpin_bucket_volume(ob_vpin_t* vpin, uint32_t symbol_id, double bucket_volume) {
+    return vpin->calculator.SetBucketVolume(symbol_id, bucket_volume);
+}
+
+void reset_vpin_symbol(ob_vpin_t* vpin, uint32_t symbol_id) {
+    vpin->calculator.Reset(symbol_id);
+}
+
+uint64_t compute_vpin_historical(const double* prices, const double* quantities, const uint8_t* sides,
+                                 size_t count, double bucket_volume, size_t window_buckets,
+                                 int classification, double* vpin_out) {
+    return microstructure::VpinCalculator::ComputeHistorical(
+        prices, quantities, sides, count, MakeVpinOptions(bucket_volume, window_buckets, classification),
+        vpin_out);
+}
+
+ob_feed_t* create_feed_pipeline(const char* const* symbols, size_t symbol_count,
+                                size_t ring_capacity, size_t batch_size, bool busy_spin,
+                                size_t analyzer_window) {
+    microstructure::FeedPipeline::Options options;
+    if (ring_capacity > 0) {
+        options.ring_capacity = ring_capacity;
+    }
+    if (batch_size > 0) {
+        options.batch_size = batch_size;
+    }
+    options.wait_strategy = busy_spin ? microstructure::WaitStrategy::kBusySpin
+                                      : microstructure::WaitStrategy::kAdaptive;
+    options.analyzer_window = analyzer_window;
+    return new ob_feed(std::vector<std::string>(symbols, symbols + symbol_count), options);
+}
+
+void destroy_feed_pipeline(ob_feed_t* feed) {
+    delete feed;
+}
+
+bool start_feed_pipeline(ob_feed_t* feed, ob_update_callback_t callback, void* user_data) {
+    if (!callback) {
+        return feed->pipeline.Start(nullptr);
+    }
+    return feed->pipeline.Start([callback, user_data](const microstructure::BookUpdate* updates, size_t count) {
+        callback(reinterpret_cast<const ob_book_update_t*>(updates), count, user_data);
+    });
+}
+
+void stop_feed_pipeline(ob_feed_t* feed) {
+    feed->pipeline.Stop();
+}
+
+size_t submit_feed_events(ob_feed_t* feed, const ob_feed_event_t* events, size_t count) {
+    return feed->pipeline.Submit(reinterpret_cast<const microstructure::FeedEvent*>(events), count);
+}
+
+void get_feed_stats(ob_feed_t* feed, ob_feed_stats_t* out) {
+    microstructure::FeedPipelineStats stats = feed->pipeline.GetStats();
+    out->submitted = stats.submitted;
+    out->rejected = stats.rejected;
+    out->applied = stats.applied;
+    out->delivered = stats.delivered;
+    out->callback_batches = stats.callback_batches;
+}
+
+void set_stage_timing_enabled(bool enabled) {
+    microstructure::SetStageTimingEnabled(enabled);
+}
+
+bool get_stage_latency(int32_t stage, ob_stage_latency_t* out) {
+    if (stage < 0 || stage >= OB_STAGE_COUNT) {
+        return false;
+    }
+    microstructure::LatencyHistogram histogram =
+        microstructure::GetStageLatency(static_cast<microstructure::PipelineStage>(stage));
+    out->count = histogram.GetCount();
+    out->mean_ns = histogram.GetMean();
+    out->min_ns = histogram.GetMin();
+    out->p50_ns = histogram.GetValueAtPercentile(50.0);
+    out->p90_ns = histogram.GetValueAtPercentile(90.0);
+    out->p99_ns = histogram.GetValueAtPercentile(99.0);
+    out->p999_ns = histogram.GetValueAtPercentile(99.9);
+    out->max_ns = histogram.GetMax();
+    return true;
+}
+
+void reset_stage_latency(void) {
+    microstructure::ResetStageLatency();
+}
+
+bool start_stage_latency_dump(uint32_t interval_ms, const char* path) {
+    return GetStageLatencyReporter().Start(interval_ms, path ? path : "");
+}
+
+void stop_stage_latency_dump(void) {
+    GetStageLatencyReporter().Stop();
+}
+
+bool start_metrics_endpoint(const char* address, uint16_t port) {
+    return GetMetricsServer().Start(&GetMetricsRegistry(), address ? address : "", port);
+}
+
+uint16_t get_metrics_endpoint_port(void) {
+    return GetMetricsServer().IsRunning() ? GetMetricsServer().GetPort() : 0;
+}
+
+void stop_metrics_endpoint(void) {
+    GetMetricsServer().Stop();
+}
+
+size_t scrape_metrics(char* buffer, size_t size) {
+    std::string text = GetMetricsRegistry().Scrape();
+    if (buffer && size > 0) {
+        size_t copied = std::min(text.size(), size - 1);
+        std::memcpy(buffer, text.data(), copied);
+        buffer[copied] = '\0';
+    }
+    return text.size();
+}
+
+} // extern "C"
@@ -0,0 +1,629 @@
+#pragma once
+
+// C ABI for liborderbook.so, consumed from Python through ctypes
+// (core/src/integration/cpp_interface.py).
+//
+// Books are opaque handles. The per-call functions keep string order IDs
+// for compatibility; the batch entry points take numeric IDs, which map
+// onto the same book as their decimal string (ID 42 is order "42"), so a
+// whole packet or a whole snapshot costs a single FFI transition.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ob_book ob_book_t;
+typedef struct ob_region ob_region_t;
+typedef struct ob_snapshot_batch ob_snapshot_batch_t;
+typedef struct ob_metric_batch ob_metric_batch_t;
+typedef struct ob_feed ob_feed_t;
+typedef struct ob_sequenced_feed ob_sequenced_feed_t;
+typedef struct ob_udp_feed ob_udp_feed_t;
+typedef struct ob_analyzer ob_analyzer_t;
+typedef struct ob_toxic_detector ob_toxic_detector_t;
+typedef struct ob_vpin ob_vpin_t;
+typedef struct ob_trigger_book ob_trigger_book_t;
+
+// Arrow C Data Interface structs, defined in arrow_export.h
+struct ArrowArray;
+struct ArrowSchema;
+
+// Event types for apply_order_events
+enum {
+    OB_EVENT_ADD = 1,
+    OB_EVENT_MODIFY = 2,
+    OB_EVENT_CANCEL = 3,
+    OB_EVENT_REPLACE = 4,
+    OB_EVENT_EXECUTE = 5
+};
+
+// Packed event record, 40 bytes. For EXECUTE, price is the trade price.
+typedef struct {
+    int64_t timestamp_ns;
+    uint64_t order_id;
+    double price;
+    double quantity;
+    uint8_t type;
+    uint8_t is_buy;
+    uint8_t reserved[6];
+} ob_event_t;
+
+// Scalar part of a snapshot; level arrays are filled alongside it
+typedef struct {
+    int64_t timestamp_ns;
+    double best_bid;
+    double best_ask;
+    double mid_price;
+    double spread;
+    double order_imbalance;
+    int32_t bid_count;
+    int32_t ask_count;
+} ob_snapshot_t;
+
+// Columnar event batch; see apply_order_event_columns
+typedef struct {
+    const int64_t* timestamp_ns;
+    const uint8_t* type;
+    const uint64_t* order_id;
+    const double* price;
+    const double* quantity;
+    const uint8_t* is_buy;
+    const uint32_t* book_index;     // Optional; NULL routes every event to books[0]
+} ob_event_columns_t;
+
+// Optional per-event outputs; NULL columns are not computed
+typedef struct {
+    double* best_bid;
+    double* best_ask;
+    double* mid_price;
+    double* order_imbalance;
+    int32_t imbalance_levels;
+} ob_derived_columns_t;
+
+typedef struct {
+    double price;
+    double quantity;
+    double hidden_quantity;
+    int64_t timestamp_ns;
+    uint8_t is_buy;
+} ob_order_info_t;
+
+// Order attributes beyond add_order's; zero-initialise for a plain limit
+// order. quantity is the displayed size: an iceberg shows peak_quantity
+// and refills it from hidden_quantity, and a fully hidden order is added
+// with quantity 0 and its size in hidden_quantity. expire_time_ns is a
+// good-till-time deadline in event time (0 never expires); re-adding an
+// order ID replaces the order and re-arms its timer. owner_id tags the
+// order for mass_cancel (0 is untagged).
+typedef struct {
+    double hidden_quantity;
+    double peak_quantity;
+    int64_t expire_time_ns;
+    uint32_t owner_id;
+    uint32_t reserved;
+} ob_order_options_t;
+
+// One execution from a book's trade tape. is_buy is the resting side.
+typedef struct {
+    double price;
+    double quantity;
+    int64_t timestamp_ns;
+    uint8_t is_buy;
+    uint8_t reserved[7];
+} ob_trade_t;
+
+// Stop order fields; limit_price 0 makes a stop-market order
+typedef struct {
+    double stop_price;
+    double limit_price;
+    double quantity;
+    int64_t timestamp_ns;
+    uint8_t is_buy;
+    uint8_t reserved[7];
+} ob_stop_order_t;
+
+// Lifecycle
+ob_book_t* create_order_book(const char* symbol);
+void destroy_order_book(ob_book_t* book);
+
+// Per-order operations (string IDs)
+void add_order(ob_book_t* book, const char* order_id, double price, double quantity,
+               bool is_buy, long long timestamp_ns);
+void add_order_with_options(ob_book_t* book, const char* order_id, double price, double quantity,
+                            bool is_buy, long long timestamp_ns, const ob_order_options_t* options);
+void modify_order(ob_book_t* book, const char* order_id, double new_quantity);
+void cancel_order(ob_book_t* book, const char* order_id);
+bool replace_order(ob_book_t* book, const char* order_id, double new_price, double new_quantity);
+double execute_order(ob_book_t* book, const char* order_id, double exec_qty, double trade_price);
+size_t advance_time(ob_book_t* book, long long now_ns);
+// Expiry timers still armed for live orders
+size_t get_pending_expiry_count(ob_book_t* book);
+// Drop every resting order, expiry timer and stop order
+void clear_order_book(ob_book_t* book);
+// Cancel every resting order on the selected sides priced within
+// [min_price, max_price], hidden and iceberg reserve included; a non-zero
+// owner_id restricts it to that participant's orders. Returns the count.
+size_t mass_cancel(ob_book_t* book, bool include_bids, bool include_asks,
+                   double min_price, double max_price, uint32_t owner_id);
+
+// Queries
+double get_best_bid(ob_book_t* book);
+double get_best_ask(ob_book_t* book);
+double get_mid_price(ob_book_t* book);
+double get_spread(ob_book_t* book);
+double get_order_imbalance(ob_book_t* book, int levels);
+size_t get_order_count(ob_book_t* book);
+bool get_order_info(ob_book_t* book, const char* order_id, ob_order_info_t* out);
+// Orders ahead in the order's queue, -1 if it is not in the book
+long long get_queue_position(ob_book_t* book, const char* order_id);
+// Non-displayed volume resting at a price
+double get_hidden_volume(ob_book_t* book, bool is_buy, double price);
+// Up to count most recent executions, oldest first; returns the number written
+size_t get_recent_trades(ob_book_t* book, ob_trade_t* out, size_t count);
+
+// Stop orders held by the book. Buy stops fire when the best ask or a
+// trade reaches the stop, sell stops when the best bid or a trade falls
+// to it; fired stops match against the book at once, and fills that move
+// the price can fire further stops.
+// False, adding nothing, if order_id belongs to a resting order
+bool add_stop_order(ob_book_t* book, const char* order_id, const ob_stop_order_t* stop);
+bool cancel_stop_order(ob_book_t* book, const char* order_id);
+size_t get_stop_order_count(ob_book_t* book);
+// Report a trade printed elsewhere, firing the stops it crosses
+void report_trade_price(ob_book_t* book, double price);
+
+// Standalone trigger index for simulators that match stops themselves.
+// fire_trigger_stops moves the crossed stops to a queue in trigger-price
+// order, buys first; pop_fired_stop drains it, copying the ID into
+// order_id (NUL-terminated, truncated to order_id_size).
+ob_trigger_book_t* create_trigger_book(void);
+void destroy_trigger_book(ob_trigger_book_t* triggers);
+void add_trigger_stop(ob_trigger_book_t* triggers, const char* order_id, const ob_stop_order_t* stop);
+bool cancel_trigger_stop(ob_trigger_book_t* triggers, const char* order_id);
+size_t get_trigger_stop_count(ob_trigger_book_t* triggers);
+size_t fire_trigger_stops(ob_trigger_book_t* triggers, double buy_reference, double sell_reference);
+bool pop_fired_stop(ob_trigger_book_t* triggers, ob_stop_order_t* out, char* order_id, size_t order_id_size);
+
+// Single-level accessors, kept for older callers. Missing bid levels
+// report price 0, missing ask levels +inf.
+double get_bid_level_price(ob_book_t* book, int index);
+double get_bid_level_volume(ob_book_t* book, int index);
+double get_ask_level_price(ob_book_t* book, int index);
+double get_ask_level_volume(ob_book_t* book, int index);
+
+// Batch entry points. apply_order_events returns the number of events
+// applied (unknown types are skipped). fill_order_book_snapshot writes up
+// to `levels` entries into each array and the counts into out.
+size_t apply_order_events(ob_book_t* book, const ob_event_t* events, size_t count);
+void fill_order_book_snapshot(ob_book_t* book, int levels,
+                              double* bid_prices, double* bid_volumes,
+                              double* ask_prices, double* ask_volumes,
+                              ob_snapshot_t* out);
+
+// Columnar ingestion across several books. Each event goes to
+// books[book_index[i]]; events with an unknown type or index are skipped
+// and their derived rows set to NaN. derived may be NULL. Returns the
+// number of events applied.
+size_t apply_order_event_columns(ob_book_t* const* books, size_t book_count,
+                                 const ob_event_columns_t* columns, size_t count,
+                                 const ob_derived_columns_t* derived);
+
+// Binary wire feed (core/src/market_data/binary_protocol.h). Decodes the
+// length-prefixed messages in data straight into books[locate] and returns
+// the bytes consumed; a trailing partial message is left for the next call.
+// stats may be NULL; counts are added to it.
+typedef struct {
+    uint64_t messages;
+    uint64_t skipped;
+    uint64_t malformed;
+} ob_decode_stats_t;
+
+size_t apply_binary_messages(ob_book_t* const* books, size_t book_count,
+                             const uint8_t* data, size_t size, ob_decode_stats_t* stats);
+
+// Sequenced packets with gap recovery (core/src/market_data/sequenced_feed.h).
+// Each channel owns the books at its locates; after a gap its packets are
+// buffered until poll_sequenced_recovery finds a snapshot file newer than
+// the gap in snapshot_dir, which is loaded before replaying the buffer.
+// max_buffered_bytes of 0 picks the default.
+typedef struct {
+    uint64_t next_sequence;
+    uint64_t packets;
+    uint64_t duplicates;
+    uint64_t gaps;
+    uint64_t recoveries;
+    uint64_t buffered_packets;
+    uint64_t overflows;
+    uint64_t stale_snapshots;
+    bool recovering;
+} ob_channel_stats_t;
+
+ob_sequenced_feed_t* create_sequenced_feed(ob_book_t* const* books, size_t book_count,
+                                           const char* snapshot_dir, size_t max_buffered_bytes);
+void destroy_sequenced_feed(ob_sequenced_feed_t* feed);
+bool add_sequenced_channel(ob_sequenced_feed_t* feed, uint16_t channel, const uint16_t* locates,
+                           size_t locate_count, uint64_t next_sequence);
+bool process_sequenced_packet(ob_sequenced_feed_t* feed, const uint8_t* data, size_t size);
+size_t poll_sequenced_recovery(ob_sequenced_feed_t* feed);
+bool get_sequenced_channel_stats(ob_sequenced_feed_t* feed, uint16_t channel, ob_channel_stats_t* out);
+
+// Write the resting orders of books[locates[i]] as the channel's snapshot
+// file at `sequence`; order IDs must be numeric
+bool write_channel_snapshot(const char* snapshot_dir, uint16_t channel, uint64_t sequence,
+                            ob_book_t* const* books, size_t book_count,
+                            const uint16_t* locates, size_t locate_count);
+
+// Historical event files (core/src/market_data/event_file_replay.h). Streams
+// a file of binary wire messages, plain or gzip, into books[locate] with
+// disk reads, decompression and book updates overlapping. backend is
+// OB_READ_AUTO, OB_READ_IO_URING or OB_READ_THREAD_POOL; zero sizes pick
+// the defaults. Stage times are in seconds.
+enum {
+    OB_READ_AUTO = 0,
+    OB_READ_IO_URING = 1,
+    OB_READ_THREAD_POOL = 2
+};
+
+typedef struct {
+    size_t chunk_size;
+    size_t queue_depth;
+    size_t threads;
+    size_t block_size;
+    int32_t backend;
+} ob_event_file_options_t;
+
+typedef struct {
+    uint64_t bytes_read;
+    uint64_t bytes_decompressed;
+    uint64_t messages;
+    uint64_t skipped;
+    uint64_t malformed;
+    uint64_t truncated_bytes;
+    bool compressed;
+    int32_t backend;
+    double elapsed_seconds;
+    double read_wait_seconds;
+    double decompress_seconds;
+    double apply_seconds;
+    double apply_wait_seconds;
+} ob_event_file_stats_t;
+
+// Returns false if the file cannot be read or its compressed stream is
+// corrupt or cut short; out is filled either way once the file opens
+bool replay_event_file(const char* path, ob_book_t* const* books, size_t book_count,
+                       const ob_event_file_options_t* options, ob_event_file_stats_t* out);
+
+// Live UDP ingestion (core/src/market_data/udp_receiver.h). A feed thread
+// drains every socket with recvmmsg and applies the datagrams to
+// books[locate], sequenced like process_sequenced_packet (snapshot files in
+// snapshot_dir) or as bare messages. Sockets and channels are added before
+// start_udp_feed; stats may be read while running. batch_size and
+// receive_buffer_bytes of 0 pick the defaults. While the feed runs its
+// books belong to the feed thread; call other functions on them only
+// between lock_udp_feed_books and unlock_udp_feed_books.
+typedef struct {
+    uint64_t datagrams;
+    uint64_t bytes;
+    uint64_t syscalls;
+    uint64_t truncated;
+    uint64_t kernel_drops;
+    int32_t receive_buffer_bytes;
+} ob_udp_socket_stats_t;
+
+ob_udp_feed_t* create_udp_feed(ob_book_t* const* books, size_t book_count, const char* snapshot_dir,
+                               bool sequenced, size_t batch_size, int receive_buffer_bytes);
+void destroy_udp_feed(ob_udp_feed_t* feed);
+
+// address is a multicast group or a local unicast address, port 0 binds
+// an ephemeral port; returns the socket index or -1
+int add_udp_socket(ob_udp_feed_t* feed, const char* address, uint16_t port, const char* interface_address);
+uint16_t get_udp_socket_port(ob_udp_feed_t* feed, size_t socket);
+bool add_udp_channel(ob_udp_feed_t* feed, uint16_t channel, const uint16_t* locates,
+                     size_t locate_count, uint64_t next_sequence);
+bool start_udp_feed(ob_udp_feed_t* feed);
+void stop_udp_feed(ob_udp_feed_t* feed);
+bool get_udp_socket_stats(ob_udp_feed_t* feed, size_t socket, ob_udp_socket_stats_t* out);
+bool get_udp_channel_stats(ob_udp_feed_t* feed, uint16_t channel, ob_channel_stats_t* out);
+void lock_udp_feed_books(ob_udp_feed_t* feed);
+void unlock_udp_feed_books(ob_udp_feed_t* feed);
+
+// Capture replay (core/src/market_data/pcap_replay.h). Replays the UDP
+// datagrams of a pcap/pcapng file through the binary decoder into
+// books[locate]. speed is a multiple of recorded time, 0 for as fast as
+// possible; udp_port 0 accepts every port. Latencies are per packet.
+typedef struct {
+    double speed;
+    uint16_t udp_port;
+    bool sequenced;
+} ob_replay_options_t;
+
+typedef struct {
+    uint64_t packets;
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t gaps;
+    uint64_t duplicates;
+    uint64_t skipped_records;
+    double elapsed_seconds;
+    double capture_seconds;
+    double latency_mean_ns;
+    uint64_t latency_p50_ns;
+    uint64_t latency_p99_ns;
+    uint64_t latency_p999_ns;
+    uint64_t latency_max_ns;
+    uint64_t lag_p99_ns;
+    uint64_t lag_max_ns;
+} ob_replay_stats_t;
+
+// Returns false if the file is not a readable capture
+bool replay_pcap_file(const char* path, ob_book_t* const* books, size_t book_count,
+                      const ob_replay_options_t* options, ob_replay_stats_t* out);
+
+// Shared-memory snapshot region (snapshot_region.h). The writer process
+// creates the region, takes one slot per symbol and publishes after each
+// batch of updates; readers map the same name read-only.
+ob_region_t* create_snapshot_region(const char* name, uint32_t slot_count, uint32_t depth);
+void destroy_snapshot_region(ob_region_t* region, bool unlink);
+int get_snapshot_region_slot(ob_region_t* region, const char* symbol);
+void publish_order_book_snapshot(ob_region_t* region, int slot, ob_book_t* book);
+
+// Arrow export (arrow_export.h). Rows accumulate in the batch until
+// export, which moves them into out_array/out_schema and leaves the batch
+// empty; the caller releases the exported structs. Snapshot rows hold
+// timestamp_ns, symbol_id, mid_price, spread, order_imbalance, bid/ask
+// counts and depth-sized bid/ask price and volume lists.
+ob_snapshot_batch_t* create_snapshot_batch(int depth);
+void destroy_snapshot_batch(ob_snapshot_batch_t* batch);
+void append_snapshot_row(ob_snapshot_batch_t* batch, uint32_t symbol_id, ob_book_t* book);
+size_t get_snapshot_batch_rows(ob_snapshot_batch_t* batch);
+void export_snapshot_batch(ob_snapshot_batch_t* batch, struct ArrowArray* out_array,
+                           struct ArrowSchema* out_schema);
+
+// Metric rows hold timestamp_ns, symbol_id and one float64 per name
+ob_metric_batch_t* create_metric_batch(const char* const* metric_names, size_t metric_count);
+void destroy_metric_batch(ob_metric_batch_t* batch);
+void append_metric_row(ob_metric_batch_t* batch, int64_t timestamp_ns, uint32_t symbol_id,
+                       const double* values);
+size_t get_metric_batch_rows(ob_metric_batch_t* batch);
+void export_metric_batch(ob_metric_batch_t* batch, struct ArrowArray* out_array,
+                         struct ArrowSchema* out_schema);
+
+// Streaming microstructure metrics for one book
+// (core/src/analysis/microstructure_analyzer.h), O(1) per update in the
+// window size. Call update after each change to the book.
+typedef struct {
+    int64_t timestamp_ns;
+    double mid_price;
+    double spread;
+    double order_imbalance;
+    double price_impact;
+    double realized_volatility;
+} ob_microstructure_metrics_t;
+
+// window_size is the number of mid returns behind realized volatility;
+// impact_size is the round-trip quantity priced for price_impact
+ob_analyzer_t* create_microstructure_analyzer(size_t window_size, int imbalance_levels, double impact_size);
+void destroy_microstructure_analyzer(ob_analyzer_t* analyzer);
+void update_microstructure_analyzer(ob_analyzer_t* analyzer, ob_book_t* book, int64_t timestamp_ns,
+                                    ob_microstructure_metrics_t* out);
+void reset_microstructure_analyzer(ob_analyzer_t* analyzer);
+// Appends the latest metrics as one row; the batch must have been created
+// with the names mid_price, spread, order_imbalance, price_impact and
+// realized_volatility in that order. False otherwise.
+bool append_analyzer_metrics(ob_analyzer_t* analyzer, ob_metric_batch_t* batch, uint32_t symbol_id);
+
+// Multi-symbol toxic flow scoring (core/src/analysis/toxic_flow_detector.h).
+// Events are routed by symbol_id in [0, symbol_count); each costs O(1) and
+// a score O(1) in the window size.
+enum {
+    OB_TOXIC_ORDER = 1,         // quantity, is_buy, price
+    OB_TOXIC_CANCEL = 2,
+    OB_TOXIC_TRADE = 3,         // quantity, is_buy, price
+    OB_TOXIC_BOOK = 4           // price_impact, volatility
+};
+
+typedef struct {
+    int64_t timestamp_ns;
+    uint32_t symbol_id;
+    uint8_t type;
+    uint8_t is_buy;
+    uint8_t reserved[2];
+    double quantity;
+    double price;
+    double price_impact;
+    double volatility;
+} ob_toxic_event_t;
+
+// factors: cancel/trade ratio, order imbalance, price impact, volatility
+// and large orders, each capped at 1 and weighted into score
+typedef struct {
+    int64_t timestamp_ns;
+    double score;
+    double confidence;
+    double cancel_trade_ratio;
+    double order_flow_imbalance;
+    double price_impact;
+    double volatility;
+    double avg_order_size;
+    double large_order_ratio;
+    double factors[5];
+    uint8_t is_toxic;
+    uint8_t reserved[7];
+} ob_toxic_score_t;
+
+// Zero window_size and large_order_multiple select the defaults: a
+// 100-event window and large orders above twice the mean size, or twice
+// the large_order_quantile order size when that is in (0, 1]. A negative
+// threshold selects the default 0.6; 0 flags any positive score as toxic.
+ob_toxic_detector_t* create_toxic_flow_detector(size_t symbol_count, size_t window_size,
+                                                double large_order_multiple, double large_order_quantile,
+                                                double threshold);
+void destroy_toxic_flow_detector(ob_toxic_detector_t* detector);
+// Returns the number applied; unknown symbols and types are skipped
+size_t apply_toxic_flow_events(ob_toxic_detector_t* detector, const ob_toxic_event_t* events, size_t count);
+// False for an unknown symbol
+bool score_toxic_flow(ob_toxic_detector_t* detector, uint32_t symbol_id, ob_toxic_score_t* out);
+// out holds symbol_count entries, indexed by symbol_id
+void score_all_toxic_flow(ob_toxic_detector_t* detector, ob_toxic_score_t* out);
+double get_toxic_order_size_quantile(ob_toxic_detector_t* detector, uint32_t symbol_id, double q);
+void reset_toxic_flow_symbol(ob_toxic_detector_t* detector, uint32_t symbol_id);
+
+// VPIN over volume-synchronised buckets (core/src/analysis/vpin_calculator.h).
+// Trades are routed by symbol_id in [0, symbol_count) and cost O(1) each.
+enum {
+    OB_VPIN_TICK_RULE = 0,
+    OB_VPIN_BULK_VOLUME = 1,
+    OB_VPIN_AGGRESSOR = 2       // side when known, tick rule otherwise
+};
+
+enum {
+    OB_VPIN_SIDE_UNKNOWN = 0,
+    OB_VPIN_SIDE_BUY = 1,       // Aggressor side
+    OB_VPIN_SIDE_SELL = 2
+};
+
+typedef struct {
+    int64_t timestamp_ns;
+    uint32_t symbol_id;
+    uint8_t side;
+    uint8_t reserved[3];
+    double price;
+    double quantity;
+} ob_vpin_trade_t;
+
+// vpin averages the closed buckets in the window, which is full once
+// buckets reaches window_buckets
+typedef struct {
+    int64_t timestamp_ns;
+    double vpin;
+    double bucket_fill;
+    double last_imbalance;
+    uint64_t buckets;
+} ob_vpin_state_t;
+
+// Zero bucket_volume or window_buckets select the defaults of 10000 and 50
+ob_vpin_t* create_vpin_calculator(size_t symbol_count, double bucket_volume, size_t window_buckets,
+                                  int classification);
+void destroy_vpin_calculator(ob_vpin_t* vpin);
+// Returns the number applied; unknown symbols and empty trades are skipped
+size_t apply_vpin_trades(ob_vpin_t* vpin, const ob_vpin_trade_t* trades, size_t count);
+// Consumes executions on the book's trade tape since the last call for symbol_id
+size_t update_vpin_from_book(ob_vpin_t* vpin, uint32_t symbol_id, ob_book_t* book);
+// False for an unknown symbol
+bool get_vpin_state(ob_vpin_t* vpin, uint32_t symbol_id, ob_vpin_state_t* out);
+// out holds symbol_count entries, indexed by symbol_id
+void get_all_vpin_states(ob_vpin_t* vpin, ob_vpin_state_t* out);
+// Resets the symbol; false for an unknown symbol or a non-positive volume
+bool set_vpin_bucket_volume(ob_vpin_t* vpin, uint32_t symbol_id, double bucket_volume);
+void reset_vpin_symbol(ob_vpin_t* vpin, uint32_t symbol_id);
+// Whole-day arrays for one symbol: vpin_out[i] is the VPIN after trade i,
+// NaN until window_buckets buckets have closed. sides may be NULL.
+// Returns the number of buckets closed.
+uint64_t compute_vpin_historical(const double* prices, const double* quantities, const uint8_t* sides,
+                                 size_t count, double bucket_volume, size_t window_buckets,
+                                 int classification, double* vpin_out);
+
+// Native feed pipeline (core/src/market_data/feed_pipeline.h). Events are
+// routed to books[book_index]; the book thread emits one update per
+// applied event and the analytics thread hands them to the callback in
+// batches. The callback runs on the analytics thread and must not keep
+// the pointer past its return.
+typedef struct {
+    ob_event_t event;
+    uint32_t book_index;
+    uint32_t reserved;
+} ob_feed_event_t;
+
+typedef struct {
+    int64_t timestamp_ns;
+    uint64_t order_id;
+    double price;
+    double quantity;
+    double best_bid;
+    double best_ask;
+    double mid_price;
+    double order_imbalance;
+    double spread;                  // Analyzer metrics; 0 when analyzer_window is 0
+    double price_impact;
+    double realized_volatility;
+    uint32_t book_index;
+    uint8_t type;
+    uint8_t is_buy;
+    uint8_t reserved[2];
+} ob_book_update_t;
+
+typedef struct {
+    uint64_t submitted;
+    uint64_t rejected;
+    uint64_t applied;
+    uint64_t delivered;
+    uint64_t callback_batches;
+} ob_feed_stats_t;
+
+typedef void (*ob_update_callback_t)(const ob_book_update_t* updates, size_t count, void* user_data);
+
+// busy_spin selects busy polling over the adaptive spin/yield/sleep wait.
+// A non-zero analyzer_window runs a microstructure analyzer per book on the
+// book thread and fills the analyzer fields of each update.
+ob_feed_t* create_feed_pipeline(const char* const* symbols, size_t symbol_count,
+                                size_t ring_capacity, size_t batch_size, bool busy_spin,
+                                size_t analyzer_window);
+void destroy_feed_pipeline(ob_feed_t* feed);
+bool start_feed_pipeline(ob_feed_t* feed, ob_update_callback_t callback, void* user_data);
+void stop_feed_pipeline(ob_feed_t* feed);
+// Non-blocking, single producer; returns the number of events accepted
+size_t submit_feed_events(ob_feed_t* feed, const ob_feed_event_t* events, size_t count);
+void get_feed_stats(ob_feed_t* feed, ob_feed_stats_t* out);
+
+// Per-stage latency (core/src/monitoring/stage_latency.h), merged across
+// every thread that records. Timing is off until enabled; the feed
+// pipeline records queue wait, apply, metrics and publish, the binary
+// decoders decode and apply. Latencies are in nanoseconds.
+enum {
+    OB_STAGE_DECODE = 0,
+    OB_STAGE_QUEUE_WAIT = 1,
+    OB_STAGE_APPLY = 2,
+    OB_STAGE_METRICS = 3,
+    OB_STAGE_PUBLISH = 4,
+    OB_STAGE_COUNT = 5
+};
+
+typedef struct {
+    uint64_t count;
+    double mean_ns;
+    uint64_t min_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} ob_stage_latency_t;
+
+void set_stage_timing_enabled(bool enabled);
+// False for an unknown stage
+bool get_stage_latency(int32_t stage, ob_stage_latency_t* out);
+void reset_stage_latency(void);
+// Appends a summary of every stage to path (stderr when null) each
+// interval; false if a dump is already running or the file cannot be opened
+bool start_stage_latency_dump(uint32_t interval_ms, const char* path);
+void stop_stage_latency_dump(void);
+
+// Prometheus text exposition of the counters of every live book, feed
+// pipeline and UDP feed. The endpoint serves GET /metrics on its own
+// thread; port 0 picks a free port. False if already running or the
+// address cannot be bound.
+bool start_metrics_endpoint(const char* address, uint16_t port);
+// Bound port, 0 when stopped
+uint16_t get_metrics_endpoint_port(void);
+void stop_metrics_endpoint(void);
+// Writes a NUL-terminated scrape, truncated to size; returns the full
+// length so a caller can retry with a larger buffer
+size_t scrape_metrics(char* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,249 @@
+#include "snapshot_region.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace microstructure {
+
+static_assert(sizeof(RegionHeader) == 64, "RegionHeader layout is shared with readers");
+static_assert(offsetof(SnapshotSlot, timestamp_ns) == 24, "SnapshotSlot layout is shared with readers");
+static_assert(offsetof(SnapshotSlot, bid_count) == 72, "SnapshotSlot layout is shared with readers");
+static_assert(sizeof(SnapshotSlot) == 80, "SnapshotSlot layout is shared with readers");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock needs a lock-free sequence");
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+
+size_t SlotSize(uint32_t depth) {
+    size_t size = sizeof(SnapshotSlot) + 4 * sizeof(double) * depth;
+    return (size + kCacheLine - 1) / kCacheLine * kCacheLine;
+}
+
+std::string ShmName(const std::string& name) {
+    return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+
+} // namespace
+
+SnapshotRegion::SnapshotRegion(std::string name, void* base, size_t size, bool writable)
+    : name_(std::move(name)), base_(base), size_(size), writable_(writable),
+      header_(static_cast<RegionHeader*>(base)) {
+    if (writable_) {
+        scratch_.resize(4 * static_cast<size_t>(header_->depth));
+    }
+}
+
+SnapshotRegion::~SnapshotRegion() {
+    munmap(base_, size_);
+}
+
+std::unique_ptr<SnapshotRegion> SnapshotRegion::Create(const std::string& name, uint32_t slot_count,
+                                                       uint32_t depth) {
+    if (slot_count == 0 || depth == 0) {
+        return nullptr;
+    }
+    std::string shm_name = ShmName(name);
+    // A name left behind by a crashed writer is replaced, not truncated:
+    // readers still mapping the old object keep valid pages and notice the
+    // new one by its inode
+    shm_unlink(shm_name.c_str());
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        return nullptr;
+    }
+    
+    size_t slot_size = SlotSize(depth);
+    size_t size = sizeof(RegionHeader) + slot_size * slot_count;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(shm_name.c_str());
+        return nullptr;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+    
+    auto* header = static_cast<RegionHeader*>(base);
+    header->version = kVersion;
+    header->slot_count = slot_count;
+    header->depth = depth;
+    header->slot_size = static_cast<uint32_t>(slot_size);
+    header->slots_used.store(0, std::memory_order_relaxed);
+    // Readers check the magic last, so it is published after the rest
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kMagic;
+    
+    return std::unique_ptr<SnapshotRegion>(new SnapshotRegion(shm_name, base, size, true));
+}
+
+std::unique_ptr<SnapshotRegion> SnapshotRegion::Open(const std::string& name) {
+    std::string shm_name = ShmName(name);
+    int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(RegionHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+    
+    const auto* header = static_cast<const RegionHeader*>(base);
+    bool valid = header->magic == kMagic && header->version == kVersion &&
+                 header->slot_size == SlotSize(header->depth) &&
+                 size >= sizeof(RegionHeader) + static_cast<size_t>(header->slot_size) * header->slot_count;
+    if (!valid) {
+        munmap(base, size);
+        return nullptr;
+    }
+    return std::unique_ptr<SnapshotRegion>(new SnapshotRegion(shm_name, base, size, false));
+}
+
+void SnapshotRegion::Unlink(const std::string& name) {
+    shm_unlink(ShmName(name).c_str());
+}
+
+SnapshotSlot* SnapshotRegion::SlotAt(int slot) const {
+    char* slots = static_cast<char*>(base_) + sizeof(RegionHeader);
+    return reinterpret_cast<SnapshotSlot*>(slots + static_cast<size_t>(slot) * header_->slot_size);
+}
+
+double* SnapshotRegion::LevelsAt(int slot) const {
+    return reinterpret_cast<double*>(SlotAt(slot) + 1);
+}
+
+int SnapshotRegion::FindSlot(const std::string& symbol) const {
+    uint32_t used = GetSlotsUsed();
+    for (uint32_t i = 0; i < used; ++i) {
+        const SnapshotSlot* slot = SlotAt(static_cast<int>(i));
+        if (strncmp(slot->symbol, symbol.c_str(), kSymbolSize) == 0) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+int SnapshotRegion::GetOrAssignSlot(const std::string& symbol) {
+    if (!writable_) {
+        return -1;
+    }
+    int slot = FindSlot(symbol);
+    if (slot >= 0) {
+        return slot;
+    }
+    uint32_t used = header_->slots_used.load(std::memory_order_relaxed);
+    if (used == header_->slot_count) {
+        return -1;
+    }
+    
+    SnapshotSlot* entry = SlotAt(static_cast<int>(used));
+    std::memset(entry->symbol, 0, kSymbolSize);
+    std::memcpy(entry->symbol, symbol.data(), std::min(symbol.size(), kSymbolSize - 1));
+    entry->sequence.store(0, std::memory_order_relaxed);
+    header_->slots_used.store(used + 1, std::memory_order_release);
+    return static_cast<int>(used);
+}
+
+void SnapshotRegion::Publish(int slot, const LimitOrderBook& book) {
+    if (!writable_ || slot < 0 || static_cast<uint32_t>(slot) >= GetSlotsUsed()) {
+        return;
+    }
+    const int depth = static_cast<int>(header_->depth);
+    SnapshotSlot* entry = SlotAt(slot);
+    double* levels = LevelsAt(slot);
+    
+    // Gather from the book first to keep the odd-sequence window short
+    int64_t timestamp_ns = book.GetCurrentTime();
+    double best_bid = book.GetBestBid();
+    double best_ask = book.GetBestAsk();
+    double mid_price = book.GetMidPrice();
+    double spread = book.GetSpread();
+    double imbalance = book.GetOrderImbalance();
+    double* staged = scratch_.data();
+    int bid_count = book.GetBidLevels(staged, staged + depth, depth);
+    int ask_count = book.GetAskLevels(staged + 2 * depth, staged + 3 * depth, depth);
+    
+    uint64_t sequence = entry->sequence.load(std::memory_order_relaxed);
+    entry->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    entry->timestamp_ns = timestamp_ns;
+    entry->best_bid = best_bid;
+    entry->best_ask = best_ask;
+    entry->mid_price = mid_price;
+    entry->spread = spread;
+    entry->order_imbalance = imbalance;
+    entry->bid_count = bid_count;
+    entry->ask_count = ask_count;
+    std::memcpy(levels, staged, sizeof(double) * scratch_.size());
+    
+    entry->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool SnapshotRegion::Read(int slot, SnapshotView* out, int max_retries) const {
+    if (slot < 0 || static_cast<uint32_t>(slot) >= GetSlotsUsed()) {
+        return false;
+    }
+    const int depth = static_cast<int>(header_->depth);
+    const SnapshotSlot* entry = SlotAt(slot);
+    const double* levels = LevelsAt(slot);
+    SnapshotSlot copy;
+    std::vector<double> level_copy(4 * static_cast<size_t>(depth));
+    
+    for (int attempt = 0; attempt < max_retries; ++attempt) {
+        uint64_t before = entry->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        std::memcpy(copy.symbol, entry->symbol, kSymbolSize);
+        copy.timestamp_ns = entry->timestamp_ns;
+        copy.best_bid = entry->best_bid;
+        copy.best_ask = entry->best_ask;
+        copy.mid_price = entry->mid_price;
+        copy.spread = entry->spread;
+        copy.order_imbalance = entry->order_imbalance;
+        copy.bid_count = entry->bid_count;
+        copy.ask_count = entry->ask_count;
+        std::memcpy(level_copy.data(), levels, sizeof(double) * level_copy.size());
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (entry->sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        
+        out->symbol.assign(copy.symbol, strnlen(copy.symbol, kSymbolSize));
+        out->timestamp_ns = copy.timestamp_ns;
+        out->best_bid = copy.best_bid;
+        out->best_ask = copy.best_ask;
+        out->mid_price = copy.mid_price;
+        out->spread = copy.spread;
+        out->order_imbalance = copy.order_imbalance;
+        int bids = std::clamp(copy.bid_count, 0, depth);
+        int asks = std::clamp(copy.ask_count, 0, depth);
+        out->bid_levels.clear();
+        out->ask_levels.clear();
+        for (int i = 0; i < bids; ++i) {
+            out->bid_levels.emplace_back(level_copy[i], level_copy[depth + i]);
+        }
+        for (int i = 0; i < asks; ++i) {
+            out->ask_levels.emplace_back(level_copy[2 * depth + i], level_copy[3 * depth + i]);
+        }
+        return true;
+    }
+    return false;
+}
+
+} // namespace microstructure
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "limit_order_book.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace microstructure {
+
+// POSIX shared-memory region holding one top-of-book snapshot per symbol,
+// written by a single process and polled by any number of readers.
+//
+// Each slot is guarded by a seqlock: the writer makes the sequence odd,
+// rewrites the slot and makes it even again; a reader retries whenever
+// it sees an odd sequence or the sequence changed under it. Readers never
+// block the writer and need no syscalls once the region is mapped.
+//
+// The layout is fixed so non-C++ readers can map it directly
+// (core/src/integration/shm_snapshot.py):
+//
+//   RegionHeader (64 bytes), then slot_count slots of slot_size bytes:
+//     0   uint64  sequence
+//     8   char    symbol[16]       NUL-padded
+//     24  int64   timestamp_ns
+//     32  double  best_bid, best_ask, mid_price, spread, order_imbalance
+//     72  int32   bid_count, ask_count
+//     80  double  levels[4][depth]  bid prices, bid volumes, ask prices, ask volumes
+struct RegionHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t depth;
+    uint32_t slot_size;
+    std::atomic<uint32_t> slots_used;   // Published after a slot's symbol is set
+    uint8_t reserved[36];
+};
+
+struct SnapshotSlot {
+    std::atomic<uint64_t> sequence;
+    char symbol[16];
+    int64_t timestamp_ns;
+    double best_bid;
+    double best_ask;
+    double mid_price;
+    double spread;
+    double order_imbalance;
+    int32_t bid_count;
+    int32_t ask_count;
+    // double levels[4 * depth] follows
+};
+
+// Consistent copy of one slot
+struct SnapshotView {
+    std::string symbol;
+    int64_t timestamp_ns = 0;
+    double best_bid = 0.0;
+    double best_ask = 0.0;
+    double mid_price = 0.0;
+    double spread = 0.0;
+    double order_imbalance = 0.0;
+    std::vector<std::pair<double, double>> bid_levels;
+    std::vector<std::pair<double, double>> ask_levels;
+};
+
+class SnapshotRegion {
+public:
+    static constexpr uint64_t kMagic = 0x31304b4f4f42534dULL;   // "MSBOOK01"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kSymbolSize = 16;
+    
+    // Create (or truncate) a region for writing. Returns null on failure.
+    static std::unique_ptr<SnapshotRegion> Create(const std::string& name, uint32_t slot_count,
+                                                  uint32_t depth);
+    
+    // Map an existing region read-only. Returns null if it is missing or
+    // its header does not match this layout.
+    static std::unique_ptr<SnapshotRegion> Open(const std::string& name);
+    
+    ~SnapshotRegion();
+    SnapshotRegion(const SnapshotRegion&) = delete;
+    SnapshotRegion& operator=(const SnapshotRegion&) = delete;
+    
+    // Writer side: slot for a symbol, assigned on first use. Returns -1
+    // when the region is full or was opened read-only.
+    int GetOrAssignSlot(const std::string& symbol);
+    
+    // Writer side: copy the book's top levels into its slot
+    void Publish(int slot, const LimitOrderBook& book);
+    
+    // Reader side. FindSlot returns -1 for an unknown symbol; Read returns
+    // false if the slot is invalid or the writer kept it busy for
+    // max_retries attempts.
+    int FindSlot(const std::string& symbol) const;
+    bool Read(int slot, SnapshotView* out, int max_retries = 1000) const;
+    
+    uint32_t GetSlotCount() const { return header_->slot_count; }
+    uint32_t GetSlotsUsed() const { return header_->slots_used.load(std::memory_order_acquire); }
+    uint32_t GetDepth() const { return header_->depth; }
+    
+    // Removes the name; existing mappings stay valid
+    static void Unlink(const std::string& name);
+    
+private:
+    SnapshotRegion(std::string name, void* base, size_t size, bool writable);
+    
+    SnapshotSlot* SlotAt(int slot) const;
+    double* LevelsAt(int slot) const;
+    
+    std::string name_;
+    void* base_;
+    size_t size_;
+    bool writable_;
+    RegionHeader* header_;
+    
+    // Writer-side staging for the level arrays
+    std::vector<double> scratch_;
+};
+
+} // namespace microstructure
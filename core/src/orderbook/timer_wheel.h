@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace microstructure {
+
+// Hierarchical timing wheel driven by event time rather than the wall
+// clock, so replays expire orders at exactly the same point every run.
+//
+// Four levels of 256 slots cover 2^32 ticks; a deadline further out is
+// parked in the top level and re-placed each time it cascades. Scheduling
+// is O(1). Per-level occupancy bitmaps let Advance jump straight to the
+// next tick with work to do, so it costs one step per occupied slot rather
+// than per elapsed tick. Cancel is amortised O(1): the entry stays in its
+// slot and is dropped when reached, but no longer counts as pending. Once
+// cancelled entries outnumber pending ones every slot is swept, so memory
+// stays proportional to the pending timers however far out they are.
+template <typename T>
+class TimerWheel {
+public:
+    using TimerId = uint64_t;           // 0 is never issued
+    
+    explicit TimerWheel(int64_t tick_ns = 1000000) : tick_ns_(tick_ns) {}
+    
+    // Deadlines are rounded up to the tick so nothing fires early
+    TimerId Schedule(int64_t deadline_ns, T payload) {
+        Entry entry{ToTick(deadline_ns), next_id_++, std::move(payload)};
+        TimerId id = entry.id;
+        ++pending_;
+        if (!started_) {
+            deferred_.push_back(std::move(entry));
+        } else {
+            Insert(std::move(entry));
+        }
+        return id;
+    }
+    
+    // id must be pending: scheduled and neither fired nor cancelled
+    void Cancel(TimerId id) {
+        if (id != 0 && cancelled_.insert(id).second) {
+            --pending_;
+            if (cancelled_.size() > pending_ + kMinSweep) {
+                Sweep();
+            }
+        }
+    }
+    
+    // Drop every timer without firing it; the clock is kept
+    void Clear() {
+        for (int level = 0; level < kLevels; ++level) {
+            for (uint64_t slot = 0; slot < kSlots; ++slot) {
+                slots_[level][slot].clear();
+            }
+            for (auto& word : occupied_[level]) {
+                word = 0;
+            }
+        }
+        due_.clear();
+        deferred_.clear();
+        cancelled_.clear();
+        pending_ = 0;
+    }
+    
+    // Move event time forward and hand every due payload to on_expired.
+    // Time never moves backwards; stale timestamps are ignored.
+    template <typename Fn>
+    size_t Advance(int64_t now_ns, Fn&& on_expired) {
+        uint64_t target = static_cast<uint64_t>(now_ns < 0 ? 0 : now_ns) / tick_ns_;
+        if (!started_) {
+            started_ = true;
+            current_tick_ = target;
+            std::vector<Entry> deferred;
+            deferred.swap(deferred_);
+            for (auto& entry : deferred) {
+                Insert(std::move(entry));
+            }
+        }
+        
+        size_t fired = FireDue(on_expired);
+        while (current_tick_ < target) {
+            if (pending_ == 0) {
+                // Only cancelled entries are left
+                Clear();
+                current_tick_ = target;
+                break;
+            }
+            uint64_t next = NextOccupiedTick();
+            if (next > target) {
+                current_tick_ = target;
+                break;
+            }
+            current_tick_ = next;
+            Cascade();
+            uint64_t slot = current_tick_ & kSlotMask;
+            SetOccupied(0, slot, false);
+            fired += FireSlot(slots_[0][slot], on_expired);
+            fired += FireDue(on_expired);
+        }
+        
+        // Timers a callback scheduled at or before the new time
+        return fired + FireDue(on_expired);
+    }
+    
+    int64_t GetCurrentTime() const { return static_cast<int64_t>(current_tick_ * tick_ns_); }
+    size_t GetPendingCount() const { return pending_; }
+    
+    // Whether Advance(now_ns) could fire anything: timers are pending and
+    // now_ns reaches past the current tick
+    bool IsBehind(int64_t now_ns) const {
+        if (pending_ == 0) {
+            return false;
+        }
+        uint64_t target = static_cast<uint64_t>(now_ns < 0 ? 0 : now_ns) / tick_ns_;
+        return !started_ || target > current_tick_ || !due_.empty();
+    }
+    
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 8;
+    static constexpr uint64_t kSlots = 1u << kSlotBits;
+    static constexpr uint64_t kSlotMask = kSlots - 1;
+    static constexpr uint64_t kMaxDelta = (uint64_t(1) << (kLevels * kSlotBits)) - 1;
+    static constexpr uint64_t kWords = kSlots / 64;
+    static constexpr size_t kMinSweep = 64;     // Cancelled entries tolerated beyond the pending count
+    
+    struct Entry {
+        uint64_t deadline_tick;
+        TimerId id;
+        T payload;
+    };
+    
+    uint64_t ToTick(int64_t time_ns) const {
+        if (time_ns <= 0) {
+            return 0;
+        }
+        return (static_cast<uint64_t>(time_ns) + tick_ns_ - 1) / tick_ns_;
+    }
+    
+    void Insert(Entry entry) {
+        if (entry.deadline_tick <= current_tick_) {
+            due_.push_back(std::move(entry));
+            return;
+        }
+        
+        uint64_t delta = entry.deadline_tick - current_tick_;
+        uint64_t placement = entry.deadline_tick;
+        if (delta > kMaxDelta) {
+            placement = current_tick_ + kMaxDelta;
+            delta = kMaxDelta;
+        }
+        
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (uint64_t(1) << ((level + 1) * kSlotBits))) {
+            ++level;
+        }
+        uint64_t slot = (placement >> (level * kSlotBits)) & kSlotMask;
+        slots_[level][slot].push_back(std::move(entry));
+        SetOccupied(level, slot, true);
+    }
+    
+    void SetOccupied(int level, uint64_t slot, bool occupied) {
+        uint64_t bit = uint64_t(1) << (slot & 63);
+        if (occupied) {
+            occupied_[level][slot >> 6] |= bit;
+        } else {
+            occupied_[level][slot >> 6] &= ~bit;
+        }
+    }
+    
+    // First occupied slot after 'after', wrapping around; kSlots if none
+    uint64_t FindOccupied(int level, uint64_t after) const {
+        for (uint64_t step = 0; step <= kWords; ++step) {
+            uint64_t index = ((after >> 6) + step) % kWords;
+            uint64_t word = occupied_[level][index];
+            if (step == 0) {
+                // Only bits strictly after 'after' in its own word
+                word &= (after & 63) == 63 ? 0 : ~uint64_t(0) << ((after & 63) + 1);
+            } else if (step == kWords) {
+                // Back to the starting word: the bits up to and including 'after'
+                word &= (after & 63) == 63 ? ~uint64_t(0) : (uint64_t(1) << ((after & 63) + 1)) - 1;
+            }
+            if (word != 0) {
+                return index * 64 + static_cast<uint64_t>(__builtin_ctzll(word));
+            }
+        }
+        return kSlots;
+    }
+    
+    // Earliest tick after the current one at which an occupied slot fires
+    // (level 0) or cascades (upper levels)
+    uint64_t NextOccupiedTick() const {
+        uint64_t next = UINT64_MAX;
+        for (int level = 0; level < kLevels; ++level) {
+            int shift = level * kSlotBits;
+            uint64_t slot = FindOccupied(level, (current_tick_ >> shift) & kSlotMask);
+            if (slot == kSlots) {
+                continue;
+            }
+            uint64_t span = uint64_t(1) << (shift + kSlotBits);
+            uint64_t tick = (current_tick_ & ~(span - 1)) | (slot << shift);
+            if (tick <= current_tick_) {
+                tick += span;
+            }
+            next = std::min(next, tick);
+        }
+        return next;
+    }
+    
+    // When the lower bits of the clock wrap, re-place the entries of the
+    // upper slot that just came into range, highest level first
+    void Cascade() {
+        if ((current_tick_ & kSlotMask) != 0) {
+            return;
+        }
+        int top = 1;
+        while (top < kLevels - 1 && ((current_tick_ >> (top * kSlotBits)) & kSlotMask) == 0) {
+            ++top;
+        }
+        for (int level = top; level >= 1; --level) {
+            uint64_t slot = (current_tick_ >> (level * kSlotBits)) & kSlotMask;
+            std::vector<Entry> entries;
+            entries.swap(slots_[level][slot]);
+            SetOccupied(level, slot, false);
+            for (auto& entry : entries) {
+                if (cancelled_.erase(entry.id) == 0) {
+                    Insert(std::move(entry));
+                }
+            }
+        }
+    }
+    
+    // Drop every cancelled entry from the slots, due and deferred lists
+    void Sweep() {
+        auto cancelled = [this](const Entry& entry) { return cancelled_.count(entry.id) != 0; };
+        auto sweep = [&cancelled](std::vector<Entry>& entries) {
+            entries.erase(std::remove_if(entries.begin(), entries.end(), cancelled), entries.end());
+        };
+        for (int level = 0; level < kLevels; ++level) {
+            for (uint64_t slot = 0; slot < kSlots; ++slot) {
+                if (!slots_[level][slot].empty()) {
+                    sweep(slots_[level][slot]);
+                    SetOccupied(level, slot, !slots_[level][slot].empty());
+                }
+            }
+        }
+        sweep(due_);
+        sweep(deferred_);
+        cancelled_.clear();
+    }
+    
+    template <typename Fn>
+    size_t FireDue(Fn& on_expired) {
+        return FireSlot(due_, on_expired);
+    }
+    
+    template <typename Fn>
+    size_t FireSlot(std::vector<Entry>& slot, Fn& on_expired) {
+        if (slot.empty()) {
+            return 0;
+        }
+        // Swap out first so callbacks may schedule new timers
+        std::vector<Entry> entries;
+        entries.swap(slot);
+        size_t fired = 0;
+        for (auto& entry : entries) {
+            if (cancelled_.erase(entry.id) != 0) {
+                continue;
+            }
+            --pending_;
+            ++fired;
+            on_expired(entry.payload);
+        }
+        
+        // Hand the buffer back to keep the slot's capacity
+        entries.clear();
+        if (slot.empty()) {
+            slot.swap(entries);
+        }
+        return fired;
+    }
+    
+    uint64_t tick_ns_;
+    uint64_t current_tick_ = 0;
+    bool started_ = false;
+    size_t pending_ = 0;
+    TimerId next_id_ = 1;
+    std::vector<Entry> slots_[kLevels][kSlots];
+    uint64_t occupied_[kLevels][kWords] = {};
+    std::unordered_set<TimerId> cancelled_;
+    std::vector<Entry> due_;
+    std::vector<Entry> deferred_;
+};
+
+} // namespace microstructure
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace microstructure {
+
+struct Trade {
+    std::string order_id;       // Resting order that was executed
+    double price;
+    double quantity;
+    bool is_buy;                // Side of the resting order
+    int64_t timestamp_ns;
+};
+
+// Fixed-capacity ring of the most recent executions. Slots are reused in
+// place, so recording a trade does not allocate once the ring is warm.
+class TradeTape {
+public:
+    explicit TradeTape(size_t capacity = 4096) : trades_(std::max<size_t>(capacity, 1)) {}
+    
+    void Record(const std::string& order_id, double price, double quantity,
+                bool is_buy, int64_t timestamp_ns) {
+        Trade& trade = trades_[next_];
+        trade.order_id.assign(order_id);
+        trade.price = price;
+        trade.quantity = quantity;
+        trade.is_buy = is_buy;
+        trade.timestamp_ns = timestamp_ns;
+        
+        next_ = (next_ + 1) % trades_.size();
+        size_ = std::min(size_ + 1, trades_.size());
+        ++total_count_;
+        total_volume_ += quantity;
+        total_notional_ += price * quantity;
+    }
+    
+    // Up to count most recent trades, oldest first
+    std::vector<Trade> GetRecentTrades(size_t count) const {
+        count = std::min(count, size_);
+        std::vector<Trade> result;
+        result.reserve(count);
+        size_t start = (next_ + trades_.size() - count) % trades_.size();
+        for (size_t i = 0; i < count; ++i) {
+            result.push_back(trades_[(start + i) % trades_.size()]);
+        }
+        return result;
+    }
+    
+    // Visit up to count most recent trades, oldest first, without copying
+    template <typename Fn>
+    void ForEachRecent(size_t count, Fn&& fn) const {
+        count = std::min(count, size_);
+        size_t index = (next_ + trades_.size() - count) % trades_.size();
+        for (size_t i = 0; i < count; ++i) {
+            fn(trades_[index]);
+            index = index + 1 == trades_.size() ? 0 : index + 1;
+        }
+    }
+    
+    size_t GetSize() const { return size_; }
+    uint64_t GetTotalCount() const { return total_count_; }
+    double GetTotalVolume() const { return total_volume_; }
+    double GetVwap() const { return total_volume_ > 0 ? total_notional_ / total_volume_ : 0.0; }
+    
+private:
+    std::vector<Trade> trades_;
+    size_t next_ = 0;
+    size_t size_ = 0;
+    uint64_t total_count_ = 0;
+    double total_volume_ = 0.0;
+    double total_notional_ = 0.0;
+};
+
+} // namespace microstructure
@@ -0,0 +1,61 @@
+#include "trigger_book.h"
+
+namespace microstructure {
+
+void TriggerBook::AddStopOrder(const StopOrder& order) {
+    CancelStopOrder(order.order_id);
+    
+    StopLocation location{order.is_buy, {}, {}};
+    if (order.is_buy) {
+        location.buy_it = buy_stops_.emplace(order.stop_price, order);
+    } else {
+        location.sell_it = sell_stops_.emplace(order.stop_price, order);
+    }
+    index_.emplace(order.order_id, location);
+}
+
+bool TriggerBook::CancelStopOrder(const std::string& order_id) {
+    auto it = index_.find(order_id);
+    if (it == index_.end()) {
+        return false;
+    }
+    
+    if (it->second.is_buy) {
+        buy_stops_.erase(it->second.buy_it);
+    } else {
+        sell_stops_.erase(it->second.sell_it);
+    }
+    index_.erase(it);
+    return true;
+}
+
+size_t TriggerBook::Trigger(double buy_reference, double sell_reference, std::deque<StopOrder>& fired) {
+    size_t count = 0;
+    
+    // Only the crossed prefix of each side is visited
+    while (!buy_stops_.empty() && buy_stops_.begin()->first <= buy_reference) {
+        auto it = buy_stops_.begin();
+        index_.erase(it->second.order_id);
+        fired.push_back(std::move(it->second));
+        buy_stops_.erase(it);
+        ++count;
+    }
+    
+    while (!sell_stops_.empty() && sell_stops_.begin()->first >= sell_reference) {
+        auto it = sell_stops_.begin();
+        index_.erase(it->second.order_id);
+        fired.push_back(std::move(it->second));
+        sell_stops_.erase(it);
+        ++count;
+    }
+    
+    return count;
+}
+
+void TriggerBook::Clear() {
+    buy_stops_.clear();
+    sell_stops_.clear();
+    index_.clear();
+}
+
+} // namespace microstructure
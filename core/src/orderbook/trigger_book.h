@@ -0,0 +1,54 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+namespace microstructure {
+
+struct StopOrder {
+    std::string order_id;
+    double stop_price;
+    double limit_price;         // 0 for a stop-market order
+    double quantity;
+    bool is_buy;
+    int64_t timestamp_ns;
+    
+    bool IsStopLimit() const { return limit_price > 0.0; }
+};
+
+// Resting stop orders indexed by trigger price. Buy stops fire once the
+// reference price rises to their stop, sell stops once it falls to it, so
+// each side is kept sorted with the next stop to fire at the front.
+class TriggerBook {
+public:
+    void AddStopOrder(const StopOrder& order);
+    bool CancelStopOrder(const std::string& order_id);
+    
+    // Move every stop crossed by the reference prices into fired, in
+    // trigger-price order. O(k log n) for k fired stops.
+    size_t Trigger(double buy_reference, double sell_reference, std::deque<StopOrder>& fired);
+    
+    size_t GetStopOrderCount() const { return index_.size(); }
+    bool IsEmpty() const { return index_.empty(); }
+    void Clear();
+    
+private:
+    using BuyStops = std::multimap<double, StopOrder>;
+    using SellStops = std::multimap<double, StopOrder, std::greater<double>>;
+    
+    struct StopLocation {
+        bool is_buy;
+        BuyStops::iterator buy_it;
+        SellStops::iterator sell_it;
+    };
+    
+    BuyStops buy_stops_;    // Lowest stop fires first
+    SellStops sell_stops_;  // Highest stop fires first
+    std::unordered_map<std::string, StopLocation> index_;
+};
+
+} // namespace microstructure
@@ -0,0 +1,98 @@
+// Publish the UDP payloads of a pcap/pcapng capture to a multicast group
+// at a target packet rate; the source side of a single-host benchmark
+// with udp_receive.
+//
+//   cd core/tools
+//   g++ -std=c++17 -O2 -I../src/orderbook -I../src/market_data udp_publish.cpp
+//       ../src/market_data/udp_publisher.cpp ../src/market_data/pcap_reader.cpp -o udp_publish
+//   ./udp_publish capture.pcap [--group 239.1.1.1] [--port 30001] [--rate PPS]
+//                 [--loops N] [--interface ADDR] [--capture-port P]
+//
+// --rate 0 (the default) sends as fast as the socket accepts. Looping
+// resends the same sequence numbers, so receivers count later loops as
+// duplicates unless they run unsequenced (udp_receive --raw).
+
+#include "udp_publisher.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace microstructure;
+
+namespace {
+
+int Usage() {
+    std::fprintf(stderr, "usage: udp_publish <capture> [--group ADDR] [--port P] [--rate PPS] [--loops N]"
+                         " [--interface ADDR] [--capture-port P]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        return Usage();
+    }
+    std::string path = argv[1];
+    UdpEndpoint destination;
+    destination.address = "239.1.1.1";
+    destination.port = 30001;
+    UdpPublisherOptions options;
+    double rate = 0.0;
+    int loops = 1;
+    uint16_t capture_port = 0;
+    for (int i = 2; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--group") && has_value) {
+            destination.address = argv[++i];
+        } else if (!std::strcmp(argv[i], "--port") && has_value) {
+            destination.port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--rate") && has_value) {
+            rate = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--loops") && has_value) {
+            loops = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--interface") && has_value) {
+            options.interface_address = argv[++i];
+        } else if (!std::strcmp(argv[i], "--capture-port") && has_value) {
+            capture_port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else {
+            return Usage();
+        }
+    }
+    
+    PcapReader reader;
+    if (!reader.Open(path)) {
+        std::fprintf(stderr, "cannot read capture %s\n", path.c_str());
+        return 1;
+    }
+    reader.SetPortFilter(capture_port);
+    UdpPublisher publisher;
+    if (!publisher.Open(destination, options)) {
+        std::fprintf(stderr, "cannot open socket to %s:%u\n", destination.address.c_str(), destination.port);
+        return 1;
+    }
+    
+    PublishStats total{};
+    for (int loop = 0; loop < loops; ++loop) {
+        reader.Rewind();
+        PublishStats stats = publisher.PublishCapture(reader, rate);
+        total.packets += stats.packets;
+        total.bytes += stats.bytes;
+        total.syscalls += stats.syscalls;
+        total.send_errors += stats.send_errors;
+        total.elapsed_seconds += stats.elapsed_seconds;
+    }
+    
+    double seconds = total.elapsed_seconds > 0.0 ? total.elapsed_seconds : 1e-9;
+    std::printf("sent %llu packets, %llu bytes in %.3f s: %.0f packets/s, %.1f MB/s\n",
+                static_cast<unsigned long long>(total.packets),
+                static_cast<unsigned long long>(total.bytes),
+                total.elapsed_seconds, total.packets / seconds, total.bytes / seconds / 1e6);
+    std::printf("sendmmsg calls %llu (%.1f packets each), send errors %llu\n",
+                static_cast<unsigned long long>(total.syscalls),
+                total.syscalls ? static_cast<double>(total.packets) / total.syscalls : 0.0,
+                static_cast<unsigned long long>(total.send_errors));
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Receive binary market data from a multicast group into order books and
+// report throughput and drops once a second; the sink side of a
+// single-host benchmark with udp_publish.
+//
+//   cd core/tools
+//   g++ -std=c++17 -O2 -I../src/orderbook -I../src/market_data -I../src/monitoring udp_receive.cpp
+//       ../src/market_data/udp_receiver.cpp ../src/market_data/sequenced_feed.cpp
+//       ../src/monitoring/stage_latency.cpp ../src/orderbook/limit_order_book.cpp ../src/orderbook/trigger_book.cpp -o udp_receive -lpthread
+//   ./udp_receive [--group 239.1.1.1] [--port 30001] [--seconds S] [--books N]
+//                 [--channel C]... [--snapshot-dir DIR] [--raw] [--rcvbuf BYTES] [--batch N]
+//
+// Each --channel owns every Nth locate, round robin over the channels
+// given; without one, channel 1 owns every book. --raw skips sequencing.
+
+#include "udp_receiver.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace microstructure;
+
+namespace {
+
+int Usage() {
+    std::fprintf(stderr, "usage: udp_receive [--group ADDR] [--port P] [--seconds S] [--books N] [--channel C]..."
+                         " [--snapshot-dir DIR] [--raw] [--rcvbuf BYTES] [--batch N]\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    UdpEndpoint endpoint;
+    endpoint.address = "239.1.1.1";
+    endpoint.port = 30001;
+    UdpFeedOptions options;
+    double seconds = 10.0;
+    size_t book_count = 256;
+    std::vector<uint16_t> channels;
+    std::string snapshot_dir = ".";
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--group") && has_value) {
+            endpoint.address = argv[++i];
+        } else if (!std::strcmp(argv[i], "--port") && has_value) {
+            endpoint.port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--seconds") && has_value) {
+            seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--books") && has_value) {
+            book_count = std::strtoul(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(argv[i], "--channel") && has_value) {
+            channels.push_back(static_cast<uint16_t>(std::atoi(argv[++i])));
+        } else if (!std::strcmp(argv[i], "--snapshot-dir") && has_value) {
+            snapshot_dir = argv[++i];
+        } else if (!std::strcmp(argv[i], "--raw")) {
+            options.sequenced = false;
+        } else if (!std::strcmp(argv[i], "--rcvbuf") && has_value) {
+            options.receiver.receive_buffer_bytes = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--batch") && has_value) {
+            options.receiver.batch_size = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            return Usage();
+        }
+    }
+    if (channels.empty()) {
+        channels.push_back(1);
+    }
+    
+    std::vector<std::unique_ptr<LimitOrderBook>> books;
+    std::vector<LimitOrderBook*> targets;
+    for (size_t i = 0; i < book_count; ++i) {
+        books.push_back(std::make_unique<LimitOrderBook>(std::to_string(i)));
+        targets.push_back(books.back().get());
+    }
+    
+    SnapshotFileSource source(snapshot_dir);
+    UdpFeed feed(targets.data(), targets.size(), &source, options);
+    if (feed.AddSocket(endpoint) < 0) {
+        std::fprintf(stderr, "cannot join %s:%u\n", endpoint.address.c_str(), endpoint.port);
+        return 1;
+    }
+    for (size_t c = 0; c < channels.size(); ++c) {
+        std::vector<uint16_t> locates;
+        for (size_t locate = c; locate < book_count; locate += channels.size()) {
+            locates.push_back(static_cast<uint16_t>(locate));
+        }
+        feed.AddChannel(channels[c], locates);
+    }
+    
+    UdpSocketStats stats;
+    feed.GetSocketStats(0, &stats);
+    std::printf("listening on %s:%u, receive buffer %d bytes\n", endpoint.address.c_str(), feed.GetPort(0),
+                stats.receive_buffer_bytes);
+    feed.Start();
+    
+    UdpSocketStats last{};
+    auto start = std::chrono::steady_clock::now();
+    for (int tick = 1; tick <= static_cast<int>(seconds); ++tick) {
+        std::this_thread::sleep_until(start + std::chrono::seconds(tick));
+        feed.GetSocketStats(0, &stats);
+        std::printf("%3ds  %9llu packets/s  %8.1f MB/s  %5.1f per recvmmsg  drops %llu  truncated %llu\n", tick,
+                    static_cast<unsigned long long>(stats.datagrams - last.datagrams),
+                    (stats.bytes - last.bytes) / 1e6,
+                    stats.syscalls > last.syscalls
+                        ? static_cast<double>(stats.datagrams - last.datagrams) / (stats.syscalls - last.syscalls)
+                        : 0.0,
+                    static_cast<unsigned long long>(stats.kernel_drops),
+                    static_cast<unsigned long long>(stats.truncated));
+        last = stats;
+    }
+    feed.Stop();
+    
+    feed.GetSocketStats(0, &stats);
+    DecodeStats decode = feed.GetDecodeStats();
+    std::printf("total %llu packets, %llu messages, %llu malformed, %llu kernel drops\n",
+                static_cast<unsigned long long>(stats.datagrams),
+                static_cast<unsigned long long>(decode.messages),
+                static_cast<unsigned long long>(decode.malformed),
+                static_cast<unsigned long long>(stats.kernel_drops));
+    for (uint16_t channel : channels) {
+        ChannelStats channel_stats;
+        if (options.sequenced && feed.GetChannelStats(channel, &channel_stats)) {
+            std::printf("channel %u: next %llu, packets %llu, duplicates %llu, gaps %llu, recoveries %llu\n",
+                        channel, static_cast<unsigned long long>(channel_stats.next_sequence),
+                        static_cast<unsigned long long>(channel_stats.packets),
+                        static_cast<unsigned long long>(channel_stats.duplicates),
+                        static_cast<unsigned long long>(channel_stats.gaps),
+                        static_cast<unsigned long long>(channel_stats.recoveries));
+        }
+    }
+    return 0;
+}
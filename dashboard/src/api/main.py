@@ -9,6 +9,9 @@ import datetime
 from typing import Dict, List, Optional
 import os
 
+from dashboard.src.config import Config
+from core.src.integration.shm_snapshot import SnapshotRegionReader
+
 app = FastAPI(title="Market Microstructure Analysis Platform")
 
 app.add_middleware(
@@ -86,6 +89,39 @@ def get_sample_order_book(symbol: str) -> OrderBook:
         order_imbalance=order_imbalance
     )
 
+_snapshot_reader = None
+
+def get_live_order_book(symbol: str) -> Optional[OrderBook]:
+    """Read the symbol's book from the shared-memory region, if one is configured"""
+    global _snapshot_reader
+    if not Config.SNAPSHOT_REGION:
+        return None
+    
+    if _snapshot_reader is None:
+        try:
+            _snapshot_reader = SnapshotRegionReader(Config.SNAPSHOT_REGION)
+        except (OSError, ValueError):
+            return None
+    elif not _snapshot_reader.refresh():
+        # The feed handler is gone or mid-restart
+        return None
+    
+    snapshot = _snapshot_reader.read(symbol)
+    if snapshot is None:
+        return None
+    
+    return OrderBook(
+        symbol=symbol,
+        timestamp=snapshot["timestamp_ns"] // 1000000,
+        bid_levels=[OrderBookLevel(price=float(p), volume=float(v))
+                    for p, v in zip(snapshot["bid_prices"], snapshot["bid_volumes"])],
+        ask_levels=[OrderBookLevel(price=float(p), volume=float(v))
+                    for p, v in zip(snapshot["ask_prices"], snapshot["ask_volumes"])],
+        mid_price=snapshot["mid_price"],
+        spread=snapshot["spread"],
+        order_imbalance=snapshot["order_imbalance"]
+    )
+
 def get_sample_metrics(symbol: str) -> List[MarketMetric]:
     now = int(datetime.datetime.now().timestamp() * 1000)
     
@@ -170,7 +206,7 @@ async def get_symbols():
 @app.get("/api/orderbook/{symbol}", response_model=OrderBook)
 async def get_orderbook(symbol: str):
     """Get current order book for a symbol"""
-    return get_sample_order_book(symbol)
+    return get_live_order_book(symbol) or get_sample_order_book(symbol)
 
 @app.get("/api/metrics/{symbol}", response_model=List[MarketMetric])
 async def get_metrics(symbol: str):
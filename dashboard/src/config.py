@@ -21,6 +21,9 @@ class Config:
     BACKTEST_WORKERS = int(os.getenv("BACKTEST_WORKERS", "4"))
     BACKTEST_DATA_DIR = os.getenv("BACKTEST_DATA_DIR", "./data/historical")
     
+    # Shared-memory book snapshots published by the feed handler process
+    SNAPSHOT_REGION = os.getenv("SNAPSHOT_REGION", "")
+    
     # Toxic flow detection
     TOXIC_FLOW_THRESHOLD = float(os.getenv("TOXIC_FLOW_THRESHOLD", "0.7"))
     
@@ -1,14 +1,27 @@
 import unittest
 import sys
 import os
+import math
+import re
+import time
 import numpy as np
 
 sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
 
-from core.src.integration.cpp_interface import OrderBookInterface
+from core.src.integration.cpp_interface import OrderBookInterface, ANALYZER_METRICS
 from backtesting.src.execution.execution_model import Order, ExecutionModel
 from core.src.analysis.toxic_flow_detector import ToxicFlowDetector
 
+try:
+    from core.src.integration import orderbook_native
+except ImportError:
+    orderbook_native = None
+
+try:
+    from dashboard.src.api import main as dashboard_api
+except ImportError:
+    dashboard_api = None
+
 class TestOrderBook(unittest.TestCase):
     def setUp(self):
         self.order_book = OrderBookInterface()
@@ -80,6 +93,1068 @@ class TestOrderBook(unittest.TestCase):
         
         self.assertTrue(imbalance > 0)
         
+    def test_replace_and_execute_order(self):
+        self.order_book.add_order(self.symbol, "bid1", 149.0, 100, True)
+        self.order_book.add_order(self.symbol, "bid2", 149.0, 100, True)
+        
+        self.assertTrue(self.order_book.replace_order(self.symbol, "bid1", 150.0, 80))
+        self.assertEqual(self.order_book.get_best_bid(self.symbol), 150.0)
+        
+        executed = self.order_book.execute_order(self.symbol, "bid1", 80, 150.0)
+        self.assertEqual(executed, 80)
+        self.assertIsNone(self.order_book.get_order_info(self.symbol, "bid1"))
+        self.assertEqual(self.order_book.get_best_bid(self.symbol), 149.0)
+        
+    def test_replace_order_queue_priority(self):
+        for order_id in ("a", "b", "c"):
+            self.order_book.add_order(self.symbol, order_id, 149.0, 100, True)
+        self.order_book.add_order(self.symbol, "d", 148.0, 100, True)
+        
+        # A size-down keeps the order's place
+        self.assertTrue(self.order_book.replace_order(self.symbol, "a", 149.0, 60))
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "a"), 0)
+        
+        # A size-up sends it to the back of its level
+        self.assertTrue(self.order_book.replace_order(self.symbol, "a", 149.0, 120))
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "a"), 2)
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "b"), 0)
+        
+        # A price change joins the back of the destination level, even when
+        # the size goes down
+        self.assertTrue(self.order_book.replace_order(self.symbol, "b", 148.0, 50))
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "b"), 1)
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "d"), 0)
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "c"), 0)
+        
+    def test_iceberg_and_hidden_orders(self):
+        self.order_book.add_order(self.symbol, "ice", 150.0, 10, False, hidden_quantity=30, peak_quantity=10)
+        self.order_book.add_order(self.symbol, "lit", 150.0, 5, False)
+        self.order_book.add_order(self.symbol, "dark", 150.5, 0, False, hidden_quantity=40)
+        
+        # Only displayed size shows in depth; reserve is reported separately
+        snapshot = self.order_book.get_order_book_snapshot(self.symbol)
+        self.assertEqual(snapshot["ask_levels"][0], (150.0, 15.0))
+        self.assertEqual(snapshot["ask_levels"][1], (150.5, 0.0))
+        self.assertEqual(self.order_book.get_hidden_volume(self.symbol, False, 150.0), 30)
+        self.assertEqual(self.order_book.get_hidden_volume(self.symbol, False, 150.5), 40)
+        self.assertEqual(self.order_book.get_best_ask(self.symbol), 150.0)
+        
+        # Consuming the tip refills it from reserve and sends it behind "lit"
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "ice"), 0)
+        self.assertEqual(self.order_book.execute_order(self.symbol, "ice", 10, 150.0), 10)
+        info = self.order_book.get_order_info(self.symbol, "ice")
+        self.assertEqual((info["quantity"], info["hidden_quantity"]), (10, 20))
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "ice"), 1)
+        self.assertEqual(self.order_book.get_queue_position(self.symbol, "lit"), 0)
+        self.assertEqual(self.order_book.get_hidden_volume(self.symbol, False, 150.0), 20)
+        
+        # An execution larger than the tip continues into the refilled tips
+        self.assertEqual(self.order_book.execute_order(self.symbol, "ice", 25, 150.0), 25)
+        info = self.order_book.get_order_info(self.symbol, "ice")
+        self.assertEqual((info["quantity"], info["hidden_quantity"]), (5, 0))
+        
+        # A hidden order executes against its reserve and leaves when spent
+        self.assertEqual(self.order_book.execute_order(self.symbol, "dark", 40, 150.5), 40)
+        self.assertIsNone(self.order_book.get_order_info(self.symbol, "dark"))
+        self.assertEqual(self.order_book.get_hidden_volume(self.symbol, False, 150.5), 0)
+        
+    def test_mass_cancel(self):
+        book, symbol = self.order_book, self.symbol
+        book.add_order(symbol, "b1", 100.0, 10, True, 0, owner_id=1)
+        book.add_order(symbol, "b2", 99.0, 10, True, 0, hidden_quantity=40, peak_quantity=10, owner_id=2)
+        book.add_order(symbol, "b3", 98.0, 0, True, 0, hidden_quantity=50, owner_id=1)
+        book.add_order(symbol, "b4", 97.0, 10, True, 0)
+        book.add_order(symbol, "a1", 101.0, 10, False, 0, owner_id=1)
+        book.add_order(symbol, "a2", 102.0, 10, False, 0, owner_id=2)
+        book.add_order(symbol, "a3", 103.0, 0, False, 0, hidden_quantity=30, owner_id=2)
+        book.add_order(symbol, "a4", 104.0, 10, False, 0, expire_time_ns=10 ** 12)
+        
+        # Participant filter, bids only; the hidden order goes too
+        self.assertEqual(book.mass_cancel(symbol, include_asks=False, owner_id=1), 2)
+        self.assertIsNone(book.get_order_info(symbol, "b3"))
+        self.assertEqual(book.get_hidden_volume(symbol, True, 98.0), 0)
+        self.assertIsNotNone(book.get_order_info(symbol, "a1"))
+        self.assertEqual(book.get_best_bid(symbol), 99.0)
+        
+        # Price band on one side, inclusive at both ends
+        self.assertEqual(book.mass_cancel(symbol, include_bids=False, min_price=102.0, max_price=103.0), 2)
+        self.assertEqual(book.get_hidden_volume(symbol, False, 103.0), 0)
+        self.assertEqual(book.get_best_ask(symbol), 101.0)
+        
+        # An iceberg leaves with its reserve
+        self.assertEqual(book.get_hidden_volume(symbol, True, 99.0), 40)
+        self.assertEqual(book.mass_cancel(symbol, include_asks=False, min_price=98.5, max_price=99.5), 1)
+        self.assertEqual(book.get_hidden_volume(symbol, True, 99.0), 0)
+        self.assertEqual(book.get_best_bid(symbol), 97.0)
+        
+        # No filter clears the book, disarming expiry timers
+        self.assertEqual(book.get_pending_expiry_count(symbol), 1)
+        self.assertEqual(book.mass_cancel(symbol), 3)
+        self.assertEqual(book.get_order_count(symbol), 0)
+        self.assertEqual(book.get_pending_expiry_count(symbol), 0)
+        
+    def test_order_expiry(self):
+        ms = 1000000
+        self.order_book.add_order(self.symbol, "gtt", 149.0, 100, True, 0, expire_time_ns=100 * ms)
+        self.order_book.add_order(self.symbol, "cxl", 148.0, 100, True, 0, expire_time_ns=100 * ms)
+        self.order_book.add_order(self.symbol, "rep", 151.0, 100, False, 0, expire_time_ns=100 * ms)
+        self.order_book.add_order(self.symbol, "far", 152.0, 100, False, 0, expire_time_ns=10 ** 15)
+        self.assertEqual(self.order_book.get_pending_expiry_count(self.symbol), 4)
+        
+        # Cancelling before expiry disarms the timer
+        self.order_book.cancel_order(self.symbol, "cxl")
+        self.assertEqual(self.order_book.get_pending_expiry_count(self.symbol), 3)
+        
+        # Re-adding the ID replaces the order and re-arms its timer
+        self.order_book.add_order(self.symbol, "rep", 151.0, 50, False, 0, expire_time_ns=300 * ms)
+        self.assertEqual(self.order_book.get_pending_expiry_count(self.symbol), 3)
+        
+        self.assertEqual(self.order_book.advance_time(self.symbol, 100 * ms - 1), 0)
+        self.assertEqual(self.order_book.advance_time(self.symbol, 200 * ms), 1)
+        self.assertIsNone(self.order_book.get_order_info(self.symbol, "gtt"))
+        self.assertEqual(self.order_book.get_order_info(self.symbol, "rep")["quantity"], 50)
+        self.assertEqual(self.order_book.get_best_bid(self.symbol), 0.0)
+        
+        self.assertEqual(self.order_book.advance_time(self.symbol, 300 * ms), 1)
+        self.assertIsNone(self.order_book.get_order_info(self.symbol, "rep"))
+        self.assertEqual(self.order_book.get_pending_expiry_count(self.symbol), 1)
+        
+        # A far deadline lands in the top level and still fires exactly once
+        self.assertEqual(self.order_book.advance_time(self.symbol, 10 ** 15 - 1), 0)
+        self.assertEqual(self.order_book.advance_time(self.symbol, 10 ** 15), 1)
+        self.assertEqual(self.order_book.get_order_count(self.symbol), 0)
+        
+        # Clearing the book disarms timers and drops stop orders
+        self.order_book.add_order(self.symbol, "gtt2", 149.0, 100, True, 0, expire_time_ns=10 ** 16)
+        self.order_book.add_stop_order(self.symbol, "stop", 160.0, 10, True)
+        self.order_book.clear_book(self.symbol)
+        self.assertEqual(self.order_book.get_order_count(self.symbol), 0)
+        self.assertEqual(self.order_book.get_pending_expiry_count(self.symbol), 0)
+        self.assertEqual(self.order_book.get_stop_order_count(self.symbol), 0)
+        self.order_book.add_order(self.symbol, "gtt2", 149.0, 100, True, 0)
+        self.assertEqual(self.order_book.advance_time(self.symbol, 10 ** 16), 0)
+        self.assertIsNotNone(self.order_book.get_order_info(self.symbol, "gtt2"))
+        
+        # Event timestamps drive expiry on the batch path, before the event applies
+        from core.src.integration.cpp_interface import EVENT_ADD
+        self.order_book.create_book("FEED")
+        self.order_book.add_order("FEED", "7", 149.0, 100, True, 0, expire_time_ns=5 * ms)
+        self.order_book.apply_events("FEED", [(4 * ms, 8, 148.0, 100, EVENT_ADD, True)])
+        self.assertEqual(self.order_book.get_best_bid("FEED"), 149.0)
+        self.order_book.apply_events("FEED", [(6 * ms, 9, 147.0, 100, EVENT_ADD, True)])
+        self.assertIsNone(self.order_book.get_order_info("FEED", "7"))
+        self.assertEqual(self.order_book.get_best_bid("FEED"), 148.0)
+        self.assertEqual(self.order_book.get_pending_expiry_count("FEED"), 0)
+        
+    def test_stop_order_cascade(self):
+        self.order_book.add_order(self.symbol, "a1", 101.0, 10, False)
+        self.order_book.add_order(self.symbol, "a2", 102.0, 10, False)
+        self.order_book.add_order(self.symbol, "a3", 103.0, 20, False)
+        self.order_book.add_order(self.symbol, "b1", 99.0, 10, True)
+        
+        self.order_book.add_stop_order(self.symbol, "s1", 102.0, 8, True)
+        self.order_book.add_stop_order(self.symbol, "s2", 103.0, 5, True)
+        self.order_book.add_stop_order(self.symbol, "s3", 101.5, 10, True)
+        self.order_book.add_stop_order(self.symbol, "s4", 98.0, 10, False)
+        self.order_book.add_stop_order(self.symbol, "s5", 110.0, 10, True)
+        self.assertEqual(self.order_book.get_stop_order_count(self.symbol), 5)
+        self.assertTrue(self.order_book.cancel_stop_order(self.symbol, "s5"))
+        self.assertFalse(self.order_book.cancel_stop_order(self.symbol, "s5"))
+        
+        # Taking out 101 lifts the ask to 102, firing s3 then s1 (lowest stop
+        # first); s3's fill lifts it to 103, which fires s2 behind s1
+        self.order_book.execute_order(self.symbol, "a1", 10, 101.0)
+        trades = self.order_book.get_recent_trades(self.symbol, 10)
+        self.assertEqual([(t["price"], t["quantity"]) for t in trades],
+                         [(101.0, 10), (102.0, 10), (103.0, 8), (103.0, 5)])
+        self.assertEqual(self.order_book.get_stop_order_count(self.symbol), 1)
+        self.assertEqual(self.order_book.get_order_info(self.symbol, "a3")["quantity"], 7)
+        
+        # A trade printed elsewhere fires the sell stop against the bids
+        self.order_book.report_trade_price(self.symbol, 97.5)
+        self.assertEqual(self.order_book.get_stop_order_count(self.symbol), 0)
+        self.assertIsNone(self.order_book.get_order_info(self.symbol, "b1"))
+        
+        # A stop cannot take a resting order's ID, and a stop-limit whose ID
+        # was taken after it was placed does not rest its remainder over it
+        self.assertFalse(self.order_book.add_stop_order(self.symbol, "a3", 104.0, 5, True))
+        self.assertTrue(self.order_book.add_stop_order(self.symbol, "s6", 104.0, 20, True, limit_price=103.0))
+        self.order_book.add_order(self.symbol, "s6", 90.0, 5, True)
+        self.order_book.report_trade_price(self.symbol, 104.0)
+        self.assertIsNone(self.order_book.get_order_info(self.symbol, "a3"))
+        info = self.order_book.get_order_info(self.symbol, "s6")
+        self.assertEqual((info["price"], info["quantity"]), (90.0, 5))
+        
+    def test_trigger_book(self):
+        triggers = self.order_book.create_trigger_book()
+        triggers.add("b11", 11.0, 1, True)
+        triggers.add("b10", 10.0, 2, True)
+        triggers.add("b12", 12.0, 3, True)
+        triggers.add("s8", 8.0, 4, False)
+        triggers.add("s9", 9.0, 5, False, limit_price=8.9, timestamp_ns=7)
+        self.assertEqual(len(triggers), 5)
+        
+        # Buys fire from the lowest stop, then sells from the highest
+        fired = triggers.fire(11.0, 8.5)
+        self.assertEqual([stop["order_id"] for stop in fired], ["b10", "b11", "s9"])
+        self.assertEqual((fired[2]["limit_price"], fired[2]["timestamp_ns"]), (8.9, 7))
+        self.assertFalse(fired[2]["is_buy"])
+        self.assertEqual(len(triggers), 2)
+        
+        self.assertTrue(triggers.cancel("s8"))
+        self.assertEqual(triggers.fire(11.5, 1.0), [])
+        self.assertEqual([stop["order_id"] for stop in triggers.fire(12.0, 1.0)], ["b12"])
+        self.assertEqual(len(triggers), 0)
+        
+    def test_snapshot_region_seqlock(self):
+        from core.src.integration.shm_snapshot import SnapshotRegionReader
+        
+        name = f"ob_test_{os.getpid()}"
+        self.order_book.add_order(self.symbol, "bid1", 149.0, 100, True, 5)
+        self.order_book.add_order(self.symbol, "ask1", 151.0, 60, False, 6)
+        self.order_book.attach_snapshot_region(name, slot_count=4, depth=5)
+        self.assertTrue(self.order_book.publish_snapshot(self.symbol))
+        
+        reader = SnapshotRegionReader(name)
+        try:
+            snapshot = reader.read(self.symbol)
+            self.assertEqual(reader.symbols(), [self.symbol])
+            self.assertEqual((snapshot["best_bid"], snapshot["best_ask"]), (149.0, 151.0))
+            self.assertEqual(snapshot["ask_volumes"].tolist(), [60.0])
+            self.assertEqual(snapshot["timestamp_ns"], 6)
+            
+            # A later publish bumps the sequence by two and is seen by the reader
+            sequence = int(reader._sequences[0])
+            self.order_book.add_order(self.symbol, "bid2", 150.0, 10, True, 7)
+            self.order_book.publish_snapshot(self.symbol)
+            self.assertEqual(int(reader._sequences[0]), sequence + 2)
+            self.assertEqual(reader.read(self.symbol)["bid_prices"].tolist(), [150.0, 149.0])
+            
+            # An odd sequence means a write is in progress: the reader retries
+            # until it is even and unchanged across the copy
+            observed = iter([sequence + 3, sequence + 4, sequence + 6, sequence + 6, sequence + 6])
+            
+            class Sequences:
+                def __getitem__(self, slot):
+                    return next(observed)
+                    
+            reader._sequences = Sequences()
+            self.assertEqual(reader.read(self.symbol)["best_bid"], 150.0)
+            self.assertIsNone(next(observed, None))
+            
+            # A writer that never finishes exhausts the retries
+            reader._sequences = [sequence + 1]
+            self.assertIsNone(reader.read(self.symbol, max_retries=3))
+        finally:
+            reader.close()
+            self.order_book.close()
+            
+    def test_snapshot_region_writer_restart(self):
+        from core.src.integration.shm_snapshot import SnapshotRegionReader
+        
+        name = f"ob_restart_{os.getpid()}"
+        self.order_book.add_order(self.symbol, "bid1", 149.0, 100, True, 5)
+        self.order_book.attach_snapshot_region(name, slot_count=4, depth=5)
+        self.order_book.publish_snapshot(self.symbol)
+        reader = SnapshotRegionReader(name)
+        self.addCleanup(reader.close)
+        self.assertTrue(reader.refresh())
+        self.assertEqual(reader.read(self.symbol)["best_bid"], 149.0)
+        
+        # Closing the writer unlinks the region; the old mapping stays readable
+        self.order_book.close()
+        self.assertFalse(reader.refresh())
+        self.assertEqual(reader.read(self.symbol)["best_bid"], 149.0)
+        
+        # A restarted writer creates a new region, which refresh picks up
+        restarted = OrderBookInterface()
+        self.addCleanup(restarted.close)
+        restarted.create_book(self.symbol)
+        restarted.add_order(self.symbol, "bid2", 147.0, 10, True, 9)
+        restarted.attach_snapshot_region(name, slot_count=4, depth=5)
+        restarted.publish_snapshot(self.symbol)
+        self.assertTrue(reader.refresh())
+        self.assertEqual(reader.read(self.symbol)["best_bid"], 147.0)
+        
+    @unittest.skipIf(dashboard_api is None, "dashboard dependencies not installed")
+    def test_dashboard_follows_writer_restart(self):
+        name = f"ob_dash_{os.getpid()}"
+        self.addCleanup(setattr, dashboard_api.Config, "SNAPSHOT_REGION", dashboard_api.Config.SNAPSHOT_REGION)
+        self.addCleanup(setattr, dashboard_api, "_snapshot_reader", None)
+        dashboard_api.Config.SNAPSHOT_REGION = name
+        dashboard_api._snapshot_reader = None
+        
+        self.order_book.add_order(self.symbol, "bid1", 149.0, 100, True, 5)
+        self.order_book.attach_snapshot_region(name, slot_count=4, depth=5)
+        self.order_book.publish_snapshot(self.symbol)
+        self.assertEqual(dashboard_api.get_live_order_book(self.symbol).bid_levels[0].price, 149.0)
+        
+        # The dashboard serves the restarted writer's book, not the frozen one
+        self.order_book.close()
+        self.assertIsNone(dashboard_api.get_live_order_book(self.symbol))
+        restarted = OrderBookInterface()
+        self.addCleanup(restarted.close)
+        restarted.create_book(self.symbol)
+        restarted.add_order(self.symbol, "bid2", 147.0, 10, True, 9)
+        restarted.attach_snapshot_region(name, slot_count=4, depth=5)
+        restarted.publish_snapshot(self.symbol)
+        self.assertEqual(dashboard_api.get_live_order_book(self.symbol).bid_levels[0].price, 147.0)
+        dashboard_api._snapshot_reader.close()
+        
+    def test_apply_events_batch(self):
+        from core.src.integration.cpp_interface import EVENT_ADD, EVENT_CANCEL
+        
+        applied = self.order_book.apply_events(self.symbol, [
+            (1, 1, 149.0, 100, EVENT_ADD, True),
+            (2, 2, 151.0, 100, EVENT_ADD, False),
+            (3, 3, 148.0, 50, EVENT_ADD, True),
+            (4, 1, 0.0, 0.0, EVENT_CANCEL, True)
+        ])
+        
+        self.assertEqual(applied, 4)
+        self.assertEqual(self.order_book.get_order_count(self.symbol), 2)
+        snapshot = self.order_book.get_order_book_snapshot(self.symbol)
+        self.assertEqual(snapshot["bid_levels"], [(148.0, 50.0)])
+        
+    def test_trade_timestamps_follow_events(self):
+        from core.src.integration.cpp_interface import EVENT_ADD, EVENT_EXECUTE, EVENT_MODIFY
+        
+        self.order_book.apply_events(self.symbol, [
+            (1000, 1, 150.0, 100, EVENT_ADD, False),
+            (2000, 2, 149.0, 100, EVENT_ADD, True),
+            (5000, 1, 150.0, 40, EVENT_EXECUTE, False),
+            (7000, 2, 0.0, 80, EVENT_MODIFY, True),
+            (9000, 1, 150.0, 10, EVENT_EXECUTE, False)
+        ])
+        
+        # Executions are stamped with their own event time, not the last add's
+        trades = self.order_book.get_recent_trades(self.symbol, 10)
+        self.assertEqual([(t["timestamp_ns"], t["quantity"]) for t in trades], [(5000, 40), (9000, 10)])
+        self.assertFalse(trades[0]["is_buy"])
+        
+    def test_execute_without_price(self):
+        from core.src.integration.cpp_interface import EVENT_EXECUTE
+        
+        self.order_book.add_order(self.symbol, "1", 149.0, 100, True)
+        self.order_book.add_order(self.symbol, "2", 148.0, 100, True)
+        self.order_book.add_stop_order(self.symbol, "s1", 140.0, 10, False)
+        
+        # No reported price fills at the resting price and fires no sell stop
+        self.assertEqual(self.order_book.execute_order(self.symbol, "1", 30, 0.0), 30)
+        self.order_book.apply_events(self.symbol, [(1000, 2, 0.0, 20, EVENT_EXECUTE, True)])
+        self.assertEqual(self.order_book.get_stop_order_count(self.symbol), 1)
+        trades = self.order_book.get_recent_trades(self.symbol, 10)
+        self.assertEqual([(t["price"], t["quantity"]) for t in trades], [(149.0, 30), (148.0, 20)])
+        
+        self.order_book.report_trade_price(self.symbol, 0.0)
+        self.assertEqual(self.order_book.get_stop_order_count(self.symbol), 1)
+        
+    def test_apply_event_columns(self):
+        from core.src.integration.cpp_interface import EVENT_ADD, EVENT_CANCEL
+        
+        self.order_book.create_book("MSFT")
+        applied, derived = self.order_book.apply_event_columns(
+            [self.symbol, "MSFT"],
+            timestamp_ns=[1, 2, 3, 4, 5],
+            event_type=[EVENT_ADD, EVENT_ADD, EVENT_ADD, EVENT_CANCEL, 9],
+            order_id=[1, 2, 1, 1, 1],
+            price=[149.0, 151.0, 300.0, 0.0, 0.0],
+            quantity=[100, 100, 10, 0, 0],
+            is_buy=[True, False, True, True, True],
+            symbol_index=[0, 0, 1, 0, 0],
+            derived=True
+        )
+        
+        self.assertEqual(applied, 4)
+        self.assertEqual(self.order_book.get_order_count(self.symbol), 1)
+        self.assertEqual(self.order_book.get_best_bid("MSFT"), 300.0)
+        np.testing.assert_array_equal(derived["best_bid"][:4], [149.0, 149.0, 300.0, 0.0])
+        self.assertEqual(derived["mid_price"][1], 150.0)
+        self.assertTrue(np.isnan(derived["best_ask"][4]))
+        
+    def test_export_snapshots_to_arrow(self):
+        self.order_book.add_order(self.symbol, "1", 149.0, 100, True, 1)
+        self.order_book.add_order(self.symbol, "2", 151.0, 50, False, 2)
+        
+        self.assertEqual(self.order_book.record_snapshots(levels=3), 1)
+        self.order_book.cancel_order(self.symbol, "2")
+        self.assertEqual(self.order_book.record_snapshots(levels=3), 2)
+        
+        batch = self.order_book.export_snapshots(levels=3)
+        self.assertEqual(batch.num_rows, 2)
+        self.assertEqual(batch.column("symbol_id").to_pylist(), [0, 0])
+        self.assertEqual(batch.column("mid_price").to_pylist()[0], 150.0)
+        self.assertEqual(batch.column("ask_count").to_pylist(), [1, 0])
+        self.assertEqual(batch.column("bid_prices").to_pylist()[0][0], 149.0)
+        self.assertEqual(self.order_book.export_snapshots(levels=3).num_rows, 0)
+        
+    def test_native_feed_handler(self):
+        from core.src.market_data.native_feed_handler import NativeFeedHandler
+        
+        handler = NativeFeedHandler(self.order_book, [self.symbol, "MSFT"], ring_capacity=1024)
+        batches = []
+        handler.subscribe_to_order_book(batches.append)
+        handler.start()
+        
+        self.assertTrue(handler.submit_order_event(self.symbol, "add", 1, 149.0, 100, True, 1))
+        self.assertTrue(handler.submit_order_event(self.symbol, "add", 2, 151.0, 100, False, 2))
+        self.assertTrue(handler.submit_order_event("MSFT", "add", 1, 300.0, 10, True, 3))
+        self.assertTrue(handler.submit_order_event(self.symbol, "cancel", 2, timestamp_ns=4))
+        handler.stop()
+        self.assertEqual(handler.get_stats()["delivered"], 4)
+        handler.close()
+        
+        updates = np.concatenate(batches)
+        self.assertEqual(len(updates), 4)
+        self.assertEqual(updates["mid_price"][1], 150.0)
+        self.assertEqual(updates["book_index"].tolist(), [0, 0, 1, 0])
+        self.assertEqual(updates["best_bid"][2], 300.0)
+        
+    def test_apply_binary_messages(self):
+        import struct
+        
+        def message(kind, locate, ts, order_id, tail=b""):
+            body = struct.pack("<cHqQ", kind, locate, ts, order_id) + tail
+            return struct.pack("<H", len(body) + 2) + body
+            
+        self.order_book.create_book("MSFT")
+        data = (message(b"A", 0, 1, 1, struct.pack("<cII", b"B", 100, 1490000)) +
+                message(b"A", 0, 2, 2, struct.pack("<cII", b"S", 50, 1510000)) +
+                message(b"A", 1, 3, 1, struct.pack("<cII", b"B", 10, 3000000)) +
+                message(b"Z", 0, 4, 0) +
+                message(b"M", 0, 5, 1, struct.pack("<I", 40)) +
+                message(b"D", 0, 6, 2))
+        partial = message(b"A", 0, 7, 3, struct.pack("<cII", b"S", 5, 1500000))[:10]
+        
+        consumed, stats = self.order_book.apply_binary_messages([self.symbol, "MSFT"], data + partial)
+        self.assertEqual(consumed, len(data))
+        self.assertEqual(stats["messages"], 5)
+        self.assertEqual(stats["skipped"], 1)
+        self.assertEqual(self.order_book.get_order_count(self.symbol), 1)
+        self.assertEqual(self.order_book.get_best_bid(self.symbol), 149.0)
+        self.assertEqual(self.order_book.get_order_info(self.symbol, "1")["quantity"], 40)
+        self.assertEqual(self.order_book.get_best_bid("MSFT"), 300.0)
+        
+        # More books than fit inline still route by locate
+        symbols = [f"S{i}" for i in range(40)]
+        for symbol in symbols:
+            self.order_book.create_book(symbol)
+        consumed, stats = self.order_book.apply_binary_messages(
+            symbols, message(b"A", 37, 8, 1, struct.pack("<cII", b"S", 5, 1500000)))
+        self.assertEqual(stats["messages"], 1)
+        self.assertEqual(self.order_book.get_best_ask("S37"), 150.0)
+        
+    def test_sequenced_feed_gap_recovery(self):
+        import shutil
+        import struct
+        import tempfile
+        from core.src.market_data.sequenced_feed import SequencedFeed
+        
+        def add(locate, order_id, side, shares, price):
+            body = struct.pack("<cHqQcII", b"A", locate, order_id, order_id, side, shares, int(price * 10000))
+            return struct.pack("<H", len(body) + 2) + body
+            
+        def packet(channel, sequence, *messages):
+            return struct.pack("<HHQ", channel, len(messages), sequence) + b"".join(messages)
+            
+        self.order_book.create_book("MSFT")
+        snapshot_dir = tempfile.mkdtemp()
+        self.addCleanup(shutil.rmtree, snapshot_dir)
+        feed = SequencedFeed(self.order_book, [self.symbol, "MSFT"], snapshot_dir)
+        self.assertTrue(feed.add_channel(1, [self.symbol]))
+        self.assertTrue(feed.add_channel(2, ["MSFT"]))
+        
+        feed.process_packet(packet(1, 1, add(0, 1, b"B", 100, 149.0)))
+        self.assertTrue(feed.write_snapshot(1, 2))
+        feed.process_packet(packet(1, 4, add(0, 4, b"S", 10, 151.0)))
+        feed.process_packet(packet(2, 1, add(1, 1, b"B", 10, 300.0)))
+        
+        stats = feed.get_channel_stats(1)
+        self.assertTrue(stats["recovering"])
+        self.assertEqual(stats["gaps"], 1)
+        self.assertEqual(self.order_book.get_best_bid("MSFT"), 300.0)
+        
+        # The snapshot at 2 cannot close a gap at 3, so nothing is loaded,
+        # and the unchanged file is not read again
+        self.assertEqual(feed.poll_recovery(), 0)
+        self.assertEqual(feed.poll_recovery(), 0)
+        self.assertEqual(feed.get_channel_stats(1)["stale_snapshots"], 1)
+        
+        # Snapshots carry what the feed shows: an iceberg's tip, no hidden orders
+        self.order_book.add_order(self.symbol, "2", 148.0, 50, True, 2)
+        self.order_book.add_order(self.symbol, "5", 152.0, 10, False, 2, hidden_quantity=30, peak_quantity=10)
+        self.order_book.add_order(self.symbol, "6", 147.0, 0, True, 2, hidden_quantity=20)
+        self.assertTrue(feed.write_snapshot(1, 3))
+        self.assertEqual(feed.poll_recovery(), 1)
+        
+        stats = feed.get_channel_stats(1)
+        self.assertFalse(stats["recovering"])
+        self.assertEqual(stats["next_sequence"], 5)
+        self.assertEqual(self.order_book.get_order_count(self.symbol), 4)
+        self.assertEqual(self.order_book.get_best_ask(self.symbol), 151.0)
+        info = self.order_book.get_order_info(self.symbol, "5")
+        self.assertEqual((info["quantity"], info["hidden_quantity"]), (10, 0))
+        self.assertIsNone(self.order_book.get_order_info(self.symbol, "6"))
+        
+        # A header claiming more bytes than the file holds is rejected
+        feed.process_packet(packet(2, 3, add(1, 3, b"B", 10, 299.0)))
+        self.assertTrue(feed.get_channel_stats(2)["recovering"])
+        with open(os.path.join(snapshot_dir, "channel_2.snap"), "wb") as f:
+            f.write(struct.pack("<QH6xQQ", 0x313050414e53534d, 2, 2, 1 << 40))
+        self.assertEqual(feed.poll_recovery(), 0)
+        self.assertTrue(feed.write_snapshot(2, 2))
+        
+        # Recovery replaces the live order rather than adding one; the add
+        # buffered during the gap is then replayed
+        def counters():
+            text = self.order_book.scrape_metrics()
+            return {name: int(re.search(rf'microstructure_{name}_total{{symbol="MSFT"}} (\d+)', text).group(1))
+                    for name in ("orders_added", "orders_recovered", "orders_cancelled")}
+            
+        before = counters()
+        self.assertEqual(feed.poll_recovery(), 1)
+        self.assertEqual(self.order_book.get_best_bid("MSFT"), 300.0)
+        after = counters()
+        self.assertEqual({name: after[name] - before[name] for name in after},
+                         {"orders_added": 1, "orders_recovered": 1, "orders_cancelled": 1})
+        
+        # Prices outside the unsigned 4-decimal wire field cannot be snapshotted
+        self.order_book.add_order("MSFT", "2", 500000.0, 10, False, 5)
+        self.assertFalse(feed.write_snapshot(2, 2))
+        self.order_book.cancel_order("MSFT", "2")
+        self.order_book.add_order("MSFT", "3", -1.0, 10, True, 6)
+        self.assertFalse(feed.write_snapshot(2, 2))
+        self.order_book.cancel_order("MSFT", "3")
+        self.assertTrue(feed.write_snapshot(2, 2))
+        
+        # Heartbeats carry no messages: one at or before the next sequence is
+        # not a duplicate, one past it reveals a gap
+        feed.process_packet(packet(1, 4))
+        feed.process_packet(packet(1, 5))
+        stats = feed.get_channel_stats(1)
+        self.assertEqual((stats["duplicates"], stats["gaps"], stats["recovering"]), (0, 1, False))
+        feed.process_packet(packet(1, 7))
+        stats = feed.get_channel_stats(1)
+        self.assertEqual((stats["next_sequence"], stats["gaps"], stats["recovering"]), (5, 2, True))
+        feed.close()
+        
+    def test_replay_pcap(self):
+        import shutil
+        import struct
+        import tempfile
+        
+        def add(order_id, side, shares, price):
+            body = struct.pack("<cHqQcII", b"A", 0, order_id, order_id, side, shares, int(price * 10000))
+            return struct.pack("<H", len(body) + 2) + body
+            
+        def frame(payload, port=30001):
+            udp = struct.pack(">HHHH", 40000, port, len(payload) + 8, 0) + payload
+            ip = struct.pack(">BBHHHBBH4s4s", 0x45, 0, 20 + len(udp), 0, 0, 64, 17, 0,
+                             bytes([10, 0, 0, 1]), bytes([239, 1, 1, 1]))
+            return b"\x01\x00\x5e\x01\x01\x01" + b"\x02" * 6 + b"\x08\x00" + ip + udp
+            
+        packets = [
+            struct.pack("<HHQ", 1, 1, 1) + add(1, b"B", 100, 149.0),
+            struct.pack("<HHQ", 1, 1, 1) + add(1, b"B", 100, 149.0),
+            struct.pack("<HHQ", 1, 1, 2) + add(2, b"S", 50, 151.0),
+            # Heartbeats: the first is not a duplicate, the second shows a gap
+            struct.pack("<HHQ", 1, 0, 3),
+            struct.pack("<HHQ", 1, 0, 5),
+        ]
+        capture = struct.pack("<IHHiIII", 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1)
+        for i, payload in enumerate(packets):
+            data = frame(payload)
+            capture += struct.pack("<IIII", 1700000000, i * 1000, len(data), len(data)) + data
+        capture += struct.pack("<IIII", 1700000000, 5000, 8, 8) + b"\x00" * 8
+        
+        directory = tempfile.mkdtemp()
+        self.addCleanup(shutil.rmtree, directory)
+        path = os.path.join(directory, "feed.pcap")
+        with open(path, "wb") as f:
+            f.write(capture)
+            
+        stats = self.order_book.replay_pcap(path, [self.symbol], udp_port=30001)
+        self.assertEqual(stats["packets"], 5)
+        self.assertEqual(stats["messages"], 2)
+        self.assertEqual((stats["duplicates"], stats["gaps"]), (1, 1))
+        self.assertEqual(stats["skipped_records"], 1)
+        self.assertAlmostEqual(stats["capture_seconds"], 0.004)
+        self.assertGreater(stats["latency_max_ns"], 0)
+        self.assertEqual(self.order_book.get_best_prices(self.symbol), (149.0, 151.0))
+        
+        # pcapng at picosecond resolution (tsresol 12): sub-second tick counts
+        # overflow 64 bits when scaled to nanoseconds directly
+        def block(block_type, body):
+            body += b"\x00" * (-len(body) % 4)
+            return struct.pack("<II", block_type, len(body) + 12) + body + struct.pack("<I", len(body) + 12)
+            
+        def interface(resolution):
+            return block(1, struct.pack("<HHIHHB3xHH", 1, 0, 65535, 9, 1, resolution, 0, 0))
+            
+        capture = block(0x0a0d0d0a, struct.pack("<IHHq", 0x1a2b3c4d, 1, 0, -1))
+        # A 2^64 ticks-per-second interface cannot be represented and its
+        # packets are skipped
+        capture += interface(12) + interface(0x80 | 64)
+        for i, payload in enumerate(packets):
+            data = frame(payload)
+            ticks = 1000 * 10**12 + 497562000000 + i * 10**9
+            capture += block(6, struct.pack("<IIIII", 0, ticks >> 32, ticks & 0xffffffff, len(data), len(data)) + data)
+        data = frame(packets[2])
+        capture += block(6, struct.pack("<IIIII", 1, 0, 1, len(data), len(data)) + data)
+        with open(path, "wb") as f:
+            f.write(capture)
+            
+        self.order_book.create_book("MSFT")
+        stats = self.order_book.replay_pcap(path, ["MSFT"], udp_port=30001)
+        self.assertEqual(stats["packets"], 5)
+        self.assertEqual(stats["skipped_records"], 1)
+        self.assertAlmostEqual(stats["capture_seconds"], 0.004)
+        self.assertEqual(self.order_book.get_best_prices("MSFT"), (149.0, 151.0))
+        
+    def test_udp_feed_loopback(self):
+        import socket
+        import struct
+        from core.src.market_data.udp_feed import UdpFeed
+        
+        def add(order_id, side, shares, price):
+            body = struct.pack("<cHqQcII", b"A", 0, order_id, order_id, side, shares, int(price * 10000))
+            return struct.pack("<H", len(body) + 2) + body
+            
+        feed = UdpFeed(self.order_book, [self.symbol])
+        self.addCleanup(feed.close)
+        feed.add_socket("127.0.0.1", 0)
+        self.assertTrue(feed.add_channel(1, [self.symbol]))
+        self.assertTrue(feed.start())
+        
+        # The receive thread owns the book until stop, bar hold_books
+        with self.assertRaises(RuntimeError):
+            self.order_book.get_best_prices(self.symbol)
+        with self.assertRaises(RuntimeError):
+            self.order_book.close()
+        with feed.hold_books() as interface:
+            self.assertEqual(interface.get_best_prices(self.symbol)[0], 0.0)
+        with self.assertRaises(RuntimeError):
+            self.order_book.get_best_prices(self.symbol)
+        
+        sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.addCleanup(sender.close)
+        target = ("127.0.0.1", feed.get_port())
+        for packet in [
+            struct.pack("<HHQ", 1, 1, 1) + add(1, b"B", 100, 149.0),
+            struct.pack("<HHQ", 1, 1, 1) + add(1, b"B", 100, 149.0),
+            struct.pack("<HHQ", 1, 1, 2) + add(2, b"S", 50, 151.0),
+        ]:
+            sender.sendto(packet, target)
+        feed.stop()
+        
+        stats = feed.get_socket_stats()
+        self.assertEqual(stats["datagrams"], 3)
+        self.assertEqual(stats["kernel_drops"], 0)
+        self.assertGreater(stats["receive_buffer_bytes"], 0)
+        self.assertEqual(feed.get_channel_stats(1)["duplicates"], 1)
+        self.assertEqual(self.order_book.get_best_prices(self.symbol), (149.0, 151.0))
+        
+    def test_replay_event_file(self):
+        import gzip
+        import shutil
+        import struct
+        import tempfile
+        from core.src.data.data_loader import MarketDataLoader
+        
+        def add(order_id, side, shares, price):
+            body = struct.pack("<cHqQcII", b"A", 0, order_id, order_id, side, shares, int(price * 10000))
+            return struct.pack("<H", len(body) + 2) + body
+            
+        events = b"".join(add(i, b"B", 100, 140.0 + i * 0.01) for i in range(1, 201))
+        events += b"".join(add(i, b"S", 100, 160.0 - i * 0.01) for i in range(201, 401))
+        data_dir = tempfile.mkdtemp()
+        self.addCleanup(shutil.rmtree, data_dir)
+        os.makedirs(os.path.join(data_dir, "events"))
+        path = os.path.join(data_dir, "events", "events_20240102.bin.gz")
+        with open(path, "wb") as f:
+            # Two gzip members, as written by appending to an existing file
+            f.write(gzip.compress(events[:5000]) + gzip.compress(events[5000:]))
+            
+        # Small chunks and blocks split messages across every boundary
+        loader = MarketDataLoader(data_dir)
+        for backend in ("auto", "thread_pool"):
+            self.order_book.create_book(backend)
+            stats = loader.replay_order_events(self.order_book, [backend], "2024-01-02", backend=backend,
+                                               chunk_size=512, queue_depth=4, block_size=100)
+            self.assertTrue(stats["compressed"])
+            self.assertEqual(stats["messages"], 400)
+            self.assertEqual(stats["bytes_decompressed"], len(events))
+            self.assertEqual(stats["truncated_bytes"], 0)
+            self.assertEqual(self.order_book.get_order_count(backend), 400)
+            self.assertEqual(self.order_book.get_best_prices(backend), (142.0, 156.0))
+            
+        with open(path, "r+b") as f:
+            f.truncate(os.path.getsize(path) - 20)
+        with self.assertRaises(OSError):
+            self.order_book.replay_event_file(path, [self.symbol])
+            
+    def test_stage_latency(self):
+        import struct
+        from core.src.market_data.native_feed_handler import NativeFeedHandler
+        
+        self.order_book.set_stage_timing(True)
+        self.addCleanup(self.order_book.set_stage_timing, False)
+        self.order_book.reset_stage_latencies()
+        
+        body = struct.pack("<cHqQcII", b"A", 0, 1, 1, b"B", 100, 1490000)
+        self.order_book.apply_binary_messages([self.symbol], struct.pack("<H", len(body) + 2) + body)
+        
+        handler = NativeFeedHandler(self.order_book, [self.symbol], ring_capacity=1024)
+        handler.start()
+        for order_id in range(1, 4):
+            self.assertTrue(handler.submit_order_event(self.symbol, "add", order_id, 150.0, 10, True))
+        handler.stop()
+        handler.close()
+        
+        latencies = self.order_book.get_stage_latencies()
+        self.assertEqual(latencies["decode"]["count"], 1)
+        self.assertEqual(latencies["apply"]["count"], 4)
+        self.assertEqual(latencies["queue_wait"]["count"], 3)
+        self.assertEqual(latencies["metrics"]["count"], 3)
+        self.assertGreaterEqual(latencies["publish"]["count"], 1)
+        self.assertLessEqual(latencies["apply"]["p50_ns"], latencies["apply"]["max_ns"])
+        
+        self.order_book.reset_stage_latencies()
+        self.assertEqual(self.order_book.get_stage_latencies()["apply"]["count"], 0)
+        
+    def test_metrics_endpoint(self):
+        import urllib.request
+        
+        symbol = "METRICS"
+        self.order_book.create_book(symbol)
+        self.order_book.add_order(symbol, "m1", 150.0, 100, True)
+        self.order_book.add_order(symbol, "m2", 151.0, 100, False)
+        self.order_book.add_order(symbol, "m3", 149.0, 100, True)
+        self.order_book.cancel_order(symbol, "m3")
+        self.order_book.cancel_order(symbol, "missing")
+        
+        text = self.order_book.scrape_metrics()
+        self.assertIn("# TYPE microstructure_orders_added_total counter", text)
+        self.assertIn('microstructure_orders_added_total{symbol="METRICS"} 3\n', text)
+        self.assertIn('microstructure_orders_cancelled_total{symbol="METRICS"} 1\n', text)
+        self.assertIn('microstructure_unknown_order_events_total{symbol="METRICS"} 1\n', text)
+        self.assertIn('microstructure_levels_created_total{symbol="METRICS"} 3\n', text)
+        self.assertIn('microstructure_levels_deleted_total{symbol="METRICS"} 1\n', text)
+        
+        port = self.order_book.start_metrics_endpoint(port=0)
+        self.addCleanup(self.order_book.stop_metrics_endpoint)
+        self.assertGreater(port, 0)
+        with urllib.request.urlopen(f"http://127.0.0.1:{port}/metrics", timeout=5) as response:
+            self.assertIn("version=0.0.4", response.headers["Content-Type"])
+            body = response.read().decode("utf-8")
+        self.assertIn('microstructure_orders_added_total{symbol="METRICS"} 3\n', body)
+        with self.assertRaises(OSError):
+            self.order_book.start_metrics_endpoint(port=port)
+            
+        # Expiries and clears count as cancels, and their levels as deleted
+        expire_ns = (time.time_ns() // 10 ** 6 + 1000) * 10 ** 6
+        self.order_book.add_order(symbol, "m4", 148.0, 100, True, expire_time_ns=expire_ns)
+        self.assertEqual(self.order_book.advance_time(symbol, expire_ns), 1)
+        self.order_book.clear_book(symbol)
+        text = self.order_book.scrape_metrics()
+        self.assertIn('microstructure_orders_added_total{symbol="METRICS"} 4\n', text)
+        self.assertIn('microstructure_orders_cancelled_total{symbol="METRICS"} 4\n', text)
+        self.assertIn('microstructure_levels_deleted_total{symbol="METRICS"} 4\n', text)
+        
+    def test_native_microstructure_analyzer(self):
+        from core.src.analysis.microstructure_metrics import MicrostructureAnalyzer
+        
+        rng = np.random.default_rng(7)
+        python_analyzer = MicrostructureAnalyzer(window_size=20)
+        native_analyzer = self.order_book.create_microstructure_analyzer(self.symbol, window_size=20)
+        self.order_book.add_order(self.symbol, "b0", 149.9, 50, True)
+        self.order_book.add_order(self.symbol, "a0", 150.1, 50, False)
+        
+        for step in range(60):
+            is_buy = bool(step % 2)
+            offset = round(float(rng.integers(1, 8)) * 0.05, 2)
+            price = 150.0 - offset if is_buy else 150.0 + offset
+            self.order_book.add_order(self.symbol, f"o{step}", price, float(rng.integers(10, 80)), is_buy)
+            if step % 5 == 4:
+                self.order_book.cancel_order(self.symbol, f"o{step - 2}")
+                
+            snapshot = self.order_book.get_order_book_snapshot(self.symbol)
+            expected = python_analyzer.process_order_book(self.symbol, step, snapshot["bid_levels"],
+                                                          snapshot["ask_levels"])
+            actual = native_analyzer.update(step)
+            for field in ("mid_price", "spread", "order_imbalance", "price_impact", "realized_volatility"):
+                self.assertAlmostEqual(getattr(actual, field), getattr(expected, field), places=6,
+                                       msg=f"{field} at step {step}")
+                
+        batch = self.order_book.create_metric_batch(ANALYZER_METRICS)
+        native_analyzer.append_to(batch, 0)
+        self.assertEqual(len(batch), 1)
+        with self.assertRaises(ValueError):
+            native_analyzer.append_to(self.order_book.create_metric_batch(["mid_price"]), 0)
+            
+    def test_metric_batch_round_trip(self):
+        batch = self.order_book.create_metric_batch(["alpha", "beta"])
+        batch.append(10, 0, [1.5, -2.0])
+        batch.append(20, 3, [2.5, 0.25])
+        self.assertEqual(len(batch), 2)
+        
+        exported = batch.export()
+        self.assertEqual(exported.schema.names, ["timestamp_ns", "symbol_id", "alpha", "beta"])
+        self.assertEqual(exported.column("timestamp_ns").to_pylist(), [10, 20])
+        self.assertEqual(exported.column("symbol_id").to_pylist(), [0, 3])
+        self.assertEqual(exported.column("alpha").to_pylist(), [1.5, 2.5])
+        self.assertEqual(exported.column("beta").to_pylist(), [-2.0, 0.25])
+        
+        # Export moves the rows out; the batch keeps its columns
+        self.assertEqual(len(batch), 0)
+        batch.append(30, 1, [0.0, 1.0])
+        self.assertEqual(batch.export().column("timestamp_ns").to_pylist(), [30])
+        
+        # Analyzer rows need the ANALYZER_METRICS columns by name, not just by count
+        analyzer = self.order_book.create_microstructure_analyzer(self.symbol)
+        renamed = self.order_book.create_metric_batch(list(reversed(ANALYZER_METRICS)))
+        with self.assertRaises(ValueError):
+            analyzer.append_to(renamed, 0)
+        self.assertEqual(renamed.export().num_rows, 0)
+        
+        batch = self.order_book.create_metric_batch(ANALYZER_METRICS)
+        self.order_book.add_order(self.symbol, "b", 149.0, 10, True, 1)
+        self.order_book.add_order(self.symbol, "a", 151.0, 10, False, 2)
+        analyzer.update(5)
+        analyzer.append_to(batch, 7)
+        exported = batch.export()
+        self.assertEqual(exported.schema.names[2:], list(ANALYZER_METRICS))
+        self.assertEqual(exported.column("mid_price").to_pylist(), [150.0])
+        self.assertEqual(exported.column("symbol_id").to_pylist(), [7])
+        
+    def test_native_toxic_flow_detector(self):
+        from core.src.integration.cpp_interface import TOXIC_BOOK, TOXIC_EVENT_DTYPE, TOXIC_FACTORS
+        
+        rng = np.random.default_rng(11)
+        symbols = ["AAPL", "MSFT"]
+        python_detector = ToxicFlowDetector(window_size=20)
+        native_detector = self.order_book.create_toxic_flow_detector(symbols, window_size=20)
+        
+        for step in range(120):
+            symbol = symbols[step % 2]
+            timestamp = 1625097600000 + step
+            quantity = 500.0 if step % 9 == 0 else float(rng.integers(10, 60))
+            is_buy = bool(rng.integers(0, 2))
+            impact = float(rng.uniform(0.0, 0.001))
+            volatility = float(rng.uniform(0.0, 0.003))
+            for detector in (python_detector, native_detector):
+                detector.process_order(symbol, timestamp, f"o{step}", "LIMIT", quantity, is_buy, 150.0)
+                if step % 3 == 0:
+                    detector.process_cancel(symbol, timestamp, f"o{step - 1}")
+                if step % 4 == 0:
+                    detector.process_trade(symbol, timestamp, f"t{step}", 150.0, quantity, is_buy)
+                detector.process_order_book(symbol, timestamp, 0.0, 150.0, impact, volatility)
+                
+            expected = python_detector.get_toxic_flow_status(symbol)
+            actual = native_detector.get_toxic_flow_status(symbol)
+            self.assertEqual(actual["is_toxic"], expected["is_toxic"])
+            self.assertEqual(actual["timestamp"], expected["timestamp"])
+            self.assertAlmostEqual(actual["confidence"], expected["confidence"], delta=1e-9)
+            for actual_factor, expected_factor in zip(actual["factors"], expected["factors"]):
+                self.assertEqual(actual_factor["name"], expected_factor["name"])
+                self.assertAlmostEqual(actual_factor["contribution"], expected_factor["contribution"],
+                                       delta=1e-9, msg=f"{actual_factor['name']} at step {step}")
+                
+        # A batch for both symbols lands in one call and is scored in one call
+        events = np.zeros(len(symbols) * 20, dtype=TOXIC_EVENT_DTYPE)
+        events["symbol_id"] = np.arange(len(events)) % len(symbols)
+        events["type"] = TOXIC_BOOK
+        events["price_impact"] = 0.001
+        events["volatility"] = 0.004
+        self.assertEqual(native_detector.process_events(events), len(events))
+        scores = native_detector.score_all()
+        self.assertEqual(len(scores), len(symbols))
+        np.testing.assert_allclose(scores["factors"][:, TOXIC_FACTORS.index("Price Impact")], 1.0)
+        np.testing.assert_allclose(scores["factors"][:, TOXIC_FACTORS.index("Recent Volatility")], 1.0)
+        
+        # Quantiles are exact nearest-rank values over the order window
+        sizes = np.sort([order["quantity"] for order in python_detector.order_history["AAPL"]])
+        self.assertEqual(len(sizes), 20)
+        self.assertEqual(native_detector.get_order_size_quantile("AAPL", 0.95), sizes[18])
+        self.assertEqual(native_detector.get_order_size_quantile("AAPL", 0.5), sizes[9])
+        
+        # Large orders measured against the median; threshold 0 flags any score
+        median_detector = self.order_book.create_toxic_flow_detector(["AAPL"], window_size=4, threshold=0.0,
+                                                                     large_order_quantile=0.5)
+        for step, quantity in enumerate([10.0, 10.0, 25.0, 100.0]):
+            median_detector.process_order("AAPL", step, f"o{step}", "LIMIT", quantity, True, 150.0)
+        self.assertEqual(median_detector.score_all()["large_order_ratio"][0], 0.5)
+        self.assertTrue(median_detector.get_toxic_flow_status("AAPL")["is_toxic"])
+        
+    def test_vpin_calculator(self):
+        from core.src.integration.cpp_interface import VPIN_AGGRESSOR, VPIN_TICK_RULE, VPIN_TRADE_DTYPE
+        
+        rng = np.random.default_rng(5)
+        prices = 100.0 + np.cumsum(rng.choice([-0.01, 0.0, 0.01], size=2000))
+        quantities = rng.integers(1, 400, size=2000).astype(np.float64)
+        bucket_volume, window = 1000.0, 10
+        
+        # Tick-rule reference, splitting each print across bucket boundaries
+        imbalances, filled, buys, tick, last = [], 0.0, 0.0, 0, None
+        for price, quantity in zip(prices, quantities):
+            if last is not None and price != last:
+                tick = 1 if price > last else -1
+            last = price
+            share = 1.0 if tick > 0 else (0.0 if tick < 0 else 0.5)
+            while quantity > 0:
+                take = min(quantity, bucket_volume - filled)
+                filled, buys, quantity = filled + take, buys + take * share, quantity - take
+                if filled >= bucket_volume:
+                    imbalances.append(abs(2 * buys - bucket_volume) / bucket_volume)
+                    filled, buys = 0.0, 0.0
+        expected = np.mean(imbalances[-window:])
+        
+        historical = self.order_book.compute_vpin(prices, quantities, bucket_volume, window, VPIN_TICK_RULE)
+        self.assertEqual(len(historical), len(prices))
+        self.assertTrue(np.isnan(historical[0]))
+        self.assertAlmostEqual(historical[-1], expected, places=9)
+        
+        # Streaming over two symbols matches the whole-day arrays
+        vpin = self.order_book.create_vpin_calculator(["AAPL", "MSFT"], bucket_volume, window, VPIN_TICK_RULE)
+        trades = np.zeros(len(prices) * 2, dtype=VPIN_TRADE_DTYPE)
+        trades["symbol_id"] = np.tile([0, 1], len(prices))
+        trades["price"] = np.repeat(prices, 2)
+        trades["quantity"] = np.repeat(quantities, 2)
+        self.assertEqual(vpin.process_trades(trades), len(trades))
+        states = vpin.get_all_states()
+        self.assertEqual(states["buckets"][0], len(imbalances))
+        np.testing.assert_allclose(states["vpin"], expected)
+        
+        # Bulk volume reference: each print that closes buckets gives all of
+        # them Phi(change / sigma) over the change since the previous closing
+        # print, with sigma from the preceding changes, and records one change
+        block = 2 * len(prices) // 3
+        bulk_quantities = quantities.copy()
+        bulk_quantities[block] = bucket_volume * 3.5
+        returns, imbalances, filled, last_close, expected = [], [], 0.0, prices[0], []
+        for price, quantity in zip(prices, bulk_quantities):
+            filled += quantity
+            closed = int(filled // bucket_volume)
+            filled -= closed * bucket_volume
+            if closed:
+                change = price - last_close
+                recent = returns[-window:]
+                share = 0.5
+                if len(recent) >= 2 and np.std(recent, ddof=1) > 0:
+                    share = 0.5 * math.erfc(-change / (np.std(recent, ddof=1) * math.sqrt(2.0)))
+                elif len(recent) >= 2:
+                    share = (np.sign(change) + 1.0) / 2.0
+                returns.append(change)
+                last_close = price
+                imbalances.extend([abs(2.0 * share - 1.0)] * closed)
+            expected.append(np.mean(imbalances[-window:]) if len(imbalances) >= window else np.nan)
+            
+        bulk = self.order_book.compute_vpin(prices, bulk_quantities, bucket_volume, window)
+        np.testing.assert_allclose(bulk, expected, rtol=1e-9, atol=1e-12)
+        self.assertGreater(bulk[block], 0.0)
+        
+        # A print spanning many buckets closes them all at once
+        vpin.reset("MSFT")
+        vpin.process_trade("MSFT", 1, 50.0, bucket_volume * 25.5, is_buy=True)
+        state = vpin.get_state("MSFT")
+        self.assertEqual(state["buckets"], 25)
+        self.assertTrue(state["is_warm"])
+        self.assertAlmostEqual(state["bucket_fill"], 0.5)
+        
+        # Executions against resting asks are buyer-initiated
+        book_vpin = self.order_book.create_vpin_calculator([self.symbol], 100.0, 2, VPIN_AGGRESSOR)
+        for i in range(4):
+            self.order_book.add_order(self.symbol, f"ask{i}", 150.0 + i * 0.01, 100, False)
+            self.order_book.execute_order(self.symbol, f"ask{i}", 100, 150.0 + i * 0.01)
+        self.assertEqual(book_vpin.update_from_book(self.symbol), 4)
+        self.assertEqual(book_vpin.update_from_book(self.symbol), 0)
+        state = book_vpin.get_state(self.symbol)
+        self.assertEqual(state["buckets"], 4)
+        self.assertAlmostEqual(state["vpin"], 1.0)
+        with self.assertRaises(ValueError):
+            book_vpin.set_bucket_volume(self.symbol, 0.0)
+            
+        # A new book for the symbol is read from its start, even when its
+        # tape is longer than the old one. The old book stays alive until
+        # cleanup so the new one cannot reuse its address
+        self.addCleanup(self.order_book.lib.destroy_order_book, self.order_book.order_books[self.symbol])
+        self.order_book.create_book(self.symbol)
+        for i in range(6):
+            self.order_book.add_order(self.symbol, f"ask{i}", 150.0, 100, False)
+            self.order_book.execute_order(self.symbol, f"ask{i}", 50, 150.0)
+        self.assertEqual(book_vpin.update_from_book(self.symbol), 6)
+        self.assertEqual(book_vpin.get_state(self.symbol)["buckets"], 7)
+        
+@unittest.skipIf(orderbook_native is None, "orderbook_native extension is not built")
+class TestNativeModule(unittest.TestCase):
+    def setUp(self):
+        self.book = orderbook_native.LimitOrderBook("AAPL")
+        
+    def make_events(self, rows):
+        return np.array(rows, dtype=orderbook_native.EVENT_DTYPE)
+        
+    def test_apply_events(self):
+        events = self.make_events([
+            (1, 1, 149.0, 100, orderbook_native.EVENT_ADD, 1),
+            (2, 2, 151.0, 100, orderbook_native.EVENT_ADD, 0),
+            (3, 3, 148.0, 50, orderbook_native.EVENT_ADD, 1),
+            (4, 1, 0.0, 0.0, orderbook_native.EVENT_CANCEL, 1)
+        ])
+        
+        self.assertEqual(self.book.apply_events(events), 4)
+        self.assertEqual(self.book.order_count, 2)
+        self.assertEqual(self.book.best_bid, 148.0)
+        self.assertEqual(self.book.best_ask, 151.0)
+        
+    def test_apply_events_rejects_bad_arrays(self):
+        events = self.make_events([(i, i, 150.0, 10, orderbook_native.EVENT_ADD, 1) for i in range(4)])
+        
+        with self.assertRaises(ValueError):
+            self.book.apply_events(np.zeros(4, dtype=np.float64))
+        with self.assertRaises(ValueError):
+            self.book.apply_events(events[::2])
+        with self.assertRaises(ValueError):
+            self.book.apply_events(events.reshape(2, 2))
+        self.assertEqual(self.book.order_count, 0)
+        
+    def test_snapshot(self):
+        self.book.add_order("b1", 149.0, 100, True, 10)
+        self.book.add_order("b2", 148.0, 50, True, 11)
+        self.book.add_order("a1", 151.0, 70, False, 12)
+        
+        snapshot = self.book.snapshot(5)
+        np.testing.assert_array_equal(snapshot.bid_prices, [149.0, 148.0])
+        np.testing.assert_array_equal(snapshot.bid_volumes, [100.0, 50.0])
+        np.testing.assert_array_equal(snapshot.ask_prices, [151.0])
+        np.testing.assert_array_equal(snapshot.ask_volumes, [70.0])
+        self.assertEqual((snapshot.bid_count, snapshot.ask_count), (2, 1))
+        self.assertEqual(snapshot.mid_price, 150.0)
+        self.assertEqual(snapshot.timestamp_ns, 12)
+        self.assertEqual(np.asarray(snapshot).shape, (4, 5))
+        
+        with self.assertRaises(ValueError):
+            self.book.snapshot(-1)
+            
+    def test_apply_event_columns(self):
+        other = orderbook_native.LimitOrderBook("MSFT")
+        timestamps = np.arange(1, 4, dtype=np.int64)
+        types = np.full(3, orderbook_native.EVENT_ADD, dtype=np.uint8)
+        ids = np.array([1, 2, 3], dtype=np.uint64)
+        prices = np.array([149.0, 151.0, 99.0])
+        quantities = np.array([100.0, 50.0, 10.0])
+        sides = np.array([1, 0, 1], dtype=np.uint8)
+        
+        applied, outputs = orderbook_native.apply_event_columns(
+            [self.book, other], timestamps, types, ids, prices, quantities, sides,
+            book_index=np.array([0, 0, 1], dtype=np.uint32), derived=True)
+        self.assertEqual(applied, 3)
+        np.testing.assert_array_equal(outputs["mid_price"][1:2], [150.0])
+        self.assertEqual(other.best_bid, 99.0)
+        
+        with self.assertRaises(ValueError):
+            orderbook_native.apply_event_columns([self.book], timestamps, types, ids[:2], prices,
+                                                 quantities, sides)
+        
 class TestExecutionModel(unittest.TestCase):
     def setUp(self):
         self.execution_model = ExecutionModel(
@@ -138,6 +1213,26 @@ class TestExecutionModel(unittest.TestCase):
         self.assertEqual(order.filled_quantity, 100)
         self.assertLessEqual(order.average_fill_price, order.price)
         
+    def test_stop_orders_through_trigger_book(self):
+        triggers = OrderBookInterface().create_trigger_book()
+        model = ExecutionModel(slippage_factor=0.0, market_impact_factor=0.0, trigger_book=triggers)
+        buy_stop = Order(symbol="AAPL", order_type="STOP", direction="BUY", quantity=10, stop_price=151.0)
+        sell_stop = Order(symbol="AAPL", order_type="STOP", direction="SELL", quantity=10, stop_price=149.0)
+        
+        self.assertFalse(model.execute_order(buy_stop, {"mid_price": 150.0}, 1))
+        self.assertFalse(model.execute_order(sell_stop, {"mid_price": 150.0}, 1))
+        self.assertEqual(len(triggers), 2)
+        
+        filled = model.process_stop_orders({"mid_price": 151.5}, 2)
+        self.assertEqual(filled, [buy_stop])
+        self.assertEqual(buy_stop.status, "FILLED")
+        self.assertEqual(buy_stop.average_fill_price, 151.5)
+        self.assertEqual(sell_stop.status, "OPEN")
+        
+        self.assertTrue(model.cancel_stop_order(sell_stop))
+        self.assertEqual(len(triggers), 0)
+        self.assertEqual(model.process_stop_orders({"mid_price": 140.0}, 3), [])
+        
 class TestToxicFlowDetector(unittest.TestCase):
     def setUp(self):
         self.detector = ToxicFlowDetector(window_size=20)